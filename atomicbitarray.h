@@ -0,0 +1,238 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#pragma once
+
+#include <atomic>
+
+#include "bitarray.h"
+
+// Fixed-size bit array that many threads can update at once without a lock, e.g. a visited set or a
+// free-slot map. Blocks are std::atomic<uint64_t>, and every single-bit operation is one atomic
+// read-modify-write of its block.
+//
+// Range operations are one atomic operation per block: a concurrent reader may see a range partially
+// updated, but never a torn block. Likewise, whole-array queries read one block at a time and are not
+// a snapshot of the array.
+//
+// Every operation takes a memory order, defaulting to sequentially consistent, with the same rules as the
+// std::atomic operation it maps to: loads take no release order and stores no acquire order.
+// An allocator handing out slots via ClaimFirstClearBit() and returning them via ClearBit() needs at
+// least acquire on the claim and release on the return.
+template <uint64_t kNBits>
+class AtomicBitArray
+{
+public:
+    static constexpr uint64_t kNumBits = kNBits;
+    static constexpr uint64_t kNumBlocks = (kNumBits + 63ULL) >> 6ULL;
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "AtomicBitArray requires lock-free 64-bit atomics.");
+
+    // All bits start clear.
+    AtomicBitArray()
+    {
+        for (uint64_t i = 0; i < kNumBlocks; ++i)
+            m_block[i].store(0ULL, std::memory_order_relaxed);
+    }
+
+    // Start with the bits of v.
+    explicit AtomicBitArray(const BitArray<kNumBits>& v)
+    {
+        for (uint64_t i = 0; i < kNumBlocks; ++i)
+            m_block[i].store(v.Blocks()[i], std::memory_order_relaxed);
+    }
+
+    AtomicBitArray(const AtomicBitArray&) = delete;
+    AtomicBitArray& operator=(const AtomicBitArray&) = delete;
+
+    // Return a copy of the bits, read one block at a time.
+    BitArray<kNumBits> Load(std::memory_order order = std::memory_order_seq_cst) const
+    {
+        BitArray<kNumBits> ret;
+        for (uint64_t i = 0; i < kNumBlocks; ++i)
+            ret.Blocks()[i] = m_block[i].load(order);
+        return ret;
+    }
+
+    // Clear all bits.
+    void ClearAll(std::memory_order order = std::memory_order_seq_cst)
+    {
+        for (uint64_t i = 0; i < kNumBlocks; ++i)
+            m_block[i].store(0ULL, order);
+    }
+
+    // Set all bits.
+    void SetAll(std::memory_order order = std::memory_order_seq_cst)
+    {
+        for (uint64_t i = 0; i < kNumBlocks; ++i)
+            m_block[i].store(~0ULL, order);
+    }
+
+    // Check if a bit is set.
+    bool IsBitSet(uint64_t index, std::memory_order order = std::memory_order_seq_cst) const
+    {
+        ASSERT(index < kNumBits);
+        return m_block[index >> 6ULL].load(order) & (1ULL << (index & 63ULL));
+    }
+
+    // Set a bit.
+    void SetBit(uint64_t index, std::memory_order order = std::memory_order_seq_cst)
+    {
+        ASSERT(index < kNumBits);
+        m_block[index >> 6ULL].fetch_or(1ULL << (index & 63ULL), order);
+    }
+
+    // Clear a bit.
+    void ClearBit(uint64_t index, std::memory_order order = std::memory_order_seq_cst)
+    {
+        ASSERT(index < kNumBits);
+        m_block[index >> 6ULL].fetch_and(~(1ULL << (index & 63ULL)), order);
+    }
+
+    // Invert a bit.
+    void XorBit(uint64_t index, std::memory_order order = std::memory_order_seq_cst)
+    {
+        ASSERT(index < kNumBits);
+        m_block[index >> 6ULL].fetch_xor(1ULL << (index & 63ULL), order);
+    }
+
+    // Assign a value to a single bit.
+    void AssignBit(uint64_t index, bool value, std::memory_order order = std::memory_order_seq_cst)
+    {
+        if (value)
+            SetBit(index, order);
+        else
+            ClearBit(index, order);
+    }
+
+    // Set a bit. Return true if it was already set.
+    // Exactly one of any number of threads setting the same clear bit sees false.
+    bool TestAndSet(uint64_t index, std::memory_order order = std::memory_order_seq_cst)
+    {
+        ASSERT(index < kNumBits);
+        const uint64_t bit = 1ULL << (index & 63ULL);
+        return m_block[index >> 6ULL].fetch_or(bit, order) & bit;
+    }
+
+    // Clear a bit. Return true if it was set.
+    // Exactly one of any number of threads clearing the same set bit sees true.
+    bool TestAndClear(uint64_t index, std::memory_order order = std::memory_order_seq_cst)
+    {
+        ASSERT(index < kNumBits);
+        const uint64_t bit = 1ULL << (index & 63ULL);
+        return m_block[index >> 6ULL].fetch_and(~bit, order) & bit;
+    }
+
+    // Invert a bit. Return true if it was set.
+    bool FetchXor(uint64_t index, std::memory_order order = std::memory_order_seq_cst)
+    {
+        ASSERT(index < kNumBits);
+        const uint64_t bit = 1ULL << (index & 63ULL);
+        return m_block[index >> 6ULL].fetch_xor(bit, order) & bit;
+    }
+
+    // Set all bits between indices [a, b], inclusive.
+    void SetBitsInRange(uint64_t a, uint64_t b, std::memory_order order = std::memory_order_seq_cst)
+    {
+        ASSERT(a <= b);
+        ASSERT(b < kNumBits);
+
+        const uint64_t iBlockA = a >> 6ULL;
+        const uint64_t iBlockB = b >> 6ULL;
+
+        if (iBlockA == iBlockB)
+        {
+            m_block[iBlockA].fetch_or(SetBitRange_U64(a, b), order);
+        }
+        else
+        {
+            m_block[iBlockA].fetch_or(SetBitRange_U64(a, 63ULL), order);
+
+            for (uint64_t iBlock = iBlockA + 1; iBlock < iBlockB; ++iBlock)
+                m_block[iBlock].fetch_or(~0ULL, order);
+
+            m_block[iBlockB].fetch_or(SetBitRange_U64(0, b), order);
+        }
+    }
+
+    // Clear all bits between indices [a, b], inclusive.
+    void ClearBitsInRange(uint64_t a, uint64_t b, std::memory_order order = std::memory_order_seq_cst)
+    {
+        ASSERT(a <= b);
+        ASSERT(b < kNumBits);
+
+        const uint64_t iBlockA = a >> 6ULL;
+        const uint64_t iBlockB = b >> 6ULL;
+
+        if (iBlockA == iBlockB)
+        {
+            m_block[iBlockA].fetch_and(~SetBitRange_U64(a, b), order);
+        }
+        else
+        {
+            m_block[iBlockA].fetch_and(~SetBitRange_U64(a, 63ULL), order);
+
+            for (uint64_t iBlock = iBlockA + 1; iBlock < iBlockB; ++iBlock)
+                m_block[iBlock].fetch_and(0ULL, order);
+
+            m_block[iBlockB].fetch_and(~SetBitRange_U64(0, b), order);
+        }
+    }
+
+    // Return the total number of set bits, reading one block at a time.
+    uint64_t CountSetBits(std::memory_order order = std::memory_order_seq_cst) const
+    {
+        uint64_t count = 0;
+        for (uint64_t iBlock = 0; iBlock < kNumBlocks - 1; ++iBlock)
+            count += CountSetBits_U64(m_block[iBlock].load(order));
+
+        return count + CountSetBits_U64(m_block[kNumBlocks - 1].load(order) & LastBlockMask());
+    }
+
+    // Find a clear bit and set it, atomically. Return its index, or ~0ULL if every bit was seen set.
+    //
+    // The search starts at the block holding hint and wraps around; threads passing different hints
+    // (e.g. their last claim, or a per-thread offset) spread out instead of all contending on the
+    // first block. Each attempt is a single fetch_or of the chosen bit: if another thread got there
+    // first, the returned block shows it and the next clear bit of the same block is tried. A failed
+    // attempt always means another thread's claim succeeded, so the search is lock-free.
+    //
+    // Returning ~0ULL is not proof the array is full: a bit cleared in a block the search has
+    // already passed is not seen.
+    uint64_t ClaimFirstClearBit(uint64_t hint = 0, std::memory_order order = std::memory_order_seq_cst)
+    {
+        ASSERT(hint < kNumBits);
+        const uint64_t iStart = hint >> 6ULL;
+        for (uint64_t k = 0; k < kNumBlocks; ++k)
+        {
+            const uint64_t iBlock = iStart + k < kNumBlocks ? iStart + k : iStart + k - kNumBlocks;
+            const uint64_t invalid = iBlock == kNumBlocks - 1 ? ~LastBlockMask() : 0ULL;
+
+            uint64_t block = m_block[iBlock].load(std::memory_order_relaxed);
+            while (~(block | invalid))
+            {
+                const uint64_t bit = FirstClearBitMask_U64(block | invalid);
+                block = m_block[iBlock].fetch_or(bit, order);
+                if (!(block & bit))
+                    return (iBlock << 6ULL) + FirstSetBitIndex_U64(bit);
+            }
+        }
+
+        return ~0ULL;
+    }
+
+    // Mask of the valid (in-use) bits of the last block.
+    static constexpr uint64_t LastBlockMask()
+    {
+        return ~0ULL >> ((0ULL - kNumBits) & 63ULL);
+    }
+
+private:
+    std::atomic<uint64_t> m_block[kNumBlocks];
+};
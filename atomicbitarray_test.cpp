@@ -0,0 +1,209 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "atomicbitarray.h"
+#include "testutil.h"
+
+#define ASSERT_TRUE(a) do { if (!(a)) { std::cerr << "FAIL: expected true for " << #a << ", got false\n"; __debugbreak(); } } while (0)
+#define ASSERT_FALSE(a) do { if ((a)) { std::cerr << "FAIL: expected false for " << #a << ", got true\n"; __debugbreak(); } } while (0)
+
+#define ASSERT_BIN_OP(a, b, op) do {                                                            \
+    const auto& va = (a);                                                                       \
+    const auto& vb = (b);                                                                       \
+    if (!(va op vb))                                                                            \
+    {                                                                                           \
+        std::cerr << "FAIL: expected " << #a << " " << #op << " " << #b << " (evaluates to ";   \
+        std::cerr << va << " " << #op << " " << vb << ")\n";                                    \
+        __debugbreak();                                                                         \
+    }                                                                                           \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_BIN_OP(a, b, ==)
+
+static constexpr uint64_t kNumThreads = 4;
+
+// Every operation from one thread, against BitArray<n> doing the same.
+template <uint64_t n>
+static void TestSingleThreaded(uint64_t& state)
+{
+    BitArray<n> v;
+    v.ClearAll();
+    AtomicBitArray<n> a;
+    ASSERT_TRUE(a.Load() == v);
+    ASSERT_EQ(a.CountSetBits(), 0ULL);
+
+    for (uint64_t k = 0; k < 4 * n; ++k)
+    {
+        const uint64_t i = SplitMix64(state) % n;
+        const bool wasSet = v.IsBitSet(i);
+        switch (SplitMix64(state) % 7)
+        {
+        case 0: a.SetBit(i); v.SetBit(i); break;
+        case 1: a.ClearBit(i); v.ClearBit(i); break;
+        case 2: a.XorBit(i); v.XorBit(i); break;
+        case 3: { const bool value = SplitMix64(state) & 1; a.AssignBit(i, value); v.AssignBit(i, value); break; }
+        case 4: ASSERT_EQ(a.TestAndSet(i), wasSet); v.SetBit(i); break;
+        case 5: ASSERT_EQ(a.TestAndClear(i), wasSet); v.ClearBit(i); break;
+        case 6: ASSERT_EQ(a.FetchXor(i), wasSet); v.XorBit(i); break;
+        }
+        ASSERT_EQ(a.IsBitSet(i), v.IsBitSet(i));
+    }
+    ASSERT_TRUE(a.Load() == v);
+    ASSERT_EQ(a.CountSetBits(), v.CountSetBits());
+
+    for (uint64_t k = 0; k < 64; ++k)
+    {
+        uint64_t lo = SplitMix64(state) % n;
+        uint64_t hi = SplitMix64(state) % n;
+        if (lo > hi)
+        {
+            const uint64_t t = lo;
+            lo = hi;
+            hi = t;
+        }
+        if (k & 1)
+        {
+            a.SetBitsInRange(lo, hi);
+            v.SetBitsInRange(lo, hi);
+        }
+        else
+        {
+            a.ClearBitsInRange(lo, hi);
+            v.ClearBitsInRange(lo, hi);
+        }
+        ASSERT_TRUE(a.Load() == v);
+    }
+
+    const AtomicBitArray<n> b(v);
+    ASSERT_TRUE(b.Load() == v);
+
+    // ClaimFirstClearBit takes the first clear bit of the hint's block, wrapping around, and never a bit past n.
+    a.ClearAll();
+    ASSERT_EQ(a.ClaimFirstClearBit(), 0ULL);
+    if (n > 1)
+        ASSERT_EQ(a.ClaimFirstClearBit(n - 1), n > 64 ? (n - 1) & ~63ULL : 1ULL);
+    a.SetAll();
+    ASSERT_EQ(a.CountSetBits(), n);
+    ASSERT_EQ(a.ClaimFirstClearBit(), ~0ULL);
+    a.ClearBit(n - 1);
+    ASSERT_EQ(a.ClaimFirstClearBit(), n - 1);
+    ASSERT_EQ(a.ClaimFirstClearBit(), ~0ULL);
+}
+
+// Threads claiming from one array get distinct bits, and every bit is handed out once.
+template <uint64_t n>
+static void TestConcurrentClaim()
+{
+    AtomicBitArray<n> a;
+    std::vector<uint64_t> claimed[kNumThreads];
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < kNumThreads; ++t)
+    {
+        threads.emplace_back([&a, &claimed, t]
+            {
+                uint64_t hint = t * n / kNumThreads;
+                for (;;)
+                {
+                    const uint64_t i = a.ClaimFirstClearBit(hint, std::memory_order_acq_rel);
+                    if (i == ~0ULL)
+                        return;
+                    claimed[t].push_back(i);
+                    hint = i;
+                }
+            });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    BitArray<n> seen;
+    seen.ClearAll();
+    uint64_t total = 0;
+    for (const std::vector<uint64_t>& c : claimed)
+    {
+        for (const uint64_t i : c)
+        {
+            ASSERT_TRUE(i < n);
+            ASSERT_FALSE(seen.IsBitSet(i));
+            seen.SetBit(i);
+        }
+        total += c.size();
+    }
+    ASSERT_EQ(total, n);
+    ASSERT_EQ(a.CountSetBits(), n);
+}
+
+void TestAtomicBitArray()
+{
+    uint64_t state = 0xA70A70ULL;
+
+    TestSingleThreaded<1>(state);
+    TestSingleThreaded<63>(state);
+    TestSingleThreaded<64>(state);
+    TestSingleThreaded<65>(state);
+    TestSingleThreaded<200>(state);
+    TestSingleThreaded<4161>(state);
+
+    TestConcurrentClaim<1>();
+    TestConcurrentClaim<100>();
+    TestConcurrentClaim<100000>();
+
+    // TestAndSet as a visited set: each bit is first-set by exactly one thread.
+    {
+        constexpr uint64_t n = 50000;
+        AtomicBitArray<n> a;
+        uint64_t firstSetCount[kNumThreads] = {};
+        std::vector<std::thread> threads;
+        for (uint64_t t = 0; t < kNumThreads; ++t)
+        {
+            threads.emplace_back([&a, &firstSetCount, t]
+                {
+                    for (uint64_t k = 0; k < n; ++k)
+                        firstSetCount[t] += !a.TestAndSet((k * 7919 + t * 1237) % n);
+                });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+
+        uint64_t total = 0;
+        for (const uint64_t c : firstSetCount)
+            total += c;
+        ASSERT_EQ(total, n);
+        ASSERT_EQ(a.CountSetBits(), n);
+    }
+
+    // Concurrent flips and range updates on shared blocks lose no update.
+    {
+        constexpr uint64_t n = 1000;
+        AtomicBitArray<n> a;
+        std::vector<std::thread> threads;
+        for (uint64_t t = 0; t < kNumThreads; ++t)
+        {
+            threads.emplace_back([&a, t]
+                {
+                    // Two flips of each of the last 200 bits, plus a set and clear of a range of its own below them.
+                    for (uint64_t k = 0; k < 400; ++k)
+                        a.FetchXor(800 + (k + t) % 200);
+                    a.SetBitsInRange(t * 200 + 10, t * 200 + 150);
+                    a.ClearBitsInRange(t * 200 + 10, t * 200 + 80);
+                });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+
+        BitArray<n> expected;
+        expected.ClearAll();
+        for (uint64_t t = 0; t < kNumThreads; ++t)
+            expected.SetBitsInRange(t * 200 + 81, t * 200 + 150);
+        ASSERT_TRUE(a.Load() == expected);
+    }
+}
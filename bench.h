@@ -0,0 +1,201 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// Shared timing harness for the *_bench.cpp files, driven from bench_main.cpp.
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+// Keep the compiler from discarding x, or the work that produced it.
+template <class T>
+static inline void DoNotOptimize(const T& x)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    static volatile T sink;
+    sink = x;
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "r,m"(x) : "memory");
+#endif
+}
+
+// Make the compiler assume any memory it can reach has changed, so that a query of unchanged data isn't hoisted out
+// of the loop timing it.
+static inline void ClobberMemory()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : : "memory");
+#endif
+}
+
+// Return the time stamp counter. It ticks at a fixed rate near the nominal clock, so cycles from it are reference
+// cycles, not core cycles, where the core is boosting or throttled.
+static inline uint64_t ReadBenchCycleCounter()
+{
+    return __rdtsc();
+}
+
+// A run must take at least this long to be timed; shorter ones double their iteration count and retry.
+static constexpr double kBenchMinSeconds = 0.01;
+
+// Timed runs per benchmark, of which the fastest is reported.
+static constexpr uint32_t kBenchRepeats = 5;
+
+// Fastest time per iteration.
+struct BenchResult
+{
+    double ns;
+    double cycles;
+};
+
+// Return the fastest time per iteration of f(numIterations), which must run numIterations iterations of the
+// operation being measured.
+template <class F>
+static BenchResult BenchMeasure(F&& f)
+{
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t numIterations = 1;
+    for (;;)
+    {
+        const Clock::time_point start = Clock::now();
+        f(numIterations);
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (seconds >= kBenchMinSeconds || numIterations >= (1ULL << 40ULL))
+            break;
+        numIterations <<= 1ULL;
+    }
+
+    BenchResult best = { 1e300, 1e300 };
+    for (uint32_t i = 0; i < kBenchRepeats; ++i)
+    {
+        const Clock::time_point start = Clock::now();
+        const uint64_t startCycles = ReadBenchCycleCounter();
+        f(numIterations);
+        const uint64_t cycles = ReadBenchCycleCounter() - startCycles;
+        const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        if (ns < best.ns * double(numIterations))
+            best = { ns / double(numIterations), double(cycles) / double(numIterations) };
+    }
+    return best;
+}
+
+// Return the fastest time per iteration, in ns, of f(numIterations), as BenchMeasure().
+template <class F>
+static double BenchNsPerIteration(F&& f)
+{
+    return BenchMeasure(f).ns;
+}
+
+enum class BenchFormat
+{
+    // Aligned columns, for reading.
+    Table,
+
+    // Comma-separated values, with a header line.
+    Csv,
+
+    // One JSON object per line.
+    Json,
+};
+
+// How results are printed, and which are run at all: only those whose group or name contains the filter.
+struct BenchOptions
+{
+    BenchFormat format = BenchFormat::Table;
+    const char* filter = "";
+};
+
+inline BenchOptions g_benchOptions;
+
+// Check if a benchmark passes the filter, and should be run.
+static inline bool BenchSelected(const char* group, const char* name)
+{
+    return strstr(group, g_benchOptions.filter) || strstr(name, g_benchOptions.filter);
+}
+
+// Print the header, if the format has one.
+static inline void PrintBenchHeader()
+{
+    if (g_benchOptions.format == BenchFormat::Table)
+        printf("%-24s %-48s %12s %12s %10s\n", "group", "name", "ns/op", "cycles/op", "GB/s");
+    else if (g_benchOptions.format == BenchFormat::Csv)
+        printf("group,name,ns_per_op,cycles_per_op,gb_per_s\n");
+}
+
+// Print one result line. Throughput is bytesPerOp over the time per op, and left out if bytesPerOp is 0. Names
+// contain no characters that need quoting or escaping.
+static inline void PrintBenchResult(const char* group, const char* name, const BenchResult& r, uint64_t bytesPerOp = 0)
+{
+    const double gbPerS = double(bytesPerOp) / r.ns;
+    switch (g_benchOptions.format)
+    {
+    case BenchFormat::Table:
+        if (bytesPerOp)
+            printf("%-24s %-48s %12.2f %12.2f %10.2f\n", group, name, r.ns, r.cycles, gbPerS);
+        else
+            printf("%-24s %-48s %12.2f %12.2f %10s\n", group, name, r.ns, r.cycles, "-");
+        break;
+    case BenchFormat::Csv:
+        if (bytesPerOp)
+            printf("%s,%s,%.4f,%.4f,%.4f\n", group, name, r.ns, r.cycles, gbPerS);
+        else
+            printf("%s,%s,%.4f,%.4f,\n", group, name, r.ns, r.cycles);
+        break;
+    case BenchFormat::Json:
+        if (bytesPerOp)
+            printf("{\"group\":\"%s\",\"name\":\"%s\",\"ns_per_op\":%.4f,\"cycles_per_op\":%.4f,\"gb_per_s\":%.4f}\n", group, name, r.ns, r.cycles, gbPerS);
+        else
+            printf("{\"group\":\"%s\",\"name\":\"%s\",\"ns_per_op\":%.4f,\"cycles_per_op\":%.4f,\"gb_per_s\":null}\n", group, name, r.ns, r.cycles);
+        break;
+    }
+    fflush(stdout);
+}
+
+// Densities, in percent of bits set, that the data-dependent benchmarks sweep.
+static constexpr uint32_t kBenchDensities[] = { 0, 1, 50, 99, 100 };
+
+static inline uint64_t BenchSplitMix64(uint64_t& state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Fill n blocks with each bit set independently with probability densityPercent / 100.
+static inline void FillBenchBlocks(uint64_t* p, uint64_t n, uint32_t densityPercent, uint64_t& state)
+{
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        uint64_t block = 0;
+        if (densityPercent == 50)
+            block = BenchSplitMix64(state);
+        else if (densityPercent >= 100)
+            block = ~0ULL;
+        else if (densityPercent)
+        {
+            for (uint64_t j = 0; j < 64; ++j)
+                block |= uint64_t(BenchSplitMix64(state) % 100 < densityPercent) << j;
+        }
+        p[i] = block;
+    }
+}
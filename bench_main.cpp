@@ -0,0 +1,49 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+// Benchmarks. Build with optimizations, for the target you mean to measure.
+//
+// Usage: bench [--csv | --json] [filter]
+// Runs only the benchmarks whose group or name contains filter, e.g. "CountSetBits" or "/1048576/".
+// --csv and --json print machine-readable results, for regression tracking: CSV with a header line, or one JSON
+// object per line.
+
+#include <cstdio>
+#include <cstring>
+
+#include "bench.h"
+
+extern void BenchBitOps();
+extern void BenchBitArray();
+extern void BenchBitmapAllocator();
+extern void BenchBlockedBloomFilter();
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--csv"))
+            g_benchOptions.format = BenchFormat::Csv;
+        else if (!strcmp(argv[i], "--json"))
+            g_benchOptions.format = BenchFormat::Json;
+        else if (argv[i][0] == '-')
+        {
+            fprintf(stderr, "Usage: %s [--csv | --json] [filter]\n", argv[0]);
+            return 1;
+        }
+        else
+            g_benchOptions.filter = argv[i];
+    }
+
+    PrintBenchHeader();
+    BenchBitOps();
+    BenchBitArray();
+    BenchBitmapAllocator();
+    BenchBlockedBloomFilter();
+}
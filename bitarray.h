@@ -30,88 +30,154 @@
 #define ASSERT(a) do {} while (0)
 #endif
 
+//#define ENABLE_BITARRAY_STATS
+
+// BITARRAY_STATS_SCOPE(name, numBlocks) counts a call of a method that is to scan numBlocks blocks, and
+// BITARRAY_STATS_BLOCKS(n) the blocks it actually scans. BITARRAY_PERF_REGION(name) wraps the rest of the
+// enclosing scope with hardware counters. See bitarraystats.h.
+#if defined(ENABLE_BITARRAY_STATS)
+#ifndef BITARRAY_SKIP_INCLUDES
+#include "bitarraystats.h"
+#endif
+#define BITARRAY_STATS_CONCAT_HELPER(a, b) a##b
+#define BITARRAY_STATS_CONCAT(a, b) BITARRAY_STATS_CONCAT_HELPER(a, b)
+#define BITARRAY_STATS_SCOPE(name, numBlocks) static BitArrayMethodStats s_bitArrayMethodStats(name); BitArrayStatsScope bitArrayStatsScope(s_bitArrayMethodStats, numBlocks)
+#define BITARRAY_STATS_BLOCKS(n) bitArrayStatsScope.AddBlocks(n)
+#define BITARRAY_PERF_REGION(name) static BitArrayPerfRegionStats BITARRAY_STATS_CONCAT(s_bitArrayPerfRegionStats, __LINE__)(name); \
+    const BitArrayPerfRegion BITARRAY_STATS_CONCAT(bitArrayPerfRegion, __LINE__)(BITARRAY_STATS_CONCAT(s_bitArrayPerfRegionStats, __LINE__))
+#else
+#define BITARRAY_STATS_SCOPE(name, numBlocks) do {} while (0)
+#define BITARRAY_STATS_BLOCKS(n) do {} while (0)
+#define BITARRAY_PERF_REGION(name) do {} while (0)
+#endif
+
 #if defined(__clang__) || defined(__GNUC__)
 #define ALWAYS_INLINE __attribute__((always_inline))
 #else
 #define ALWAYS_INLINE __forceinline
 #endif
 
-template <uint64_t kNBits>
-class BitArray
+// The runs of set bits, or of clear bits, of an array, in increasing order, as BitRuns. See BitArray::SetRuns().
+// Each step finds the next run with NextRun_Blocks().
+class BitRunRange
 {
 public:
-    static constexpr uint64_t kNumBits = kNBits;
-    static constexpr uint64_t kNumBlocks = (kNumBits + 63ULL) >> 6ULL;
-
-    // Repeat value into every block.
-    void Rep(uint64_t value)
+    BitRunRange(const uint64_t* blocks, uint64_t numBits, uint64_t flip) : m_block(blocks), m_numBits(numBits), m_flip(flip)
     {
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-            m_block[i] = value;
     }
 
-    // Assign value to all bits.
-    void AssignAll(bool value)
+    class EndIterator
     {
-        Rep(value ? uint64_t(-1) : uint64_t(0));
-    }
+    };
 
-    // Set all bits.
-    void SetAll()
+    class Iterator
     {
-        AssignAll(true);
-    }
+    public:
+        ALWAYS_INLINE Iterator(const uint64_t* v, uint64_t numBits, uint64_t flip) : m_v(v), m_numBits(numBits), m_flip(flip), m_end(0)
+        {
+            m_start = NextRun_Blocks(m_v, m_numBits, 0, m_flip, m_end);
+        }
 
-    // Clear all bits.
-    void ClearAll()
-    {
-        AssignAll(false);
-    }
+        ALWAYS_INLINE BitRun operator*() const
+        {
+            return { m_start, m_end - m_start };
+        }
 
-    // Set a bit.
-    void SetBit(uint64_t index)
-    {
-        ASSERT(index < kNumBits);
-        m_block[index >> 6ULL] |= 1ULL << (index & 63ULL);
-    }
+        ALWAYS_INLINE Iterator& operator++()
+        {
+            m_start = NextRun_Blocks(m_v, m_numBits, m_end, m_flip, m_end);
+            return *this;
+        }
 
-    // Clear a bit.
-    void ClearBit(uint64_t index)
-    {
-        ASSERT(index < kNumBits);
-        m_block[index >> 6ULL] &= ~(1ULL << (index & 63ULL));
-    }
+        ALWAYS_INLINE bool operator==(const Iterator& other) const
+        {
+            return m_start == other.m_start;
+        }
 
-    // Invert a bit.
-    void XorBit(uint64_t index)
+        ALWAYS_INLINE bool operator!=(const Iterator& other) const
+        {
+            return !(*this == other);
+        }
+
+        ALWAYS_INLINE bool operator==(const EndIterator&) const
+        {
+            return m_start >= m_numBits;
+        }
+
+        ALWAYS_INLINE bool operator!=(const EndIterator&) const
+        {
+            return m_start < m_numBits;
+        }
+
+    private:
+        const uint64_t* m_v;
+        uint64_t m_numBits;
+        uint64_t m_flip;
+        uint64_t m_start;
+        uint64_t m_end;
+    };
+
+    ALWAYS_INLINE Iterator begin() const
     {
-        ASSERT(index < kNumBits);
-        m_block[index >> 6ULL] ^= 1ULL << (index & 63ULL);
+        return Iterator(m_block, m_numBits, m_flip);
     }
 
-    // Assign a value to a single bit.
-    void AssignBit(uint64_t index, bool value)
+    ALWAYS_INLINE EndIterator end() const
     {
-        ASSERT(index < kNumBits);
-        m_block[index >> 6ULL] = AssignBit_U64(m_block[index >> 6ULL], index & 63ULL, value);
+        return {};
     }
 
+private:
+    const uint64_t* m_block;
+    uint64_t m_numBits;
+    uint64_t m_flip;
+};
+
+// The queries of BitArray and BasicBitSpan (bitspan.h), written once over the blocks of Derived, which provides
+// Blocks(), NumBits(), and NumBlocks(). BitArray's sizes are compile-time constants, so they fold here as they
+// would in a BitArray method. Bits past NumBits() in the last block are ignored, and the size must be nonzero.
+template <class Derived>
+class BitArrayQueries
+{
+public:
     // Check if a bit is set.
     bool IsBitSet(uint64_t index) const
     {
-        ASSERT(index < kNumBits);
-        return m_block[index >> 6ULL] & (1ULL << (index & 63ULL));
+        ASSERT(index < Self().NumBits());
+        return Self().Blocks()[index >> 6ULL] & (1ULL << (index & 63ULL));
+    }
+
+    // out[i] = 1 if bit idx[i] is set, otherwise 0, for the n indices at idx. Prefetches the blocks of later indices,
+    // so batches of scattered indices run at memory-level parallelism rather than one cache miss at a time.
+    void TestBits(const uint64_t* __restrict idx, uint64_t n, uint8_t* __restrict out) const
+    {
+        for (uint64_t i = 0; i < n; ++i)
+            ASSERT(idx[i] < Self().NumBits());
+        TestBits_Blocks(out, Self().Blocks(), idx, n);
     }
 
     // Return the total number of set bits.
     uint64_t CountSetBits() const
     {
+        const uint64_t* const p = Self().Blocks();
+        const uint64_t numBlocks = Self().NumBlocks();
+
+        BITARRAY_STATS_SCOPE("CountSetBits", numBlocks);
+        BITARRAY_STATS_BLOCKS(numBlocks);
+
         uint64_t count = 0;
 
-        for (uint64_t iBlock = 0; iBlock < kNumBlocks - 1; ++iBlock)
-            count += CountSetBits_U64(m_block[iBlock]);
+        if (numBlocks - 1 >= kMinBlocksForVectorCount)
+        {
+            count = CountSetBits_Blocks(p, numBlocks - 1);
+        }
+        else
+        {
+            for (uint64_t iBlock = 0; iBlock < numBlocks - 1; ++iBlock)
+                count += CountSetBits_U64(p[iBlock]);
+        }
 
-        count += CountSetBits_U64(m_block[kNumBlocks - 1] & LastBlockMask());
+        count += CountSetBits_U64(p[numBlocks - 1] & LastBlockMask());
 
         return count;
     }
@@ -119,13 +185,17 @@ public:
     // Return true if all bits are set.
     bool AreAllBitsSet() const
     {
-        for (uint64_t iBlock = 0; iBlock < kNumBlocks - 1; ++iBlock)
-        {
-            if (~m_block[iBlock])
-                return false;
-        }
+        const uint64_t numBlocks = Self().NumBlocks();
+
+        BITARRAY_STATS_SCOPE("AreAllBitsSet", numBlocks);
 
-        if (~m_block[kNumBlocks - 1] & LastBlockMask())
+        const uint64_t iBlock = FirstBlockNotEqualTo(0, numBlocks - 1, ~0ULL);
+        BITARRAY_STATS_BLOCKS(iBlock < numBlocks - 1 ? iBlock + 1 : iBlock);
+        if (iBlock < numBlocks - 1)
+            return false;
+
+        BITARRAY_STATS_BLOCKS(1);
+        if (~Self().Blocks()[numBlocks - 1] & LastBlockMask())
             return false;
 
         return true;
@@ -134,13 +204,17 @@ public:
     // Return true if all bits are clear.
     bool AreAllBitsClear() const
     {
-        for (uint64_t iBlock = 0; iBlock < kNumBlocks - 1; ++iBlock)
-        {
-            if (m_block[iBlock])
-                return false;
-        }
+        const uint64_t numBlocks = Self().NumBlocks();
 
-        if (m_block[kNumBlocks - 1] & LastBlockMask())
+        BITARRAY_STATS_SCOPE("AreAllBitsClear", numBlocks);
+
+        const uint64_t iBlock = FirstBlockNotEqualTo(0, numBlocks - 1, 0);
+        BITARRAY_STATS_BLOCKS(iBlock < numBlocks - 1 ? iBlock + 1 : iBlock);
+        if (iBlock < numBlocks - 1)
+            return false;
+
+        BITARRAY_STATS_BLOCKS(1);
+        if (Self().Blocks()[numBlocks - 1] & LastBlockMask())
             return false;
 
         return true;
@@ -149,95 +223,65 @@ public:
     // Return the number of set bits between indices [a, b], inclusive.
     uint64_t CountSetBitsInRange(uint64_t a, uint64_t b) const
     {
+        const uint64_t* const p = Self().Blocks();
+
         ASSERT(a <= b);
-        ASSERT(b < kNumBits);
+        ASSERT(b < Self().NumBits());
 
         const uint64_t iBlockA = a >> 6ULL;
         const uint64_t iBlockB = b >> 6ULL;
+        BITARRAY_STATS_SCOPE("CountSetBitsInRange", iBlockB - iBlockA + 1);
+        BITARRAY_STATS_BLOCKS(iBlockB - iBlockA + 1);
 
         if (iBlockA == iBlockB)
-            return CountSetBits_U64(m_block[iBlockA] & SetBitRange_U64(a, b));
-
-        uint64_t count = CountSetBits_U64(m_block[iBlockA] & SetBitRange_U64(a, 63ULL));
-
-        for (uint64_t iBlock = iBlockA + 1; iBlock < iBlockB; ++iBlock)
-            count += CountSetBits_U64(m_block[iBlock]);
-
-        count += CountSetBits_U64(m_block[iBlockB] & SetBitRange_U64(0, b));
+            return CountSetBits_U64(p[iBlockA] & SetBitRange_U64(a, b));
 
-        return count;
-    }
-
-    // Set all bits between indices [a, b], inclusive.
-    void SetBitsInRange(uint64_t a, uint64_t b)
-    {
-        ASSERT(a <= b);
-        ASSERT(b < kNumBits);
+        uint64_t count = CountSetBits_U64(p[iBlockA] & SetBitRange_U64(a, 63ULL));
 
-        const uint64_t iBlockA = a >> 6ULL;
-        const uint64_t iBlockB = b >> 6ULL;
-
-        if (iBlockA == iBlockB)
+        if (Self().NumBlocks() - 1 >= kMinBlocksForVectorCount)
         {
-            m_block[iBlockA] |= SetBitRange_U64(a, b);
+            count += CountSetBits_Blocks(p + iBlockA + 1, iBlockB - iBlockA - 1);
         }
         else
         {
-            m_block[iBlockA] |= SetBitRange_U64(a, 63ULL);
-
             for (uint64_t iBlock = iBlockA + 1; iBlock < iBlockB; ++iBlock)
-                m_block[iBlock] = ~0ULL;
-
-            m_block[iBlockB] |= SetBitRange_U64(0, b);
-        }
-    }
-
-    // Clear all bits between indices [a, b], inclusive.
-    void ClearBitsInRange(uint64_t a, uint64_t b)
-    {
-        ASSERT(a <= b);
-        ASSERT(b < kNumBits);
-
-        const uint64_t iBlockA = a >> 6ULL;
-        const uint64_t iBlockB = b >> 6ULL;
-
-        if (iBlockA == iBlockB)
-        {
-            m_block[iBlockA] &= ~SetBitRange_U64(a, b);
+                count += CountSetBits_U64(p[iBlock]);
         }
-        else
-        {
-            m_block[iBlockA] &= ~SetBitRange_U64(a, 63ULL);
 
-            for (uint64_t iBlock = iBlockA + 1; iBlock < iBlockB; ++iBlock)
-                m_block[iBlock] = 0ULL;
+        count += CountSetBits_U64(p[iBlockB] & SetBitRange_U64(0, b));
 
-            m_block[iBlockB] &= ~SetBitRange_U64(0, b);
-        }
+        return count;
     }
 
     // Return true if all bits are set between indices [a, b], inclusive.
     bool AreAllBitsInRangeSet(uint64_t a, uint64_t b) const
     {
+        const uint64_t* const p = Self().Blocks();
+
         ASSERT(a <= b);
-        ASSERT(b < kNumBits);
+        ASSERT(b < Self().NumBits());
 
         const uint64_t iBlockA = a >> 6ULL;
         const uint64_t iBlockB = b >> 6ULL;
+        BITARRAY_STATS_SCOPE("AreAllBitsInRangeSet", iBlockB - iBlockA + 1);
 
         if (iBlockA == iBlockB)
-            return !(~m_block[iBlockA] & SetBitRange_U64(a, b));
+        {
+            BITARRAY_STATS_BLOCKS(1);
+            return !(~p[iBlockA] & SetBitRange_U64(a, b));
+        }
 
-        if (~m_block[iBlockA] & SetBitRange_U64(a, 63ULL))
+        BITARRAY_STATS_BLOCKS(1);
+        if (~p[iBlockA] & SetBitRange_U64(a, 63ULL))
             return false;
 
-        for (uint64_t iBlock = iBlockA + 1; iBlock < iBlockB; ++iBlock)
-        {
-            if (~m_block[iBlock])
-                return false;
-        }
+        const uint64_t iBlock = FirstBlockNotEqualTo(iBlockA + 1, iBlockB, ~0ULL);
+        BITARRAY_STATS_BLOCKS(iBlock < iBlockB ? iBlock - iBlockA : iBlock - iBlockA - 1);
+        if (iBlock < iBlockB)
+            return false;
 
-        if (~m_block[iBlockB] & SetBitRange_U64(0, b))
+        BITARRAY_STATS_BLOCKS(1);
+        if (~p[iBlockB] & SetBitRange_U64(0, b))
             return false;
 
         return true;
@@ -246,71 +290,94 @@ public:
     // Return true if all bits are clear between indices [a, b], inclusive.
     bool AreAllBitsInRangeClear(uint64_t a, uint64_t b) const
     {
+        const uint64_t* const p = Self().Blocks();
+
         ASSERT(a <= b);
-        ASSERT(b < kNumBits);
+        ASSERT(b < Self().NumBits());
 
         const uint64_t iBlockA = a >> 6ULL;
         const uint64_t iBlockB = b >> 6ULL;
+        BITARRAY_STATS_SCOPE("AreAllBitsInRangeClear", iBlockB - iBlockA + 1);
 
         if (iBlockA == iBlockB)
-            return !(m_block[iBlockA] & SetBitRange_U64(a, b));
+        {
+            BITARRAY_STATS_BLOCKS(1);
+            return !(p[iBlockA] & SetBitRange_U64(a, b));
+        }
 
-        if (m_block[iBlockA] & SetBitRange_U64(a, 63ULL))
+        BITARRAY_STATS_BLOCKS(1);
+        if (p[iBlockA] & SetBitRange_U64(a, 63ULL))
             return false;
 
-        for (uint64_t iBlock = iBlockA + 1; iBlock < iBlockB; ++iBlock)
-        {
-            if (m_block[iBlock])
-                return false;
-        }
+        const uint64_t iBlock = FirstBlockNotEqualTo(iBlockA + 1, iBlockB, 0);
+        BITARRAY_STATS_BLOCKS(iBlock < iBlockB ? iBlock - iBlockA : iBlock - iBlockA - 1);
+        if (iBlock < iBlockB)
+            return false;
 
-        if (m_block[iBlockB] & SetBitRange_U64(0, b))
+        BITARRAY_STATS_BLOCKS(1);
+        if (p[iBlockB] & SetBitRange_U64(0, b))
             return false;
 
         return true;
     }
 
-    // Return the number of leading (last; high index) zeros, or kNumBits if all bits are clear.
+    // Return the number of leading (last; high index) zeros, or NumBits() if all bits are clear.
     uint64_t CountLeadingZeros() const
     {
-        if (const uint64_t block = m_block[kNumBlocks - 1] & LastBlockMask())
-            return (kNumBits - 1) - 63ULL - ((kNumBlocks - 1) << 6ULL) + CountLeadingZeros_U64(block);
+        const uint64_t* const p = Self().Blocks();
+        const uint64_t numBits = Self().NumBits();
+        const uint64_t numBlocks = Self().NumBlocks();
 
-        for (uint64_t i = kNumBlocks - 2; int64_t(i) >= 0; --i)
-        {
-            if (const uint64_t block = m_block[i])
-                return (kNumBits - 1) - 63ULL - (i << 6ULL) + CountLeadingZeros_U64(block);
-        }
+        BITARRAY_STATS_SCOPE("CountLeadingZeros", numBlocks);
 
-        return kNumBits;
+        BITARRAY_STATS_BLOCKS(1);
+        if (const uint64_t block = p[numBlocks - 1] & LastBlockMask())
+            return (numBits - 1) - 63ULL - ((numBlocks - 1) << 6ULL) + CountLeadingZeros_U64(block);
+
+        const uint64_t i = LastBlockNotEqualTo(numBlocks - 1, 0);
+        BITARRAY_STATS_BLOCKS(i != ~0ULL ? numBlocks - 1 - i : numBlocks - 1);
+        if (i != ~0ULL)
+            return (numBits - 1) - 63ULL - (i << 6ULL) + CountLeadingZeros_U64(p[i]);
+
+        return numBits;
     }
 
-    // Return the number of trailing (first; low index) zeros, or kNumBits if all bits are clear.
+    // Return the number of trailing (first; low index) zeros, or NumBits() if all bits are clear.
     uint64_t CountTrailingZeros() const
     {
-        for (uint64_t i = 0; i < kNumBlocks - 1; ++i)
-        {
-            if (const uint64_t block = m_block[i])
-                return (i << 6ULL) + FirstSetBitIndex_U64(block);
-        }
+        const uint64_t* const p = Self().Blocks();
+        const uint64_t numBlocks = Self().NumBlocks();
 
-        if (const uint64_t block = m_block[kNumBlocks - 1] & LastBlockMask())
-            return ((kNumBlocks - 1) << 6ULL) + FirstSetBitIndex_U64(block);
+        BITARRAY_STATS_SCOPE("CountTrailingZeros", numBlocks);
 
-        return kNumBits;
+        const uint64_t i = FirstBlockNotEqualTo(0, numBlocks - 1, 0);
+        BITARRAY_STATS_BLOCKS(i < numBlocks - 1 ? i + 1 : i);
+        if (i < numBlocks - 1)
+            return (i << 6ULL) + FirstSetBitIndex_U64(p[i]);
+
+        BITARRAY_STATS_BLOCKS(1);
+        if (const uint64_t block = p[numBlocks - 1] & LastBlockMask())
+            return ((numBlocks - 1) << 6ULL) + FirstSetBitIndex_U64(block);
+
+        return Self().NumBits();
     }
 
     // Return the index of the first (trailing; lowest index) set bit, or ~0ULL if all bits are clear.
     uint64_t FirstSetBitIndex() const
     {
-        for (uint64_t i = 0; i < kNumBlocks - 1; ++i)
-        {
-            if (const uint64_t block = m_block[i])
-                return (i << 6ULL) + FirstSetBitIndex_U64(block);
-        }
+        const uint64_t* const p = Self().Blocks();
+        const uint64_t numBlocks = Self().NumBlocks();
+
+        BITARRAY_STATS_SCOPE("FirstSetBitIndex", numBlocks);
 
-        if (const uint64_t block = m_block[kNumBlocks - 1] & LastBlockMask())
-            return ((kNumBlocks - 1) << 6ULL) + FirstSetBitIndex_U64(block);
+        const uint64_t i = FirstBlockNotEqualTo(0, numBlocks - 1, 0);
+        BITARRAY_STATS_BLOCKS(i < numBlocks - 1 ? i + 1 : i);
+        if (i < numBlocks - 1)
+            return (i << 6ULL) + FirstSetBitIndex_U64(p[i]);
+
+        BITARRAY_STATS_BLOCKS(1);
+        if (const uint64_t block = p[numBlocks - 1] & LastBlockMask())
+            return ((numBlocks - 1) << 6ULL) + FirstSetBitIndex_U64(block);
 
         return ~0ULL;
     }
@@ -318,14 +385,19 @@ public:
     // Return the index of the first (trailing; lowest index) clear bit, or ~0ULL if all bits are set.
     uint64_t FirstClearBitIndex() const
     {
-        for (uint64_t i = 0; i < kNumBlocks - 1; ++i)
-        {
-            if (const uint64_t block = ~m_block[i])
-                return (i << 6ULL) + FirstSetBitIndex_U64(block);
-        }
+        const uint64_t* const p = Self().Blocks();
+        const uint64_t numBlocks = Self().NumBlocks();
+
+        BITARRAY_STATS_SCOPE("FirstClearBitIndex", numBlocks);
 
-        if (const uint64_t block = ~m_block[kNumBlocks - 1] & LastBlockMask())
-            return ((kNumBlocks - 1) << 6ULL) + FirstSetBitIndex_U64(block);
+        const uint64_t i = FirstBlockNotEqualTo(0, numBlocks - 1, ~0ULL);
+        BITARRAY_STATS_BLOCKS(i < numBlocks - 1 ? i + 1 : i);
+        if (i < numBlocks - 1)
+            return (i << 6ULL) + FirstSetBitIndex_U64(~p[i]);
+
+        BITARRAY_STATS_BLOCKS(1);
+        if (const uint64_t block = ~p[numBlocks - 1] & LastBlockMask())
+            return ((numBlocks - 1) << 6ULL) + FirstSetBitIndex_U64(block);
 
         return ~0ULL;
     }
@@ -333,14 +405,19 @@ public:
     // Return the index of the last (leading; highest index) set bit, or ~0ULL if all bits are clear.
     uint64_t LastSetBitIndex() const
     {
-        if (const uint64_t block = m_block[kNumBlocks - 1] & LastBlockMask())
-            return ((kNumBlocks - 1) << 6ULL) + LastSetBitIndex_U64(block);
+        const uint64_t* const p = Self().Blocks();
+        const uint64_t numBlocks = Self().NumBlocks();
 
-        for (uint64_t i = kNumBlocks - 2; int64_t(i) >= 0; --i)
-        {
-            if (const uint64_t block = m_block[i])
-                return (i << 6ULL) + LastSetBitIndex_U64(block);
-        }
+        BITARRAY_STATS_SCOPE("LastSetBitIndex", numBlocks);
+
+        BITARRAY_STATS_BLOCKS(1);
+        if (const uint64_t block = p[numBlocks - 1] & LastBlockMask())
+            return ((numBlocks - 1) << 6ULL) + LastSetBitIndex_U64(block);
+
+        const uint64_t i = LastBlockNotEqualTo(numBlocks - 1, 0);
+        BITARRAY_STATS_BLOCKS(i != ~0ULL ? numBlocks - 1 - i : numBlocks - 1);
+        if (i != ~0ULL)
+            return (i << 6ULL) + LastSetBitIndex_U64(p[i]);
 
         return ~0ULL;
     }
@@ -348,14 +425,19 @@ public:
     // Return the index of the last (leading; highest index) clear bit, or ~0ULL if all bits are set.
     uint64_t LastClearBitIndex() const
     {
-        if (const uint64_t block = ~m_block[kNumBlocks - 1] & LastBlockMask())
-            return ((kNumBlocks - 1) << 6ULL) + LastSetBitIndex_U64(block);
+        const uint64_t* const p = Self().Blocks();
+        const uint64_t numBlocks = Self().NumBlocks();
 
-        for (uint64_t i = kNumBlocks - 2; int64_t(i) >= 0; --i)
-        {
-            if (const uint64_t block = ~m_block[i])
-                return (i << 6ULL) + LastSetBitIndex_U64(block);
-        }
+        BITARRAY_STATS_SCOPE("LastClearBitIndex", numBlocks);
+
+        BITARRAY_STATS_BLOCKS(1);
+        if (const uint64_t block = ~p[numBlocks - 1] & LastBlockMask())
+            return ((numBlocks - 1) << 6ULL) + LastSetBitIndex_U64(block);
+
+        const uint64_t i = LastBlockNotEqualTo(numBlocks - 1, ~0ULL);
+        BITARRAY_STATS_BLOCKS(i != ~0ULL ? numBlocks - 1 - i : numBlocks - 1);
+        if (i != ~0ULL)
+            return (i << 6ULL) + LastSetBitIndex_U64(~p[i]);
 
         return ~0ULL;
     }
@@ -364,18 +446,21 @@ public:
     // bits before the ith bit.
     uint64_t PrevSetBitIndex(uint64_t i) const
     {
-        ASSERT(i < kNumBits);
+        const uint64_t* const p = Self().Blocks();
+
+        ASSERT(i < Self().NumBits());
 
-        uint64_t iBlock = i >> 6ULL;
+        const uint64_t iBlock = i >> 6ULL;
+        BITARRAY_STATS_SCOPE("PrevSetBitIndex", iBlock + 1);
 
-        if (const uint64_t block = m_block[iBlock] & ((1ULL << (i & 63ULL)) - 1ULL))
+        BITARRAY_STATS_BLOCKS(1);
+        if (const uint64_t block = p[iBlock] & ((1ULL << (i & 63ULL)) - 1ULL))
             return (iBlock << 6ULL) + LastSetBitIndex_U64(block);
 
-        for (--iBlock; int64_t(iBlock) >= 0; --iBlock)
-        {
-            if (const uint64_t block = m_block[iBlock])
-                return (iBlock << 6ULL) + LastSetBitIndex_U64(block);
-        }
+        const uint64_t iPrev = LastBlockNotEqualTo(iBlock, 0);
+        BITARRAY_STATS_BLOCKS(iPrev != ~0ULL ? iBlock - iPrev : iBlock);
+        if (iPrev != ~0ULL)
+            return (iPrev << 6ULL) + LastSetBitIndex_U64(p[iPrev]);
 
         return ~0ULL;
     }
@@ -384,18 +469,21 @@ public:
     // bits before the ith bit.
     uint64_t PrevClearBitIndex(uint64_t i) const
     {
-        ASSERT(i < kNumBits);
+        const uint64_t* const p = Self().Blocks();
 
-        uint64_t iBlock = i >> 6ULL;
+        ASSERT(i < Self().NumBits());
 
-        if (const uint64_t block = ~m_block[iBlock] & ((1ULL << (i & 63ULL)) - 1ULL))
+        const uint64_t iBlock = i >> 6ULL;
+        BITARRAY_STATS_SCOPE("PrevClearBitIndex", iBlock + 1);
+
+        BITARRAY_STATS_BLOCKS(1);
+        if (const uint64_t block = ~p[iBlock] & ((1ULL << (i & 63ULL)) - 1ULL))
             return (iBlock << 6ULL) + LastSetBitIndex_U64(block);
 
-        for (--iBlock; int64_t(iBlock) >= 0; --iBlock)
-        {
-            if (const uint64_t block = ~m_block[iBlock])
-                return (iBlock << 6ULL) + LastSetBitIndex_U64(block);
-        }
+        const uint64_t iPrev = LastBlockNotEqualTo(iBlock, ~0ULL);
+        BITARRAY_STATS_BLOCKS(iPrev != ~0ULL ? iBlock - iPrev : iBlock);
+        if (iPrev != ~0ULL)
+            return (iPrev << 6ULL) + LastSetBitIndex_U64(~p[iPrev]);
 
         return ~0ULL;
     }
@@ -404,28 +492,34 @@ public:
     // bits after the ith bit.
     uint64_t NextSetBitIndex(uint64_t i) const
     {
-        ASSERT(i < kNumBits);
+        const uint64_t* const p = Self().Blocks();
+        const uint64_t numBlocks = Self().NumBlocks();
+
+        ASSERT(i < Self().NumBits());
 
-        uint64_t iBlock = i >> 6ULL;
+        const uint64_t iBlock = i >> 6ULL;
+        BITARRAY_STATS_SCOPE("NextSetBitIndex", numBlocks - iBlock);
 
-        if (iBlock == kNumBlocks - 1)
+        if (iBlock == numBlocks - 1)
         {
-            if (const uint64_t block = m_block[kNumBlocks - 1] & ((~1ULL) << (i & 63ULL)) & LastBlockMask())
-                return ((kNumBlocks - 1) << 6ULL) + FirstSetBitIndex_U64(block);
+            BITARRAY_STATS_BLOCKS(1);
+            if (const uint64_t block = p[numBlocks - 1] & ((~1ULL) << (i & 63ULL)) & LastBlockMask())
+                return ((numBlocks - 1) << 6ULL) + FirstSetBitIndex_U64(block);
         }
         else
         {
-            if (const uint64_t block = m_block[iBlock] & ((~1ULL) << (i & 63ULL)))
+            BITARRAY_STATS_BLOCKS(1);
+            if (const uint64_t block = p[iBlock] & ((~1ULL) << (i & 63ULL)))
                 return (iBlock << 6ULL) + FirstSetBitIndex_U64(block);
 
-            for (++iBlock; iBlock < kNumBlocks - 1; ++iBlock)
-            {
-                if (const uint64_t block = m_block[iBlock])
-                    return (iBlock << 6ULL) + FirstSetBitIndex_U64(block);
-            }
+            const uint64_t iNext = FirstBlockNotEqualTo(iBlock + 1, numBlocks - 1, 0);
+            BITARRAY_STATS_BLOCKS(iNext < numBlocks - 1 ? iNext - iBlock : iNext - iBlock - 1);
+            if (iNext < numBlocks - 1)
+                return (iNext << 6ULL) + FirstSetBitIndex_U64(p[iNext]);
 
-            if (const uint64_t block = m_block[kNumBlocks - 1] & LastBlockMask())
-                return ((kNumBlocks - 1) << 6ULL) + FirstSetBitIndex_U64(block);
+            BITARRAY_STATS_BLOCKS(1);
+            if (const uint64_t block = p[numBlocks - 1] & LastBlockMask())
+                return ((numBlocks - 1) << 6ULL) + FirstSetBitIndex_U64(block);
         }
 
         return ~0ULL;
@@ -435,28 +529,34 @@ public:
     // bits after the ith bit.
     uint64_t NextClearBitIndex(uint64_t i) const
     {
-        ASSERT(i < kNumBits);
+        const uint64_t* const p = Self().Blocks();
+        const uint64_t numBlocks = Self().NumBlocks();
 
-        uint64_t iBlock = i >> 6ULL;
+        ASSERT(i < Self().NumBits());
 
-        if (iBlock == kNumBlocks - 1)
+        const uint64_t iBlock = i >> 6ULL;
+        BITARRAY_STATS_SCOPE("NextClearBitIndex", numBlocks - iBlock);
+
+        if (iBlock == numBlocks - 1)
         {
-            if (const uint64_t block = ~m_block[kNumBlocks - 1] & ((~1ULL) << (i & 63ULL)) & LastBlockMask())
-                return ((kNumBlocks - 1) << 6ULL) + FirstSetBitIndex_U64(block);
+            BITARRAY_STATS_BLOCKS(1);
+            if (const uint64_t block = ~p[numBlocks - 1] & ((~1ULL) << (i & 63ULL)) & LastBlockMask())
+                return ((numBlocks - 1) << 6ULL) + FirstSetBitIndex_U64(block);
         }
         else
         {
-            if (const uint64_t block = ~m_block[iBlock] & ((~1ULL) << (i & 63ULL)))
+            BITARRAY_STATS_BLOCKS(1);
+            if (const uint64_t block = ~p[iBlock] & ((~1ULL) << (i & 63ULL)))
                 return (iBlock << 6ULL) + FirstSetBitIndex_U64(block);
 
-            for (++iBlock; iBlock < kNumBlocks - 1; ++iBlock)
-            {
-                if (const uint64_t block = ~m_block[iBlock])
-                    return (iBlock << 6ULL) + FirstSetBitIndex_U64(block);
-            }
+            const uint64_t iNext = FirstBlockNotEqualTo(iBlock + 1, numBlocks - 1, ~0ULL);
+            BITARRAY_STATS_BLOCKS(iNext < numBlocks - 1 ? iNext - iBlock : iNext - iBlock - 1);
+            if (iNext < numBlocks - 1)
+                return (iNext << 6ULL) + FirstSetBitIndex_U64(~p[iNext]);
 
-            if (const uint64_t block = ~m_block[kNumBlocks - 1] & LastBlockMask())
-                return ((kNumBlocks - 1) << 6ULL) + FirstSetBitIndex_U64(block);
+            BITARRAY_STATS_BLOCKS(1);
+            if (const uint64_t block = ~p[numBlocks - 1] & LastBlockMask())
+                return ((numBlocks - 1) << 6ULL) + FirstSetBitIndex_U64(block);
         }
 
         return ~0ULL;
@@ -465,16 +565,23 @@ public:
     // Return the index of the nth set bit, where n starts at 0, or ~0ULL if there are n or fewer set bits.
     uint64_t NthSetBitIndex(uint64_t n) const
     {
-        for (uint64_t iBlock = 0; iBlock < kNumBlocks - 1; ++iBlock)
+        const uint64_t* const p = Self().Blocks();
+        const uint64_t numBlocks = Self().NumBlocks();
+
+        BITARRAY_STATS_SCOPE("NthSetBitIndex", numBlocks);
+
+        for (uint64_t iBlock = 0; iBlock < numBlocks - 1; ++iBlock)
         {
+            BITARRAY_STATS_BLOCKS(1);
             uint64_t iBit;
-            if (NthBitHelper(iBit, n, iBlock, m_block[iBlock]))
+            if (NthBitHelper(iBit, n, iBlock, p[iBlock]))
                 return iBit;
         }
 
         {
             uint64_t iBit;
-            if (NthBitHelper(iBit, n, kNumBlocks - 1, m_block[kNumBlocks - 1] & LastBlockMask()))
+            BITARRAY_STATS_BLOCKS(1);
+            if (NthBitHelper(iBit, n, numBlocks - 1, p[numBlocks - 1] & LastBlockMask()))
                 return iBit;
         }
 
@@ -484,16 +591,23 @@ public:
     // Return the index of the nth clear bit, where n starts at 0, or ~0ULL if there are n or fewer set bits.
     uint64_t NthClearBitIndex(uint64_t n) const
     {
-        for (uint64_t iBlock = 0; iBlock < kNumBlocks - 1; ++iBlock)
+        const uint64_t* const p = Self().Blocks();
+        const uint64_t numBlocks = Self().NumBlocks();
+
+        BITARRAY_STATS_SCOPE("NthClearBitIndex", numBlocks);
+
+        for (uint64_t iBlock = 0; iBlock < numBlocks - 1; ++iBlock)
         {
+            BITARRAY_STATS_BLOCKS(1);
             uint64_t iBit;
-            if (NthBitHelper(iBit, n, iBlock, ~m_block[iBlock]))
+            if (NthBitHelper(iBit, n, iBlock, ~p[iBlock]))
                 return iBit;
         }
 
         {
             uint64_t iBit;
-            if (NthBitHelper(iBit, n, kNumBlocks - 1, ~m_block[kNumBlocks - 1] & LastBlockMask()))
+            BITARRAY_STATS_BLOCKS(1);
+            if (NthBitHelper(iBit, n, numBlocks - 1, ~p[numBlocks - 1] & LastBlockMask()))
                 return iBit;
         }
 
@@ -503,16 +617,22 @@ public:
     // Return the index of the start of the first block of n consecutive set bits, or ~0ULL if there is no such block.
     uint64_t FirstBlockOfNSetBits(uint64_t n) const
     {
+        const uint64_t* const p = Self().Blocks();
+        const uint64_t numBlocks = Self().NumBlocks();
+
         ASSERT(n != 0);
+        BITARRAY_STATS_SCOPE("FirstBlockOfNSetBits", numBlocks);
 
         uint64_t iBit = 0;
-        for (uint64_t iBlock = 0; iBlock < kNumBlocks - 1; ++iBlock)
+        for (uint64_t iBlock = 0; iBlock < numBlocks - 1; ++iBlock)
         {
-            if (FirstBlockOfNBitsHelper(iBit, n, iBlock, ~m_block[iBlock]))
+            BITARRAY_STATS_BLOCKS(1);
+            if (FirstBlockOfNBitsHelper(iBit, n, iBlock, ~p[iBlock]))
                 return iBit;
         }
 
-        if (FirstBlockOfNBitsHelper(iBit, n, kNumBlocks - 1, ~(m_block[kNumBlocks - 1] & LastBlockMask())))
+        BITARRAY_STATS_BLOCKS(1);
+        if (FirstBlockOfNBitsHelper(iBit, n, numBlocks - 1, ~(p[numBlocks - 1] & LastBlockMask())))
             return iBit;
 
         return ~0ULL;
@@ -522,20 +642,26 @@ public:
     // or ~0ULL if there is no such block.
     uint64_t FirstAlignedBlockOfNSetBits(uint64_t n, uint64_t alignment) const
     {
+        const uint64_t* const p = Self().Blocks();
+        const uint64_t numBlocks = Self().NumBlocks();
+
         ASSERT(n);
         ASSERT(IsPowerOf2AndNotZero_U64(alignment));
+        BITARRAY_STATS_SCOPE("FirstAlignedBlockOfNSetBits", numBlocks);
 
         if (alignment >= 64ULL)
         {
             const uint64_t alignMask = alignment - 1ULL;
             uint64_t iBit = 0;
-            for (uint64_t iBlock = 0; iBlock < kNumBlocks - 1; ++iBlock)
+            for (uint64_t iBlock = 0; iBlock < numBlocks - 1; ++iBlock)
             {
-                if (FirstHighAlignedBlockOfNBitsHelper(iBit, alignMask, n, iBlock, ~m_block[iBlock]))
+                BITARRAY_STATS_BLOCKS(1);
+                if (FirstHighAlignedBlockOfNBitsHelper(iBit, alignMask, n, iBlock, ~p[iBlock]))
                     return iBit;
             }
 
-            if (FirstHighAlignedBlockOfNBitsHelper(iBit, alignMask, n, kNumBlocks - 1, ~(m_block[kNumBlocks - 1] & LastBlockMask())))
+            BITARRAY_STATS_BLOCKS(1);
+            if (FirstHighAlignedBlockOfNBitsHelper(iBit, alignMask, n, numBlocks - 1, ~(p[numBlocks - 1] & LastBlockMask())))
                 return iBit;
         }
         else
@@ -544,13 +670,15 @@ public:
             const uint64_t alignMask = ~(alignment - 1ULL);
 
             uint64_t iBit = 0;
-            for (uint64_t iBlock = 0; iBlock < kNumBlocks - 1; ++iBlock)
+            for (uint64_t iBlock = 0; iBlock < numBlocks - 1; ++iBlock)
             {
-                if (FirstLowAlignedBlockOfNBitsHelper(iBit, alignMask, validBits, n, iBlock, ~m_block[iBlock]))
+                BITARRAY_STATS_BLOCKS(1);
+                if (FirstLowAlignedBlockOfNBitsHelper(iBit, alignMask, validBits, n, iBlock, ~p[iBlock]))
                     return iBit;
             }
 
-            if (FirstLowAlignedBlockOfNBitsHelper(iBit, alignMask, validBits, n, kNumBlocks - 1, ~(m_block[kNumBlocks - 1] & LastBlockMask())))
+            BITARRAY_STATS_BLOCKS(1);
+            if (FirstLowAlignedBlockOfNBitsHelper(iBit, alignMask, validBits, n, numBlocks - 1, ~(p[numBlocks - 1] & LastBlockMask())))
                 return iBit;
         }
 
@@ -560,16 +688,22 @@ public:
     // Return the index of the start of the first block of n consecutive clear bits, or ~0ULL if there is no such block.
     uint64_t FirstBlockOfNClearBits(uint64_t n) const
     {
+        const uint64_t* const p = Self().Blocks();
+        const uint64_t numBlocks = Self().NumBlocks();
+
         ASSERT(n != 0);
+        BITARRAY_STATS_SCOPE("FirstBlockOfNClearBits", numBlocks);
 
         uint64_t iBit = 0;
-        for (uint64_t iBlock = 0; iBlock < kNumBlocks - 1; ++iBlock)
+        for (uint64_t iBlock = 0; iBlock < numBlocks - 1; ++iBlock)
         {
-            if (FirstBlockOfNBitsHelper(iBit, n, iBlock, m_block[iBlock]))
+            BITARRAY_STATS_BLOCKS(1);
+            if (FirstBlockOfNBitsHelper(iBit, n, iBlock, p[iBlock]))
                 return iBit;
         }
 
-        if (FirstBlockOfNBitsHelper(iBit, n, kNumBlocks - 1, m_block[kNumBlocks - 1] | ~LastBlockMask()))
+        BITARRAY_STATS_BLOCKS(1);
+        if (FirstBlockOfNBitsHelper(iBit, n, numBlocks - 1, p[numBlocks - 1] | ~LastBlockMask()))
             return iBit;
 
         return ~0ULL;
@@ -579,20 +713,26 @@ public:
     // or ~0ULL if there is no such block.
     uint64_t FirstAlignedBlockOfNClearBits(uint64_t n, uint64_t alignment) const
     {
+        const uint64_t* const p = Self().Blocks();
+        const uint64_t numBlocks = Self().NumBlocks();
+
         ASSERT(n);
         ASSERT(IsPowerOf2AndNotZero_U64(alignment));
+        BITARRAY_STATS_SCOPE("FirstAlignedBlockOfNClearBits", numBlocks);
 
         if (alignment >= 64ULL)
         {
             const uint64_t alignMask = alignment - 1ULL;
             uint64_t iBit = 0;
-            for (uint64_t iBlock = 0; iBlock < kNumBlocks - 1; ++iBlock)
+            for (uint64_t iBlock = 0; iBlock < numBlocks - 1; ++iBlock)
             {
-                if (FirstHighAlignedBlockOfNBitsHelper(iBit, alignMask, n, iBlock, m_block[iBlock]))
+                BITARRAY_STATS_BLOCKS(1);
+                if (FirstHighAlignedBlockOfNBitsHelper(iBit, alignMask, n, iBlock, p[iBlock]))
                     return iBit;
             }
 
-            if (FirstHighAlignedBlockOfNBitsHelper(iBit, alignMask, n, kNumBlocks - 1, m_block[kNumBlocks - 1] | ~LastBlockMask()))
+            BITARRAY_STATS_BLOCKS(1);
+            if (FirstHighAlignedBlockOfNBitsHelper(iBit, alignMask, n, numBlocks - 1, p[numBlocks - 1] | ~LastBlockMask()))
                 return iBit;
         }
         else
@@ -601,269 +741,575 @@ public:
             const uint64_t alignMask = ~(alignment - 1ULL);
 
             uint64_t iBit = 0;
-            for (uint64_t iBlock = 0; iBlock < kNumBlocks - 1; ++iBlock)
+            for (uint64_t iBlock = 0; iBlock < numBlocks - 1; ++iBlock)
             {
-                if (FirstLowAlignedBlockOfNBitsHelper(iBit, alignMask, validBits, n, iBlock, m_block[iBlock]))
+                BITARRAY_STATS_BLOCKS(1);
+                if (FirstLowAlignedBlockOfNBitsHelper(iBit, alignMask, validBits, n, iBlock, p[iBlock]))
                     return iBit;
             }
 
-            if (FirstLowAlignedBlockOfNBitsHelper(iBit, alignMask, validBits, n, kNumBlocks - 1, m_block[kNumBlocks - 1] | ~LastBlockMask()))
+            BITARRAY_STATS_BLOCKS(1);
+            if (FirstLowAlignedBlockOfNBitsHelper(iBit, alignMask, validBits, n, numBlocks - 1, p[numBlocks - 1] | ~LastBlockMask()))
                 return iBit;
         }
 
         return ~0ULL;
     }
 
-    // Mask of the valid (in-use) bits of the last block.
-    static constexpr uint64_t LastBlockMask()
+    // Return the index of the start of the shortest run of clear bits holding n consecutive clear bits, or ~0ULL if
+    // there is no such run. Ties go to the lowest index. Unlike FirstBlockOfNClearBits(), this leaves the longer
+    // runs whole for later, larger requests.
+    uint64_t BestFitBlockOfNClearBits(uint64_t n) const
     {
-        return ~0ULL >> (-kNumBits & 63ULL);
+        ASSERT(n != 0);
+        return BestFitRun_Blocks(Self().Blocks(), Self().NumBits(), n, 1ULL, ~0ULL);
     }
 
-    void operator|=(const BitArray<kNumBits>& __restrict other)
+    // Return the index of the first bit aligned to alignment that starts n consecutive clear bits within the
+    // shortest run of clear bits holding such a block, or ~0ULL if there is no such block. Ties go to the lowest index.
+    uint64_t BestFitAlignedBlockOfNClearBits(uint64_t n, uint64_t alignment) const
     {
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            m_block[i] |= other.m_block[i];
-        }
+        ASSERT(n);
+        ASSERT(IsPowerOf2AndNotZero_U64(alignment));
+        return BestFitRun_Blocks(Self().Blocks(), Self().NumBits(), n, alignment, ~0ULL);
     }
 
-    void OrNot(const BitArray<kNumBits>& __restrict other)
+    // Return the longest run of clear bits, the lowest-index one if there is a tie, or { ~0ULL, 0 } if all bits are
+    // set. See ExtentBitArray (extentbitarray.h) to answer this in O(1) as the array changes.
+    BitRun LargestClearRun() const
     {
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            m_block[i] |= ~other.m_block[i];
-        }
+        BITARRAY_STATS_SCOPE("LargestClearRun", Self().NumBlocks());
+        BITARRAY_STATS_BLOCKS(Self().NumBlocks());
+        return LargestRun_Blocks(Self().Blocks(), Self().NumBits(), ~0ULL);
     }
 
-    void NotOr(const BitArray<kNumBits>& __restrict other)
+    // Iterate the runs of consecutive set bits, in increasing order, as BitRuns: for (const BitRun r : v.SetRuns()).
+    // Each step skips a whole run, rather than visiting its bits one at a time.
+    BitRunRange SetRuns() const
     {
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            m_block[i] = ~m_block[i] | other.m_block[i];
-        }
+        return BitRunRange(Self().Blocks(), Self().NumBits(), 0ULL);
     }
 
-    void NotOrNot(const BitArray<kNumBits>& __restrict other)
+    // Iterate the runs of consecutive clear bits, in increasing order, as BitRuns.
+    BitRunRange ClearRuns() const
     {
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            m_block[i] = ~m_block[i] | ~other.m_block[i];
-        }
+        return BitRunRange(Self().Blocks(), Self().NumBits(), ~0ULL);
     }
 
-    void operator^=(const BitArray<kNumBits>& __restrict other)
+    // Write each run of consecutive set bits to out, in increasing order: the same runs as SetRuns(), in one pass.
+    // out must have room for one entry per run; (NumBits() + 1) / 2 always suffices. Return the number of entries written.
+    uint64_t EncodeRuns(BitRun* __restrict out) const
     {
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            m_block[i] ^= other.m_block[i];
-        }
+        return EncodeRuns_Blocks(out, Self().Blocks(), Self().NumBits(), 0ULL);
     }
 
-    void XorNot(const BitArray<kNumBits>& __restrict other)
+    // Write each run of consecutive clear bits to out, in increasing order: the same runs as ClearRuns(), in one pass.
+    // out must have room for one entry per run; (NumBits() + 1) / 2 always suffices. Return the number of entries written.
+    uint64_t EncodeClearRuns(BitRun* __restrict out) const
     {
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            m_block[i] ^= ~other.m_block[i];
-        }
+        return EncodeRuns_Blocks(out, Self().Blocks(), Self().NumBits(), ~0ULL);
     }
 
-    void NotXor(const BitArray<kNumBits>& __restrict other)
+    // Mask of the valid (in-use) bits of the last block.
+    uint64_t LastBlockMask() const
     {
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            m_block[i] = ~m_block[i] ^ other.m_block[i];
-        }
+        return ~0ULL >> ((0ULL - Self().NumBits()) & 63ULL);
     }
 
-    void NotXorNot(const BitArray<kNumBits>& __restrict other)
+protected:
+    // Arrays with at least this many full blocks count bits with the vectorized kernel;
+    // below it the setup and reduction cost more than the scalar popcnt loop.
+    static constexpr uint64_t kMinBlocksForVectorCount = 64;
+
+    // Arrays with at least this many full blocks compare and scan blocks with the vectorized kernels, which test
+    // 4 cache lines per branch; below it the scalar loop exits as early for less setup.
+    static constexpr uint64_t kMinBlocksForVectorScan = 8;
+
+    // Blocks decoded per ForEachSetBitBatch() batch, bounding its stack buffer to 8 KB.
+    static constexpr uint64_t kDecodeBatchBlocks = 32;
+
+    // Return true if the bits equal those of other, blocks of the same size. Bits past NumBits() are ignored.
+    bool AreBlocksEqual(const uint64_t* __restrict other) const
     {
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
+        const uint64_t* const p = Self().Blocks();
+        const uint64_t numBlocks = Self().NumBlocks();
+
+        BITARRAY_STATS_SCOPE("operator==", numBlocks);
+
+        uint64_t iBlock = 0;
+        if (numBlocks - 1 >= kMinBlocksForVectorScan)
         {
-            m_block[i] = ~m_block[i] ^ ~other.m_block[i];
+            iBlock = FirstUnequalBlock_Blocks(p, other, numBlocks - 1);
+        }
+        else
+        {
+            while (iBlock < numBlocks - 1 && p[iBlock] == other[iBlock])
+                ++iBlock;
         }
-    }
 
-    void operator&=(const BitArray<kNumBits>& __restrict other)
+        BITARRAY_STATS_BLOCKS(iBlock < numBlocks - 1 ? iBlock + 1 : iBlock);
+        if (iBlock < numBlocks - 1)
+            return false;
+
+        BITARRAY_STATS_BLOCKS(1);
+        if ((p[numBlocks - 1] & LastBlockMask()) != (other[numBlocks - 1] & LastBlockMask()))
+            return false;
+
+        return true;
+    }
+
+    // Decode the set bits of the n blocks starting at iBlock into out, masking the last block if it is among them.
+    uint64_t DecodeSetBitsHelper(uint32_t* __restrict out, uint64_t iBlock, uint64_t n) const
     {
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
+        const uint64_t* const p = Self().Blocks();
+        const uint64_t numBlocks = Self().NumBlocks();
+
+        if (iBlock + n < numBlocks)
+            return DecodeSetBits_Blocks(out, p + iBlock, n, uint32_t(iBlock << 6ULL));
+
+        const uint64_t count = DecodeSetBits_Blocks(out, p + iBlock, n - 1, uint32_t(iBlock << 6ULL));
+        const uint64_t lastBlock = p[numBlocks - 1] & LastBlockMask();
+        return count + DecodeSetBits_Blocks(out + count, &lastBlock, 1, uint32_t((numBlocks - 1) << 6ULL));
+    }
+
+    // Return the index of the first block in [iBlockA, iBlockB) that is not x, or iBlockB if there is none.
+    uint64_t FirstBlockNotEqualTo(uint64_t iBlockA, uint64_t iBlockB, uint64_t x) const
+    {
+        const uint64_t* const p = Self().Blocks();
+
+        if (Self().NumBlocks() - 1 >= kMinBlocksForVectorScan)
+            return iBlockA + FirstBlockNotEqualTo_Blocks(p + iBlockA, iBlockB - iBlockA, x);
+
+        uint64_t iBlock = iBlockA;
+        while (iBlock < iBlockB && p[iBlock] == x)
+            ++iBlock;
+        return iBlock;
+    }
+
+    // Return the index of the last of the first n blocks that is not x, or ~0ULL if there is none.
+    uint64_t LastBlockNotEqualTo(uint64_t n, uint64_t x) const
+    {
+        const uint64_t* const p = Self().Blocks();
+
+        if (Self().NumBlocks() - 1 >= kMinBlocksForVectorScan)
+            return LastBlockNotEqualTo_Blocks(p, n, x);
+
+        uint64_t iBlock = n;
+        while (iBlock && p[iBlock - 1] == x)
+            --iBlock;
+        return iBlock - 1;
+    }
+
+    static uint64_t AlignmentMask(uint64_t alignment)
+    {
+        uint64_t ret = 0xFFFFFFFFFFFFFFFFULL;
+        if (alignment == 2)
+            ret = 0x5555555555555555ULL;
+        if (alignment == 4)
+            ret = 0x1111111111111111ULL;
+        if (alignment == 8)
+            ret = 0x0101010101010101ULL;
+        if (alignment == 16)
+            ret = 0x0001000100010001ULL;
+        if (alignment == 32)
+            ret = 0x0000000100000001ULL;
+        return ret;
+    }
+
+    static bool NthBitHelper(uint64_t& iBit, uint64_t& n, uint64_t iBlock, uint64_t block)
+    {
+        const uint64_t set = CountSetBits_U64(block);
+        if (set > n)
         {
-            m_block[i] &= other.m_block[i];
+            iBit = (iBlock << 6ULL) + NthSetBitIndex_U64(block, uint32_t(n));
+            return true;
         }
+
+        n -= set;
+
+        return false;
     }
 
-    void AndNot(const BitArray<kNumBits>& __restrict other)
+    static bool FirstBlockOfNBitsHelper(uint64_t& iStart, uint64_t n, uint64_t iBlock, uint64_t block)
     {
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
+        const uint64_t iBit = iBlock << 6ULL;
+        const uint64_t blockStartRun = CountTrailingZeros_U64(block);
+
+        if (iBit + blockStartRun >= iStart + n)
+            return true;
+
+        const uint64_t blockEndRun = CountLeadingZeros_U64(block);
+
+        if (int64_t(62ULL - blockStartRun - blockEndRun) >= int64_t(n))
         {
-            m_block[i] &= ~other.m_block[i];
+            const uint64_t blockMidRun = FirstNClearBitsIndex_U64(block, uint32_t(n));
+            if (blockMidRun < 64ULL)
+            {
+                iStart = iBit + blockMidRun;
+                return true;
+            }
         }
+
+        const uint64_t iCandidateStart = iBit + 64ULL - blockEndRun;
+        if (blockEndRun < 64ULL)
+            iStart = iCandidateStart;
+
+        return blockEndRun >= n;
     }
 
-    void NotAnd(const BitArray<kNumBits>& __restrict other)
+    static bool FirstHighAlignedBlockOfNBitsHelper(uint64_t& iStart, uint64_t alignMask, uint64_t n, uint64_t iBlock, uint64_t block)
     {
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
+        const uint64_t iBit = iBlock << 6ULL;
+        const uint64_t blockStartRun = CountTrailingZeros_U64(block);
+        if (iBit + blockStartRun >= iStart + n)
+            return true;
+        const uint64_t iCandidateStart = (iBit + 64ULL + alignMask) & ~alignMask;
+        if (blockStartRun < 64ULL)
+            iStart = iCandidateStart;
+        return false;
+    }
+
+    static bool FirstLowAlignedBlockOfNBitsHelper(uint64_t& iStart, uint64_t alignMask, uint64_t validBits, uint64_t n, uint64_t iBlock, uint64_t block)
+    {
+        const uint64_t iBit = iBlock << 6ULL;
+        const uint64_t blockStartRun = CountTrailingZeros_U64(block);
+        if (iBit + blockStartRun >= iStart + n)
+            return true;
+        const uint64_t blockEndRun = CountLeadingZeros_U64(block);
+
+        if (int64_t(62ULL - blockStartRun - blockEndRun) >= int64_t(n))
         {
-            m_block[i] = ~m_block[i] & other.m_block[i];
+            const uint64_t blockMidRun = FirstNClearBitsIndex_U64(block, uint32_t(n), validBits);
+            if (blockMidRun < 64ULL)
+            {
+                iStart = iBit + blockMidRun;
+                return true;
+            }
         }
+
+        const uint64_t alignedBlockEndRun = blockEndRun & alignMask;
+        const uint64_t iCandidateStart = iBit + 64ULL - alignedBlockEndRun;
+        if (alignedBlockEndRun < 64ULL)
+            iStart = iCandidateStart;
+
+        return alignedBlockEndRun >= n;
     }
 
-    void NotAndNot(const BitArray<kNumBits>& __restrict other)
+private:
+    const Derived& Self() const
+    {
+        return static_cast<const Derived&>(*this);
+    }
+};
+
+template <uint64_t kNBits>
+class BitArray : public BitArrayQueries<BitArray<kNBits>>
+{
+public:
+    static constexpr uint64_t kNumBits = kNBits;
+    static constexpr uint64_t kNumBlocks = (kNumBits + 63ULL) >> 6ULL;
+
+    // Return the number of bits.
+    static constexpr uint64_t NumBits()
+    {
+        return kNumBits;
+    }
+
+    // Return the number of 64-bit blocks.
+    static constexpr uint64_t NumBlocks()
+    {
+        return kNumBlocks;
+    }
+
+    // Repeat value into every block.
+    void Rep(uint64_t value)
     {
         for (uint64_t i = 0; i < kNumBlocks; ++i)
+            m_block[i] = value;
+    }
+
+    // Assign value to all bits.
+    void AssignAll(bool value)
+    {
+        Rep(value ? uint64_t(-1) : uint64_t(0));
+    }
+
+    // Set all bits.
+    void SetAll()
+    {
+        AssignAll(true);
+    }
+
+    // Clear all bits.
+    void ClearAll()
+    {
+        AssignAll(false);
+    }
+
+    // Set a bit.
+    void SetBit(uint64_t index)
+    {
+        ASSERT(index < kNumBits);
+        m_block[index >> 6ULL] |= 1ULL << (index & 63ULL);
+    }
+
+    // Clear a bit.
+    void ClearBit(uint64_t index)
+    {
+        ASSERT(index < kNumBits);
+        m_block[index >> 6ULL] &= ~(1ULL << (index & 63ULL));
+    }
+
+    // Invert a bit.
+    void XorBit(uint64_t index)
+    {
+        ASSERT(index < kNumBits);
+        m_block[index >> 6ULL] ^= 1ULL << (index & 63ULL);
+    }
+
+    // Assign a value to a single bit.
+    void AssignBit(uint64_t index, bool value)
+    {
+        ASSERT(index < kNumBits);
+        m_block[index >> 6ULL] = AssignBit_U64(m_block[index >> 6ULL], index & 63ULL, value);
+    }
+
+    // Set bit idx[i] for each of the n indices at idx, with prefetching like TestBits().
+    void SetBits(const uint64_t* idx, uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; ++i)
+            ASSERT(idx[i] < kNumBits);
+        SetBits_Blocks(m_block, idx, n);
+    }
+
+    // Clear bit idx[i] for each of the n indices at idx, with prefetching like TestBits().
+    void ClearBits(const uint64_t* idx, uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; ++i)
+            ASSERT(idx[i] < kNumBits);
+        ClearBits_Blocks(m_block, idx, n);
+    }
+
+    // Set all bits between indices [a, b], inclusive.
+    void SetBitsInRange(uint64_t a, uint64_t b)
+    {
+        ASSERT(a <= b);
+        ASSERT(b < kNumBits);
+
+        const uint64_t iBlockA = a >> 6ULL;
+        const uint64_t iBlockB = b >> 6ULL;
+
+        if (iBlockA == iBlockB)
         {
-            m_block[i] = ~m_block[i] & ~other.m_block[i];
+            m_block[iBlockA] |= SetBitRange_U64(a, b);
+        }
+        else
+        {
+            m_block[iBlockA] |= SetBitRange_U64(a, 63ULL);
+
+            for (uint64_t iBlock = iBlockA + 1; iBlock < iBlockB; ++iBlock)
+                m_block[iBlock] = ~0ULL;
+
+            m_block[iBlockB] |= SetBitRange_U64(0, b);
         }
     }
 
-    void Invert()
+    // Clear all bits between indices [a, b], inclusive.
+    void ClearBitsInRange(uint64_t a, uint64_t b)
     {
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
+        ASSERT(a <= b);
+        ASSERT(b < kNumBits);
+
+        const uint64_t iBlockA = a >> 6ULL;
+        const uint64_t iBlockB = b >> 6ULL;
+
+        if (iBlockA == iBlockB)
         {
-            m_block[i] = ~m_block[i];
+            m_block[iBlockA] &= ~SetBitRange_U64(a, b);
         }
+        else
+        {
+            m_block[iBlockA] &= ~SetBitRange_U64(a, 63ULL);
+
+            for (uint64_t iBlock = iBlockA + 1; iBlock < iBlockB; ++iBlock)
+                m_block[iBlock] = 0ULL;
+
+            m_block[iBlockB] &= ~SetBitRange_U64(0, b);
+        }
+    }
+
+    // Mask of the valid (in-use) bits of the last block.
+    static constexpr uint64_t LastBlockMask()
+    {
+        return ~0ULL >> (-kNumBits & 63ULL);
+    }
+
+    // Return the underlying blocks. Bits past kNumBits in the last block are unspecified.
+    const uint64_t* Blocks() const
+    {
+        return m_block;
+    }
+
+    uint64_t* Blocks()
+    {
+        return m_block;
+    }
+
+    void operator|=(const BitArray<kNumBits>& __restrict other)
+    {
+        BinaryOp_Blocks<BitOpOr>(m_block, m_block, other.m_block, kNumBlocks);
+    }
+
+    void OrNot(const BitArray<kNumBits>& __restrict other)
+    {
+        BinaryOp_Blocks<BitOpOrNot>(m_block, m_block, other.m_block, kNumBlocks);
+    }
+
+    void NotOr(const BitArray<kNumBits>& __restrict other)
+    {
+        BinaryOp_Blocks<BitOpNotOr>(m_block, m_block, other.m_block, kNumBlocks);
+    }
+
+    void NotOrNot(const BitArray<kNumBits>& __restrict other)
+    {
+        BinaryOp_Blocks<BitOpNotOrNot>(m_block, m_block, other.m_block, kNumBlocks);
+    }
+
+    void operator^=(const BitArray<kNumBits>& __restrict other)
+    {
+        BinaryOp_Blocks<BitOpXor>(m_block, m_block, other.m_block, kNumBlocks);
+    }
+
+    void XorNot(const BitArray<kNumBits>& __restrict other)
+    {
+        BinaryOp_Blocks<BitOpXorNot>(m_block, m_block, other.m_block, kNumBlocks);
+    }
+
+    void NotXor(const BitArray<kNumBits>& __restrict other)
+    {
+        BinaryOp_Blocks<BitOpXorNot>(m_block, m_block, other.m_block, kNumBlocks);
+    }
+
+    void NotXorNot(const BitArray<kNumBits>& __restrict other)
+    {
+        BinaryOp_Blocks<BitOpXor>(m_block, m_block, other.m_block, kNumBlocks);
+    }
+
+    void operator&=(const BitArray<kNumBits>& __restrict other)
+    {
+        BinaryOp_Blocks<BitOpAnd>(m_block, m_block, other.m_block, kNumBlocks);
+    }
+
+    void AndNot(const BitArray<kNumBits>& __restrict other)
+    {
+        BinaryOp_Blocks<BitOpAndNot>(m_block, m_block, other.m_block, kNumBlocks);
+    }
+
+    void NotAnd(const BitArray<kNumBits>& __restrict other)
+    {
+        BinaryOp_Blocks<BitOpNotAnd>(m_block, m_block, other.m_block, kNumBlocks);
+    }
+
+    void NotAndNot(const BitArray<kNumBits>& __restrict other)
+    {
+        BinaryOp_Blocks<BitOpNotAndNot>(m_block, m_block, other.m_block, kNumBlocks);
+    }
+
+    void Invert()
+    {
+        BinaryOp_Blocks<BitOpNot>(m_block, m_block, m_block, kNumBlocks);
     }
 
     void AssignNot(const BitArray<kNumBits>& __restrict other)
     {
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            m_block[i] = ~other.m_block[i];
-        }
+        BinaryOp_Blocks<BitOpNot>(m_block, other.m_block, other.m_block, kNumBlocks);
     }
 
-    // but will it?
     void Blend(const BitArray<kNumBits>& __restrict other, const BitArray<kNumBits>& __restrict mask)
     {
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            m_block[i] = (m_block[i] & ~mask.m_block[i]) | (other.m_block[i] & mask.m_block[i]);
-        }
+        TernaryOp_Blocks<BitOpBlend>(m_block, m_block, other.m_block, mask.m_block, kNumBlocks);
     }
 
     friend BitArray<kNumBits> operator|(const BitArray<kNumBits>& __restrict a, const BitArray<kNumBits>& __restrict b)
     {
         BitArray<kNumBits> ret;
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            ret.m_block[i] = a.m_block[i] | b.m_block[i];
-        }
+        BinaryOp_Blocks<BitOpOr>(ret.m_block, a.m_block, b.m_block, kNumBlocks);
         return ret;
     }
 
     friend BitArray<kNumBits> OrNot(const BitArray<kNumBits>& __restrict a, const BitArray<kNumBits>& __restrict b)
     {
         BitArray<kNumBits> ret;
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            ret.m_block[i] = a.m_block[i] | ~b.m_block[i];
-        }
+        BinaryOp_Blocks<BitOpOrNot>(ret.m_block, a.m_block, b.m_block, kNumBlocks);
         return ret;
     }
 
     friend BitArray<kNumBits> NotOrNot(const BitArray<kNumBits>& __restrict a, const BitArray<kNumBits>& __restrict b)
     {
         BitArray<kNumBits> ret;
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            ret.m_block[i] = ~a.m_block[i] | ~b.m_block[i];
-        }
+        BinaryOp_Blocks<BitOpNotOrNot>(ret.m_block, a.m_block, b.m_block, kNumBlocks);
         return ret;
     }
 
     friend BitArray<kNumBits> operator^(const BitArray<kNumBits>& __restrict a, const BitArray<kNumBits>& __restrict b)
     {
         BitArray<kNumBits> ret;
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            ret.m_block[i] = a.m_block[i] ^ b.m_block[i];
-        }
+        BinaryOp_Blocks<BitOpXor>(ret.m_block, a.m_block, b.m_block, kNumBlocks);
         return ret;
     }
 
     friend BitArray<kNumBits> XorNot(const BitArray<kNumBits>& __restrict a, const BitArray<kNumBits>& __restrict b)
     {
         BitArray<kNumBits> ret;
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            ret.m_block[i] = a.m_block[i] ^ ~b.m_block[i];
-        }
+        BinaryOp_Blocks<BitOpXorNot>(ret.m_block, a.m_block, b.m_block, kNumBlocks);
         return ret;
     }
 
     friend BitArray<kNumBits> NotXorNot(const BitArray<kNumBits>& __restrict a, const BitArray<kNumBits>& __restrict b)
     {
         BitArray<kNumBits> ret;
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            ret.m_block[i] = ~a.m_block[i] ^ ~b.m_block[i];
-        }
+        BinaryOp_Blocks<BitOpXor>(ret.m_block, a.m_block, b.m_block, kNumBlocks);
         return ret;
     }
 
     friend BitArray<kNumBits> operator&(const BitArray<kNumBits>& __restrict a, const BitArray<kNumBits>& __restrict b)
     {
         BitArray<kNumBits> ret;
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            ret.m_block[i] = a.m_block[i] & b.m_block[i];
-        }
+        BinaryOp_Blocks<BitOpAnd>(ret.m_block, a.m_block, b.m_block, kNumBlocks);
         return ret;
     }
 
     friend BitArray<kNumBits> AndNot(const BitArray<kNumBits>& __restrict a, const BitArray<kNumBits>& __restrict b)
     {
         BitArray<kNumBits> ret;
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            ret.m_block[i] = a.m_block[i] & ~b.m_block[i];
-        }
+        BinaryOp_Blocks<BitOpAndNot>(ret.m_block, a.m_block, b.m_block, kNumBlocks);
         return ret;
     }
 
     friend BitArray<kNumBits> NotAndNot(const BitArray<kNumBits>& __restrict a, const BitArray<kNumBits>& __restrict b)
     {
         BitArray<kNumBits> ret;
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            ret.m_block[i] = ~a.m_block[i] & ~b.m_block[i];
-        }
+        BinaryOp_Blocks<BitOpNotAndNot>(ret.m_block, a.m_block, b.m_block, kNumBlocks);
         return ret;
     }
 
     friend BitArray<kNumBits> operator~(const BitArray<kNumBits>& __restrict other)
     {
         BitArray<kNumBits> ret;
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            ret.m_block[i] = ~other.m_block[i];
-        }
+        BinaryOp_Blocks<BitOpNot>(ret.m_block, other.m_block, other.m_block, kNumBlocks);
         return ret;
     }
 
-    // but will it?
     friend BitArray<kNumBits> Blend(const BitArray<kNumBits>& __restrict a, const BitArray<kNumBits>& __restrict b, const BitArray<kNumBits>& __restrict mask)
     {
         BitArray<kNumBits> ret;
-        for (uint64_t i = 0; i < kNumBlocks; ++i)
-        {
-            ret.m_block[i] = (a.m_block[i] & ~mask.m_block[i]) | (b.m_block[i] & mask.m_block[i]);
-        }
+        TernaryOp_Blocks<BitOpBlend>(ret.m_block, a.m_block, b.m_block, mask.m_block, kNumBlocks);
         return ret;
     }
 
     bool operator==(const BitArray<kNumBits>& __restrict other) const
     {
-        for (uint64_t i = 0; i < kNumBlocks - 1; ++i)
-        {
-            if (m_block[i] != other.m_block[i])
-                return false;
-        }
-
-        if ((m_block[kNumBlocks - 1] & LastBlockMask()) != (other.m_block[kNumBlocks - 1] & LastBlockMask()))
-            return false;
-
-        return true;
+        return AreBlocksEqual(other.m_block);
     }
 
     bool operator!=(const BitArray<kNumBits>& __restrict other) const
@@ -871,88 +1317,73 @@ public:
         return !(*this == other);
     }
 
-    // Left shift (note that shift amount is modulo 64).
+    // Left shift. Shifting by kNumBits or more clears all bits.
     void operator<<=(uint64_t s)
     {
-        s &= 63ULL;
-
-        if (s == 0)
-            return;
-
-        uint64_t prevBlock = m_block[0];
-        m_block[0] = prevBlock << s;
-        for (uint64_t i = 1; i < kNumBlocks; ++i)
-        {
-            const uint64_t newBlock = (prevBlock >> (64 - s)) | (m_block[i] << s);
-            prevBlock = m_block[i];
-            m_block[i] = newBlock;
-        }
+        ShiftLeft_Blocks(m_block, m_block, kNumBits, s);
     }
 
-    // Right shift (note that shift amount is modulo 64).
+    // Right shift. Shifting by kNumBits or more clears all bits.
     void operator>>=(uint64_t s)
     {
-        s &= 63ULL;
+        ShiftRight_Blocks(m_block, m_block, kNumBits, s);
+    }
 
-        if (s == 0)
-            return;
+    // Left shift. Shifting by kNumBits or more clears all bits.
+    friend BitArray<kNumBits> operator<<(const BitArray<kNumBits>& __restrict other, uint64_t s)
+    {
+        BitArray<kNumBits> ret;
+        ShiftLeft_Blocks(ret.m_block, other.m_block, kNumBits, s);
+        return ret;
+    }
 
-        if constexpr (kNumBlocks == 1)
-        {
-            m_block[0] = (m_block[0] & LastBlockMask()) >> s;
-        }
-        else
-        {
-            for (uint64_t i = 0; i < kNumBlocks - 2; ++i)
-            {
-                m_block[i] = (m_block[i + 1] << (64 - s)) | (m_block[i] >> s);
-            }
+    // Right shift. Shifting by kNumBits or more clears all bits.
+    friend BitArray<kNumBits> operator>>(const BitArray<kNumBits>& __restrict other, uint64_t s)
+    {
+        BitArray<kNumBits> ret;
+        ShiftRight_Blocks(ret.m_block, other.m_block, kNumBits, s);
+        return ret;
+    }
 
-            const uint64_t block = m_block[kNumBlocks - 1] & LastBlockMask();
-            m_block[kNumBlocks - 2] = (block << (64 - s)) | (m_block[kNumBlocks - 2] >> s);
-            m_block[kNumBlocks - 1] = block >> s;
-        }
+    // Rotate toward higher indices: bit i moves to bit (i + s) % kNumBits. In place, with no temporary copy.
+    void RotateLeft(uint64_t s)
+    {
+        RotateLeftInPlace_Blocks(m_block, kNumBits, s % kNumBits);
     }
 
-    // Left shift (note that shift amount is modulo 64).
-    friend BitArray<kNumBits> operator<<(const BitArray<kNumBits>& __restrict other, uint64_t s)
+    // Rotate toward lower indices: bit i moves to bit (i - s) % kNumBits. In place, with no temporary copy.
+    void RotateRight(uint64_t s)
     {
-        s &= 63ULL;
-        if (s == 0)
-            return other;
+        RotateLeftInPlace_Blocks(m_block, kNumBits, (kNumBits - s % kNumBits) % kNumBits);
+    }
 
+    // Rotate toward higher indices: bit i moves to bit (i + s) % kNumBits.
+    friend BitArray<kNumBits> RotateLeft(const BitArray<kNumBits>& __restrict other, uint64_t s)
+    {
         BitArray<kNumBits> ret;
-        ret.m_block[0] = other.m_block[0] << s;
-        for (uint64_t i = 1; i < kNumBlocks; ++i)
-        {
-            ret.m_block[i] = (other.m_block[i - 1] >> (64 - s)) | (other.m_block[i] << s);
-        }
+        RotateLeft_Blocks(ret.m_block, other.m_block, kNumBits, s % kNumBits);
         return ret;
     }
 
-    // Right shift (note that shift amount is modulo 64).
-    friend BitArray<kNumBits> operator>>(const BitArray<kNumBits>& __restrict other, uint64_t s)
+    // Rotate toward lower indices: bit i moves to bit (i - s) % kNumBits.
+    friend BitArray<kNumBits> RotateRight(const BitArray<kNumBits>& __restrict other, uint64_t s)
     {
-        s &= 63ULL;
-        if (s == 0)
-            return other;
-
         BitArray<kNumBits> ret;
-        if constexpr (kNumBlocks == 1)
-        {
-            ret.m_block[0] = (other.m_block[0] & LastBlockMask()) >> s;
-        }
-        else
-        {
-            for (uint64_t i = 0; i < kNumBlocks - 2; ++i)
-            {
-                ret.m_block[i] = (other.m_block[i + 1] << (64 - s)) | (other.m_block[i] >> s);
-            }
+        RotateLeft_Blocks(ret.m_block, other.m_block, kNumBits, (kNumBits - s % kNumBits) % kNumBits);
+        return ret;
+    }
 
-            const uint64_t block = other.m_block[kNumBlocks - 1] & LastBlockMask();
-            ret.m_block[kNumBlocks - 2] = (block << (64 - s)) | (other.m_block[kNumBlocks - 2] >> s);
-            ret.m_block[kNumBlocks - 1] = block >> s;
-        }
+    // Reverse the order of the bits: bit i moves to bit kNumBits - 1 - i.
+    void ReverseBits()
+    {
+        ReverseBitsHelper(m_block, m_block);
+    }
+
+    // Reverse the order of the bits: bit i moves to bit kNumBits - 1 - i.
+    friend BitArray<kNumBits> ReverseBits(const BitArray<kNumBits>& __restrict other)
+    {
+        BitArray<kNumBits> ret;
+        ReverseBitsHelper(ret.m_block, other.m_block);
         return ret;
     }
 
@@ -1050,134 +1481,51 @@ public:
         return {};
     }
 
-private:
-    static uint64_t AlignmentMask(uint64_t alignment)
+    // Write the indices of all set bits to out, in increasing order: the same indices as iterating, but decoded
+    // 8 or 16 at a time by a vectorized kernel. out must have room for CountSetBits() entries.
+    // Return the number of entries written.
+    uint64_t DecodeSetBits(uint32_t* __restrict out) const
     {
-        uint64_t ret = 0xFFFFFFFFFFFFFFFFULL;
-        if (alignment == 2)
-            ret = 0x5555555555555555ULL;
-        if (alignment == 4)
-            ret = 0x1111111111111111ULL;
-        if (alignment == 8)
-            ret = 0x0101010101010101ULL;
-        if (alignment == 16)
-            ret = 0x0001000100010001ULL;
-        if (alignment == 32)
-            ret = 0x0000000100000001ULL;
-        return ret;
-    }
-
-    static bool NthBitHelper(uint64_t& iBit, uint64_t& n, uint64_t iBlock, uint64_t block)
-    {
-        uint64_t set = CountSetBits_U64(block);
-        if (set > n)
-        {
-            iBit = iBlock << 6ULL;
-
-            set = CountSetBits_U32(uint32_t(block));
-            if (set <= n)
-            {
-                block >>= 32;
-                iBit += 32;
-                n -= set;
-            }
-
-            set = CountSetBits_U32(uint32_t(block) & 0xFFFFU);
-            if (set <= n)
-            {
-                block >>= 16;
-                iBit += 16;
-                n -= set;
-            }
-
-            set = CountSetBits_U32(uint32_t(block) & 0xFFU);
-            if (set <= n)
-            {
-                block >>= 8;
-                iBit += 8;
-                n -= set;
-            }
-
-            do
-            {
-                n -= uint32_t(block) & 1U;
-                block >>= 1;
-                ++iBit;
-            } while (n != ~0ULL);
-
-            --iBit;
-
-            return true;
-        }
-
-        n -= set;
-
-        return false;
+        static_assert(kNumBits <= (1ULL << 32ULL), "Indices must fit in 32 bits");
+        return DecodeSetBitsHelper(out, 0, kNumBlocks);
     }
 
-    static bool FirstBlockOfNBitsHelper(uint64_t& iStart, uint64_t n, uint64_t iBlock, uint64_t block)
+    // Call f(const uint32_t* indices, uint64_t count) for successive batches of the indices of the set bits,
+    // in increasing order. Each batch is decoded as by DecodeSetBits() into a buffer on the stack, so no
+    // caller buffer is needed; the indices are valid only during the call.
+    template <class F>
+    void ForEachSetBitBatch(F&& f) const
     {
-        const uint64_t iBit = iBlock << 6ULL;
-        const uint64_t blockStartRun = CountTrailingZeros_U64(block);
-
-        if (iBit + blockStartRun >= iStart + n)
-            return true;
+        static_assert(kNumBits <= (1ULL << 32ULL), "Indices must fit in 32 bits");
+        static constexpr uint64_t kBatchBlocks = kNumBlocks < kDecodeBatchBlocks ? kNumBlocks : kDecodeBatchBlocks;
 
-        const uint64_t blockEndRun = CountLeadingZeros_U64(block);
-
-        if (int64_t(62ULL - blockStartRun - blockEndRun) >= int64_t(n))
+        uint32_t indices[kBatchBlocks << 6ULL];
+        for (uint64_t iBlock = 0; iBlock < kNumBlocks; iBlock += kBatchBlocks)
         {
-            const uint64_t blockMidRun = FirstNClearBitsIndex_U64(block, uint32_t(n));
-            if (blockMidRun < 64ULL)
-            {
-                iStart = iBit + blockMidRun;
-                return true;
-            }
+            const uint64_t n = kNumBlocks - iBlock < kBatchBlocks ? kNumBlocks - iBlock : kBatchBlocks;
+            const uint64_t count = DecodeSetBitsHelper(indices, iBlock, n);
+            if (count)
+                f(static_cast<const uint32_t*>(indices), count);
         }
-
-        const uint64_t iCandidateStart = iBit + 64ULL - blockEndRun;
-        if (blockEndRun < 64ULL)
-            iStart = iCandidateStart;
-
-        return blockEndRun >= n;
     }
 
-    static bool FirstHighAlignedBlockOfNBitsHelper(uint64_t& iStart, uint64_t alignMask, uint64_t n, uint64_t iBlock, uint64_t block)
-    {
-        const uint64_t iBit = iBlock << 6ULL;
-        const uint64_t blockStartRun = CountTrailingZeros_U64(block);
-        if (iBit + blockStartRun >= iStart + n)
-            return true;
-        const uint64_t iCandidateStart = (iBit + 64ULL + alignMask) & ~alignMask;
-        if (blockStartRun < 64ULL)
-            iStart = iCandidateStart;
-        return false;
-    }
+private:
+    using Queries = BitArrayQueries<BitArray<kNBits>>;
+    using Queries::kDecodeBatchBlocks, Queries::DecodeSetBitsHelper, Queries::AreBlocksEqual;
 
-    static bool FirstLowAlignedBlockOfNBitsHelper(uint64_t& iStart, uint64_t alignMask, uint64_t validBits, uint64_t n, uint64_t iBlock, uint64_t block)
+    // Reverse the bits of src into dst, which may be src. The whole blocks are reversed in one pass from both ends,
+    // which leaves the garbage excess bits at the bottom, so a second pass shifts them out.
+    static void ReverseBitsHelper(uint64_t* dst, const uint64_t* src)
     {
-        const uint64_t iBit = iBlock << 6ULL;
-        const uint64_t blockStartRun = CountTrailingZeros_U64(block);
-        if (iBit + blockStartRun >= iStart + n)
-            return true;
-        const uint64_t blockEndRun = CountLeadingZeros_U64(block);
+        ReverseBits_Buffer(reinterpret_cast<uint8_t*>(dst), reinterpret_cast<const uint8_t*>(src), kNumBlocks << 3ULL);
 
-        if (int64_t(62ULL - blockStartRun - blockEndRun) >= int64_t(n))
+        constexpr uint64_t kExcess = (kNumBlocks << 6ULL) - kNumBits;
+        if constexpr (kExcess != 0)
         {
-            const uint64_t blockMidRun = FirstNClearBitsIndex_U64(block, uint32_t(n), validBits);
-            if (blockMidRun < 64ULL)
-            {
-                iStart = iBit + blockMidRun;
-                return true;
-            }
+            for (uint64_t i = 0; i < kNumBlocks - 1; ++i)
+                dst[i] = (dst[i] >> kExcess) | (dst[i + 1] << (64ULL - kExcess));
+            dst[kNumBlocks - 1] >>= kExcess;
         }
-
-        const uint64_t alignedBlockEndRun = blockEndRun & alignMask;
-        const uint64_t iCandidateStart = iBit + 64ULL - alignedBlockEndRun;
-        if (alignedBlockEndRun < 64ULL)
-            iStart = iCandidateStart;
-
-        return alignedBlockEndRun >= n;
     }
 
     uint64_t m_block[kNumBlocks];
@@ -0,0 +1,224 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "bench.h"
+#include "bitarray.h"
+
+// Random indices per per-bit benchmark, cycled through.
+static constexpr uint64_t kNumIndices = 4096;
+
+// Time f(k) for k = 0, 1, 2, ..., as "method/numBits/density%". Queries are kept from being hoisted out of the loop
+// by clobbering memory after each call. Throughput is over bytesPerOp, or left out if 0; for scans that can exit
+// early, it is over the whole array, so it is the effective rate of the scan.
+template <class F>
+static void BenchMethod(const char* method, uint64_t numBits, uint32_t density, uint64_t bytesPerOp, F&& f)
+{
+    char name[96];
+    snprintf(name, sizeof(name), "%s/%llu/%u%%", method, static_cast<unsigned long long>(numBits), density);
+    if (!BenchSelected("BitArray", name))
+        return;
+
+    const BenchResult r = BenchMeasure([&](uint64_t numIterations)
+        {
+            for (uint64_t k = 0; k < numIterations; ++k)
+            {
+                if constexpr (std::is_void_v<decltype(f(k))>)
+                    f(k);
+                else
+                    DoNotOptimize(f(k));
+                ClobberMemory();
+            }
+        });
+    PrintBenchResult("BitArray", name, r, bytesPerOp);
+}
+
+// Every BitArray method on kNumBits bits. Those whose time depends on the bits are swept over kBenchDensities;
+// the rest, which only write, run once, at 50%.
+template <uint64_t kNumBits>
+static void BenchBitArrayOfSize(uint64_t& state)
+{
+    using V = BitArray<kNumBits>;
+    constexpr uint64_t kBytes = V::kNumBlocks * 8ULL;
+
+    // Large arrays don't fit on the stack.
+    const std::unique_ptr<V> pv = std::make_unique<V>();
+    const std::unique_ptr<V> pw = std::make_unique<V>();
+    const std::unique_ptr<V> pm = std::make_unique<V>();
+    V& v = *pv;
+    V& w = *pw;
+    V& m = *pm;
+    DoNotOptimize(v.Blocks());
+    DoNotOptimize(w.Blocks());
+    DoNotOptimize(m.Blocks());
+
+    std::vector<uint64_t> indices(kNumIndices);
+    for (uint64_t& i : indices)
+        i = BenchSplitMix64(state) % kNumBits;
+    const uint64_t* idx = indices.data();
+    constexpr uint64_t kMask = kNumIndices - 1;
+
+    std::vector<uint32_t> decoded(kNumBits);
+    std::vector<BitRun> runs((kNumBits + 1) / 2);
+
+    // A range over the middle half, or the whole of a tiny array.
+    constexpr uint64_t a = kNumBits / 4;
+    constexpr uint64_t b = kNumBits - 1 - kNumBits / 4;
+    constexpr uint64_t n = kNumBits < 8 ? kNumBits : 8;
+    constexpr uint64_t s = kNumBits / 3 + 1;
+
+    for (const uint32_t d : kBenchDensities)
+    {
+        FillBenchBlocks(v.Blocks(), V::kNumBlocks, d, state);
+        w = v;
+        const uint64_t numSet = v.CountSetBits();
+
+        BenchMethod("CountSetBits", kNumBits, d, kBytes, [&](uint64_t) { return v.CountSetBits(); });
+        BenchMethod("AreAllBitsSet", kNumBits, d, kBytes, [&](uint64_t) { return v.AreAllBitsSet(); });
+        BenchMethod("AreAllBitsClear", kNumBits, d, kBytes, [&](uint64_t) { return v.AreAllBitsClear(); });
+        BenchMethod("CountSetBitsInRange", kNumBits, d, kBytes / 2, [&](uint64_t) { return v.CountSetBitsInRange(a, b); });
+        BenchMethod("AreAllBitsInRangeSet", kNumBits, d, kBytes / 2, [&](uint64_t) { return v.AreAllBitsInRangeSet(a, b); });
+        BenchMethod("AreAllBitsInRangeClear", kNumBits, d, kBytes / 2, [&](uint64_t) { return v.AreAllBitsInRangeClear(a, b); });
+        BenchMethod("operator==", kNumBits, d, 2 * kBytes, [&](uint64_t) { return v == w; });
+        BenchMethod("CountLeadingZeros", kNumBits, d, kBytes, [&](uint64_t) { return v.CountLeadingZeros(); });
+        BenchMethod("CountTrailingZeros", kNumBits, d, kBytes, [&](uint64_t) { return v.CountTrailingZeros(); });
+        BenchMethod("FirstSetBitIndex", kNumBits, d, kBytes, [&](uint64_t) { return v.FirstSetBitIndex(); });
+        BenchMethod("FirstClearBitIndex", kNumBits, d, kBytes, [&](uint64_t) { return v.FirstClearBitIndex(); });
+        BenchMethod("LastSetBitIndex", kNumBits, d, kBytes, [&](uint64_t) { return v.LastSetBitIndex(); });
+        BenchMethod("LastClearBitIndex", kNumBits, d, kBytes, [&](uint64_t) { return v.LastClearBitIndex(); });
+        BenchMethod("NthSetBitIndex", kNumBits, d, kBytes, [&](uint64_t) { return v.NthSetBitIndex(numSet / 2); });
+        BenchMethod("NthClearBitIndex", kNumBits, d, kBytes, [&](uint64_t) { return v.NthClearBitIndex((kNumBits - numSet) / 2); });
+        BenchMethod("FirstBlockOfNSetBits", kNumBits, d, kBytes, [&](uint64_t) { return v.FirstBlockOfNSetBits(n); });
+        BenchMethod("FirstAlignedBlockOfNSetBits", kNumBits, d, kBytes, [&](uint64_t) { return v.FirstAlignedBlockOfNSetBits(n, 8); });
+        BenchMethod("FirstBlockOfNClearBits", kNumBits, d, kBytes, [&](uint64_t) { return v.FirstBlockOfNClearBits(n); });
+        BenchMethod("FirstAlignedBlockOfNClearBits", kNumBits, d, kBytes, [&](uint64_t) { return v.FirstAlignedBlockOfNClearBits(n, 8); });
+        BenchMethod("BestFitBlockOfNClearBits", kNumBits, d, kBytes, [&](uint64_t) { return v.BestFitBlockOfNClearBits(n); });
+        BenchMethod("BestFitAlignedBlockOfNClearBits", kNumBits, d, kBytes, [&](uint64_t) { return v.BestFitAlignedBlockOfNClearBits(n, 8); });
+        BenchMethod("LargestClearRun", kNumBits, d, kBytes, [&](uint64_t) { return v.LargestClearRun().start; });
+        BenchMethod("DecodeSetBits", kNumBits, d, kBytes, [&](uint64_t) { return v.DecodeSetBits(decoded.data()); });
+        BenchMethod("EncodeRuns", kNumBits, d, kBytes, [&](uint64_t) { return v.EncodeRuns(runs.data()); });
+        BenchMethod("EncodeClearRuns", kNumBits, d, kBytes, [&](uint64_t) { return v.EncodeClearRuns(runs.data()); });
+        BenchMethod("iterate", kNumBits, d, kBytes, [&](uint64_t)
+            {
+                uint64_t acc = 0;
+                for (const uint64_t i : v)
+                    acc += i;
+                return acc;
+            });
+        BenchMethod("SetRuns", kNumBits, d, kBytes, [&](uint64_t)
+            {
+                uint64_t acc = 0;
+                for (const BitRun r : v.SetRuns())
+                    acc += r.length;
+                return acc;
+            });
+
+        BenchMethod("IsBitSet", kNumBits, d, 0, [&](uint64_t k) { return v.IsBitSet(idx[k & kMask]); });
+        BenchMethod("NextSetBitIndex", kNumBits, d, 0, [&](uint64_t k) { return v.NextSetBitIndex(idx[k & kMask]); });
+        BenchMethod("NextClearBitIndex", kNumBits, d, 0, [&](uint64_t k) { return v.NextClearBitIndex(idx[k & kMask]); });
+        BenchMethod("PrevSetBitIndex", kNumBits, d, 0, [&](uint64_t k) { return v.PrevSetBitIndex(idx[k & kMask]); });
+        BenchMethod("PrevClearBitIndex", kNumBits, d, 0, [&](uint64_t k) { return v.PrevClearBitIndex(idx[k & kMask]); });
+    }
+
+    // A walk from set bit to set bit of a sparse array, with one in every 4096 bits set on average (0%, rounded).
+    if constexpr (kNumBits >= (1ULL << 16ULL))
+    {
+        v.ClearAll();
+        for (uint64_t k = 0; k < kNumBits / 4096; ++k)
+            v.SetBit(BenchSplitMix64(state) % kNumBits);
+
+        BenchMethod("NextSetBitIndex walk", kNumBits, 0, kBytes, [&](uint64_t)
+            {
+                uint64_t count = 0;
+                for (uint64_t i = v.FirstSetBitIndex(); i != ~0ULL; i = v.NextSetBitIndex(i))
+                    ++count;
+                return count;
+            });
+    }
+
+    FillBenchBlocks(v.Blocks(), V::kNumBlocks, 50, state);
+    FillBenchBlocks(w.Blocks(), V::kNumBlocks, 50, state);
+    FillBenchBlocks(m.Blocks(), V::kNumBlocks, 50, state);
+
+    BenchMethod("SetBit", kNumBits, 50, 0, [&](uint64_t k) { v.SetBit(idx[k & kMask]); });
+    BenchMethod("ClearBit", kNumBits, 50, 0, [&](uint64_t k) { v.ClearBit(idx[k & kMask]); });
+    BenchMethod("XorBit", kNumBits, 50, 0, [&](uint64_t k) { v.XorBit(idx[k & kMask]); });
+    BenchMethod("AssignBit", kNumBits, 50, 0, [&](uint64_t k) { v.AssignBit(idx[k & kMask], k & 1ULL); });
+
+    // Every random index at once, batched, then one at a time for comparison.
+    if constexpr (kNumBits >= (1ULL << 16ULL))
+    {
+        static uint8_t out[kNumIndices];
+        BenchMethod("TestBits batch", kNumBits, 50, 0, [&](uint64_t) { v.TestBits(idx, kNumIndices, out); });
+        BenchMethod("IsBitSet batch", kNumBits, 50, 0, [&](uint64_t)
+            {
+                for (uint64_t i = 0; i < kNumIndices; ++i)
+                    out[i] = v.IsBitSet(idx[i]);
+            });
+        BenchMethod("SetBits batch", kNumBits, 50, 0, [&](uint64_t) { v.SetBits(idx, kNumIndices); });
+        BenchMethod("SetBit batch", kNumBits, 50, 0, [&](uint64_t)
+            {
+                for (uint64_t i = 0; i < kNumIndices; ++i)
+                    v.SetBit(idx[i]);
+            });
+        BenchMethod("ClearBits batch", kNumBits, 50, 0, [&](uint64_t) { v.ClearBits(idx, kNumIndices); });
+    }
+
+    BenchMethod("SetAll", kNumBits, 50, kBytes, [&](uint64_t) { v.SetAll(); });
+    BenchMethod("ClearAll", kNumBits, 50, kBytes, [&](uint64_t) { v.ClearAll(); });
+    BenchMethod("SetBitsInRange", kNumBits, 50, kBytes / 2, [&](uint64_t) { v.SetBitsInRange(a, b); });
+    BenchMethod("ClearBitsInRange", kNumBits, 50, kBytes / 2, [&](uint64_t) { v.ClearBitsInRange(a, b); });
+
+    FillBenchBlocks(v.Blocks(), V::kNumBlocks, 50, state);
+    BenchMethod("operator|=", kNumBits, 50, 2 * kBytes, [&](uint64_t) { v |= w; });
+    BenchMethod("operator&=", kNumBits, 50, 2 * kBytes, [&](uint64_t) { v &= w; });
+    BenchMethod("operator^=", kNumBits, 50, 2 * kBytes, [&](uint64_t) { v ^= w; });
+    BenchMethod("AndNot", kNumBits, 50, 2 * kBytes, [&](uint64_t) { v.AndNot(w); });
+    BenchMethod("OrNot", kNumBits, 50, 2 * kBytes, [&](uint64_t) { v.OrNot(w); });
+    BenchMethod("XorNot", kNumBits, 50, 2 * kBytes, [&](uint64_t) { v.XorNot(w); });
+    BenchMethod("NotAndNot", kNumBits, 50, 2 * kBytes, [&](uint64_t) { v.NotAndNot(w); });
+    BenchMethod("Invert", kNumBits, 50, kBytes, [&](uint64_t) { v.Invert(); });
+    BenchMethod("AssignNot", kNumBits, 50, 2 * kBytes, [&](uint64_t) { v.AssignNot(w); });
+    BenchMethod("Blend", kNumBits, 50, 3 * kBytes, [&](uint64_t) { v.Blend(w, m); });
+    BenchMethod("operator<<=", kNumBits, 50, kBytes, [&](uint64_t) { v <<= s; });
+    BenchMethod("operator>>=", kNumBits, 50, kBytes, [&](uint64_t) { v >>= s; });
+    BenchMethod("RotateLeft", kNumBits, 50, kBytes, [&](uint64_t) { v.RotateLeft(s); });
+    BenchMethod("RotateRight", kNumBits, 50, kBytes, [&](uint64_t) { v.RotateRight(s); });
+    BenchMethod("ReverseBits", kNumBits, 50, kBytes, [&](uint64_t) { v.ReverseBits(); });
+}
+
+void BenchBitArray()
+{
+    uint64_t state = 0xB17A77A7ULL;
+
+    // The sizes of SweepArraySizes() in bitarray_test.cpp, then large ones.
+    BenchBitArrayOfSize<1>(state);
+    BenchBitArrayOfSize<2>(state);
+    BenchBitArrayOfSize<3>(state);
+    BenchBitArrayOfSize<4>(state);
+    BenchBitArrayOfSize<32>(state);
+    BenchBitArrayOfSize<63>(state);
+    BenchBitArrayOfSize<64>(state);
+    BenchBitArrayOfSize<65>(state);
+    BenchBitArrayOfSize<127>(state);
+    BenchBitArrayOfSize<128>(state);
+    BenchBitArrayOfSize<129>(state);
+    BenchBitArrayOfSize<191>(state);
+    BenchBitArrayOfSize<192>(state);
+    BenchBitArrayOfSize<193>(state);
+    BenchBitArrayOfSize<255>(state);
+    BenchBitArrayOfSize<256>(state);
+    BenchBitArrayOfSize<257>(state);
+    BenchBitArrayOfSize<(1ULL << 16ULL)>(state);
+    BenchBitArrayOfSize<(1ULL << 20ULL)>(state);
+    BenchBitArrayOfSize<(1ULL << 24ULL)>(state);
+}
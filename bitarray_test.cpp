@@ -10,6 +10,7 @@
 #include <iostream>
 
 #include "bitarray.h"
+#include "testutil.h"
 
 #define ASSERT_TRUE(a) do { if (!(a)) { std::cerr << "FAIL: expected true for " << #a << ", got false\n"; __debugbreak(); } } while (0)
 #define ASSERT_FALSE(a) do { if ((a)) { std::cerr << "FAIL: expected false for " << #a << ", got true\n"; __debugbreak(); } } while (0)
@@ -190,6 +191,32 @@ static void SweepArraySizes(U func)
     SWEEP_ARRAY_SIZE(257);
 }
 
+// Arrays large enough to take the vectorized paths, with and without a partial last block.
+template <class U>
+static void SweepLargeArraySizes(U func)
+{
+#undef SWEEP_ARRAY_SIZE
+#define SWEEP_ARRAY_SIZE(i) { BitArray<i> v; func(v); }
+    SWEEP_ARRAY_SIZE(4095);
+    SWEEP_ARRAY_SIZE(4160);
+    SWEEP_ARRAY_SIZE(4161);
+    SWEEP_ARRAY_SIZE(8191);
+    SWEEP_ARRAY_SIZE(16447);
+}
+
+// Fill with pseudorandom blocks. Density 0 and 4 are all clear and all set; 1, 2, 3 are sparse, half, and dense.
+template <size_t n>
+static void FillRandom(BitArray<n>& v, uint64_t& state, uint32_t density)
+{
+    uint64_t* p = reinterpret_cast<uint64_t*>(&v);
+    for (uint64_t i = 0; i < BitArray<n>::kNumBlocks; ++i)
+    {
+        const uint64_t r = SplitMix64(state);
+        const uint64_t sparse = r & SplitMix64(state) & SplitMix64(state) & SplitMix64(state);
+        p[i] = density == 0 ? 0ULL : density == 1 ? sparse : density == 2 ? r : density == 3 ? ~sparse : ~0ULL;
+    }
+}
+
 template <size_t n>
 static void AssignBlocks(BitArray<n>& v, uint64_t x)
 {
@@ -518,6 +545,42 @@ void TestBitArray()
             }
         });
 
+    // CountSetBits, CountSetBitsInRange (vectorized)
+    SweepLargeArraySizes([](auto& v)
+        {
+            uint64_t state = v.kNumBits;
+            for (const bool setExcessBits : {true, false})
+            {
+                for (uint32_t density = 0; density <= 4; ++density)
+                {
+                    FillRandom(v, state, density);
+                    AssignExcessBits(v, setExcessBits);
+
+                    uint64_t expectedNumBits = 0;
+                    for (uint64_t i = 0; i < v.kNumBits; ++i)
+                        expectedNumBits += v.IsBitSet(i);
+                    ASSERT_EQ(v.CountSetBits(), expectedNumBits);
+
+                    for (uint64_t k = 0; k < 64; ++k)
+                    {
+                        uint64_t a = SplitMix64(state) % v.kNumBits;
+                        uint64_t b = SplitMix64(state) % v.kNumBits;
+                        if (a > b)
+                        {
+                            const uint64_t t = a;
+                            a = b;
+                            b = t;
+                        }
+                        uint64_t expectedInRange = 0;
+                        for (uint64_t i = a; i <= b; ++i)
+                            expectedInRange += v.IsBitSet(i);
+                        ASSERT_EQ(v.CountSetBitsInRange(a, b), expectedInRange);
+                    }
+                    ASSERT_EQ(v.CountSetBitsInRange(0, v.kNumBits - 1), expectedNumBits);
+                }
+            }
+        });
+
     // SetBitsInRange, ClearBitsInRange, AreAllBitsInRangeSet, AreAllBitsInRangeClear
     SweepArraySizes([](auto& v)
         {
@@ -1132,7 +1195,7 @@ void TestBitArray()
         [](auto& v)
         {
             // right shifts
-            for (uint64_t i = 0; i < (v.kNumBits < 64 ? v.kNumBits : 64); ++i)
+            for (uint64_t i = 0; i < v.kNumBits + 70; ++i)
             {
                 BitArray<v.kNumBits> r1 = v >> i;
                 BitArray<v.kNumBits> r2 = v;
@@ -1145,7 +1208,7 @@ void TestBitArray()
             }
 
             // left shifts
-            for (uint64_t i = 0; i < (v.kNumBits < 64 ? v.kNumBits : 64); ++i)
+            for (uint64_t i = 0; i < v.kNumBits + 70; ++i)
             {
                 BitArray<v.kNumBits> r1 = v << i;
                 BitArray<v.kNumBits> r2 = v;
@@ -1156,6 +1219,36 @@ void TestBitArray()
                     ASSERT_EQ(j < i ? false : v.IsBitSet(j - i), r1.IsBitSet(j));
                 }
             }
+
+            // rotates
+            for (uint64_t i = 0; i < 2 * v.kNumBits + 3; ++i)
+            {
+                BitArray<v.kNumBits> r1 = RotateLeft(v, i);
+                BitArray<v.kNumBits> r2 = v;
+                r2.RotateLeft(i);
+                ASSERT_TRUE(r1 == r2);
+                BitArray<v.kNumBits> r3 = RotateRight(v, i);
+                BitArray<v.kNumBits> r4 = v;
+                r4.RotateRight(i);
+                ASSERT_TRUE(r3 == r4);
+                for (uint64_t j = 0; j < v.kNumBits; ++j)
+                {
+                    ASSERT_EQ(v.IsBitSet(j), r1.IsBitSet((j + i) % v.kNumBits));
+                    ASSERT_EQ(v.IsBitSet((j + i) % v.kNumBits), r3.IsBitSet(j));
+                }
+            }
+
+            // reverse
+            {
+                BitArray<v.kNumBits> r1 = ReverseBits(v);
+                BitArray<v.kNumBits> r2 = v;
+                r2.ReverseBits();
+                ASSERT_TRUE(r1 == r2);
+                for (uint64_t j = 0; j < v.kNumBits; ++j)
+                    ASSERT_EQ(v.IsBitSet(j), r1.IsBitSet(v.kNumBits - 1 - j));
+                r2.ReverseBits();
+                ASSERT_TRUE(r2 == v);
+            }
         }
         );
 
@@ -1228,6 +1321,159 @@ void TestBitArray()
             ASSERT_EQ(iRef, ~0ULL);
         });
 
+    // DecodeSetBits, ForEachSetBitBatch
+    const auto testDecode = [](auto& v)
+        {
+            static uint32_t indices[16448];
+            uint64_t state = v.kNumBits;
+            for (const bool setExcessBits : {true, false})
+            {
+                for (uint32_t density = 0; density <= 4; ++density)
+                {
+                    FillRandom(v, state, density);
+                    AssignExcessBits(v, setExcessBits);
+
+                    const uint64_t count = v.CountSetBits();
+                    indices[count] = 0xDEADBEEFU;
+                    ASSERT_EQ(v.DecodeSetBits(indices), count);
+                    ASSERT_EQ(indices[count], 0xDEADBEEFU);
+
+                    uint64_t k = 0;
+                    for (const uint64_t i : v)
+                        ASSERT_EQ(uint64_t(indices[k++]), i);
+
+                    k = 0;
+                    v.ForEachSetBitBatch([&](const uint32_t* batch, uint64_t n)
+                        {
+                            ASSERT_TRUE(n > 0);
+                            for (uint64_t j = 0; j < n; ++j)
+                                ASSERT_EQ(batch[j], indices[k++]);
+                        });
+                    ASSERT_EQ(k, count);
+                }
+            }
+        };
+    SweepArraySizes(testDecode);
+    SweepLargeArraySizes(testDecode);
+
+    // TestBits, SetBits, ClearBits
+    const auto testBatch = [](auto& v)
+        {
+            static uint64_t idx[1024];
+            static uint8_t out[1025];
+            uint64_t state = v.kNumBits;
+            for (uint32_t density = 0; density <= 4; ++density)
+            {
+                FillRandom(v, state, density);
+                AssignExcessBits(v, density & 1);
+                const uint64_t n = SplitMix64(state) % 1025;
+                for (uint64_t i = 0; i < n; ++i)
+                    idx[i] = SplitMix64(state) % v.kNumBits;
+
+                out[n] = 0xAA;
+                v.TestBits(idx, n, out);
+                for (uint64_t i = 0; i < n; ++i)
+                    ASSERT_EQ(bool(out[i]), v.IsBitSet(idx[i]));
+                ASSERT_EQ(out[n], uint8_t(0xAA));
+
+                auto w = v;
+                v.SetBits(idx, n);
+                for (uint64_t i = 0; i < n; ++i)
+                    w.SetBit(idx[i]);
+                ASSERT_TRUE(v == w);
+
+                v.ClearBits(idx, n / 2);
+                for (uint64_t i = 0; i < n / 2; ++i)
+                    w.ClearBit(idx[i]);
+                ASSERT_TRUE(v == w);
+            }
+        };
+    SweepArraySizes(testBatch);
+    SweepLargeArraySizes(testBatch);
+
+    // SetRuns, ClearRuns, EncodeRuns, EncodeClearRuns
+    const auto testRuns = [](auto& v)
+        {
+            static BitRun runs[8225];
+            uint64_t state = v.kNumBits;
+            for (const bool setExcessBits : {true, false})
+            {
+                for (uint32_t density = 0; density <= 4; ++density)
+                {
+                    FillRandom(v, state, density);
+                    AssignExcessBits(v, setExcessBits);
+
+                    for (const bool set : {true, false})
+                    {
+                        const uint64_t count = set ? v.EncodeRuns(runs) : v.EncodeClearRuns(runs);
+                        ASSERT_TRUE(count <= (v.kNumBits + 1) / 2);
+
+                        // The runs cover exactly the bits of the given value.
+                        uint64_t k = 0;
+                        for (uint64_t i = 0; i < v.kNumBits;)
+                        {
+                            if (v.IsBitSet(i) != set)
+                            {
+                                ++i;
+                                continue;
+                            }
+                            ASSERT_TRUE(k < count);
+                            ASSERT_EQ(runs[k].start, i);
+                            while (i < v.kNumBits && v.IsBitSet(i) == set)
+                                ++i;
+                            ASSERT_EQ(runs[k].start + runs[k].length, i);
+                            ++k;
+                        }
+                        ASSERT_EQ(k, count);
+
+                        k = 0;
+                        for (const BitRun r : set ? v.SetRuns() : v.ClearRuns())
+                        {
+                            ASSERT_TRUE(k < count);
+                            ASSERT_EQ(r.start, runs[k].start);
+                            ASSERT_EQ(r.length, runs[k].length);
+                            ++k;
+                        }
+                        ASSERT_EQ(k, count);
+                    }
+
+                    // LargestClearRun, BestFit*, from the clear runs
+                    const uint64_t count = v.EncodeClearRuns(runs);
+                    BitRun largest = { ~0ULL, 0 };
+                    for (uint64_t k = 0; k < count; ++k)
+                        largest = runs[k].length > largest.length ? runs[k] : largest;
+                    ASSERT_EQ(v.LargestClearRun().start, largest.start);
+                    ASSERT_EQ(v.LargestClearRun().length, largest.length);
+
+                    for (uint64_t n = 1; n <= v.kNumBits; n += 1 + (n >> 1))
+                    {
+                        for (uint64_t alignment = 1; alignment <= 128; alignment <<= 1)
+                        {
+                            uint64_t best = ~0ULL;
+                            uint64_t bestLength = ~0ULL;
+                            for (uint64_t k = 0; k < count; ++k)
+                            {
+                                const uint64_t aligned = (runs[k].start + alignment - 1) & ~(alignment - 1);
+                                if (runs[k].length < bestLength && aligned + n <= runs[k].start + runs[k].length)
+                                {
+                                    best = aligned;
+                                    bestLength = runs[k].length;
+                                }
+                            }
+                            ASSERT_EQ(v.BestFitAlignedBlockOfNClearBits(n, alignment), best);
+                            if (alignment == 1)
+                                ASSERT_EQ(v.BestFitBlockOfNClearBits(n), best);
+
+                            // A fit exists exactly when a first fit does.
+                            ASSERT_EQ(best == ~0ULL, v.FirstAlignedBlockOfNClearBits(n, alignment) == ~0ULL);
+                        }
+                    }
+                }
+            }
+        };
+    SweepArraySizes(testRuns);
+    SweepLargeArraySizes(testRuns);
+
     // SmallBitArray
     TestSmall(TestDefaultConstruct);
     TestSmall(TestValueConstruct);
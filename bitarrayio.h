@@ -0,0 +1,459 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#include "dynamicbitarray.h"
+
+// Streaming save and load of bit arrays, for files and sockets.
+//
+// A stream is a 20-byte header, the encoded blocks, and a 4-byte trailer:
+//
+//     offset  size
+//          0     4  magic "BITA"
+//          4     1  format version, 1
+//          5     1  encoding, BitArrayEncoding
+//          6     2  byte order tag 0x0102, in the writer's byte order
+//          8     8  number of bits
+//         16     4  CRC32C of bytes 0-15, so a damaged size is caught before anything is allocated for it
+//         20     -  encoded blocks
+//     end - 4    4  CRC32C of everything before it
+//
+// Multi-byte fields and blocks are in the writer's byte order, which the tag records; a reader on a host of the
+// other order swaps them. Bits past the size in the last block are written as zero.
+//
+// A writer encodes blocks as they are handed to it, and a reader decodes as many blocks as are asked for, each
+// through a fixed 64 KB buffer, so a bitmap of any size moves in pieces, never whole in memory.
+// Writers and readers call a sink or source:
+//
+//     sink(const uint8_t* p, uint64_t n)      write n bytes
+//     source(uint8_t* p, uint64_t n)          read up to n bytes; return the number read, 0 at the end
+//
+// e.g. [f](const uint8_t* p, uint64_t n) { fwrite(p, 1, n, f); }
+
+enum class BitArrayEncoding : uint8_t
+{
+    // Every block as is.
+    Raw = 0,
+
+    // A sequence of tokens, each a 32-bit word with a kind in the top 2 bits and a block count in the rest:
+    // a run of all-clear blocks, a run of all-set blocks, or that many blocks as is, following the token.
+    // A sparse or nearly full map costs about 8 bytes per block that is neither.
+    Runs = 1,
+};
+
+// Layout constants shared by BitArrayWriter and BitArrayReader.
+struct BitArrayStreamFormat
+{
+    static constexpr uint8_t kMagic[4] = { 'B', 'I', 'T', 'A' };
+    static constexpr uint8_t kVersion = 1;
+    static constexpr uint16_t kByteOrderTag = 0x0102;
+    static constexpr uint64_t kHeaderBytes = 20;
+
+    // Kinds of Runs tokens.
+    static constexpr uint32_t kZeros = 0;
+    static constexpr uint32_t kOnes = 1;
+    static constexpr uint32_t kLiterals = 2;
+    static constexpr uint32_t kMaxTokenCount = (1U << 30U) - 1U;
+
+    static constexpr uint64_t kBufferBytes = 65536;
+
+    // Largest size ReadBitArray() resizes a DynamicBitArray to unless told otherwise: 2^35 bits, 4 GiB.
+    static constexpr uint64_t kDefaultMaxBits = 1ULL << 35ULL;
+};
+
+// Encode a bit array to a sink, a range of blocks at a time. Pass every block, in order, to WriteBlocks(),
+// then call Finish().
+template <class Sink>
+class BitArrayWriter
+{
+    using F = BitArrayStreamFormat;
+
+public:
+    // Buffer the header of a stream of numBits bits.
+    BitArrayWriter(Sink sink, uint64_t numBits, BitArrayEncoding encoding = BitArrayEncoding::Runs) :
+        m_sink(std::move(sink)), m_buffer(new uint8_t[F::kBufferBytes]), m_numBits(numBits), m_numBlocks((numBits + 63ULL) >> 6ULL), m_encoding(encoding)
+    {
+        ASSERT(numBits <= ~0ULL - 63ULL);
+        const uint8_t version = F::kVersion;
+        const uint8_t encodingByte = uint8_t(encoding);
+        const uint16_t tag = F::kByteOrderTag;
+        Put(F::kMagic, 4);
+        Put(&version, 1);
+        Put(&encodingByte, 1);
+        Put(&tag, 2);
+        Put(&numBits, 8);
+        const uint32_t headerCrc = Crc32c_Buffer(m_buffer.get(), m_size);
+        Put(&headerCrc, 4);
+    }
+
+    // Return the number of blocks the stream holds.
+    uint64_t NumBlocks() const
+    {
+        return m_numBlocks;
+    }
+
+    // Encode the next n blocks.
+    void WriteBlocks(const uint64_t* p, uint64_t n)
+    {
+        ASSERT(m_numBlocksWritten + n <= m_numBlocks);
+
+        // The last block goes separately, masked.
+        const bool hasLast = n && m_numBlocksWritten + n == m_numBlocks;
+        const uint64_t numFull = n - hasLast;
+
+        if (m_encoding == BitArrayEncoding::Raw)
+        {
+            PutBlocks(p, numFull);
+        }
+        else
+        {
+            for (uint64_t i = 0; i < numFull; ++i)
+                PutRunsBlock(p[i]);
+        }
+
+        if (hasLast)
+        {
+            const uint64_t last = p[n - 1] & (~0ULL >> ((0ULL - m_numBits) & 63ULL));
+            if (m_encoding == BitArrayEncoding::Raw)
+                PutBlocks(&last, 1);
+            else
+                PutRunsBlock(last);
+        }
+
+        m_numBlocksWritten += n;
+    }
+
+    // Write the trailer and flush everything to the sink. Call once, after all blocks.
+    void Finish()
+    {
+        ASSERT(m_numBlocksWritten == m_numBlocks);
+
+        EndToken();
+        Reserve(4);
+        const uint32_t crc = Crc32c_Buffer(m_buffer.get(), m_size, m_crc);
+        Put(&crc, 4);
+        Flush();
+    }
+
+    // Return the number of bytes passed to the sink so far.
+    uint64_t BytesWritten() const
+    {
+        return m_bytesWritten;
+    }
+
+private:
+    void Flush()
+    {
+        if (!m_size)
+            return;
+        m_crc = Crc32c_Buffer(m_buffer.get(), m_size, m_crc);
+        m_sink(static_cast<const uint8_t*>(m_buffer.get()), m_size);
+        m_bytesWritten += m_size;
+        m_size = 0;
+    }
+
+    // Make room for n more bytes. Not while a literal token is open, as its count isn't filled in yet.
+    void Reserve(uint64_t n)
+    {
+        if (m_size + n > F::kBufferBytes)
+            Flush();
+    }
+
+    void Put(const void* p, uint64_t n)
+    {
+        memcpy(m_buffer.get() + m_size, p, n);
+        m_size += n;
+    }
+
+    void PutBlocks(const uint64_t* p, uint64_t n)
+    {
+        while (n)
+        {
+            const uint64_t room = (F::kBufferBytes - m_size) >> 3ULL;
+            if (!room)
+            {
+                Flush();
+                continue;
+            }
+
+            const uint64_t k = n < room ? n : room;
+            Put(p, k << 3ULL);
+            p += k;
+            n -= k;
+        }
+    }
+
+    void PutRunsBlock(uint64_t block)
+    {
+        const uint32_t kind = block == 0ULL ? F::kZeros : block == ~0ULL ? F::kOnes : F::kLiterals;
+
+        // A literal token ends where the buffer does, so it can be flushed with its count filled in.
+        if (!m_count || kind != m_kind || m_count == F::kMaxTokenCount || (kind == F::kLiterals && m_size + 8 > F::kBufferBytes))
+        {
+            EndToken();
+            m_kind = kind;
+            if (kind == F::kLiterals)
+            {
+                Reserve(12);
+                m_tokenOffset = m_size;
+                m_size += 4;
+            }
+        }
+
+        if (kind == F::kLiterals)
+            Put(&block, 8);
+        ++m_count;
+    }
+
+    // Write out the open token, if any.
+    void EndToken()
+    {
+        if (!m_count)
+            return;
+
+        const uint32_t token = (m_kind << 30U) | m_count;
+        if (m_kind == F::kLiterals)
+        {
+            memcpy(m_buffer.get() + m_tokenOffset, &token, 4);
+        }
+        else
+        {
+            Reserve(4);
+            Put(&token, 4);
+        }
+        m_count = 0;
+    }
+
+    Sink m_sink;
+    std::unique_ptr<uint8_t[]> m_buffer;
+    uint64_t m_size = 0;
+    uint64_t m_numBits;
+    uint64_t m_numBlocks;
+    uint64_t m_numBlocksWritten = 0;
+    uint64_t m_bytesWritten = 0;
+    uint32_t m_crc = 0;
+    BitArrayEncoding m_encoding;
+
+    // The open Runs token: its kind, its count so far, and for literals, where its word is in the buffer.
+    uint32_t m_kind = 0;
+    uint32_t m_count = 0;
+    uint64_t m_tokenOffset = 0;
+};
+
+// Decode a bit array from a source, a range of blocks at a time. Call ReadHeader(), then ReadBlocks() for every
+// block, in order, then Finish() to check the checksum. Any false return means the stream is malformed,
+// truncated, or from an unknown version; stop reading there.
+template <class Source>
+class BitArrayReader
+{
+    using F = BitArrayStreamFormat;
+
+public:
+    explicit BitArrayReader(Source source) : m_source(std::move(source)), m_buffer(new uint8_t[F::kBufferBytes])
+    {
+    }
+
+    // Read and check the header.
+    bool ReadHeader()
+    {
+        uint8_t header[F::kHeaderBytes];
+        if (!Pull(header, F::kHeaderBytes))
+            return false;
+
+        uint32_t headerCrc;
+        memcpy(&headerCrc, header + 16, 4);
+
+        if (memcmp(header, F::kMagic, 4) || header[4] != F::kVersion || header[5] > uint8_t(BitArrayEncoding::Runs))
+            return false;
+        m_encoding = BitArrayEncoding(header[5]);
+
+        uint16_t tag;
+        memcpy(&tag, header + 6, 2);
+        if (tag != F::kByteOrderTag && tag != ReverseBytes_U16(F::kByteOrderTag))
+            return false;
+        m_swap = tag != F::kByteOrderTag;
+        if ((m_swap ? ReverseBytes_U32(headerCrc) : headerCrc) != Crc32c_Buffer(header, 16))
+            return false;
+
+        memcpy(&m_numBits, header + 8, 8);
+        m_numBits = m_swap ? ReverseBytes_U64(m_numBits) : m_numBits;
+
+        // No writer could have produced a size whose block count overflows. The CRC only catches accidental
+        // damage, not a crafted stream.
+        if (m_numBits > ~0ULL - 63ULL)
+            return false;
+        m_numBlocks = (m_numBits + 63ULL) >> 6ULL;
+        return true;
+    }
+
+    // Return the number of bits in the stream. Valid after ReadHeader().
+    uint64_t NumBits() const
+    {
+        return m_numBits;
+    }
+
+    // Return the number of blocks in the stream. Valid after ReadHeader().
+    uint64_t NumBlocks() const
+    {
+        return m_numBlocks;
+    }
+
+    // Return the encoding of the stream. Valid after ReadHeader().
+    BitArrayEncoding Encoding() const
+    {
+        return m_encoding;
+    }
+
+    // Decode the next n blocks into out.
+    bool ReadBlocks(uint64_t* out, uint64_t n)
+    {
+        ASSERT(m_numBlocksRead + n <= m_numBlocks);
+        m_numBlocksRead += n;
+
+        if (m_encoding == BitArrayEncoding::Raw)
+            return PullBlocks(out, n);
+
+        while (n)
+        {
+            if (!m_count)
+            {
+                uint32_t token;
+                if (!Pull(&token, 4))
+                    return false;
+                token = m_swap ? ReverseBytes_U32(token) : token;
+                m_kind = token >> 30U;
+                m_count = token & F::kMaxTokenCount;
+                m_numBlocksInTokens += m_count;
+                if (!m_count || m_kind > F::kLiterals || m_numBlocksInTokens > m_numBlocks)
+                    return false;
+            }
+
+            const uint64_t k = n < m_count ? n : m_count;
+            if (m_kind == F::kLiterals)
+            {
+                if (!PullBlocks(out, k))
+                    return false;
+            }
+            else
+            {
+                const uint64_t fill = m_kind == F::kOnes ? ~0ULL : 0ULL;
+                for (uint64_t i = 0; i < k; ++i)
+                    out[i] = fill;
+            }
+
+            out += k;
+            n -= k;
+            m_count -= uint32_t(k);
+        }
+
+        return true;
+    }
+
+    // Read the trailer and check the checksum of everything before it.
+    bool Finish()
+    {
+        ASSERT(m_numBlocksRead == m_numBlocks);
+
+        const uint32_t expected = m_crc;
+        uint32_t crc;
+        if (!Pull(&crc, 4))
+            return false;
+        return (m_swap ? ReverseBytes_U32(crc) : crc) == expected;
+    }
+
+private:
+    // Copy the next n bytes of the stream to dst.
+    bool Pull(void* dst, uint64_t n)
+    {
+        uint8_t* d = static_cast<uint8_t*>(dst);
+        while (n)
+        {
+            if (m_pos == m_size)
+            {
+                m_size = m_source(m_buffer.get(), F::kBufferBytes);
+                m_pos = 0;
+                if (!m_size)
+                    return false;
+            }
+
+            const uint64_t k = n < m_size - m_pos ? n : m_size - m_pos;
+            memcpy(d, m_buffer.get() + m_pos, k);
+            m_crc = Crc32c_Buffer(m_buffer.get() + m_pos, k, m_crc);
+            m_pos += k;
+            d += k;
+            n -= k;
+        }
+        return true;
+    }
+
+    bool PullBlocks(uint64_t* out, uint64_t n)
+    {
+        if (!Pull(out, n << 3ULL))
+            return false;
+
+        if (m_swap)
+        {
+            for (uint64_t i = 0; i < n; ++i)
+                out[i] = ReverseBytes_U64(out[i]);
+        }
+        return true;
+    }
+
+    Source m_source;
+    std::unique_ptr<uint8_t[]> m_buffer;
+    uint64_t m_pos = 0;
+    uint64_t m_size = 0;
+    uint64_t m_numBits = 0;
+    uint64_t m_numBlocks = 0;
+    uint64_t m_numBlocksRead = 0;
+    uint64_t m_numBlocksInTokens = 0;
+    uint32_t m_crc = 0;
+    BitArrayEncoding m_encoding = BitArrayEncoding::Raw;
+    bool m_swap = false;
+
+    // The current Runs token: its kind and the blocks of it not yet read.
+    uint32_t m_kind = 0;
+    uint32_t m_count = 0;
+};
+
+// Write all of v to sink. Return the number of bytes written.
+template <class Sink>
+static inline uint64_t WriteBitArray(Sink sink, BitArrayView v, BitArrayEncoding encoding = BitArrayEncoding::Runs)
+{
+    BitArrayWriter<Sink> writer(std::move(sink), v.NumBits(), encoding);
+    writer.WriteBlocks(v.Blocks(), v.NumBlocks());
+    writer.Finish();
+    return writer.BytesWritten();
+}
+
+// Read a whole stream into dst, which must be the stream's size. Return false if it isn't, or if the stream is
+// bad; dst may then be partly overwritten.
+template <class Source>
+static inline bool ReadBitArray(Source source, BitSpan dst)
+{
+    BitArrayReader<Source> reader(std::move(source));
+    return reader.ReadHeader() && reader.NumBits() == dst.NumBits() && reader.ReadBlocks(dst.Blocks(), dst.NumBlocks()) && reader.Finish();
+}
+
+// Read a whole stream into dst, resized to the stream's size. Return false if the stream is bad, or larger than
+// maxBits, which bounds what an untrusted stream can make dst allocate; dst may then be partly overwritten.
+template <class Source>
+static inline bool ReadBitArray(Source source, DynamicBitArray& dst, uint64_t maxBits = BitArrayStreamFormat::kDefaultMaxBits)
+{
+    BitArrayReader<Source> reader(std::move(source));
+    if (!reader.ReadHeader() || reader.NumBits() > maxBits)
+        return false;
+    dst.Resize(reader.NumBits());
+    return reader.ReadBlocks(dst.Blocks(), dst.NumBlocks()) && reader.Finish();
+}
@@ -0,0 +1,250 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#include <iostream>
+#include <vector>
+
+#include "bitarrayio.h"
+#include "testutil.h"
+
+#define ASSERT_TRUE(a) do { if (!(a)) { std::cerr << "FAIL: expected true for " << #a << ", got false\n"; __debugbreak(); } } while (0)
+#define ASSERT_FALSE(a) do { if ((a)) { std::cerr << "FAIL: expected false for " << #a << ", got true\n"; __debugbreak(); } } while (0)
+
+#define ASSERT_BIN_OP(a, b, op) do {                                                            \
+    const auto& va = (a);                                                                       \
+    const auto& vb = (b);                                                                       \
+    if (!(va op vb))                                                                            \
+    {                                                                                           \
+        std::cerr << "FAIL: expected " << #a << " " << #op << " " << #b << " (evaluates to ";   \
+        std::cerr << va << " " << #op << " " << vb << ")\n";                                    \
+        __debugbreak();                                                                         \
+    }                                                                                           \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_BIN_OP(a, b, ==)
+
+// Appends to a byte vector.
+struct VectorSink
+{
+    std::vector<uint8_t>* bytes;
+
+    void operator()(const uint8_t* p, uint64_t n)
+    {
+        bytes->insert(bytes->end(), p, p + n);
+    }
+};
+
+// Reads a byte vector at most maxRead bytes at a time.
+struct VectorSource
+{
+    const std::vector<uint8_t>* bytes;
+    uint64_t maxRead;
+    uint64_t pos = 0;
+
+    uint64_t operator()(uint8_t* p, uint64_t n)
+    {
+        n = n < maxRead ? n : maxRead;
+        n = n < bytes->size() - pos ? n : bytes->size() - pos;
+        memcpy(p, bytes->data() + pos, n);
+        pos += n;
+        return n;
+    }
+};
+
+// Blocks with long runs of clear and set blocks between random ones; excess bits of the last block are garbage.
+static DynamicBitArray MakeArray(uint64_t numBits, uint64_t& state)
+{
+    DynamicBitArray v(numBits);
+    uint64_t* p = v.Blocks();
+    for (uint64_t i = 0; i < v.NumBlocks();)
+    {
+        const uint64_t len = 1 + SplitMix64(state) % 300;
+        const uint64_t r = SplitMix64(state) % 4;
+        for (uint64_t j = 0; j < len && i < v.NumBlocks(); ++j, ++i)
+            p[i] = r == 0 ? 0ULL : r == 1 ? ~0ULL : r == 2 ? SplitMix64(state) : 1ULL << (SplitMix64(state) & 63ULL);
+    }
+    return v;
+}
+
+// Write and read back in random-sized pieces, in both encodings.
+static void TestRoundTrip(uint64_t numBits, uint64_t& state)
+{
+    const DynamicBitArray v = MakeArray(numBits, state);
+
+    for (const BitArrayEncoding encoding : { BitArrayEncoding::Raw, BitArrayEncoding::Runs })
+    {
+        std::vector<uint8_t> bytes;
+        BitArrayWriter<VectorSink> writer(VectorSink{ &bytes }, numBits, encoding);
+        ASSERT_EQ(writer.NumBlocks(), v.NumBlocks());
+        for (uint64_t i = 0; i < v.NumBlocks();)
+        {
+            const uint64_t n = SplitMix64(state) % (v.NumBlocks() - i + 1);
+            writer.WriteBlocks(v.Blocks() + i, n);
+            i += n;
+        }
+        writer.Finish();
+        ASSERT_EQ(writer.BytesWritten(), uint64_t(bytes.size()));
+
+        // The same bytes in one call, and with the excess bits cleared.
+        std::vector<uint8_t> whole;
+        DynamicBitArray clean = v;
+        if (numBits)
+            clean.Blocks()[clean.NumBlocks() - 1] &= clean.LastBlockMask();
+        ASSERT_EQ(WriteBitArray(VectorSink{ &whole }, clean, encoding), uint64_t(whole.size()));
+        ASSERT_TRUE(whole == bytes);
+        if (encoding == BitArrayEncoding::Raw)
+            ASSERT_EQ(uint64_t(bytes.size()), 24ULL + (v.NumBlocks() << 3ULL));
+
+        BitArrayReader<VectorSource> reader(VectorSource{ &bytes, 1 + SplitMix64(state) % 100000 });
+        ASSERT_TRUE(reader.ReadHeader());
+        ASSERT_EQ(reader.NumBits(), numBits);
+        ASSERT_TRUE(reader.Encoding() == encoding);
+        DynamicBitArray w(numBits);
+        for (uint64_t i = 0; i < v.NumBlocks();)
+        {
+            const uint64_t n = SplitMix64(state) % (v.NumBlocks() - i + 1);
+            ASSERT_TRUE(reader.ReadBlocks(w.Blocks() + i, n));
+            i += n;
+        }
+        ASSERT_TRUE(reader.Finish());
+        ASSERT_TRUE(w == v);
+
+        DynamicBitArray d;
+        ASSERT_TRUE(ReadBitArray(VectorSource{ &bytes, ~0ULL }, d));
+        ASSERT_TRUE(d == v);
+    }
+}
+
+// A Raw stream as a writer of the other byte order would produce it.
+static std::vector<uint8_t> SwapRawStream(const std::vector<uint8_t>& bytes)
+{
+    std::vector<uint8_t> swapped = bytes;
+    uint16_t tag = ReverseBytes_U16(BitArrayStreamFormat::kByteOrderTag);
+    memcpy(swapped.data() + 6, &tag, 2);
+    for (uint64_t i = 8; i + 4 < swapped.size(); i += i == 8 ? 12 : 8)
+    {
+        uint64_t x;
+        memcpy(&x, swapped.data() + i, 8);
+        x = ReverseBytes_U64(x);
+        memcpy(swapped.data() + i, &x, 8);
+    }
+    const uint32_t headerCrc = ReverseBytes_U32(Crc32c_Buffer(swapped.data(), 16));
+    memcpy(swapped.data() + 16, &headerCrc, 4);
+    const uint32_t crc = ReverseBytes_U32(Crc32c_Buffer(swapped.data(), swapped.size() - 4));
+    memcpy(swapped.data() + swapped.size() - 4, &crc, 4);
+    return swapped;
+}
+
+void TestBitArrayIO()
+{
+    uint64_t state = 0xB17A10ULL;
+
+    for (const uint64_t numBits : { 0ULL, 1ULL, 63ULL, 64ULL, 65ULL, 4161ULL, 100000ULL, (1ULL << 21ULL) + 17ULL })
+        TestRoundTrip(numBits, state);
+
+    // A sparse map shrinks; a random one, past the writer's buffer, survives literal tokens split across flushes.
+    {
+        DynamicBitArray sparse(1ULL << 24ULL);
+        for (uint64_t k = 0; k < 100; ++k)
+            sparse.SetBit(SplitMix64(state) % sparse.NumBits());
+        std::vector<uint8_t> bytes;
+        WriteBitArray(VectorSink{ &bytes }, sparse);
+        ASSERT_TRUE(bytes.size() < 2000);
+        DynamicBitArray d;
+        ASSERT_TRUE(ReadBitArray(VectorSource{ &bytes, 777 }, d));
+        ASSERT_TRUE(d == sparse);
+
+        DynamicBitArray random(1ULL << 20ULL);
+        for (uint64_t i = 0; i < random.NumBlocks(); ++i)
+            random.Blocks()[i] = SplitMix64(state);
+        bytes.clear();
+        WriteBitArray(VectorSink{ &bytes }, random);
+        ASSERT_TRUE(ReadBitArray(VectorSource{ &bytes, 4096 }, d));
+        ASSERT_TRUE(d == random);
+    }
+
+    // Into a BitArray of the stream's size, and not of another.
+    {
+        BitArray<1000> v;
+        v.ClearAll();
+        v.SetBitsInRange(100, 900);
+        std::vector<uint8_t> bytes;
+        WriteBitArray(VectorSink{ &bytes }, v);
+
+        BitArray<1000> w;
+        ASSERT_TRUE(ReadBitArray(VectorSource{ &bytes, ~0ULL }, w));
+        ASSERT_TRUE(w == v);
+        BitArray<1001> x;
+        ASSERT_FALSE(ReadBitArray(VectorSource{ &bytes, ~0ULL }, x));
+    }
+
+    // The other byte order reads the same.
+    {
+        const DynamicBitArray v = MakeArray(5000, state);
+        std::vector<uint8_t> bytes;
+        WriteBitArray(VectorSink{ &bytes }, v, BitArrayEncoding::Raw);
+        const std::vector<uint8_t> swapped = SwapRawStream(bytes);
+        ASSERT_FALSE(swapped == bytes);
+        DynamicBitArray d;
+        ASSERT_TRUE(ReadBitArray(VectorSource{ &swapped, 1000 }, d));
+        ASSERT_EQ(d.NumBits(), 5000ULL);
+        ASSERT_TRUE(d == v);
+    }
+
+    // A size whose block count would overflow is rejected, however valid its CRCs, and so is one past the
+    // caller's limit.
+    {
+        const DynamicBitArray v = MakeArray(3000, state);
+        std::vector<uint8_t> bytes;
+        WriteBitArray(VectorSink{ &bytes }, v, BitArrayEncoding::Raw);
+
+        for (const uint64_t numBits : { ~0ULL, ~0ULL - 62ULL, BitArrayStreamFormat::kDefaultMaxBits + 1ULL })
+        {
+            std::vector<uint8_t> bad = bytes;
+            memcpy(bad.data() + 8, &numBits, 8);
+            const uint32_t headerCrc = Crc32c_Buffer(bad.data(), 16);
+            memcpy(bad.data() + 16, &headerCrc, 4);
+            const uint32_t crc = Crc32c_Buffer(bad.data(), bad.size() - 4);
+            memcpy(bad.data() + bad.size() - 4, &crc, 4);
+
+            BitArrayReader<VectorSource> reader(VectorSource{ &bad, ~0ULL });
+            ASSERT_EQ(reader.ReadHeader(), numBits == BitArrayStreamFormat::kDefaultMaxBits + 1ULL);
+            DynamicBitArray d;
+            ASSERT_FALSE(ReadBitArray(VectorSource{ &bad, ~0ULL }, d));
+            ASSERT_EQ(d.NumBits(), 0ULL);
+        }
+
+        DynamicBitArray d;
+        ASSERT_FALSE(ReadBitArray(VectorSource{ &bytes, ~0ULL }, d, 2999));
+        ASSERT_TRUE(ReadBitArray(VectorSource{ &bytes, ~0ULL }, d, 3000));
+        ASSERT_TRUE(d == v);
+    }
+
+    // Damage is caught: every single-byte change, and every truncation.
+    {
+        const DynamicBitArray v = MakeArray(3000, state);
+        for (const BitArrayEncoding encoding : { BitArrayEncoding::Raw, BitArrayEncoding::Runs })
+        {
+            std::vector<uint8_t> bytes;
+            WriteBitArray(VectorSink{ &bytes }, v, encoding);
+
+            DynamicBitArray d;
+            for (uint64_t i = 0; i < bytes.size(); ++i)
+            {
+                std::vector<uint8_t> bad = bytes;
+                bad[i] ^= uint8_t(1U << (i & 7U));
+                ASSERT_FALSE(ReadBitArray(VectorSource{ &bad, ~0ULL }, d));
+
+                bad = bytes;
+                bad.resize(i);
+                ASSERT_FALSE(ReadBitArray(VectorSource{ &bad, ~0ULL }, d));
+            }
+        }
+    }
+}
@@ -0,0 +1,314 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Opt-in instrumentation of BitArray, compiled out unless ENABLE_BITARRAY_STATS is defined (see bitarray.h).
+// The spans of bitspan.h and DynamicBitArray share BitArray's queries, and are counted under the same names.
+//
+// Each scanning method counts its calls, the blocks it reads, and its early exits: calls that returned before
+// reading every block in their span. Blocks per call show how much of each array a workload really scans, and the
+// early exit rate how predictable the loop exit is.
+//
+// BITARRAY_PERF_REGION(name) wraps the rest of a scope with Linux hardware counters, through perf_event_open:
+// cycles, instructions, branch misses, L1D read misses and LLC misses, for the calling thread. Reading them costs
+// system calls, so wrap a loop or a request, not a single call. Elsewhere, or where the kernel refuses them
+// (perf_event_paranoid, containers), regions count only their entries.
+//
+// DumpBitArrayStats() prints both as a report. Enabling the stats in one translation unit but not another gives
+// BitArray two definitions, so define ENABLE_BITARRAY_STATS for the whole program.
+
+// Counters of one instrumented method of one BitArray size or span type, registered on its first call.
+struct BitArrayMethodStats
+{
+    explicit BitArrayMethodStats(const char* methodName);
+
+    const char* name;
+    std::atomic<uint64_t> calls{ 0 };
+    std::atomic<uint64_t> blocksScanned{ 0 };
+    std::atomic<uint64_t> earlyExits{ 0 };
+    BitArrayMethodStats* next;
+};
+
+inline std::atomic<BitArrayMethodStats*> g_bitArrayMethodStats{ nullptr };
+
+inline BitArrayMethodStats::BitArrayMethodStats(const char* methodName) : name(methodName), next(g_bitArrayMethodStats.load())
+{
+    while (!g_bitArrayMethodStats.compare_exchange_weak(next, this))
+    {
+    }
+}
+
+// Counts one call of a method, which is to scan numBlocks blocks unless it exits early.
+class BitArrayStatsScope
+{
+public:
+    BitArrayStatsScope(BitArrayMethodStats& stats, uint64_t numBlocks) : m_stats(stats), m_numBlocks(numBlocks), m_blocks(0)
+    {
+    }
+
+    ~BitArrayStatsScope()
+    {
+        m_stats.calls.fetch_add(1, std::memory_order_relaxed);
+        m_stats.blocksScanned.fetch_add(m_blocks, std::memory_order_relaxed);
+        if (m_blocks < m_numBlocks)
+            m_stats.earlyExits.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    BitArrayStatsScope(const BitArrayStatsScope&) = delete;
+    BitArrayStatsScope& operator=(const BitArrayStatsScope&) = delete;
+
+    void AddBlocks(uint64_t n)
+    {
+        m_blocks += n;
+    }
+
+private:
+    BitArrayMethodStats& m_stats;
+    const uint64_t m_numBlocks;
+    uint64_t m_blocks;
+};
+
+enum BitArrayPerfCounter
+{
+    kBitArrayPerfCycles,
+    kBitArrayPerfInstructions,
+    kBitArrayPerfBranchMisses,
+    kBitArrayPerfL1DMisses,
+    kBitArrayPerfLLCMisses,
+    kNumBitArrayPerfCounters,
+};
+
+// Hardware counters of the calling thread, as one perf_event_open group, so that they count over the same
+// intervals. A counter the kernel refuses stays closed, and reads as 0.
+class BitArrayPerfCounters
+{
+public:
+    BitArrayPerfCounters()
+    {
+        for (int& fd : m_fd)
+            fd = -1;
+
+#if defined(__linux__)
+        static constexpr struct { uint32_t type; uint64_t config; } kEvents[kNumBitArrayPerfCounters] = {
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+            { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        };
+
+        for (uint32_t i = 0; i < kNumBitArrayPerfCounters; ++i)
+        {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = kEvents[i].type;
+            attr.config = kEvents[i].config;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            m_fd[i] = int(syscall(SYS_perf_event_open, &attr, 0, -1, m_fd[0], 0));
+
+            // Without a leader, there is no group to join.
+            if (i == 0 && m_fd[0] < 0)
+                break;
+        }
+#endif
+    }
+
+    ~BitArrayPerfCounters()
+    {
+#if defined(__linux__)
+        for (const int fd : m_fd)
+        {
+            if (fd >= 0)
+                close(fd);
+        }
+#endif
+    }
+
+    BitArrayPerfCounters(const BitArrayPerfCounters&) = delete;
+    BitArrayPerfCounters& operator=(const BitArrayPerfCounters&) = delete;
+
+    // Check if a counter is open.
+    bool IsAvailable(uint32_t i) const
+    {
+        return m_fd[i] >= 0;
+    }
+
+    // Read every counter into values.
+    void Read(uint64_t* values) const
+    {
+        for (uint32_t i = 0; i < kNumBitArrayPerfCounters; ++i)
+        {
+            values[i] = 0;
+#if defined(__linux__)
+            if (m_fd[i] >= 0 && read(m_fd[i], &values[i], sizeof(values[i])) != sizeof(values[i]))
+                values[i] = 0;
+#endif
+        }
+    }
+
+private:
+    int m_fd[kNumBitArrayPerfCounters];
+};
+
+// Return the calling thread's counters, opened on first use.
+static inline const BitArrayPerfCounters& GetThreadBitArrayPerfCounters()
+{
+    thread_local const BitArrayPerfCounters counters;
+    return counters;
+}
+
+// Counter totals of one region, registered on its first entry.
+struct BitArrayPerfRegionStats
+{
+    explicit BitArrayPerfRegionStats(const char* regionName);
+
+    const char* name;
+    std::atomic<uint64_t> entries{ 0 };
+    std::atomic<uint64_t> counts[kNumBitArrayPerfCounters] = {};
+    BitArrayPerfRegionStats* next;
+};
+
+inline std::atomic<BitArrayPerfRegionStats*> g_bitArrayPerfRegionStats{ nullptr };
+
+inline BitArrayPerfRegionStats::BitArrayPerfRegionStats(const char* regionName) : name(regionName), next(g_bitArrayPerfRegionStats.load())
+{
+    while (!g_bitArrayPerfRegionStats.compare_exchange_weak(next, this))
+    {
+    }
+}
+
+// Adds the counts between its construction and destruction to a region.
+class BitArrayPerfRegion
+{
+public:
+    explicit BitArrayPerfRegion(BitArrayPerfRegionStats& stats) : m_stats(stats), m_counters(GetThreadBitArrayPerfCounters())
+    {
+        m_counters.Read(m_start);
+    }
+
+    ~BitArrayPerfRegion()
+    {
+        uint64_t end[kNumBitArrayPerfCounters];
+        m_counters.Read(end);
+        m_stats.entries.fetch_add(1, std::memory_order_relaxed);
+        for (uint32_t i = 0; i < kNumBitArrayPerfCounters; ++i)
+            m_stats.counts[i].fetch_add(end[i] - m_start[i], std::memory_order_relaxed);
+    }
+
+    BitArrayPerfRegion(const BitArrayPerfRegion&) = delete;
+    BitArrayPerfRegion& operator=(const BitArrayPerfRegion&) = delete;
+
+private:
+    BitArrayPerfRegionStats& m_stats;
+    const BitArrayPerfCounters& m_counters;
+    uint64_t m_start[kNumBitArrayPerfCounters];
+};
+
+// Totals of a method over every BitArray size.
+struct BitArrayMethodTotals
+{
+    uint64_t calls;
+    uint64_t blocksScanned;
+    uint64_t earlyExits;
+};
+
+// Return the totals of a method, all 0 if it has never been called.
+static inline BitArrayMethodTotals GetBitArrayMethodTotals(const char* name)
+{
+    BitArrayMethodTotals t = { 0, 0, 0 };
+    for (const BitArrayMethodStats* s = g_bitArrayMethodStats.load(); s; s = s->next)
+    {
+        if (!strcmp(s->name, name))
+        {
+            t.calls += s->calls.load(std::memory_order_relaxed);
+            t.blocksScanned += s->blocksScanned.load(std::memory_order_relaxed);
+            t.earlyExits += s->earlyExits.load(std::memory_order_relaxed);
+        }
+    }
+    return t;
+}
+
+// Zero every count.
+static inline void ResetBitArrayStats()
+{
+    for (BitArrayMethodStats* s = g_bitArrayMethodStats.load(); s; s = s->next)
+    {
+        s->calls.store(0, std::memory_order_relaxed);
+        s->blocksScanned.store(0, std::memory_order_relaxed);
+        s->earlyExits.store(0, std::memory_order_relaxed);
+    }
+
+    for (BitArrayPerfRegionStats* s = g_bitArrayPerfRegionStats.load(); s; s = s->next)
+    {
+        s->entries.store(0, std::memory_order_relaxed);
+        for (std::atomic<uint64_t>& c : s->counts)
+            c.store(0, std::memory_order_relaxed);
+    }
+}
+
+// Print the counts of each method that has been called, summed over BitArray sizes, then those of each region.
+static inline void DumpBitArrayStats(FILE* f = stdout)
+{
+    std::map<std::string, BitArrayMethodTotals> methods;
+    for (const BitArrayMethodStats* s = g_bitArrayMethodStats.load(); s; s = s->next)
+        methods.emplace(s->name, GetBitArrayMethodTotals(s->name));
+
+    fprintf(f, "%-32s %14s %16s %12s %12s\n", "method", "calls", "blocks scanned", "blocks/call", "early exit");
+    for (const auto& [name, t] : methods)
+    {
+        if (t.calls)
+            fprintf(f, "%-32s %14llu %16llu %12.2f %11.2f%%\n", name.c_str(), static_cast<unsigned long long>(t.calls), static_cast<unsigned long long>(t.blocksScanned),
+                double(t.blocksScanned) / double(t.calls), 100.0 * double(t.earlyExits) / double(t.calls));
+    }
+
+    if (!g_bitArrayPerfRegionStats.load())
+        return;
+
+    const BitArrayPerfCounters& counters = GetThreadBitArrayPerfCounters();
+    static constexpr const char* kNames[kNumBitArrayPerfCounters] = { "cycles", "instructions", "branch misses", "L1D misses", "LLC misses" };
+    fprintf(f, "\n%-32s %14s", "region", "entries");
+    for (const char* name : kNames)
+        fprintf(f, " %16s", name);
+    fprintf(f, " %8s\n", "IPC");
+
+    for (const BitArrayPerfRegionStats* s = g_bitArrayPerfRegionStats.load(); s; s = s->next)
+    {
+        fprintf(f, "%-32s %14llu", s->name, static_cast<unsigned long long>(s->entries.load(std::memory_order_relaxed)));
+        for (uint32_t i = 0; i < kNumBitArrayPerfCounters; ++i)
+        {
+            if (counters.IsAvailable(i))
+                fprintf(f, " %16llu", static_cast<unsigned long long>(s->counts[i].load(std::memory_order_relaxed)));
+            else
+                fprintf(f, " %16s", "n/a");
+        }
+
+        const uint64_t cycles = s->counts[kBitArrayPerfCycles].load(std::memory_order_relaxed);
+        const uint64_t instructions = s->counts[kBitArrayPerfInstructions].load(std::memory_order_relaxed);
+        if (cycles && instructions)
+            fprintf(f, " %8.2f\n", double(instructions) / double(cycles));
+        else
+            fprintf(f, " %8s\n", "n/a");
+    }
+}
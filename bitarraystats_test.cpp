@@ -0,0 +1,126 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#include <iostream>
+
+// The stats change BitArray's definition, which must be the same in every translation unit, so this file is a
+// program of its own rather than part of main.cpp's.
+#ifndef ENABLE_BITARRAY_STATS
+#define ENABLE_BITARRAY_STATS
+#endif
+#include "bitspan.h"
+
+#define ASSERT_TRUE(a) do { if (!(a)) { std::cerr << "FAIL: expected true for " << #a << ", got false\n"; __debugbreak(); } } while (0)
+#define ASSERT_FALSE(a) do { if ((a)) { std::cerr << "FAIL: expected false for " << #a << ", got true\n"; __debugbreak(); } } while (0)
+
+#define ASSERT_BIN_OP(a, b, op) do {                                                            \
+    const auto& va = (a);                                                                       \
+    const auto& vb = (b);                                                                       \
+    if (!(va op vb))                                                                            \
+    {                                                                                           \
+        std::cerr << "FAIL: expected " << #a << " " << #op << " " << #b << " (evaluates to ";   \
+        std::cerr << va << " " << #op << " " << vb << ")\n";                                    \
+        __debugbreak();                                                                         \
+    }                                                                                           \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_BIN_OP(a, b, ==)
+
+static void AssertTotals(const char* method, uint64_t calls, uint64_t blocksScanned, uint64_t earlyExits)
+{
+    const BitArrayMethodTotals t = GetBitArrayMethodTotals(method);
+    ASSERT_EQ(t.calls, calls);
+    ASSERT_EQ(t.blocksScanned, blocksScanned);
+    ASSERT_EQ(t.earlyExits, earlyExits);
+}
+
+static void TestBitArrayStats()
+{
+    static BitArray<4099> v;
+    static BitArray<4099> w;
+    constexpr uint64_t kNumBlocks = BitArray<4099>::kNumBlocks;
+    ResetBitArrayStats();
+    AssertTotals("FirstSetBitIndex", 0, 0, 0);
+
+    // A full scan, then one that stops in the second block.
+    v.ClearAll();
+    ASSERT_EQ(v.FirstSetBitIndex(), ~0ULL);
+    AssertTotals("FirstSetBitIndex", 1, kNumBlocks, 0);
+    v.SetBit(100);
+    ASSERT_EQ(v.FirstSetBitIndex(), 100ULL);
+    AssertTotals("FirstSetBitIndex", 2, kNumBlocks + 2, 1);
+
+    // Scans from an index count from its block.
+    ASSERT_EQ(v.NextSetBitIndex(64), 100ULL);
+    AssertTotals("NextSetBitIndex", 1, 1, 1);
+    ASSERT_EQ(v.NextSetBitIndex(100), ~0ULL);
+    AssertTotals("NextSetBitIndex", 2, 1 + kNumBlocks - 1, 1);
+    ASSERT_EQ(v.PrevSetBitIndex(4000), 100ULL);
+    AssertTotals("PrevSetBitIndex", 1, 4000 / 64 - 1 + 1, 1);
+
+    // Range scans count only the blocks of the range.
+    ASSERT_TRUE(v.AreAllBitsInRangeClear(200, 4098));
+    AssertTotals("AreAllBitsInRangeClear", 1, 4098 / 64 - 200 / 64 + 1, 0);
+    ASSERT_FALSE(v.AreAllBitsInRangeClear(0, 4098));
+    AssertTotals("AreAllBitsInRangeClear", 2, 4098 / 64 - 200 / 64 + 1 + 2, 1);
+    ASSERT_TRUE(v.AreAllBitsInRangeClear(5, 6));
+    AssertTotals("AreAllBitsInRangeClear", 3, 4098 / 64 - 200 / 64 + 1 + 2 + 1, 1);
+    ASSERT_EQ(v.CountSetBitsInRange(0, 4098), 1ULL);
+    AssertTotals("CountSetBitsInRange", 1, kNumBlocks, 0);
+
+    // Counts add up over sizes.
+    static BitArray<777> u;
+    u.ClearAll();
+    ASSERT_EQ(v.CountSetBits() + u.CountSetBits(), 1ULL);
+    AssertTotals("CountSetBits", 2, kNumBlocks + BitArray<777>::kNumBlocks, 0);
+
+    // Spans share the queries, and their counts.
+    ASSERT_EQ(BitArrayView(u).CountSetBits(), 0ULL);
+    AssertTotals("CountSetBits", 3, kNumBlocks + 2 * BitArray<777>::kNumBlocks, 0);
+
+    w = v;
+    ASSERT_TRUE(v == w);
+    w.SetBit(4098);
+    ASSERT_FALSE(v == w);
+    AssertTotals("operator==", 2, 2 * kNumBlocks, 0);
+    w.SetBit(0);
+    ASSERT_FALSE(v == w);
+    AssertTotals("operator==", 3, 2 * kNumBlocks + 1, 1);
+
+    // Regions count their entries, and, where the kernel allows, hardware events.
+    for (uint64_t k = 0; k < 3; ++k)
+    {
+        BITARRAY_PERF_REGION("test region");
+        for (uint64_t i = 0; i < 1000; ++i)
+            ASSERT_EQ(v.FirstSetBitIndex(), 100ULL);
+    }
+
+    ASSERT_EQ(g_bitArrayPerfRegionStats.load()->entries.load(), 3ULL);
+    if (GetThreadBitArrayPerfCounters().IsAvailable(kBitArrayPerfInstructions))
+        ASSERT_TRUE(g_bitArrayPerfRegionStats.load()->counts[kBitArrayPerfInstructions].load() > 3000ULL);
+
+    FILE* f = tmpfile();
+    ASSERT_TRUE(f != nullptr);
+    DumpBitArrayStats(f);
+    rewind(f);
+    char report[8192] = {};
+    ASSERT_TRUE(fread(report, 1, sizeof(report) - 1, f) > 0);
+    fclose(f);
+    ASSERT_TRUE(strstr(report, "FirstSetBitIndex") != nullptr);
+    ASSERT_TRUE(strstr(report, "test region") != nullptr);
+    ASSERT_TRUE(strstr(report, "LastSetBitIndex") == nullptr);
+
+    ResetBitArrayStats();
+    AssertTotals("FirstSetBitIndex", 0, 0, 0);
+}
+
+int main()
+{
+    TestBitArrayStats();
+}
@@ -0,0 +1,309 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#pragma once
+
+#include <type_traits>
+
+#include "dynamicbitarray.h"
+
+// Lazy bitwise expressions over BitArray, DynamicBitArray, and BitArrayView.
+//
+// The eager operators (a & b, ~a, ...) each produce a full temporary array. Wrapping one operand in Lazy()
+// instead builds an expression tree of &, |, ^ and ~ that is evaluated one block at a time, in a single pass
+// over the inputs and with no temporaries:
+//
+//     Assign(dst, (Lazy(a) & b) | (Lazy(c) & ~Lazy(d)));
+//     const uint64_t n = CountSetBits(Lazy(a) & ~Lazy(b));
+//
+// Any operator with at least one expression operand builds a bigger expression; the other operand may be an
+// array. All operands must have the same size. An expression refers to its arrays; do not keep one beyond
+// their lifetime. dst may be one of the operands.
+
+// Tag base of every expression node.
+struct BitExprBase
+{
+};
+
+template <class E>
+struct BitExpr : BitExprBase
+{
+};
+
+// A BitArray, DynamicBitArray, or view, read in place.
+class BitExprLeaf : public BitExpr<BitExprLeaf>
+{
+public:
+    BitExprLeaf(const uint64_t* block, uint64_t numBits) : m_block(block), m_numBits(numBits)
+    {
+    }
+
+    uint64_t NumBits() const
+    {
+        return m_numBits;
+    }
+
+    uint64_t Block(uint64_t i) const
+    {
+        return m_block[i];
+    }
+
+private:
+    const uint64_t* m_block;
+    uint64_t m_numBits;
+};
+
+// Op applied blockwise to two expressions. Op is one of the BitOp* structs from bitops.h.
+template <class L, class R, class Op>
+class BitExprBinary : public BitExpr<BitExprBinary<L, R, Op>>
+{
+public:
+    BitExprBinary(const L& l, const R& r) : m_l(l), m_r(r)
+    {
+        ASSERT(l.NumBits() == r.NumBits());
+    }
+
+    uint64_t NumBits() const
+    {
+        return m_l.NumBits();
+    }
+
+    uint64_t Block(uint64_t i) const
+    {
+        return Op::U64(m_l.Block(i), m_r.Block(i));
+    }
+
+private:
+    L m_l;
+    R m_r;
+};
+
+template <class E>
+class BitExprNot : public BitExpr<BitExprNot<E>>
+{
+public:
+    explicit BitExprNot(const E& e) : m_e(e)
+    {
+    }
+
+    uint64_t NumBits() const
+    {
+        return m_e.NumBits();
+    }
+
+    uint64_t Block(uint64_t i) const
+    {
+        return ~m_e.Block(i);
+    }
+
+private:
+    E m_e;
+};
+
+// Start an expression from an array.
+template <uint64_t kNBits>
+[[nodiscard]] static inline BitExprLeaf Lazy(const BitArray<kNBits>& v)
+{
+    return BitExprLeaf(v.Blocks(), kNBits);
+}
+
+// Start an expression from a DynamicBitArray or view.
+[[nodiscard]] static inline BitExprLeaf Lazy(BitArrayView v)
+{
+    return BitExprLeaf(v.Blocks(), v.NumBits());
+}
+
+template <class E, std::enable_if_t<std::is_base_of_v<BitExprBase, E>, int> = 0>
+[[nodiscard]] static inline const E& Lazy(const E& e)
+{
+    return e;
+}
+
+// True for the types an expression operator accepts, as long as one side is an expression.
+template <class T>
+struct IsBitExprOperand : std::is_base_of<BitExprBase, T>
+{
+};
+
+template <uint64_t kNBits>
+struct IsBitExprOperand<BitArray<kNBits>> : std::true_type
+{
+};
+
+template <>
+struct IsBitExprOperand<DynamicBitArray> : std::true_type
+{
+};
+
+template <>
+struct IsBitExprOperand<BitArrayView> : std::true_type
+{
+};
+
+template <>
+struct IsBitExprOperand<BitSpan> : std::true_type
+{
+};
+
+template <class L, class R>
+static constexpr bool kIsBitExprBinary = IsBitExprOperand<L>::value && IsBitExprOperand<R>::value &&
+    (std::is_base_of_v<BitExprBase, L> || std::is_base_of_v<BitExprBase, R>);
+
+template <class T>
+using BitExprOf = std::decay_t<decltype(Lazy(std::declval<const T&>()))>;
+
+template <class L, class R, std::enable_if_t<kIsBitExprBinary<L, R>, int> = 0>
+[[nodiscard]] static inline BitExprBinary<BitExprOf<L>, BitExprOf<R>, BitOpAnd> operator&(const L& l, const R& r)
+{
+    return { Lazy(l), Lazy(r) };
+}
+
+template <class L, class R, std::enable_if_t<kIsBitExprBinary<L, R>, int> = 0>
+[[nodiscard]] static inline BitExprBinary<BitExprOf<L>, BitExprOf<R>, BitOpOr> operator|(const L& l, const R& r)
+{
+    return { Lazy(l), Lazy(r) };
+}
+
+template <class L, class R, std::enable_if_t<kIsBitExprBinary<L, R>, int> = 0>
+[[nodiscard]] static inline BitExprBinary<BitExprOf<L>, BitExprOf<R>, BitOpXor> operator^(const L& l, const R& r)
+{
+    return { Lazy(l), Lazy(r) };
+}
+
+template <class E>
+[[nodiscard]] static inline BitExprNot<E> operator~(const BitExpr<E>& e)
+{
+    return BitExprNot<E>(static_cast<const E&>(e));
+}
+
+// a & ~b in one node, so that it maps to andn.
+template <class L, class R, std::enable_if_t<kIsBitExprBinary<L, R>, int> = 0>
+[[nodiscard]] static inline BitExprBinary<BitExprOf<L>, BitExprOf<R>, BitOpAndNot> AndNot(const L& l, const R& r)
+{
+    return { Lazy(l), Lazy(r) };
+}
+
+// Evaluate e into dst in a single pass.
+template <uint64_t kNBits, class E>
+static inline void Assign(BitArray<kNBits>& dst, const BitExpr<E>& e)
+{
+    const E& x = static_cast<const E&>(e);
+    ASSERT(x.NumBits() == kNBits);
+    uint64_t* p = dst.Blocks();
+    for (uint64_t i = 0; i < BitArray<kNBits>::kNumBlocks; ++i)
+        p[i] = x.Block(i);
+}
+
+// Evaluate e into dst in a single pass.
+template <class E>
+static inline void Assign(BitSpan dst, const BitExpr<E>& e)
+{
+    const E& x = static_cast<const E&>(e);
+    ASSERT(x.NumBits() == dst.NumBits());
+    uint64_t* p = dst.Blocks();
+    const uint64_t numBlocks = dst.NumBlocks();
+    for (uint64_t i = 0; i < numBlocks; ++i)
+        p[i] = x.Block(i);
+}
+
+// Evaluate e into dst in a single pass.
+template <class E>
+static inline void Assign(DynamicBitArray& dst, const BitExpr<E>& e)
+{
+    Assign(dst.Span(), e);
+}
+
+// Return the number of set bits in e, without materializing it.
+// Large expressions are evaluated a chunk at a time into an L1-resident buffer for the vectorized count.
+template <class E>
+[[nodiscard]] static inline uint64_t CountSetBits(const BitExpr<E>& e)
+{
+    static constexpr uint64_t kChunkBlocks = 256;
+
+    const E& x = static_cast<const E&>(e);
+    const uint64_t numBits = x.NumBits();
+    ASSERT(numBits);
+    const uint64_t numBlocks = (numBits + 63ULL) >> 6ULL;
+
+    uint64_t count = 0;
+    uint64_t i = 0;
+    if (numBlocks - 1 >= kChunkBlocks)
+    {
+        alignas(64) uint64_t chunk[kChunkBlocks];
+        for (; i + kChunkBlocks <= numBlocks - 1; i += kChunkBlocks)
+        {
+            for (uint64_t j = 0; j < kChunkBlocks; ++j)
+                chunk[j] = x.Block(i + j);
+            count += CountSetBits_Blocks(chunk, kChunkBlocks);
+        }
+    }
+
+    for (; i < numBlocks - 1; ++i)
+        count += CountSetBits_U64(x.Block(i));
+
+    return count + CountSetBits_U64(x.Block(numBlocks - 1) & (~0ULL >> ((0ULL - numBits) & 63ULL)));
+}
+
+// Return true if all bits of e are set, without materializing it.
+template <class E>
+[[nodiscard]] static inline bool AreAllBitsSet(const BitExpr<E>& e)
+{
+    const E& x = static_cast<const E&>(e);
+    const uint64_t numBits = x.NumBits();
+    ASSERT(numBits);
+    const uint64_t numBlocks = (numBits + 63ULL) >> 6ULL;
+
+    // Test 8 blocks at a time, so that the inner loop has no branch.
+    uint64_t i = 0;
+    for (; i + 8 <= numBlocks - 1; i += 8)
+    {
+        uint64_t acc = ~0ULL;
+        for (uint64_t j = 0; j < 8; ++j)
+            acc &= x.Block(i + j);
+        if (~acc)
+            return false;
+    }
+
+    for (; i < numBlocks - 1; ++i)
+    {
+        if (~x.Block(i))
+            return false;
+    }
+
+    return !(~x.Block(numBlocks - 1) & (~0ULL >> ((0ULL - numBits) & 63ULL)));
+}
+
+// Return true if all bits of e are clear, without materializing it.
+template <class E>
+[[nodiscard]] static inline bool AreAllBitsClear(const BitExpr<E>& e)
+{
+    const E& x = static_cast<const E&>(e);
+    const uint64_t numBits = x.NumBits();
+    ASSERT(numBits);
+    const uint64_t numBlocks = (numBits + 63ULL) >> 6ULL;
+
+    // Test 8 blocks at a time, so that the inner loop has no branch.
+    uint64_t i = 0;
+    for (; i + 8 <= numBlocks - 1; i += 8)
+    {
+        uint64_t acc = 0ULL;
+        for (uint64_t j = 0; j < 8; ++j)
+            acc |= x.Block(i + j);
+        if (acc)
+            return false;
+    }
+
+    for (; i < numBlocks - 1; ++i)
+    {
+        if (x.Block(i))
+            return false;
+    }
+
+    return !(x.Block(numBlocks - 1) & (~0ULL >> ((0ULL - numBits) & 63ULL)));
+}
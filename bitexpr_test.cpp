@@ -0,0 +1,128 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#include <iostream>
+
+#include "bitexpr.h"
+#include "testutil.h"
+
+#define ASSERT_TRUE(a) do { if (!(a)) { std::cerr << "FAIL: expected true for " << #a << ", got false\n"; __debugbreak(); } } while (0)
+
+#define ASSERT_BIN_OP(a, b, op) do {                                                            \
+    const auto& va = (a);                                                                       \
+    const auto& vb = (b);                                                                       \
+    if (!(va op vb))                                                                            \
+    {                                                                                           \
+        std::cerr << "FAIL: expected " << #a << " " << #op << " " << #b << " (evaluates to ";   \
+        std::cerr << va << " " << #op << " " << vb << ")\n";                                    \
+        __debugbreak();                                                                         \
+    }                                                                                           \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_BIN_OP(a, b, ==)
+
+// Fill with pseudorandom blocks, including the excess bits of the last block.
+template <size_t n>
+static void FillRandom(BitArray<n>& v, uint64_t& state)
+{
+    for (uint64_t i = 0; i < BitArray<n>::kNumBlocks; ++i)
+        v.Blocks()[i] = SplitMix64(state);
+}
+
+template <size_t n>
+static void TestExpressions(uint64_t& state)
+{
+    BitArray<n> a, b, c, d;
+    FillRandom(a, state);
+    FillRandom(b, state);
+    FillRandom(c, state);
+    FillRandom(d, state);
+
+    // Assign
+    {
+        BitArray<n> r;
+        Assign(r, (Lazy(a) & b) | (Lazy(c) & ~Lazy(d)));
+        ASSERT_TRUE(r == ((a & b) | (c & ~d)));
+
+        Assign(r, Lazy(a) ^ b ^ c);
+        ASSERT_TRUE(r == (a ^ b ^ c));
+
+        Assign(r, ~(Lazy(a) | b));
+        ASSERT_TRUE(r == ~(a | b));
+
+        Assign(r, AndNot(Lazy(a), b));
+        ASSERT_TRUE(r == AndNot(a, b));
+
+        Assign(r, AndNot(a, Lazy(b) ^ c));
+        ASSERT_TRUE(r == AndNot(a, b ^ c));
+
+        Assign(r, Lazy(a));
+        ASSERT_TRUE(r == a);
+    }
+
+    // Assign into an operand
+    {
+        BitArray<n> r = a;
+        Assign(r, (Lazy(r) & ~Lazy(b)) | c);
+        ASSERT_TRUE(r == ((a & ~b) | c));
+    }
+
+    // reductions
+    {
+        ASSERT_EQ(CountSetBits(Lazy(a) & b), (a & b).CountSetBits());
+        ASSERT_EQ(CountSetBits((Lazy(a) | b) ^ ~Lazy(c)), ((a | b) ^ ~c).CountSetBits());
+        ASSERT_EQ(CountSetBits(Lazy(a) | ~Lazy(a)), uint64_t(n));
+        ASSERT_EQ(CountSetBits(Lazy(a) & ~Lazy(a)), 0ULL);
+
+        ASSERT_TRUE(AreAllBitsSet(Lazy(a) | ~Lazy(a)));
+        ASSERT_TRUE(AreAllBitsClear(Lazy(a) & ~Lazy(a)));
+        ASSERT_EQ(AreAllBitsSet(Lazy(a) | b | c | d), (a | b | c | d).AreAllBitsSet());
+        ASSERT_EQ(AreAllBitsClear(Lazy(a) & b & c & d), (a & b & c & d).AreAllBitsClear());
+
+        // A single differing bit anywhere, including the last valid one, must be seen.
+        for (uint64_t i : { uint64_t(0), uint64_t(n / 2), uint64_t(n - 1) })
+        {
+            BitArray<n> e = a;
+            e.XorBit(i);
+            ASSERT_TRUE(!AreAllBitsClear(Lazy(a) ^ e));
+            ASSERT_EQ(CountSetBits(Lazy(a) ^ e), 1ULL);
+            ASSERT_TRUE(!AreAllBitsSet(~(Lazy(a) ^ e)));
+        }
+    }
+}
+
+void TestBitExpr()
+{
+    uint64_t state = 0xE4E4E4E4ULL;
+
+    TestExpressions<1>(state);
+    TestExpressions<63>(state);
+    TestExpressions<64>(state);
+    TestExpressions<65>(state);
+    TestExpressions<511>(state);
+    TestExpressions<577>(state);
+    TestExpressions<16384>(state);
+    TestExpressions<16447>(state);
+    TestExpressions<40000>(state);
+
+    // DynamicBitArray
+    {
+        DynamicBitArray a(3000), b(3000), r(3000);
+        for (uint64_t i = 0; i < a.NumBlocks(); ++i)
+        {
+            a.Blocks()[i] = SplitMix64(state);
+            b.Blocks()[i] = SplitMix64(state);
+        }
+
+        Assign(r, Lazy(a) & ~Lazy(b));
+        ASSERT_TRUE(r == AndNot(a, b));
+        ASSERT_EQ(CountSetBits(Lazy(a) ^ b), (a ^ b).CountSetBits());
+        ASSERT_TRUE(AreAllBitsClear(Lazy(r) & b));
+    }
+}
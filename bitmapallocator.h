@@ -0,0 +1,165 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#pragma once
+
+#include "bitspan.h"
+
+// Where BitmapAllocator starts each search.
+enum class BitmapAllocatorPolicy
+{
+    // From the lowest free unit, keeping allocations packed toward the start of the map.
+    FirstFit,
+
+    // From just past the previous allocation made with the same hint, wrapping around once. Spreads churn over the
+    // whole map instead of rescanning the busy front of it each time.
+    NextFit,
+};
+
+// Where a NextFit search starts. Give each thread its own (e.g. thread_local) hint, started at a different part of
+// the map, so that threads sharing an allocator carve separate regions and don't interleave their allocations.
+struct BitmapAllocatorHint
+{
+    uint64_t next = 0;
+};
+
+// Allocator of runs of units (pages, slabs, slots) out of kNBits, one bit per unit, set while allocated.
+//
+// A search is the word-parallel first fit of FirstAlignedBlockOfNClearBits(), but started from a hint rather than
+// from unit 0, walking runs of free units only up to the first block boundary. The free count is kept, so a request
+// larger than what is left fails immediately, and FirstFit keeps a floor below which every unit is allocated, so it
+// never rescans the full prefix of the map.
+//
+// Not thread-safe: share it between threads behind a lock, each thread with its own BitmapAllocatorHint.
+template <uint64_t kNBits, BitmapAllocatorPolicy kPolicy = BitmapAllocatorPolicy::NextFit>
+class BitmapAllocator
+{
+public:
+    static constexpr uint64_t kNumBits = kNBits;
+
+    // All units start free.
+    BitmapAllocator() : m_numFree(kNumBits), m_firstFree(0)
+    {
+        m_bits.ClearAll();
+    }
+
+    // Allocate n consecutive units, the first aligned to alignment, a power of 2. Return the index of the first, or
+    // ~0ULL if there is no such run free. NextFit searches from the allocator's own hint.
+    uint64_t Allocate(uint64_t n, uint64_t alignment = 1)
+    {
+        return Allocate(n, alignment, m_hint);
+    }
+
+    // Allocate n consecutive units, the first aligned to alignment, a power of 2. Return the index of the first, or
+    // ~0ULL if there is no such run free. NextFit searches from hint, and advances it past the allocation.
+    uint64_t Allocate(uint64_t n, uint64_t alignment, BitmapAllocatorHint& hint)
+    {
+        ASSERT(n != 0);
+        ASSERT(IsPowerOf2AndNotZero_U64(alignment));
+
+        if (n > m_numFree)
+            return ~0ULL;
+
+        uint64_t i = ~0ULL;
+        bool fromFloor = true;
+        if constexpr (kPolicy == BitmapAllocatorPolicy::NextFit)
+        {
+            if (hint.next > m_firstFree && hint.next < kNumBits)
+            {
+                i = FindFrom(hint.next, n, alignment);
+                fromFloor = i == ~0ULL;
+            }
+        }
+        if (fromFloor)
+            i = FindFrom(m_firstFree, n, alignment);
+
+        if (i == ~0ULL)
+            return ~0ULL;
+
+        m_bits.SetBitsInRange(i, i + n - 1);
+        m_numFree -= n;
+        hint.next = i + n;
+
+        // A single unit found from the floor was the first free one, so everything up to it is now allocated.
+        // Otherwise there may be holes too small or misaligned for this request below it.
+        if (i == m_firstFree || (fromFloor && n == 1 && alignment == 1))
+            m_firstFree = i + n;
+        return i;
+    }
+
+    // Free the n units starting at index, all of which must be allocated.
+    void Free(uint64_t index, uint64_t n)
+    {
+        ASSERT(n != 0);
+        ASSERT(index + n <= kNumBits);
+        ASSERT(m_bits.AreAllBitsInRangeSet(index, index + n - 1));
+
+        m_bits.ClearBitsInRange(index, index + n - 1);
+        m_numFree += n;
+        m_firstFree = index < m_firstFree ? index : m_firstFree;
+    }
+
+    // Return the number of free units. O(1).
+    uint64_t NumFree() const
+    {
+        return m_numFree;
+    }
+
+    // Return the number of allocated units. O(1).
+    uint64_t NumAllocated() const
+    {
+        return kNumBits - m_numFree;
+    }
+
+    // Check if a unit is allocated.
+    bool IsAllocated(uint64_t index) const
+    {
+        return m_bits.IsBitSet(index);
+    }
+
+    // Return the map itself, one bit per unit, set while allocated.
+    const BitArray<kNumBits>& Bits() const
+    {
+        return m_bits;
+    }
+
+private:
+    // Return the first index at or after i, aligned to alignment, that starts n free units, or ~0ULL if there is none.
+    // Runs of free units starting before the next block (or multiple of alignment, if larger) are walked one at a
+    // time. Past that, the search is BitArrayView's over the rest of the map, whose start is then aligned, so that
+    // alignment within the view is alignment within the map.
+    uint64_t FindFrom(uint64_t i, uint64_t n, uint64_t alignment) const
+    {
+        const uint64_t step = alignment > 64ULL ? alignment : 64ULL;
+        const uint64_t iRest = (i + step) & ~(step - 1ULL);
+
+        uint64_t end = 0;
+        for (uint64_t start = NextRun_Blocks(m_bits.Blocks(), kNumBits, i, ~0ULL, end); start < iRest && start < kNumBits; start = NextRun_Blocks(m_bits.Blocks(), kNumBits, end, ~0ULL, end))
+        {
+            const uint64_t aligned = (start + alignment - 1ULL) & ~(alignment - 1ULL);
+            if (aligned + n <= end)
+                return aligned;
+        }
+
+        if (iRest >= kNumBits)
+            return ~0ULL;
+
+        const BitArrayView rest(m_bits.Blocks() + (iRest >> 6ULL), kNumBits - iRest);
+        const uint64_t iFound = rest.FirstAlignedBlockOfNClearBits(n, alignment);
+        return iFound == ~0ULL ? ~0ULL : iRest + iFound;
+    }
+
+    BitArray<kNumBits> m_bits;
+    uint64_t m_numFree;
+
+    // Every unit below this is allocated.
+    uint64_t m_firstFree;
+
+    BitmapAllocatorHint m_hint;
+};
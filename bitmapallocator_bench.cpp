@@ -0,0 +1,134 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#include <memory>
+#include <vector>
+
+#include "bench.h"
+#include "bitmapallocator.h"
+
+// Units in the benchmarked map.
+static constexpr uint64_t kBenchUnits = 1ULL << 20ULL;
+
+// The same churn for every allocator: a map filled to about 3/4, then a long sequence of freeing a random live
+// allocation and allocating a new one of random size, a quarter of those of 8 units or more aligned to 8, so that
+// the free space stays fragmented.
+struct ChurnScript
+{
+    static constexpr uint64_t kLength = 1ULL << 16ULL;
+
+    uint64_t size[kLength];
+    uint64_t alignment[kLength];
+    uint64_t victim[kLength];
+};
+
+static void MakeChurnScript(ChurnScript& script, uint64_t maxSize)
+{
+    uint64_t state = 0xBE7C4ULL;
+    for (uint64_t i = 0; i < ChurnScript::kLength; ++i)
+    {
+        script.size[i] = 1 + BenchSplitMix64(state) % maxSize;
+        script.alignment[i] = script.size[i] >= 8 && BenchSplitMix64(state) % 4 == 0 ? 8 : 1;
+        script.victim[i] = BenchSplitMix64(state);
+    }
+}
+
+struct Allocation
+{
+    uint64_t index;
+    uint64_t n;
+};
+
+// Return the time per free-and-allocate pair under churn, with allocate(n, alignment) returning an index or ~0ULL and
+// free(index, n).
+template <class Alloc, class Free>
+static BenchResult BenchChurn(const ChurnScript& script, uint64_t maxSize, Alloc&& allocate, Free&& free)
+{
+    std::vector<Allocation> live;
+    uint64_t used = 0;
+    for (uint64_t i = 0; used < kBenchUnits / 4 * 3; ++i)
+    {
+        const uint64_t n = 1 + i % maxSize;
+        const uint64_t index = allocate(n, 1);
+        if (index == ~0ULL)
+            break;
+        live.push_back({ index, n });
+        used += n;
+    }
+
+    uint64_t step = 0;
+    return BenchMeasure([&](uint64_t numIterations)
+        {
+            for (uint64_t k = 0; k < numIterations; ++k, ++step)
+            {
+                const uint64_t i = step & (ChurnScript::kLength - 1);
+                Allocation& x = live[script.victim[i] % live.size()];
+                free(x.index, x.n);
+                const uint64_t n = script.size[i];
+                const uint64_t index = allocate(n, script.alignment[i]);
+                if (index != ~0ULL)
+                {
+                    x = { index, n };
+                }
+                else
+                {
+                    x = live.back();
+                    live.pop_back();
+                }
+                DoNotOptimize(index);
+            }
+        });
+}
+
+template <BitmapAllocatorPolicy kPolicy>
+static BenchResult BenchAllocator(const ChurnScript& script, uint64_t maxSize)
+{
+    const std::unique_ptr<BitmapAllocator<kBenchUnits, kPolicy>> a = std::make_unique<BitmapAllocator<kBenchUnits, kPolicy>>();
+    return BenchChurn(script, maxSize,
+        [&](uint64_t n, uint64_t alignment) { return a->Allocate(n, alignment); },
+        [&](uint64_t index, uint64_t n) { a->Free(index, n); });
+}
+
+// What BitmapAllocator replaces: a first-fit search from bit 0 and a range set on every allocation.
+static BenchResult BenchRawBitArray(const ChurnScript& script, uint64_t maxSize)
+{
+    const std::unique_ptr<BitArray<kBenchUnits>> v = std::make_unique<BitArray<kBenchUnits>>();
+    v->ClearAll();
+    return BenchChurn(script, maxSize,
+        [&](uint64_t n, uint64_t alignment)
+        {
+            const uint64_t index = v->FirstAlignedBlockOfNClearBits(n, alignment);
+            if (index != ~0ULL)
+                v->SetBitsInRange(index, index + n - 1);
+            return index;
+        },
+        [&](uint64_t index, uint64_t n) { v->ClearBitsInRange(index, index + n - 1); });
+}
+
+void BenchBitmapAllocator()
+{
+    const std::unique_ptr<ChurnScript> script = std::make_unique<ChurnScript>();
+    for (const uint64_t maxSize : { 1ULL, 16ULL, 256ULL })
+    {
+        MakeChurnScript(*script, maxSize);
+        char name[64];
+
+        snprintf(name, sizeof(name), "raw BitArray/sizes 1-%llu", static_cast<unsigned long long>(maxSize));
+        if (BenchSelected("BitmapAllocator", name))
+            PrintBenchResult("BitmapAllocator", name, BenchRawBitArray(*script, maxSize));
+
+        snprintf(name, sizeof(name), "FirstFit/sizes 1-%llu", static_cast<unsigned long long>(maxSize));
+        if (BenchSelected("BitmapAllocator", name))
+            PrintBenchResult("BitmapAllocator", name, BenchAllocator<BitmapAllocatorPolicy::FirstFit>(*script, maxSize));
+
+        snprintf(name, sizeof(name), "NextFit/sizes 1-%llu", static_cast<unsigned long long>(maxSize));
+        if (BenchSelected("BitmapAllocator", name))
+            PrintBenchResult("BitmapAllocator", name, BenchAllocator<BitmapAllocatorPolicy::NextFit>(*script, maxSize));
+    }
+}
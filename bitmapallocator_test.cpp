@@ -0,0 +1,139 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "bitmapallocator.h"
+#include "testutil.h"
+
+#define ASSERT_TRUE(a) do { if (!(a)) { std::cerr << "FAIL: expected true for " << #a << ", got false\n"; __debugbreak(); } } while (0)
+
+#define ASSERT_BIN_OP(a, b, op) do {                                                            \
+    const auto& va = (a);                                                                       \
+    const auto& vb = (b);                                                                       \
+    if (!(va op vb))                                                                            \
+    {                                                                                           \
+        std::cerr << "FAIL: expected " << #a << " " << #op << " " << #b << " (evaluates to ";   \
+        std::cerr << va << " " << #op << " " << vb << ")\n";                                    \
+        __debugbreak();                                                                         \
+    }                                                                                           \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_BIN_OP(a, b, ==)
+
+struct Allocation
+{
+    uint64_t index;
+    uint64_t n;
+};
+
+// Random allocations and frees, checked against a BitArray<n> of the same units: every allocation is free, aligned,
+// and under FirstFit the lowest fit; an allocation fails only when nothing fits.
+template <uint64_t n, BitmapAllocatorPolicy kPolicy>
+static void TestChurn(uint64_t maxRun, uint64_t& state)
+{
+    const std::unique_ptr<BitmapAllocator<n, kPolicy>> a = std::make_unique<BitmapAllocator<n, kPolicy>>();
+    const std::unique_ptr<BitArray<n>> v = std::make_unique<BitArray<n>>();
+    v->ClearAll();
+    std::vector<Allocation> live;
+    BitmapAllocatorHint hints[3] = { { 0 }, { n / 3 }, { 2 * n / 3 } };
+
+    for (uint64_t k = 0; k < 20000; ++k)
+    {
+        if (live.empty() || SplitMix64(state) % 16 < 9)
+        {
+            const uint64_t len = 1 + SplitMix64(state) % maxRun;
+            const uint64_t alignment = 1ULL << (SplitMix64(state) % 4 == 0 ? SplitMix64(state) % 8 : 0);
+            const uint64_t expected = v->FirstAlignedBlockOfNClearBits(len, alignment);
+            const uint64_t i = k % 5 == 0 ? a->Allocate(len, alignment, hints[k % 3]) : a->Allocate(len, alignment);
+            if (kPolicy == BitmapAllocatorPolicy::FirstFit)
+                ASSERT_EQ(i, expected);
+            ASSERT_EQ(i == ~0ULL, expected == ~0ULL);
+            if (i == ~0ULL)
+                continue;
+
+            ASSERT_EQ(i & (alignment - 1), 0ULL);
+            ASSERT_TRUE(v->AreAllBitsInRangeClear(i, i + len - 1));
+            v->SetBitsInRange(i, i + len - 1);
+            live.push_back({ i, len });
+        }
+        else
+        {
+            const uint64_t j = SplitMix64(state) % live.size();
+            a->Free(live[j].index, live[j].n);
+            v->ClearBitsInRange(live[j].index, live[j].index + live[j].n - 1);
+            live[j] = live.back();
+            live.pop_back();
+        }
+
+        ASSERT_EQ(a->NumFree(), n - v->CountSetBits());
+        ASSERT_EQ(a->NumAllocated(), v->CountSetBits());
+    }
+    ASSERT_TRUE(a->Bits() == *v);
+
+    for (const Allocation& x : live)
+        a->Free(x.index, x.n);
+    ASSERT_EQ(a->NumFree(), n);
+    ASSERT_TRUE(a->Bits().AreAllBitsClear());
+}
+
+void TestBitmapAllocator()
+{
+    uint64_t state = 0xA110CULL;
+
+    TestChurn<1, BitmapAllocatorPolicy::FirstFit>(1, state);
+    TestChurn<1, BitmapAllocatorPolicy::NextFit>(1, state);
+    TestChurn<200, BitmapAllocatorPolicy::FirstFit>(20, state);
+    TestChurn<200, BitmapAllocatorPolicy::NextFit>(20, state);
+    TestChurn<4161, BitmapAllocatorPolicy::FirstFit>(100, state);
+    TestChurn<4161, BitmapAllocatorPolicy::NextFit>(100, state);
+    TestChurn<100000, BitmapAllocatorPolicy::FirstFit>(3000, state);
+    TestChurn<100000, BitmapAllocatorPolicy::NextFit>(3000, state);
+
+    // Fill exactly, fail, free one, and get it back.
+    {
+        BitmapAllocator<1000, BitmapAllocatorPolicy::NextFit> a;
+        for (uint64_t i = 0; i < 100; ++i)
+            ASSERT_EQ(a.Allocate(10), 10 * i);
+        ASSERT_EQ(a.NumFree(), 0ULL);
+        ASSERT_EQ(a.Allocate(1), ~0ULL);
+        a.Free(370, 10);
+        ASSERT_EQ(a.Allocate(11), ~0ULL);
+        ASSERT_EQ(a.Allocate(8, 8), ~0ULL);
+        ASSERT_EQ(a.Allocate(2), 370ULL);
+        ASSERT_EQ(a.Allocate(8), 372ULL);
+        ASSERT_EQ(a.NumFree(), 0ULL);
+    }
+
+    // NextFit moves on past each allocation; FirstFit reuses the lowest hole.
+    {
+        BitmapAllocator<256, BitmapAllocatorPolicy::NextFit> next;
+        BitmapAllocator<256, BitmapAllocatorPolicy::FirstFit> first;
+        ASSERT_EQ(next.Allocate(4), 0ULL);
+        ASSERT_EQ(first.Allocate(4), 0ULL);
+        next.Free(0, 4);
+        first.Free(0, 4);
+        ASSERT_EQ(next.Allocate(4), 4ULL);
+        ASSERT_EQ(first.Allocate(4), 0ULL);
+
+        // Separate hints carve separate regions.
+        BitmapAllocatorHint h1 = { 64 };
+        BitmapAllocatorHint h2 = { 128 };
+        ASSERT_EQ(next.Allocate(16, 1, h1), 64ULL);
+        ASSERT_EQ(next.Allocate(16, 1, h2), 128ULL);
+        ASSERT_EQ(next.Allocate(16, 1, h1), 80ULL);
+        ASSERT_EQ(h1.next, 96ULL);
+
+        // Past the end, it wraps to the start, skipping the hole at 0 that is too small.
+        BitmapAllocatorHint h3 = { 250 };
+        ASSERT_EQ(next.Allocate(8, 1, h3), 8ULL);
+    }
+}
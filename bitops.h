@@ -10,6 +10,7 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 #include <immintrin.h>
 
 #if defined(_MSC_VER) && !defined(__clang__) && !defined(__GNUC__)
@@ -18,6 +19,23 @@
 #include <intrin.h>
 #endif
 
+// Compile a function for an instruction set beyond the translation unit's own target, so that
+// variants for several instruction sets can live side by side (see bitops_dispatch.h).
+// MSVC allows any intrinsic in any function, so nothing is needed there.
+#if defined(__clang__) || defined(__GNUC__)
+#define BITOPS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define BITOPS_TARGET(isa)
+#endif
+
+// In-word select (NthSetBitIndex_*) uses PDEP when the target has BMI2. PDEP is microcoded on AMD
+// before Zen 3, taking hundreds of cycles, so builds for those hosts use a broadword sequence instead.
+// Define BITOPS_NO_PDEP to force the broadword sequence, e.g. for a BMI2 binary that may run on Zen 1/2.
+// MSVC has no BMI2 macro; AVX2 is taken to imply it.
+#if !defined(BITOPS_NO_PDEP) && !defined(__znver1__) && !defined(__znver2__) && (defined(__BMI2__) || (defined(_MSC_VER) && !defined(__clang__) && !defined(__GNUC__) && defined(__AVX2__)))
+#define BITOPS_USE_PDEP
+#endif
+
 // If cond, set bit i in x.
 // Otherwise, clear bit i in x.
 [[nodiscard]] static inline uint8_t AssignBit_U8(uint8_t x, uint32_t i, bool cond)
@@ -138,6 +156,129 @@
 	return uint64_t(_mm_popcnt_u64(x));
 }
 
+// Return the number of bits set in each 64-bit lane of v.
+[[nodiscard]] BITOPS_TARGET("avx2") static inline __m256i CountSetBits_M256(__m256i v)
+{
+	const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i L = _mm256_and_si256(v, _mm256_set1_epi8(0xF));
+	const __m256i H = _mm256_and_si256(_mm256_srli_epi32(v, 4), _mm256_set1_epi8(0xF));
+	const __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lut, L), _mm256_shuffle_epi8(lut, H));
+	return _mm256_sad_epu8(bytes, _mm256_setzero_si256());
+}
+
+// Carry-save add: h receives the carries and l the sum bits of a + b + c.
+BITOPS_TARGET("avx2") static inline void CarrySaveAdd_M256(__m256i& h, __m256i& l, __m256i a, __m256i b, __m256i c)
+{
+	const __m256i u = _mm256_xor_si256(a, b);
+	h = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+	l = _mm256_xor_si256(u, c);
+}
+
+// Return the number of bits set in the n 64-bit blocks starting at p.
+// popcnt loop; the baseline variant for runtime dispatch.
+[[nodiscard]] BITOPS_TARGET("popcnt") static inline uint64_t CountSetBits_Blocks_SSE42(const uint64_t* __restrict p, uint64_t n)
+{
+	uint64_t count = 0;
+	for (uint64_t i = 0; i < n; ++i)
+		count += uint64_t(_mm_popcnt_u64(p[i]));
+	return count;
+}
+
+// Return the number of bits set in the n 64-bit blocks starting at p.
+// Harley-Seal: fold 16 vectors at a time through a tree of carry-save adders
+// so that only one vector in 16 needs a full popcount.
+[[nodiscard]] BITOPS_TARGET("avx2,popcnt") static inline uint64_t CountSetBits_Blocks_AVX2(const uint64_t* __restrict p, uint64_t n)
+{
+	uint64_t count = 0;
+	uint64_t i = 0;
+
+	if (n >= 64)
+	{
+		const __m256i* __restrict v = reinterpret_cast<const __m256i*>(p);
+		__m256i total = _mm256_setzero_si256();
+		__m256i ones = _mm256_setzero_si256();
+		__m256i twos = _mm256_setzero_si256();
+		__m256i fours = _mm256_setzero_si256();
+		__m256i eights = _mm256_setzero_si256();
+		__m256i sixteens, twosA, twosB, foursA, foursB, eightsA, eightsB;
+
+		const uint64_t nVec = n >> 2ULL;
+		uint64_t iVec = 0;
+		for (; iVec + 16 <= nVec; iVec += 16)
+		{
+			CarrySaveAdd_M256(twosA, ones, ones, _mm256_loadu_si256(v + iVec + 0), _mm256_loadu_si256(v + iVec + 1));
+			CarrySaveAdd_M256(twosB, ones, ones, _mm256_loadu_si256(v + iVec + 2), _mm256_loadu_si256(v + iVec + 3));
+			CarrySaveAdd_M256(foursA, twos, twos, twosA, twosB);
+			CarrySaveAdd_M256(twosA, ones, ones, _mm256_loadu_si256(v + iVec + 4), _mm256_loadu_si256(v + iVec + 5));
+			CarrySaveAdd_M256(twosB, ones, ones, _mm256_loadu_si256(v + iVec + 6), _mm256_loadu_si256(v + iVec + 7));
+			CarrySaveAdd_M256(foursB, twos, twos, twosA, twosB);
+			CarrySaveAdd_M256(eightsA, fours, fours, foursA, foursB);
+			CarrySaveAdd_M256(twosA, ones, ones, _mm256_loadu_si256(v + iVec + 8), _mm256_loadu_si256(v + iVec + 9));
+			CarrySaveAdd_M256(twosB, ones, ones, _mm256_loadu_si256(v + iVec + 10), _mm256_loadu_si256(v + iVec + 11));
+			CarrySaveAdd_M256(foursA, twos, twos, twosA, twosB);
+			CarrySaveAdd_M256(twosA, ones, ones, _mm256_loadu_si256(v + iVec + 12), _mm256_loadu_si256(v + iVec + 13));
+			CarrySaveAdd_M256(twosB, ones, ones, _mm256_loadu_si256(v + iVec + 14), _mm256_loadu_si256(v + iVec + 15));
+			CarrySaveAdd_M256(foursB, twos, twos, twosA, twosB);
+			CarrySaveAdd_M256(eightsB, fours, fours, foursA, foursB);
+			CarrySaveAdd_M256(sixteens, eights, eights, eightsA, eightsB);
+			total = _mm256_add_epi64(total, CountSetBits_M256(sixteens));
+		}
+
+		total = _mm256_slli_epi64(total, 4);
+		total = _mm256_add_epi64(total, _mm256_slli_epi64(CountSetBits_M256(eights), 3));
+		total = _mm256_add_epi64(total, _mm256_slli_epi64(CountSetBits_M256(fours), 2));
+		total = _mm256_add_epi64(total, _mm256_slli_epi64(CountSetBits_M256(twos), 1));
+		total = _mm256_add_epi64(total, CountSetBits_M256(ones));
+
+		for (; iVec < nVec; ++iVec)
+			total = _mm256_add_epi64(total, CountSetBits_M256(_mm256_loadu_si256(v + iVec)));
+
+		const __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(total), _mm256_extracti128_si256(total, 1));
+		count = uint64_t(_mm_cvtsi128_si64(sum)) + uint64_t(_mm_extract_epi64(sum, 1));
+		i = nVec << 2ULL;
+	}
+
+	for (; i < n; ++i)
+		count += uint64_t(_mm_popcnt_u64(p[i]));
+
+	return count;
+}
+
+// Return the number of bits set in the n 64-bit blocks starting at p.
+// VPOPCNTDQ, with a masked load for the tail.
+[[nodiscard]] BITOPS_TARGET("avx512f,avx512vpopcntdq") static inline uint64_t CountSetBits_Blocks_AVX512(const uint64_t* __restrict p, uint64_t n)
+{
+	__m512i acc0 = _mm512_setzero_si512();
+	__m512i acc1 = _mm512_setzero_si512();
+	uint64_t i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		acc0 = _mm512_add_epi64(acc0, _mm512_popcnt_epi64(_mm512_loadu_si512(p + i)));
+		acc1 = _mm512_add_epi64(acc1, _mm512_popcnt_epi64(_mm512_loadu_si512(p + i + 8)));
+	}
+	if (i + 8 <= n)
+	{
+		acc0 = _mm512_add_epi64(acc0, _mm512_popcnt_epi64(_mm512_loadu_si512(p + i)));
+		i += 8;
+	}
+	if (i < n)
+		acc1 = _mm512_add_epi64(acc1, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64(__mmask8((1U << (n - i)) - 1U), p + i)));
+	return uint64_t(_mm512_reduce_add_epi64(_mm512_add_epi64(acc0, acc1)));
+}
+
+// Return the number of bits set in the n 64-bit blocks starting at p.
+// Uses the best variant the compilation target allows. See bitops_dispatch.h to choose at runtime instead.
+[[nodiscard]] static inline uint64_t CountSetBits_Blocks(const uint64_t* __restrict p, uint64_t n)
+{
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+	return CountSetBits_Blocks_AVX512(p, n);
+#elif defined(__AVX2__)
+	return CountSetBits_Blocks_AVX2(p, n);
+#else
+	return CountSetBits_Blocks_SSE42(p, n);
+#endif
+}
+
 // Return the number of leading (most significant) zero bits.
 // Returns 8 when x is 0.
 [[nodiscard]] static inline uint32_t CountLeadingZeros_U8(uint8_t x)
@@ -479,13 +620,36 @@
 }
 
 // Reverse bit order within each byte, while leaving byte order unmofidied.
-[[nodiscard]] static inline __m128i ReverseBitsInBytes_M128(__m128i v)
+// One GF(2) affine transform by the bit-reversal matrix.
+[[nodiscard]] BITOPS_TARGET("gfni") static inline __m128i ReverseBitsInBytes_M128_GFNI(__m128i v)
 {
+	return _mm_gf2p8affine_epi64_epi8(v, _mm_set1_epi64x(int64_t(0x8040201008040201ULL)), 0);
+}
+
+// Reverse bit order within each byte, while leaving byte order unmofidied.
+[[nodiscard]] BITOPS_TARGET("gfni,avx") static inline __m256i ReverseBitsInBytes_M256_GFNI(__m256i v)
+{
+	return _mm256_gf2p8affine_epi64_epi8(v, _mm256_set1_epi64x(int64_t(0x8040201008040201ULL)), 0);
+}
+
+// Reverse bit order within each byte, while leaving byte order unmofidied.
+[[nodiscard]] BITOPS_TARGET("gfni,avx512f,avx512bw") static inline __m512i ReverseBitsInBytes_M512_GFNI(__m512i v)
+{
+	return _mm512_gf2p8affine_epi64_epi8(v, _mm512_set1_epi64(int64_t(0x8040201008040201ULL)), 0);
+}
+
+// Reverse bit order within each byte, while leaving byte order unmofidied.
+[[nodiscard]] BITOPS_TARGET("ssse3") static inline __m128i ReverseBitsInBytes_M128(__m128i v)
+{
+#if defined(__GFNI__)
+	return ReverseBitsInBytes_M128_GFNI(v);
+#else
 	const __m128i hMask = _mm_set_epi64x(int64_t(0x0F070B030D050901ULL), int64_t(0x0E060A020C040800ULL));
 	const __m128i lMask = _mm_set_epi64x(int64_t(0xF070B030D0509010ULL), int64_t(0xE060A020C0408000ULL));
 	const __m128i L = _mm_and_si128(v, _mm_set1_epi8(0xF));
 	const __m128i H = _mm_and_si128(_mm_srli_epi32(v, 4), _mm_set1_epi8(0xF));
 	return _mm_or_si128(_mm_shuffle_epi8(lMask, L), _mm_shuffle_epi8(hMask, H));
+#endif
 }
 
 // Reverse bit order.
@@ -526,6 +690,253 @@
 	return ReverseBytes_U64(uint64_t(_mm_cvtsi128_si64(ReverseBitsInBytes_M128(_mm_cvtsi64_si128(int64_t(x))))));
 }
 
+// Reverse bit order within each byte, while leaving byte order unmofidied.
+[[nodiscard]] BITOPS_TARGET("avx2") static inline __m256i ReverseBitsInBytes_M256(__m256i v)
+{
+#if defined(__GFNI__)
+	return ReverseBitsInBytes_M256_GFNI(v);
+#else
+	const __m256i hMask = _mm256_set_epi64x(int64_t(0x0F070B030D050901ULL), int64_t(0x0E060A020C040800ULL), int64_t(0x0F070B030D050901ULL), int64_t(0x0E060A020C040800ULL));
+	const __m256i lMask = _mm256_set_epi64x(int64_t(0xF070B030D0509010ULL), int64_t(0xE060A020C0408000ULL), int64_t(0xF070B030D0509010ULL), int64_t(0xE060A020C0408000ULL));
+	const __m256i L = _mm256_and_si256(v, _mm256_set1_epi8(0xF));
+	const __m256i H = _mm256_and_si256(_mm256_srli_epi32(v, 4), _mm256_set1_epi8(0xF));
+	return _mm256_or_si256(_mm256_shuffle_epi8(lMask, L), _mm256_shuffle_epi8(hMask, H));
+#endif
+}
+
+// Reverse bit order within each byte, while leaving byte order unmofidied.
+[[nodiscard]] BITOPS_TARGET("avx512f,avx512bw") static inline __m512i ReverseBitsInBytes_M512(__m512i v)
+{
+#if defined(__GFNI__)
+	return ReverseBitsInBytes_M512_GFNI(v);
+#else
+	const __m512i hMask = _mm512_broadcast_i32x4(_mm_set_epi64x(int64_t(0x0F070B030D050901ULL), int64_t(0x0E060A020C040800ULL)));
+	const __m512i lMask = _mm512_broadcast_i32x4(_mm_set_epi64x(int64_t(0xF070B030D0509010ULL), int64_t(0xE060A020C0408000ULL)));
+	const __m512i L = _mm512_and_si512(v, _mm512_set1_epi8(0xF));
+	const __m512i H = _mm512_and_si512(_mm512_srli_epi32(v, 4), _mm512_set1_epi8(0xF));
+	return _mm512_or_si512(_mm512_shuffle_epi8(lMask, L), _mm512_shuffle_epi8(hMask, H));
+#endif
+}
+
+// Reverse bit order within each of nBytes bytes from src into dst, while leaving byte order unmodified.
+// dst may be src, but the two must not otherwise overlap.
+BITOPS_TARGET("ssse3") static inline void ReverseBitsInBytes_Buffer_SSSE3(uint8_t* dst, const uint8_t* src, uint64_t nBytes)
+{
+	uint64_t i = 0;
+	for (; i + 16 <= nBytes; i += 16)
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), ReverseBitsInBytes_M128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+	for (; i < nBytes; ++i)
+		dst[i] = ReverseBits_U8(src[i]);
+}
+
+// Reverse bit order within each of nBytes bytes from src into dst, while leaving byte order unmodified.
+// dst may be src, but the two must not otherwise overlap.
+BITOPS_TARGET("avx2") static inline void ReverseBitsInBytes_Buffer_AVX2(uint8_t* dst, const uint8_t* src, uint64_t nBytes)
+{
+	uint64_t i = 0;
+	for (; i + 32 <= nBytes; i += 32)
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), ReverseBitsInBytes_M256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i))));
+	for (; i < nBytes; ++i)
+		dst[i] = ReverseBits_U8(src[i]);
+}
+
+// Reverse bit order within each of nBytes bytes from src into dst, while leaving byte order unmodified.
+// dst may be src, but the two must not otherwise overlap.
+BITOPS_TARGET("avx512f,avx512bw") static inline void ReverseBitsInBytes_Buffer_AVX512(uint8_t* dst, const uint8_t* src, uint64_t nBytes)
+{
+	uint64_t i = 0;
+	for (; i + 64 <= nBytes; i += 64)
+		_mm512_storeu_si512(dst + i, ReverseBitsInBytes_M512(_mm512_loadu_si512(src + i)));
+	if (i < nBytes)
+	{
+		const __mmask64 m = __mmask64((1ULL << (nBytes - i)) - 1ULL);
+		_mm512_mask_storeu_epi8(dst + i, m, ReverseBitsInBytes_M512(_mm512_maskz_loadu_epi8(m, src + i)));
+	}
+}
+
+// Reverse bit order within each of nBytes bytes from src into dst, while leaving byte order unmodified.
+// dst may be src, but the two must not otherwise overlap.
+BITOPS_TARGET("gfni,avx2") static inline void ReverseBitsInBytes_Buffer_AVX2_GFNI(uint8_t* dst, const uint8_t* src, uint64_t nBytes)
+{
+	uint64_t i = 0;
+	for (; i + 32 <= nBytes; i += 32)
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), ReverseBitsInBytes_M256_GFNI(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i))));
+	for (; i < nBytes; ++i)
+		dst[i] = ReverseBits_U8(src[i]);
+}
+
+// Reverse bit order within each of nBytes bytes from src into dst, while leaving byte order unmodified.
+// dst may be src, but the two must not otherwise overlap.
+BITOPS_TARGET("gfni,avx512f,avx512bw") static inline void ReverseBitsInBytes_Buffer_AVX512_GFNI(uint8_t* dst, const uint8_t* src, uint64_t nBytes)
+{
+	uint64_t i = 0;
+	for (; i + 64 <= nBytes; i += 64)
+		_mm512_storeu_si512(dst + i, ReverseBitsInBytes_M512_GFNI(_mm512_loadu_si512(src + i)));
+	if (i < nBytes)
+	{
+		const __mmask64 m = __mmask64((1ULL << (nBytes - i)) - 1ULL);
+		_mm512_mask_storeu_epi8(dst + i, m, ReverseBitsInBytes_M512_GFNI(_mm512_maskz_loadu_epi8(m, src + i)));
+	}
+}
+
+// Reverse bit order within each of nBytes bytes from src into dst, while leaving byte order unmodified.
+// dst may be src, but the two must not otherwise overlap.
+// Uses the best variant the compilation target allows. See bitops_dispatch.h to choose at runtime instead.
+static inline void ReverseBitsInBytes_Buffer(uint8_t* dst, const uint8_t* src, uint64_t nBytes)
+{
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+	ReverseBitsInBytes_Buffer_AVX512(dst, src, nBytes);
+#elif defined(__AVX2__)
+	ReverseBitsInBytes_Buffer_AVX2(dst, src, nBytes);
+#else
+	ReverseBitsInBytes_Buffer_SSSE3(dst, src, nBytes);
+#endif
+}
+
+// Reverse byte order, while leaving bits within bytes unmodified.
+[[nodiscard]] BITOPS_TARGET("ssse3") static inline __m128i ReverseBytes_M128(__m128i v)
+{
+	return _mm_shuffle_epi8(v, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+// Reverse byte order, while leaving bits within bytes unmodified.
+[[nodiscard]] BITOPS_TARGET("avx2") static inline __m256i ReverseBytes_M256(__m256i v)
+{
+	const __m256i idx = _mm256_broadcastsi128_si256(_mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+	return _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, idx), 0x4E);
+}
+
+// Reverse byte order, while leaving bits within bytes unmodified.
+[[nodiscard]] BITOPS_TARGET("avx512f,avx512bw") static inline __m512i ReverseBytes_M512(__m512i v)
+{
+	const __m512i idx = _mm512_broadcast_i32x4(_mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+	return _mm512_shuffle_i64x2(_mm512_shuffle_epi8(v, idx), _mm512_shuffle_epi8(v, idx), 0x1B);
+}
+
+// Reverse the bytes [i, nBytes - i) of src into the same positions of dst, each with its bits reversed:
+// the part between the ends the vector loops of ReverseBits_Buffer_* have done.
+static inline void ReverseBits_Buffer_Middle(uint8_t* dst, const uint8_t* src, uint64_t i, uint64_t nBytes)
+{
+	uint64_t j = nBytes - i;
+	for (; j - i >= 16; i += 8, j -= 8)
+	{
+		uint64_t lo;
+		uint64_t hi;
+		memcpy(&lo, src + i, 8);
+		memcpy(&hi, src + j - 8, 8);
+		lo = ReverseBits_U64(lo);
+		hi = ReverseBits_U64(hi);
+		memcpy(dst + i, &hi, 8);
+		memcpy(dst + j - 8, &lo, 8);
+	}
+	if (j - i == 8)
+	{
+		uint64_t x;
+		memcpy(&x, src + i, 8);
+		x = ReverseBits_U64(x);
+		memcpy(dst + i, &x, 8);
+		return;
+	}
+	for (; i < j; ++i)
+	{
+		--j;
+		const uint8_t lo = src[i];
+		const uint8_t hi = src[j];
+		dst[i] = ReverseBits_U8(hi);
+		dst[j] = ReverseBits_U8(lo);
+	}
+}
+
+// Reverse the bit order of the whole nBytes-byte buffer src into dst: bit j of byte i moves to bit 7 - j of
+// byte nBytes - 1 - i. dst may be src, but the two must not otherwise overlap.
+// Each step swaps a vector from each end, so that the in-place reversal needs no second buffer.
+BITOPS_TARGET("ssse3") static inline void ReverseBits_Buffer_SSSE3(uint8_t* dst, const uint8_t* src, uint64_t nBytes)
+{
+	uint64_t i = 0;
+	for (; 2 * (i + 16) <= nBytes; i += 16)
+	{
+		const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + nBytes - i - 16));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), ReverseBitsInBytes_M128(ReverseBytes_M128(hi)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + nBytes - i - 16), ReverseBitsInBytes_M128(ReverseBytes_M128(lo)));
+	}
+	ReverseBits_Buffer_Middle(dst, src, i, nBytes);
+}
+
+// Reverse the bit order of the whole nBytes-byte buffer src into dst: bit j of byte i moves to bit 7 - j of
+// byte nBytes - 1 - i. dst may be src, but the two must not otherwise overlap.
+BITOPS_TARGET("avx2") static inline void ReverseBits_Buffer_AVX2(uint8_t* dst, const uint8_t* src, uint64_t nBytes)
+{
+	uint64_t i = 0;
+	for (; 2 * (i + 32) <= nBytes; i += 32)
+	{
+		const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+		const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + nBytes - i - 32));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), ReverseBitsInBytes_M256(ReverseBytes_M256(hi)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + nBytes - i - 32), ReverseBitsInBytes_M256(ReverseBytes_M256(lo)));
+	}
+	ReverseBits_Buffer_Middle(dst, src, i, nBytes);
+}
+
+// Reverse the bit order of the whole nBytes-byte buffer src into dst: bit j of byte i moves to bit 7 - j of
+// byte nBytes - 1 - i. dst may be src, but the two must not otherwise overlap.
+BITOPS_TARGET("gfni,avx2") static inline void ReverseBits_Buffer_AVX2_GFNI(uint8_t* dst, const uint8_t* src, uint64_t nBytes)
+{
+	uint64_t i = 0;
+	for (; 2 * (i + 32) <= nBytes; i += 32)
+	{
+		const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+		const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + nBytes - i - 32));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), ReverseBitsInBytes_M256_GFNI(ReverseBytes_M256(hi)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + nBytes - i - 32), ReverseBitsInBytes_M256_GFNI(ReverseBytes_M256(lo)));
+	}
+	ReverseBits_Buffer_Middle(dst, src, i, nBytes);
+}
+
+// Reverse the bit order of the whole nBytes-byte buffer src into dst: bit j of byte i moves to bit 7 - j of
+// byte nBytes - 1 - i. dst may be src, but the two must not otherwise overlap.
+BITOPS_TARGET("avx512f,avx512bw") static inline void ReverseBits_Buffer_AVX512(uint8_t* dst, const uint8_t* src, uint64_t nBytes)
+{
+	uint64_t i = 0;
+	for (; 2 * (i + 64) <= nBytes; i += 64)
+	{
+		const __m512i lo = _mm512_loadu_si512(src + i);
+		const __m512i hi = _mm512_loadu_si512(src + nBytes - i - 64);
+		_mm512_storeu_si512(dst + i, ReverseBitsInBytes_M512(ReverseBytes_M512(hi)));
+		_mm512_storeu_si512(dst + nBytes - i - 64, ReverseBitsInBytes_M512(ReverseBytes_M512(lo)));
+	}
+	ReverseBits_Buffer_Middle(dst, src, i, nBytes);
+}
+
+// Reverse the bit order of the whole nBytes-byte buffer src into dst: bit j of byte i moves to bit 7 - j of
+// byte nBytes - 1 - i. dst may be src, but the two must not otherwise overlap.
+BITOPS_TARGET("gfni,avx512f,avx512bw") static inline void ReverseBits_Buffer_AVX512_GFNI(uint8_t* dst, const uint8_t* src, uint64_t nBytes)
+{
+	uint64_t i = 0;
+	for (; 2 * (i + 64) <= nBytes; i += 64)
+	{
+		const __m512i lo = _mm512_loadu_si512(src + i);
+		const __m512i hi = _mm512_loadu_si512(src + nBytes - i - 64);
+		_mm512_storeu_si512(dst + i, ReverseBitsInBytes_M512_GFNI(ReverseBytes_M512(hi)));
+		_mm512_storeu_si512(dst + nBytes - i - 64, ReverseBitsInBytes_M512_GFNI(ReverseBytes_M512(lo)));
+	}
+	ReverseBits_Buffer_Middle(dst, src, i, nBytes);
+}
+
+// Reverse the bit order of the whole nBytes-byte buffer src into dst: bit j of byte i moves to bit 7 - j of
+// byte nBytes - 1 - i. dst may be src, but the two must not otherwise overlap.
+// Uses the best variant the compilation target allows. See bitops_dispatch.h to choose at runtime instead.
+static inline void ReverseBits_Buffer(uint8_t* dst, const uint8_t* src, uint64_t nBytes)
+{
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+	ReverseBits_Buffer_AVX512(dst, src, nBytes);
+#elif defined(__AVX2__)
+	ReverseBits_Buffer_AVX2(dst, src, nBytes);
+#else
+	ReverseBits_Buffer_SSSE3(dst, src, nBytes);
+#endif
+}
+
 // Return true if x is a power of 2. To avoid ambiguity: this excludes 0.
 [[nodiscard]] static inline bool IsPowerOf2AndNotZero_U8(uint8_t x)
 {
@@ -667,6 +1078,98 @@
 	return LastSetBitIndex_U64(x);
 }
 
+// Return the index of the nth (0-based) set bit, counting from the least significant.
+// Returns 64 when x has n or fewer set bits. n must be less than 64.
+// PDEP deposits bit n of the mask onto the nth set bit of x.
+[[nodiscard]] BITOPS_TARGET("bmi,bmi2") static inline uint64_t NthSetBitIndex_U64_PDEP(uint64_t x, uint32_t n)
+{
+	return _tzcnt_u64(_pdep_u64(1ULL << n, x));
+}
+
+// Return the index of the nth (0-based) set bit, counting from the least significant.
+// Returns 64 when x has n or fewer set bits. n must be less than 64.
+// Broadword: find the byte from prefix popcounts of all 8 bytes at once, then bisect within it.
+[[nodiscard]] static inline uint64_t NthSetBitIndex_U64_Broadword(uint64_t x, uint32_t n)
+{
+	uint64_t s = x - ((x >> 1ULL) & 0x5555555555555555ULL);
+	s = (s & 0x3333333333333333ULL) + ((s >> 2ULL) & 0x3333333333333333ULL);
+	s = (s + (s >> 4ULL)) & 0x0F0F0F0F0F0F0F0FULL;
+
+	// Byte i of prefix is the number of set bits in bytes 0 through i. The high bit of byte i of le is
+	// set where that is <= n, so the target byte is the number of such bytes.
+	const uint64_t prefix = s * 0x0101010101010101ULL;
+	const uint64_t le = ((n * 0x0101010101010101ULL | 0x8080808080808080ULL) - prefix) & 0x8080808080808080ULL;
+	uint64_t iBit = CountSetBits_U64(le) << 3ULL;
+
+	// iBit is 64 when x has n or fewer set bits. The shifts take it mod 64, and none selects 64 at the end.
+	const uint64_t none = 0ULL - (iBit >> 6ULL);
+	n -= uint32_t(((prefix << 8ULL) >> (iBit & 63ULL)) & 0xFFULL);
+
+	uint32_t b = uint32_t(x >> (iBit & 63ULL)) & 0xFFU;
+
+	uint32_t c = CountSetBits_U32(b & 0xFU);
+	uint32_t step = c <= n ? 4U : 0U;
+	n -= c <= n ? c : 0U;
+	b >>= step;
+	iBit += step;
+
+	c = CountSetBits_U32(b & 0x3U);
+	step = c <= n ? 2U : 0U;
+	n -= c <= n ? c : 0U;
+	b >>= step;
+	iBit += step;
+
+	iBit += (b & 1U) <= n ? 1U : 0U;
+	return (iBit & ~none) | (64ULL & none);
+}
+
+// Return the index of the nth (0-based) set bit, counting from the least significant.
+// Returns 8 when x has n or fewer set bits. n must be less than 8.
+[[nodiscard]] static inline uint32_t NthSetBitIndex_U8(uint8_t x, uint32_t n)
+{
+#if defined(BITOPS_USE_PDEP)
+	return CountTrailingZeros_U8(uint8_t(_pdep_u32(1U << n, x)));
+#else
+	const uint64_t i = NthSetBitIndex_U64_Broadword(x, n);
+	return i < 8 ? uint32_t(i) : 8U;
+#endif
+}
+
+// Return the index of the nth (0-based) set bit, counting from the least significant.
+// Returns 16 when x has n or fewer set bits. n must be less than 16.
+[[nodiscard]] static inline uint32_t NthSetBitIndex_U16(uint16_t x, uint32_t n)
+{
+#if defined(BITOPS_USE_PDEP)
+	return CountTrailingZeros_U16(uint16_t(_pdep_u32(1U << n, x)));
+#else
+	const uint64_t i = NthSetBitIndex_U64_Broadword(x, n);
+	return i < 16 ? uint32_t(i) : 16U;
+#endif
+}
+
+// Return the index of the nth (0-based) set bit, counting from the least significant.
+// Returns 32 when x has n or fewer set bits. n must be less than 32.
+[[nodiscard]] static inline uint32_t NthSetBitIndex_U32(uint32_t x, uint32_t n)
+{
+#if defined(BITOPS_USE_PDEP)
+	return CountTrailingZeros_U32(_pdep_u32(1U << n, x));
+#else
+	const uint64_t i = NthSetBitIndex_U64_Broadword(x, n);
+	return i < 32 ? uint32_t(i) : 32U;
+#endif
+}
+
+// Return the index of the nth (0-based) set bit, counting from the least significant.
+// Returns 64 when x has n or fewer set bits. n must be less than 64.
+[[nodiscard]] static inline uint64_t NthSetBitIndex_U64(uint64_t x, uint32_t n)
+{
+#if defined(BITOPS_USE_PDEP)
+	return NthSetBitIndex_U64_PDEP(x, n);
+#else
+	return NthSetBitIndex_U64_Broadword(x, n);
+#endif
+}
+
 // Return the index of the first (least significant) run of n set bits.
 // Returns 8 when x is 0.
 [[nodiscard]] static inline uint32_t FirstNSetBitsIndex_U8(uint8_t x, uint32_t n)
@@ -1035,6 +1538,1346 @@
 	return LastNSetBitsIndex_U64(~x, n, validBits);
 }
 
+// Outputs of at least this many bytes are written by BinaryOp_Blocks and TernaryOp_Blocks with non-temporal
+// stores, which bypass the cache: an output larger than the LLC won't stay there anyway, and writing it through
+// the cache would evict everything else on the way. Define to about the host's LLC size; 0 disables.
+#if !defined(BITOPS_NON_TEMPORAL_THRESHOLD)
+#define BITOPS_NON_TEMPORAL_THRESHOLD (32ULL << 20ULL)
+#endif
+
+// Bitwise operations for the *_Blocks kernels below, in scalar, 256-bit, and 512-bit forms.
+// On AVX-512, the forms with a NOT are one VPTERNLOGQ each.
+struct BitOpAnd
+{
+	static uint64_t U64(uint64_t a, uint64_t b) { return a & b; }
+	BITOPS_TARGET("avx2") static __m256i M256(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+	BITOPS_TARGET("avx512f") static __m512i M512(__m512i a, __m512i b) { return _mm512_and_si512(a, b); }
+};
+
+struct BitOpOr
+{
+	static uint64_t U64(uint64_t a, uint64_t b) { return a | b; }
+	BITOPS_TARGET("avx2") static __m256i M256(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+	BITOPS_TARGET("avx512f") static __m512i M512(__m512i a, __m512i b) { return _mm512_or_si512(a, b); }
+};
+
+struct BitOpXor
+{
+	static uint64_t U64(uint64_t a, uint64_t b) { return a ^ b; }
+	BITOPS_TARGET("avx2") static __m256i M256(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+	BITOPS_TARGET("avx512f") static __m512i M512(__m512i a, __m512i b) { return _mm512_xor_si512(a, b); }
+};
+
+// a & ~b
+struct BitOpAndNot
+{
+	static uint64_t U64(uint64_t a, uint64_t b) { return a & ~b; }
+	BITOPS_TARGET("avx2") static __m256i M256(__m256i a, __m256i b) { return _mm256_andnot_si256(b, a); }
+	BITOPS_TARGET("avx512f") static __m512i M512(__m512i a, __m512i b) { return _mm512_andnot_si512(b, a); }
+};
+
+// ~a & b
+struct BitOpNotAnd
+{
+	static uint64_t U64(uint64_t a, uint64_t b) { return ~a & b; }
+	BITOPS_TARGET("avx2") static __m256i M256(__m256i a, __m256i b) { return _mm256_andnot_si256(a, b); }
+	BITOPS_TARGET("avx512f") static __m512i M512(__m512i a, __m512i b) { return _mm512_andnot_si512(a, b); }
+};
+
+// ~a & ~b
+struct BitOpNotAndNot
+{
+	static uint64_t U64(uint64_t a, uint64_t b) { return ~a & ~b; }
+	BITOPS_TARGET("avx2") static __m256i M256(__m256i a, __m256i b) { return _mm256_xor_si256(_mm256_or_si256(a, b), _mm256_set1_epi64x(-1)); }
+	BITOPS_TARGET("avx512f") static __m512i M512(__m512i a, __m512i b) { return _mm512_ternarylogic_epi64(a, b, b, 0x03); }
+};
+
+// a | ~b
+struct BitOpOrNot
+{
+	static uint64_t U64(uint64_t a, uint64_t b) { return a | ~b; }
+	BITOPS_TARGET("avx2") static __m256i M256(__m256i a, __m256i b) { return _mm256_or_si256(a, _mm256_xor_si256(b, _mm256_set1_epi64x(-1))); }
+	BITOPS_TARGET("avx512f") static __m512i M512(__m512i a, __m512i b) { return _mm512_ternarylogic_epi64(a, b, b, 0xF3); }
+};
+
+// ~a | b
+struct BitOpNotOr
+{
+	static uint64_t U64(uint64_t a, uint64_t b) { return ~a | b; }
+	BITOPS_TARGET("avx2") static __m256i M256(__m256i a, __m256i b) { return _mm256_or_si256(_mm256_xor_si256(a, _mm256_set1_epi64x(-1)), b); }
+	BITOPS_TARGET("avx512f") static __m512i M512(__m512i a, __m512i b) { return _mm512_ternarylogic_epi64(a, b, b, 0xCF); }
+};
+
+// ~a | ~b
+struct BitOpNotOrNot
+{
+	static uint64_t U64(uint64_t a, uint64_t b) { return ~a | ~b; }
+	BITOPS_TARGET("avx2") static __m256i M256(__m256i a, __m256i b) { return _mm256_xor_si256(_mm256_and_si256(a, b), _mm256_set1_epi64x(-1)); }
+	BITOPS_TARGET("avx512f") static __m512i M512(__m512i a, __m512i b) { return _mm512_ternarylogic_epi64(a, b, b, 0x3F); }
+};
+
+// a ^ ~b, which is also ~a ^ b
+struct BitOpXorNot
+{
+	static uint64_t U64(uint64_t a, uint64_t b) { return a ^ ~b; }
+	BITOPS_TARGET("avx2") static __m256i M256(__m256i a, __m256i b) { return _mm256_xor_si256(_mm256_xor_si256(a, b), _mm256_set1_epi64x(-1)); }
+	BITOPS_TARGET("avx512f") static __m512i M512(__m512i a, __m512i b) { return _mm512_ternarylogic_epi64(a, b, b, 0xC3); }
+};
+
+// ~a; b is ignored
+struct BitOpNot
+{
+	static uint64_t U64(uint64_t a, uint64_t) { return ~a; }
+	BITOPS_TARGET("avx2") static __m256i M256(__m256i a, __m256i) { return _mm256_xor_si256(a, _mm256_set1_epi64x(-1)); }
+	BITOPS_TARGET("avx512f") static __m512i M512(__m512i a, __m512i) { return _mm512_ternarylogic_epi64(a, a, a, 0x0F); }
+};
+
+// (a & ~mask) | (b & mask): bits of b where mask is set, and of a elsewhere.
+struct BitOpBlend
+{
+	static uint64_t U64(uint64_t a, uint64_t b, uint64_t mask) { return a ^ ((a ^ b) & mask); }
+	BITOPS_TARGET("avx2") static __m256i M256(__m256i a, __m256i b, __m256i mask) { return _mm256_xor_si256(a, _mm256_and_si256(_mm256_xor_si256(a, b), mask)); }
+	BITOPS_TARGET("avx512f") static __m512i M512(__m512i a, __m512i b, __m512i mask) { return _mm512_ternarylogic_epi64(a, b, mask, 0xD8); }
+};
+
+// dst[i] = Op(a[i], b[i]) for the n 64-bit blocks starting at dst, a, and b.
+// dst may be a or b, but must not otherwise overlap them.
+// kNonTemporal writes dst with streaming stores; see BITOPS_NON_TEMPORAL_THRESHOLD.
+template <class Op, bool kNonTemporal = false>
+static inline void BinaryOp_Blocks_SSE42(uint64_t* dst, const uint64_t* a, const uint64_t* b, uint64_t n)
+{
+	uint64_t i = 0;
+	if constexpr (kNonTemporal)
+	{
+		if (n && (reinterpret_cast<uintptr_t>(dst) & 15U))
+		{
+			dst[0] = Op::U64(a[0], b[0]);
+			i = 1;
+		}
+		for (; i + 2 <= n; i += 2)
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + i), _mm_set_epi64x(int64_t(Op::U64(a[i + 1], b[i + 1])), int64_t(Op::U64(a[i], b[i]))));
+	}
+	for (; i < n; ++i)
+		dst[i] = Op::U64(a[i], b[i]);
+	if constexpr (kNonTemporal)
+		_mm_sfence();
+}
+
+// dst[i] = Op(a[i], b[i]) for the n 64-bit blocks starting at dst, a, and b.
+// dst may be a or b, but must not otherwise overlap them.
+// kNonTemporal writes dst with streaming stores; see BITOPS_NON_TEMPORAL_THRESHOLD.
+template <class Op, bool kNonTemporal = false>
+BITOPS_TARGET("avx2") static inline void BinaryOp_Blocks_AVX2(uint64_t* dst, const uint64_t* a, const uint64_t* b, uint64_t n)
+{
+	uint64_t i = 0;
+	if constexpr (kNonTemporal)
+	{
+		for (; i < n && (reinterpret_cast<uintptr_t>(dst + i) & 31U); ++i)
+			dst[i] = Op::U64(a[i], b[i]);
+	}
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+		const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+		if constexpr (kNonTemporal)
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(dst + i), Op::M256(va, vb));
+		else
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), Op::M256(va, vb));
+	}
+	for (; i < n; ++i)
+		dst[i] = Op::U64(a[i], b[i]);
+	if constexpr (kNonTemporal)
+		_mm_sfence();
+}
+
+// dst[i] = Op(a[i], b[i]) for the n 64-bit blocks starting at dst, a, and b.
+// dst may be a or b, but must not otherwise overlap them.
+// kNonTemporal writes dst with streaming stores; see BITOPS_NON_TEMPORAL_THRESHOLD.
+template <class Op, bool kNonTemporal = false>
+BITOPS_TARGET("avx512f") static inline void BinaryOp_Blocks_AVX512(uint64_t* dst, const uint64_t* a, const uint64_t* b, uint64_t n)
+{
+	uint64_t i = 0;
+	if constexpr (kNonTemporal)
+	{
+		// Up to the first 64-byte line of dst, then whole lines.
+		i = ((0ULL - uint64_t(reinterpret_cast<uintptr_t>(dst))) & 63ULL) >> 3ULL;
+		i = i < n ? i : n;
+		if (i)
+		{
+			const __mmask8 m = __mmask8((1U << i) - 1U);
+			_mm512_mask_storeu_epi64(dst, m, Op::M512(_mm512_maskz_loadu_epi64(m, a), _mm512_maskz_loadu_epi64(m, b)));
+		}
+		for (; i + 8 <= n; i += 8)
+			_mm512_stream_si512(reinterpret_cast<__m512i*>(dst + i), Op::M512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i)));
+	}
+	else
+	{
+		for (; i + 8 <= n; i += 8)
+			_mm512_storeu_si512(dst + i, Op::M512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i)));
+	}
+	if (i < n)
+	{
+		const __mmask8 m = __mmask8((1U << (n - i)) - 1U);
+		_mm512_mask_storeu_epi64(dst + i, m, Op::M512(_mm512_maskz_loadu_epi64(m, a + i), _mm512_maskz_loadu_epi64(m, b + i)));
+	}
+	if constexpr (kNonTemporal)
+		_mm_sfence();
+}
+
+// dst[i] = Op(a[i], b[i]) for the n 64-bit blocks starting at dst, a, and b.
+// dst may be a or b, but must not otherwise overlap them.
+// Uses the best variant the compilation target allows, with non-temporal stores past BITOPS_NON_TEMPORAL_THRESHOLD.
+// See bitops_dispatch.h to choose at runtime instead.
+template <class Op>
+static inline void BinaryOp_Blocks(uint64_t* dst, const uint64_t* a, const uint64_t* b, uint64_t n)
+{
+	const bool nonTemporal = BITOPS_NON_TEMPORAL_THRESHOLD && (n << 3ULL) >= uint64_t(BITOPS_NON_TEMPORAL_THRESHOLD);
+#if defined(__AVX512F__)
+	if (nonTemporal)
+		BinaryOp_Blocks_AVX512<Op, true>(dst, a, b, n);
+	else
+		BinaryOp_Blocks_AVX512<Op>(dst, a, b, n);
+#elif defined(__AVX2__)
+	if (nonTemporal)
+		BinaryOp_Blocks_AVX2<Op, true>(dst, a, b, n);
+	else
+		BinaryOp_Blocks_AVX2<Op>(dst, a, b, n);
+#else
+	if (nonTemporal)
+		BinaryOp_Blocks_SSE42<Op, true>(dst, a, b, n);
+	else
+		BinaryOp_Blocks_SSE42<Op>(dst, a, b, n);
+#endif
+}
+
+// dst[i] = Op(a[i], b[i], c[i]) for the n 64-bit blocks starting at dst, a, b, and c.
+// dst may be a, b, or c, but must not otherwise overlap them.
+// kNonTemporal writes dst with streaming stores; see BITOPS_NON_TEMPORAL_THRESHOLD.
+template <class Op, bool kNonTemporal = false>
+static inline void TernaryOp_Blocks_SSE42(uint64_t* dst, const uint64_t* a, const uint64_t* b, const uint64_t* c, uint64_t n)
+{
+	uint64_t i = 0;
+	if constexpr (kNonTemporal)
+	{
+		if (n && (reinterpret_cast<uintptr_t>(dst) & 15U))
+		{
+			dst[0] = Op::U64(a[0], b[0], c[0]);
+			i = 1;
+		}
+		for (; i + 2 <= n; i += 2)
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + i), _mm_set_epi64x(int64_t(Op::U64(a[i + 1], b[i + 1], c[i + 1])), int64_t(Op::U64(a[i], b[i], c[i]))));
+	}
+	for (; i < n; ++i)
+		dst[i] = Op::U64(a[i], b[i], c[i]);
+	if constexpr (kNonTemporal)
+		_mm_sfence();
+}
+
+// dst[i] = Op(a[i], b[i], c[i]) for the n 64-bit blocks starting at dst, a, b, and c.
+// dst may be a, b, or c, but must not otherwise overlap them.
+// kNonTemporal writes dst with streaming stores; see BITOPS_NON_TEMPORAL_THRESHOLD.
+template <class Op, bool kNonTemporal = false>
+BITOPS_TARGET("avx2") static inline void TernaryOp_Blocks_AVX2(uint64_t* dst, const uint64_t* a, const uint64_t* b, const uint64_t* c, uint64_t n)
+{
+	uint64_t i = 0;
+	if constexpr (kNonTemporal)
+	{
+		for (; i < n && (reinterpret_cast<uintptr_t>(dst + i) & 31U); ++i)
+			dst[i] = Op::U64(a[i], b[i], c[i]);
+	}
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+		const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+		const __m256i vc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + i));
+		if constexpr (kNonTemporal)
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(dst + i), Op::M256(va, vb, vc));
+		else
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), Op::M256(va, vb, vc));
+	}
+	for (; i < n; ++i)
+		dst[i] = Op::U64(a[i], b[i], c[i]);
+	if constexpr (kNonTemporal)
+		_mm_sfence();
+}
+
+// dst[i] = Op(a[i], b[i], c[i]) for the n 64-bit blocks starting at dst, a, b, and c.
+// dst may be a, b, or c, but must not otherwise overlap them.
+// kNonTemporal writes dst with streaming stores; see BITOPS_NON_TEMPORAL_THRESHOLD.
+template <class Op, bool kNonTemporal = false>
+BITOPS_TARGET("avx512f") static inline void TernaryOp_Blocks_AVX512(uint64_t* dst, const uint64_t* a, const uint64_t* b, const uint64_t* c, uint64_t n)
+{
+	uint64_t i = 0;
+	if constexpr (kNonTemporal)
+	{
+		// Up to the first 64-byte line of dst, then whole lines.
+		i = ((0ULL - uint64_t(reinterpret_cast<uintptr_t>(dst))) & 63ULL) >> 3ULL;
+		i = i < n ? i : n;
+		if (i)
+		{
+			const __mmask8 m = __mmask8((1U << i) - 1U);
+			_mm512_mask_storeu_epi64(dst, m, Op::M512(_mm512_maskz_loadu_epi64(m, a), _mm512_maskz_loadu_epi64(m, b), _mm512_maskz_loadu_epi64(m, c)));
+		}
+		for (; i + 8 <= n; i += 8)
+			_mm512_stream_si512(reinterpret_cast<__m512i*>(dst + i), Op::M512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i), _mm512_loadu_si512(c + i)));
+	}
+	else
+	{
+		for (; i + 8 <= n; i += 8)
+			_mm512_storeu_si512(dst + i, Op::M512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i), _mm512_loadu_si512(c + i)));
+	}
+	if (i < n)
+	{
+		const __mmask8 m = __mmask8((1U << (n - i)) - 1U);
+		_mm512_mask_storeu_epi64(dst + i, m, Op::M512(_mm512_maskz_loadu_epi64(m, a + i), _mm512_maskz_loadu_epi64(m, b + i), _mm512_maskz_loadu_epi64(m, c + i)));
+	}
+	if constexpr (kNonTemporal)
+		_mm_sfence();
+}
+
+// dst[i] = Op(a[i], b[i], c[i]) for the n 64-bit blocks starting at dst, a, b, and c.
+// dst may be a, b, or c, but must not otherwise overlap them.
+// Uses the best variant the compilation target allows, with non-temporal stores past BITOPS_NON_TEMPORAL_THRESHOLD.
+// See bitops_dispatch.h to choose at runtime instead.
+template <class Op>
+static inline void TernaryOp_Blocks(uint64_t* dst, const uint64_t* a, const uint64_t* b, const uint64_t* c, uint64_t n)
+{
+	const bool nonTemporal = BITOPS_NON_TEMPORAL_THRESHOLD && (n << 3ULL) >= uint64_t(BITOPS_NON_TEMPORAL_THRESHOLD);
+#if defined(__AVX512F__)
+	if (nonTemporal)
+		TernaryOp_Blocks_AVX512<Op, true>(dst, a, b, c, n);
+	else
+		TernaryOp_Blocks_AVX512<Op>(dst, a, b, c, n);
+#elif defined(__AVX2__)
+	if (nonTemporal)
+		TernaryOp_Blocks_AVX2<Op, true>(dst, a, b, c, n);
+	else
+		TernaryOp_Blocks_AVX2<Op>(dst, a, b, c, n);
+#else
+	if (nonTemporal)
+		TernaryOp_Blocks_SSE42<Op, true>(dst, a, b, c, n);
+	else
+		TernaryOp_Blocks_SSE42<Op>(dst, a, b, c, n);
+#endif
+}
+
+// Blocks per early-exit test of the mismatch kernels: 4 cache lines, ORed together before a single branch, so that
+// a long match costs one predictable branch per 256 bytes instead of one per block. Scans often stop within the first
+// few blocks, so each kernel tests its first block alone and takes the rest of its first chunk a vector at a time,
+// as it does to search a failing chunk.
+static constexpr uint64_t kMismatchChunkBlocks = 32;
+
+// Return the first index in [i, end) at which the 64-bit blocks at p differ from their counterparts, or end if there
+// is none, a pair of blocks at a time. The counterpart of p[i] is q[i] if kVsBlocks, otherwise x.
+template <bool kVsBlocks>
+[[nodiscard]] BITOPS_TARGET("sse4.2") static inline uint64_t FirstMismatchByVector_SSE42(const uint64_t* p, const uint64_t* q, uint64_t x, uint64_t i, uint64_t end)
+{
+	const __m128i vx = _mm_set1_epi64x(int64_t(x));
+	for (; i + 2 <= end; i += 2)
+	{
+		const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+		const __m128i b = kVsBlocks ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i)) : vx;
+		const uint32_t m = uint32_t(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(a, b)))) ^ 3U;
+		if (m)
+			return i + CountTrailingZeros_U32(m);
+	}
+	if (i < end && p[i] != (kVsBlocks ? q[i] : x))
+		return i;
+	return end;
+}
+
+// Return the index of the first of the n 64-bit blocks starting at p that differs from its counterpart, or n if there
+// is none. The counterpart of p[i] is q[i] if kVsBlocks, otherwise x; q is not read unless kVsBlocks.
+// PTEST per chunk.
+template <bool kVsBlocks>
+[[nodiscard]] BITOPS_TARGET("sse4.2") static inline uint64_t FirstMismatch_Blocks_SSE42(const uint64_t* p, const uint64_t* q, uint64_t x, uint64_t n)
+{
+	if (n && p[0] != (kVsBlocks ? q[0] : x))
+		return 0;
+
+	const uint64_t head = n < kMismatchChunkBlocks ? n : kMismatchChunkBlocks;
+	uint64_t i = FirstMismatchByVector_SSE42<kVsBlocks>(p, q, x, 1, head);
+	if (i < head)
+		return i;
+
+	const __m128i vx = _mm_set1_epi64x(int64_t(x));
+	for (; i + kMismatchChunkBlocks <= n; i += kMismatchChunkBlocks)
+	{
+		__m128i acc0 = _mm_setzero_si128();
+		__m128i acc1 = _mm_setzero_si128();
+		for (uint64_t j = 0; j < kMismatchChunkBlocks; j += 4)
+		{
+			const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + j));
+			const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + j + 2));
+			const __m128i b0 = kVsBlocks ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i + j)) : vx;
+			const __m128i b1 = kVsBlocks ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i + j + 2)) : vx;
+			acc0 = _mm_or_si128(acc0, _mm_xor_si128(a0, b0));
+			acc1 = _mm_or_si128(acc1, _mm_xor_si128(a1, b1));
+		}
+		const __m128i acc = _mm_or_si128(acc0, acc1);
+		if (!_mm_testz_si128(acc, acc))
+			break;
+	}
+	return FirstMismatchByVector_SSE42<kVsBlocks>(p, q, x, i, n);
+}
+
+// Return the first index in [i, end) at which the 64-bit blocks at p differ from their counterparts, or end if there
+// is none, 4 blocks at a time. The counterpart of p[i] is q[i] if kVsBlocks, otherwise x.
+template <bool kVsBlocks>
+[[nodiscard]] BITOPS_TARGET("avx2") static inline uint64_t FirstMismatchByVector_AVX2(const uint64_t* p, const uint64_t* q, uint64_t x, uint64_t i, uint64_t end)
+{
+	const __m256i vx = _mm256_set1_epi64x(int64_t(x));
+	for (; i + 4 <= end; i += 4)
+	{
+		const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+		const __m256i b = kVsBlocks ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q + i)) : vx;
+		const uint32_t m = uint32_t(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(a, b)))) ^ 0xFU;
+		if (m)
+			return i + CountTrailingZeros_U32(m);
+	}
+	for (; i < end; ++i)
+	{
+		if (p[i] != (kVsBlocks ? q[i] : x))
+			return i;
+	}
+	return end;
+}
+
+// Return the index of the first of the n 64-bit blocks starting at p that differs from its counterpart, or n if there
+// is none. The counterpart of p[i] is q[i] if kVsBlocks, otherwise x; q is not read unless kVsBlocks.
+// VPTEST per chunk.
+template <bool kVsBlocks>
+[[nodiscard]] BITOPS_TARGET("avx2") static inline uint64_t FirstMismatch_Blocks_AVX2(const uint64_t* p, const uint64_t* q, uint64_t x, uint64_t n)
+{
+	if (n && p[0] != (kVsBlocks ? q[0] : x))
+		return 0;
+
+	const uint64_t head = n < kMismatchChunkBlocks ? n : kMismatchChunkBlocks;
+	uint64_t i = FirstMismatchByVector_AVX2<kVsBlocks>(p, q, x, 1, head);
+	if (i < head)
+		return i;
+
+	const __m256i vx = _mm256_set1_epi64x(int64_t(x));
+	for (; i + kMismatchChunkBlocks <= n; i += kMismatchChunkBlocks)
+	{
+		__m256i acc0 = _mm256_setzero_si256();
+		__m256i acc1 = _mm256_setzero_si256();
+		for (uint64_t j = 0; j < kMismatchChunkBlocks; j += 8)
+		{
+			const __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + j));
+			const __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + j + 4));
+			const __m256i b0 = kVsBlocks ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q + i + j)) : vx;
+			const __m256i b1 = kVsBlocks ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q + i + j + 4)) : vx;
+			acc0 = _mm256_or_si256(acc0, _mm256_xor_si256(a0, b0));
+			acc1 = _mm256_or_si256(acc1, _mm256_xor_si256(a1, b1));
+		}
+		const __m256i acc = _mm256_or_si256(acc0, acc1);
+		if (!_mm256_testz_si256(acc, acc))
+			break;
+	}
+	return FirstMismatchByVector_AVX2<kVsBlocks>(p, q, x, i, n);
+}
+
+// Return the first index in [i, end) at which the 64-bit blocks at p differ from their counterparts, or end if there
+// is none, 8 blocks at a time, with masked loads for the tail. The counterpart of p[i] is q[i] if kVsBlocks,
+// otherwise x.
+template <bool kVsBlocks>
+[[nodiscard]] BITOPS_TARGET("avx512f") static inline uint64_t FirstMismatchByVector_AVX512(const uint64_t* p, const uint64_t* q, uint64_t x, uint64_t i, uint64_t end)
+{
+	const __m512i vx = _mm512_set1_epi64(int64_t(x));
+	for (; i < end; i += 8)
+	{
+		const __mmask8 valid = end - i >= 8 ? __mmask8(0xFF) : __mmask8((1U << (end - i)) - 1U);
+		const __m512i a = _mm512_maskz_loadu_epi64(valid, p + i);
+		const __m512i b = kVsBlocks ? _mm512_maskz_loadu_epi64(valid, q + i) : vx;
+		const uint32_t m = _mm512_mask_cmpneq_epi64_mask(valid, a, b);
+		if (m)
+			return i + CountTrailingZeros_U32(m);
+	}
+	return end;
+}
+
+// Return the index of the first of the n 64-bit blocks starting at p that differs from its counterpart, or n if there
+// is none. The counterpart of p[i] is q[i] if kVsBlocks, otherwise x; q is not read unless kVsBlocks.
+// One VPTERNLOGQ per vector folds its difference into the chunk's, which KORTEST tests.
+template <bool kVsBlocks>
+[[nodiscard]] BITOPS_TARGET("avx512f") static inline uint64_t FirstMismatch_Blocks_AVX512(const uint64_t* p, const uint64_t* q, uint64_t x, uint64_t n)
+{
+	if (n && p[0] != (kVsBlocks ? q[0] : x))
+		return 0;
+
+	const uint64_t head = n < kMismatchChunkBlocks ? n : kMismatchChunkBlocks;
+	uint64_t i = FirstMismatchByVector_AVX512<kVsBlocks>(p, q, x, 1, head);
+	if (i < head)
+		return i;
+
+	const __m512i vx = _mm512_set1_epi64(int64_t(x));
+	for (; i + kMismatchChunkBlocks <= n; i += kMismatchChunkBlocks)
+	{
+		const __m512i a0 = _mm512_loadu_si512(p + i);
+		const __m512i a1 = _mm512_loadu_si512(p + i + 8);
+		const __m512i a2 = _mm512_loadu_si512(p + i + 16);
+		const __m512i a3 = _mm512_loadu_si512(p + i + 24);
+		const __m512i b0 = kVsBlocks ? _mm512_loadu_si512(q + i) : vx;
+		const __m512i b1 = kVsBlocks ? _mm512_loadu_si512(q + i + 8) : vx;
+		const __m512i b2 = kVsBlocks ? _mm512_loadu_si512(q + i + 16) : vx;
+		const __m512i b3 = kVsBlocks ? _mm512_loadu_si512(q + i + 24) : vx;
+
+		// 0xF6: acc | (a ^ b).
+		__m512i acc = _mm512_xor_si512(a0, b0);
+		acc = _mm512_ternarylogic_epi64(acc, a1, b1, 0xF6);
+		acc = _mm512_ternarylogic_epi64(acc, a2, b2, 0xF6);
+		acc = _mm512_ternarylogic_epi64(acc, a3, b3, 0xF6);
+		if (_mm512_test_epi64_mask(acc, acc))
+			break;
+	}
+	return FirstMismatchByVector_AVX512<kVsBlocks>(p, q, x, i, n);
+}
+
+// Return the index of the first of the n 64-bit blocks starting at p that is not x, or n if there is none.
+[[nodiscard]] static inline uint64_t FirstBlockNotEqualTo_Blocks_SSE42(const uint64_t* p, uint64_t n, uint64_t x)
+{
+	return FirstMismatch_Blocks_SSE42<false>(p, nullptr, x, n);
+}
+
+// Return the index of the first of the n 64-bit blocks starting at p that is not x, or n if there is none.
+[[nodiscard]] static inline uint64_t FirstBlockNotEqualTo_Blocks_AVX2(const uint64_t* p, uint64_t n, uint64_t x)
+{
+	return FirstMismatch_Blocks_AVX2<false>(p, nullptr, x, n);
+}
+
+// Return the index of the first of the n 64-bit blocks starting at p that is not x, or n if there is none.
+[[nodiscard]] static inline uint64_t FirstBlockNotEqualTo_Blocks_AVX512(const uint64_t* p, uint64_t n, uint64_t x)
+{
+	return FirstMismatch_Blocks_AVX512<false>(p, nullptr, x, n);
+}
+
+// Return the index of the first of the n 64-bit blocks starting at p that is not x, or n if there is none.
+// Uses the best variant the compilation target allows. See bitops_dispatch.h to choose at runtime instead.
+[[nodiscard]] static inline uint64_t FirstBlockNotEqualTo_Blocks(const uint64_t* p, uint64_t n, uint64_t x)
+{
+#if defined(__AVX512F__)
+	return FirstBlockNotEqualTo_Blocks_AVX512(p, n, x);
+#elif defined(__AVX2__)
+	return FirstBlockNotEqualTo_Blocks_AVX2(p, n, x);
+#else
+	return FirstBlockNotEqualTo_Blocks_SSE42(p, n, x);
+#endif
+}
+
+// Return the first i < n for which the 64-bit blocks p[i] and q[i] differ, or n if there is none.
+[[nodiscard]] static inline uint64_t FirstUnequalBlock_Blocks_SSE42(const uint64_t* p, const uint64_t* q, uint64_t n)
+{
+	return FirstMismatch_Blocks_SSE42<true>(p, q, 0, n);
+}
+
+// Return the first i < n for which the 64-bit blocks p[i] and q[i] differ, or n if there is none.
+[[nodiscard]] static inline uint64_t FirstUnequalBlock_Blocks_AVX2(const uint64_t* p, const uint64_t* q, uint64_t n)
+{
+	return FirstMismatch_Blocks_AVX2<true>(p, q, 0, n);
+}
+
+// Return the first i < n for which the 64-bit blocks p[i] and q[i] differ, or n if there is none.
+[[nodiscard]] static inline uint64_t FirstUnequalBlock_Blocks_AVX512(const uint64_t* p, const uint64_t* q, uint64_t n)
+{
+	return FirstMismatch_Blocks_AVX512<true>(p, q, 0, n);
+}
+
+// Return the first i < n for which the 64-bit blocks p[i] and q[i] differ, or n if there is none.
+// Uses the best variant the compilation target allows. See bitops_dispatch.h to choose at runtime instead.
+[[nodiscard]] static inline uint64_t FirstUnequalBlock_Blocks(const uint64_t* p, const uint64_t* q, uint64_t n)
+{
+#if defined(__AVX512F__)
+	return FirstUnequalBlock_Blocks_AVX512(p, q, n);
+#elif defined(__AVX2__)
+	return FirstUnequalBlock_Blocks_AVX2(p, q, n);
+#else
+	return FirstUnequalBlock_Blocks_SSE42(p, q, n);
+#endif
+}
+
+// Return the last index in [begin, i) at which the 64-bit block at p is not x, or ~0ULL if there is none, a pair of
+// blocks at a time.
+[[nodiscard]] BITOPS_TARGET("sse4.2") static inline uint64_t LastNotEqualToByVector_SSE42(const uint64_t* p, uint64_t x, uint64_t begin, uint64_t i)
+{
+	const __m128i vx = _mm_set1_epi64x(int64_t(x));
+	for (; i >= begin + 2; i -= 2)
+	{
+		const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i - 2));
+		const uint32_t m = uint32_t(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(a, vx)))) ^ 3U;
+		if (m)
+			return i - 2 + LastSetBitIndex_U32(m);
+	}
+	if (i > begin && p[begin] != x)
+		return begin;
+	return ~0ULL;
+}
+
+// Return the index of the last of the n 64-bit blocks starting at p that is not x, or ~0ULL if there is none.
+// As FirstMismatch_Blocks_SSE42, from the end down.
+[[nodiscard]] BITOPS_TARGET("sse4.2") static inline uint64_t LastBlockNotEqualTo_Blocks_SSE42(const uint64_t* p, uint64_t n, uint64_t x)
+{
+	// ~0ULL if n is 0.
+	if (!n || p[n - 1] != x)
+		return n - 1;
+
+	uint64_t i = n < kMismatchChunkBlocks ? 0 : n - kMismatchChunkBlocks;
+	const uint64_t last = LastNotEqualToByVector_SSE42(p, x, i, n - 1);
+	if (last != ~0ULL)
+		return last;
+
+	const __m128i vx = _mm_set1_epi64x(int64_t(x));
+	for (; i >= kMismatchChunkBlocks; i -= kMismatchChunkBlocks)
+	{
+		const uint64_t* chunk = p + i - kMismatchChunkBlocks;
+		__m128i acc0 = _mm_setzero_si128();
+		__m128i acc1 = _mm_setzero_si128();
+		for (uint64_t j = 0; j < kMismatchChunkBlocks; j += 4)
+		{
+			acc0 = _mm_or_si128(acc0, _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(chunk + j)), vx));
+			acc1 = _mm_or_si128(acc1, _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(chunk + j + 2)), vx));
+		}
+		const __m128i acc = _mm_or_si128(acc0, acc1);
+		if (!_mm_testz_si128(acc, acc))
+			break;
+	}
+	return LastNotEqualToByVector_SSE42(p, x, 0, i);
+}
+
+// Return the last index in [begin, i) at which the 64-bit block at p is not x, or ~0ULL if there is none, 4 blocks
+// at a time.
+[[nodiscard]] BITOPS_TARGET("avx2") static inline uint64_t LastNotEqualToByVector_AVX2(const uint64_t* p, uint64_t x, uint64_t begin, uint64_t i)
+{
+	const __m256i vx = _mm256_set1_epi64x(int64_t(x));
+	for (; i >= begin + 4; i -= 4)
+	{
+		const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i - 4));
+		const uint32_t m = uint32_t(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(a, vx)))) ^ 0xFU;
+		if (m)
+			return i - 4 + LastSetBitIndex_U32(m);
+	}
+	while (i > begin)
+	{
+		if (p[--i] != x)
+			return i;
+	}
+	return ~0ULL;
+}
+
+// Return the index of the last of the n 64-bit blocks starting at p that is not x, or ~0ULL if there is none.
+// As FirstMismatch_Blocks_AVX2, from the end down.
+[[nodiscard]] BITOPS_TARGET("avx2") static inline uint64_t LastBlockNotEqualTo_Blocks_AVX2(const uint64_t* p, uint64_t n, uint64_t x)
+{
+	// ~0ULL if n is 0.
+	if (!n || p[n - 1] != x)
+		return n - 1;
+
+	uint64_t i = n < kMismatchChunkBlocks ? 0 : n - kMismatchChunkBlocks;
+	const uint64_t last = LastNotEqualToByVector_AVX2(p, x, i, n - 1);
+	if (last != ~0ULL)
+		return last;
+
+	const __m256i vx = _mm256_set1_epi64x(int64_t(x));
+	for (; i >= kMismatchChunkBlocks; i -= kMismatchChunkBlocks)
+	{
+		const uint64_t* chunk = p + i - kMismatchChunkBlocks;
+		__m256i acc0 = _mm256_setzero_si256();
+		__m256i acc1 = _mm256_setzero_si256();
+		for (uint64_t j = 0; j < kMismatchChunkBlocks; j += 8)
+		{
+			acc0 = _mm256_or_si256(acc0, _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(chunk + j)), vx));
+			acc1 = _mm256_or_si256(acc1, _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(chunk + j + 4)), vx));
+		}
+		const __m256i acc = _mm256_or_si256(acc0, acc1);
+		if (!_mm256_testz_si256(acc, acc))
+			break;
+	}
+	return LastNotEqualToByVector_AVX2(p, x, 0, i);
+}
+
+// Return the last index in [begin, i) at which the 64-bit block at p is not x, or ~0ULL if there is none, 8 blocks
+// at a time, with masked loads for the head.
+[[nodiscard]] BITOPS_TARGET("avx512f") static inline uint64_t LastNotEqualToByVector_AVX512(const uint64_t* p, uint64_t x, uint64_t begin, uint64_t i)
+{
+	const __m512i vx = _mm512_set1_epi64(int64_t(x));
+	while (i > begin)
+	{
+		// The vector ending at block i, or the blocks from begin to i.
+		const uint64_t k = i - begin < 8 ? i - begin : 8;
+		const __mmask8 valid = __mmask8(0xFFU >> (8 - k));
+		const uint32_t m = _mm512_mask_cmpneq_epi64_mask(valid, _mm512_maskz_loadu_epi64(valid, p + i - k), vx);
+		if (m)
+			return i - k + LastSetBitIndex_U32(m);
+		i -= k;
+	}
+	return ~0ULL;
+}
+
+// Return the index of the last of the n 64-bit blocks starting at p that is not x, or ~0ULL if there is none.
+// As FirstMismatch_Blocks_AVX512, from the end down.
+[[nodiscard]] BITOPS_TARGET("avx512f") static inline uint64_t LastBlockNotEqualTo_Blocks_AVX512(const uint64_t* p, uint64_t n, uint64_t x)
+{
+	// ~0ULL if n is 0.
+	if (!n || p[n - 1] != x)
+		return n - 1;
+
+	uint64_t i = n < kMismatchChunkBlocks ? 0 : n - kMismatchChunkBlocks;
+	const uint64_t last = LastNotEqualToByVector_AVX512(p, x, i, n - 1);
+	if (last != ~0ULL)
+		return last;
+
+	const __m512i vx = _mm512_set1_epi64(int64_t(x));
+	for (; i >= kMismatchChunkBlocks; i -= kMismatchChunkBlocks)
+	{
+		const uint64_t* chunk = p + i - kMismatchChunkBlocks;
+
+		// 0xF6: acc | (a ^ b).
+		__m512i acc = _mm512_xor_si512(_mm512_loadu_si512(chunk), vx);
+		acc = _mm512_ternarylogic_epi64(acc, _mm512_loadu_si512(chunk + 8), vx, 0xF6);
+		acc = _mm512_ternarylogic_epi64(acc, _mm512_loadu_si512(chunk + 16), vx, 0xF6);
+		acc = _mm512_ternarylogic_epi64(acc, _mm512_loadu_si512(chunk + 24), vx, 0xF6);
+		if (_mm512_test_epi64_mask(acc, acc))
+			break;
+	}
+	return LastNotEqualToByVector_AVX512(p, x, 0, i);
+}
+
+// Return the index of the last of the n 64-bit blocks starting at p that is not x, or ~0ULL if there is none.
+// Uses the best variant the compilation target allows. See bitops_dispatch.h to choose at runtime instead.
+[[nodiscard]] static inline uint64_t LastBlockNotEqualTo_Blocks(const uint64_t* p, uint64_t n, uint64_t x)
+{
+#if defined(__AVX512F__)
+	return LastBlockNotEqualTo_Blocks_AVX512(p, n, x);
+#elif defined(__AVX2__)
+	return LastBlockNotEqualTo_Blocks_AVX2(p, n, x);
+#else
+	return LastBlockNotEqualTo_Blocks_SSE42(p, n, x);
+#endif
+}
+
+// Indices ahead of the current one whose blocks TestBits_Blocks, SetBits_Blocks, and ClearBits_Blocks prefetch:
+// enough to keep about as many cache misses in flight as a core can track, which a loop of dependent accesses
+// through random indices would otherwise take one at a time.
+static constexpr uint64_t kBitBatchPrefetchDistance = 16;
+
+// Prefetch the block holding bit idx[i] of the blocks at p, if i < n.
+static inline void PrefetchBitBlock(const uint64_t* p, const uint64_t* idx, uint64_t i, uint64_t n)
+{
+	if (i < n)
+		_mm_prefetch(reinterpret_cast<const char*>(p + (idx[i] >> 6ULL)), _MM_HINT_T0);
+}
+
+// out[i] = 1 if bit idx[i] of the 64-bit blocks starting at p is set, otherwise 0, for the n indices at idx.
+// Bit j of block i has index 64 * i + j.
+// One index at a time, with prefetching; the baseline variant for runtime dispatch.
+static inline void TestBits_Blocks_SSE42(uint8_t* __restrict out, const uint64_t* __restrict p, const uint64_t* __restrict idx, uint64_t n)
+{
+	for (uint64_t i = 0; i < n; ++i)
+	{
+		PrefetchBitBlock(p, idx, i + kBitBatchPrefetchDistance, n);
+		out[i] = uint8_t((p[idx[i] >> 6ULL] >> (idx[i] & 63ULL)) & 1ULL);
+	}
+}
+
+// out[i] = 1 if bit idx[i] of the 64-bit blocks starting at p is set, otherwise 0, for the n indices at idx.
+// Bit j of block i has index 64 * i + j.
+// 4 indices at a time: VPGATHERQQ fetches their blocks, VPSLLVQ shifts each bit to the top, and VMOVMSKPD collects
+// the 4 bits, which a multiply spreads to one per byte. The tail goes one index at a time.
+BITOPS_TARGET("avx2") static inline void TestBits_Blocks_AVX2(uint8_t* __restrict out, const uint64_t* __restrict p, const uint64_t* __restrict idx, uint64_t n)
+{
+	const __m256i low6 = _mm256_set1_epi64x(63);
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		for (uint64_t j = i + kBitBatchPrefetchDistance; j < i + kBitBatchPrefetchDistance + 4; ++j)
+			PrefetchBitBlock(p, idx, j, n);
+
+		const __m256i vi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx + i));
+		const __m256i blocks = _mm256_i64gather_epi64(reinterpret_cast<const long long*>(p), _mm256_srli_epi64(vi, 6), 8);
+		const __m256i top = _mm256_sllv_epi64(blocks, _mm256_sub_epi64(low6, _mm256_and_si256(vi, low6)));
+		const uint32_t bits = uint32_t(_mm256_movemask_pd(_mm256_castsi256_pd(top)));
+		const uint32_t bytes = (bits * 0x00204081U) & 0x01010101U;
+		memcpy(out + i, &bytes, sizeof(bytes));
+	}
+
+	for (; i < n; ++i)
+		out[i] = uint8_t((p[idx[i] >> 6ULL] >> (idx[i] & 63ULL)) & 1ULL);
+}
+
+// out[i] = 1 if bit idx[i] of the 64-bit blocks starting at p is set, otherwise 0, for the n indices at idx.
+// Bit j of block i has index 64 * i + j.
+// 8 indices at a time: VPGATHERQQ fetches their blocks, VPSRLVQ shifts each bit down, and VPMOVQB narrows the
+// results to bytes. The tail is gathered and stored under a mask.
+BITOPS_TARGET("avx512f") static inline void TestBits_Blocks_AVX512(uint8_t* __restrict out, const uint64_t* __restrict p, const uint64_t* __restrict idx, uint64_t n)
+{
+	const __m512i low6 = _mm512_set1_epi64(63);
+	const __m512i one = _mm512_set1_epi64(1);
+	for (uint64_t i = 0; i < n; i += 8)
+	{
+		for (uint64_t j = i + kBitBatchPrefetchDistance; j < i + kBitBatchPrefetchDistance + 8; ++j)
+			PrefetchBitBlock(p, idx, j, n);
+
+		const __mmask8 valid = n - i >= 8 ? __mmask8(0xFF) : __mmask8((1U << (n - i)) - 1U);
+		const __m512i vi = _mm512_maskz_loadu_epi64(valid, idx + i);
+		const __m512i blocks = _mm512_mask_i64gather_epi64(_mm512_setzero_si512(), valid, _mm512_srli_epi64(vi, 6), p, 8);
+		const __m512i bits = _mm512_and_si512(_mm512_srlv_epi64(blocks, _mm512_and_si512(vi, low6)), one);
+		_mm512_mask_cvtepi64_storeu_epi8(out + i, valid, bits);
+	}
+}
+
+// out[i] = 1 if bit idx[i] of the 64-bit blocks starting at p is set, otherwise 0, for the n indices at idx.
+// Bit j of block i has index 64 * i + j.
+// Uses the best variant the compilation target allows. See bitops_dispatch.h to choose at runtime instead.
+static inline void TestBits_Blocks(uint8_t* __restrict out, const uint64_t* __restrict p, const uint64_t* __restrict idx, uint64_t n)
+{
+#if defined(__AVX512F__)
+	TestBits_Blocks_AVX512(out, p, idx, n);
+#elif defined(__AVX2__)
+	TestBits_Blocks_AVX2(out, p, idx, n);
+#else
+	TestBits_Blocks_SSE42(out, p, idx, n);
+#endif
+}
+
+// Set bit idx[i] of the 64-bit blocks starting at p for each of the n indices at idx, with prefetching.
+// Bit j of block i has index 64 * i + j. Indices may repeat.
+static inline void SetBits_Blocks(uint64_t* __restrict p, const uint64_t* __restrict idx, uint64_t n)
+{
+	for (uint64_t i = 0; i < n; ++i)
+	{
+		PrefetchBitBlock(p, idx, i + kBitBatchPrefetchDistance, n);
+		p[idx[i] >> 6ULL] |= 1ULL << (idx[i] & 63ULL);
+	}
+}
+
+// Clear bit idx[i] of the 64-bit blocks starting at p for each of the n indices at idx, with prefetching.
+// Bit j of block i has index 64 * i + j. Indices may repeat.
+static inline void ClearBits_Blocks(uint64_t* __restrict p, const uint64_t* __restrict idx, uint64_t n)
+{
+	for (uint64_t i = 0; i < n; ++i)
+	{
+		PrefetchBitBlock(p, idx, i + kBitBatchPrefetchDistance, n);
+		p[idx[i] >> 6ULL] &= ~(1ULL << (idx[i] & 63ULL));
+	}
+}
+
+// Odd multipliers that turn the low 32 bits of a hash into one bit index per 64-bit word of a 512-bit Bloom filter
+// bucket: the top 6 bits of each product.
+alignas(32) static constexpr uint32_t kBloomBucketSalts[8] = {
+	0x47B6137BU, 0x44974D91U, 0x8824AD5BU, 0xA2B7289DU, 0x705495C7U, 0x2DF1424BU, 0x9EFC4947U, 0x5C6BFB31U,
+};
+
+// Set bit (h * kBloomBucketSalts[i]) >> 26 of word i of the 8-word bucket at p, for each word i.
+static inline void SetBloomBucketBits_SSE42(uint64_t* p, uint32_t h)
+{
+	for (uint64_t i = 0; i < 8; ++i)
+		p[i] |= 1ULL << ((h * kBloomBucketSalts[i]) >> 26U);
+}
+
+// Set bit (h * kBloomBucketSalts[i]) >> 26 of word i of the 8-word bucket at p, for each word i.
+// The 8 products come from one VPMULLD, the 8 bits from two VPSLLVQs.
+BITOPS_TARGET("avx2") static inline void SetBloomBucketBits_AVX2(uint64_t* p, uint32_t h)
+{
+	const __m256i shifts = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(int(h)), _mm256_load_si256(reinterpret_cast<const __m256i*>(kBloomBucketSalts))), 26);
+	const __m256i one = _mm256_set1_epi64x(1);
+	const __m256i lo = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(shifts)));
+	const __m256i hi = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(shifts, 1)));
+	__m256i* v = reinterpret_cast<__m256i*>(p);
+	_mm256_storeu_si256(v, _mm256_or_si256(_mm256_loadu_si256(v), lo));
+	_mm256_storeu_si256(v + 1, _mm256_or_si256(_mm256_loadu_si256(v + 1), hi));
+}
+
+// Set bit (h * kBloomBucketSalts[i]) >> 26 of word i of the 8-word bucket at p, for each word i.
+// The 8 products come from one VPMULLD, the 8 bits from one VPSLLVQ, and the bucket is updated as one vector.
+BITOPS_TARGET("avx512f") static inline void SetBloomBucketBits_AVX512(uint64_t* p, uint32_t h)
+{
+	const __m256i shifts = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(int(h)), _mm256_load_si256(reinterpret_cast<const __m256i*>(kBloomBucketSalts))), 26);
+	const __m512i bits = _mm512_sllv_epi64(_mm512_set1_epi64(1), _mm512_cvtepu32_epi64(shifts));
+	_mm512_storeu_si512(p, _mm512_or_si512(_mm512_loadu_si512(p), bits));
+}
+
+// Set bit (h * kBloomBucketSalts[i]) >> 26 of word i of the 8-word bucket at p, for each word i.
+// Uses the best variant the compilation target allows.
+static inline void SetBloomBucketBits(uint64_t* p, uint32_t h)
+{
+#if defined(__AVX512F__)
+	SetBloomBucketBits_AVX512(p, h);
+#elif defined(__AVX2__)
+	SetBloomBucketBits_AVX2(p, h);
+#else
+	SetBloomBucketBits_SSE42(p, h);
+#endif
+}
+
+// Check if bit (h * kBloomBucketSalts[i]) >> 26 of word i of the 8-word bucket at p is set, for every word i.
+[[nodiscard]] static inline bool AreBloomBucketBitsSet_SSE42(const uint64_t* p, uint32_t h)
+{
+	uint64_t missing = 0;
+	for (uint64_t i = 0; i < 8; ++i)
+		missing |= ~p[i] & (1ULL << ((h * kBloomBucketSalts[i]) >> 26U));
+	return !missing;
+}
+
+// Check if bit (h * kBloomBucketSalts[i]) >> 26 of word i of the 8-word bucket at p is set, for every word i.
+// Builds the bits as SetBloomBucketBits_AVX2() does, and checks each half of the bucket with one VPTEST.
+[[nodiscard]] BITOPS_TARGET("avx2") static inline bool AreBloomBucketBitsSet_AVX2(const uint64_t* p, uint32_t h)
+{
+	const __m256i shifts = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(int(h)), _mm256_load_si256(reinterpret_cast<const __m256i*>(kBloomBucketSalts))), 26);
+	const __m256i one = _mm256_set1_epi64x(1);
+	const __m256i lo = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(shifts)));
+	const __m256i hi = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(shifts, 1)));
+	const __m256i* v = reinterpret_cast<const __m256i*>(p);
+	return _mm256_testc_si256(_mm256_loadu_si256(v), lo) & _mm256_testc_si256(_mm256_loadu_si256(v + 1), hi);
+}
+
+// Check if bit (h * kBloomBucketSalts[i]) >> 26 of word i of the 8-word bucket at p is set, for every word i.
+// Builds the bits as SetBloomBucketBits_AVX512() does, and checks the whole bucket with one VPTESTNMQ.
+[[nodiscard]] BITOPS_TARGET("avx512f") static inline bool AreBloomBucketBitsSet_AVX512(const uint64_t* p, uint32_t h)
+{
+	const __m256i shifts = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(int(h)), _mm256_load_si256(reinterpret_cast<const __m256i*>(kBloomBucketSalts))), 26);
+	const __m512i bits = _mm512_sllv_epi64(_mm512_set1_epi64(1), _mm512_cvtepu32_epi64(shifts));
+	return !_mm512_testn_epi64_mask(_mm512_loadu_si512(p), bits);
+}
+
+// Check if bit (h * kBloomBucketSalts[i]) >> 26 of word i of the 8-word bucket at p is set, for every word i.
+// Uses the best variant the compilation target allows.
+[[nodiscard]] static inline bool AreBloomBucketBitsSet(const uint64_t* p, uint32_t h)
+{
+#if defined(__AVX512F__)
+	return AreBloomBucketBitsSet_AVX512(p, h);
+#elif defined(__AVX2__)
+	return AreBloomBucketBitsSet_AVX2(p, h);
+#else
+	return AreBloomBucketBitsSet_SSE42(p, h);
+#endif
+}
+
+// Bit positions of the set bits of each byte value, in increasing order, padded with zeros.
+struct DecodeSetBitsTable
+{
+	alignas(64) uint8_t idx[256][8];
+};
+
+[[nodiscard]] static constexpr DecodeSetBitsTable MakeDecodeSetBitsTable()
+{
+	DecodeSetBitsTable t = {};
+	for (uint32_t x = 0; x < 256; ++x)
+	{
+		uint32_t n = 0;
+		for (uint32_t i = 0; i < 8; ++i)
+		{
+			if ((x >> i) & 1U)
+				t.idx[x][n++] = uint8_t(i);
+		}
+	}
+	return t;
+}
+
+inline constexpr DecodeSetBitsTable kDecodeSetBitsTable = MakeDecodeSetBitsTable();
+
+// Write base + the index of each set bit in the n 64-bit blocks starting at p to out, in increasing order.
+// Bit j of block i has index 64 * i + j. out must have room for one entry per set bit; nothing past that is written.
+// Return the number of entries written.
+// tzcnt loop; the baseline variant for runtime dispatch.
+static inline uint64_t DecodeSetBits_Blocks_SSE42(uint32_t* __restrict out, const uint64_t* __restrict p, uint64_t n, uint32_t base)
+{
+	uint32_t* const start = out;
+	for (uint64_t i = 0; i < n; ++i)
+	{
+		const uint32_t offset = base + uint32_t(i << 6ULL);
+		for (uint64_t x = p[i]; x; x = ClearFirstSetBit_U64(x))
+			*out++ = offset + uint32_t(FirstSetBitIndex_U64(x));
+	}
+	return uint64_t(out - start);
+}
+
+// Write base + the index of each set bit in the n 64-bit blocks starting at p to out, in increasing order.
+// Bit j of block i has index 64 * i + j. out must have room for one entry per set bit; nothing past that is written.
+// Return the number of entries written.
+// One table lookup per nonzero byte, widened and stored as 8 indices. Each store may run past the byte's own
+// indices into space the rest of the block will overwrite; the block's last few stores are masked to stay in bounds.
+BITOPS_TARGET("avx2,popcnt") static inline uint64_t DecodeSetBits_Blocks_AVX2(uint32_t* __restrict out, const uint64_t* __restrict p, uint64_t n, uint32_t base)
+{
+	uint32_t* const start = out;
+	const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	for (uint64_t i = 0; i < n; ++i)
+	{
+		uint64_t x = p[i];
+		uint32_t remaining = uint32_t(CountSetBits_U64(x));
+		__m256i offset = _mm256_set1_epi32(int32_t(base + uint32_t(i << 6ULL)));
+		for (; x; x >>= 8ULL, offset = _mm256_add_epi32(offset, _mm256_set1_epi32(8)))
+		{
+			const uint32_t byte = uint32_t(x & 0xFFULL);
+			const __m128i idx = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(kDecodeSetBitsTable.idx[byte]));
+			const __m256i v = _mm256_add_epi32(offset, _mm256_cvtepu8_epi32(idx));
+			if (remaining >= 8)
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), v);
+			else
+				_mm256_maskstore_epi32(reinterpret_cast<int*>(out), _mm256_cmpgt_epi32(_mm256_set1_epi32(int32_t(remaining)), lane), v);
+			const uint32_t count = CountSetBits_U32(byte);
+			out += count;
+			remaining -= count;
+		}
+	}
+	return uint64_t(out - start);
+}
+
+// Write base + the index of each set bit in the n 64-bit blocks starting at p to out, in increasing order.
+// Bit j of block i has index 64 * i + j. out must have room for one entry per set bit; nothing past that is written.
+// Return the number of entries written.
+// VPCOMPRESSD 16 bits at a time. The compress goes to a register followed by a masked store, as
+// the compress-to-memory form is microcoded on some cores.
+BITOPS_TARGET("avx512f,popcnt") static inline uint64_t DecodeSetBits_Blocks_AVX512(uint32_t* __restrict out, const uint64_t* __restrict p, uint64_t n, uint32_t base)
+{
+	uint32_t* const start = out;
+	const __m512i lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	for (uint64_t i = 0; i < n; ++i)
+	{
+		__m512i offset = _mm512_add_epi32(lane, _mm512_set1_epi32(int32_t(base + uint32_t(i << 6ULL))));
+		for (uint64_t x = p[i]; x; x >>= 16ULL, offset = _mm512_add_epi32(offset, _mm512_set1_epi32(16)))
+		{
+			const __mmask16 m = __mmask16(x);
+			const uint32_t count = CountSetBits_U32(uint32_t(m));
+			_mm512_mask_storeu_epi32(out, __mmask16((1U << count) - 1U), _mm512_maskz_compress_epi32(m, offset));
+			out += count;
+		}
+	}
+	return uint64_t(out - start);
+}
+
+// Write base + the index of each set bit in the n 64-bit blocks starting at p to out, in increasing order.
+// Bit j of block i has index 64 * i + j. out must have room for one entry per set bit; nothing past that is written.
+// Return the number of entries written.
+// Uses the best variant the compilation target allows. See bitops_dispatch.h to choose at runtime instead.
+static inline uint64_t DecodeSetBits_Blocks(uint32_t* __restrict out, const uint64_t* __restrict p, uint64_t n, uint32_t base)
+{
+#if defined(__AVX512F__)
+	return DecodeSetBits_Blocks_AVX512(out, p, n, base);
+#elif defined(__AVX2__)
+	return DecodeSetBits_Blocks_AVX2(out, p, n, base);
+#else
+	return DecodeSetBits_Blocks_SSE42(out, p, n, base);
+#endif
+}
+
+// A run of consecutive set (or clear) bits: bits [start, start + length).
+struct BitRun
+{
+	uint64_t start;
+	uint64_t length;
+};
+
+// Find the first run of set bits starting at or after bit i of the numBits bits in the blocks at p, with each block
+// XORed with flip first (~0ULL to find runs of clear bits instead). Return its first bit and set end to one past its
+// last, or return numBits, leaving end unmodified, if there is none. Excess bits of the last block are ignored.
+// tzcnt finds each edge, and the inverted block the far one, so a run spanning whole blocks costs one compare per block.
+[[nodiscard]] static inline uint64_t NextRun_Blocks(const uint64_t* p, uint64_t numBits, uint64_t i, uint64_t flip, uint64_t& end)
+{
+	if (i >= numBits)
+		return numBits;
+
+	const uint64_t numBlocks = (numBits + 63ULL) >> 6ULL;
+	uint64_t iBlock = i >> 6ULL;
+	uint64_t block = (p[iBlock] ^ flip) & (~0ULL << (i & 63ULL));
+	while (!block)
+	{
+		if (++iBlock == numBlocks)
+			return numBits;
+		block = p[iBlock] ^ flip;
+	}
+
+	const uint64_t start = (iBlock << 6ULL) + FirstSetBitIndex_U64(block);
+	if (start >= numBits)
+		return numBits;
+
+	block = ~block & (~0ULL << (start & 63ULL));
+	while (!block)
+	{
+		if (++iBlock == numBlocks)
+		{
+			end = numBits;
+			return start;
+		}
+		block = ~(p[iBlock] ^ flip);
+	}
+
+	const uint64_t iEnd = (iBlock << 6ULL) + FirstSetBitIndex_U64(block);
+	end = iEnd < numBits ? iEnd : numBits;
+	return start;
+}
+
+// Return the longest run of set bits in the numBits bits of the blocks at p, with each block XORed with flip first
+// (~0ULL for the longest run of clear bits instead), the lowest-index one if there is a tie, or { ~0ULL, 0 } if there
+// is none. Excess bits of the last block are ignored. One pass, a run at a time.
+[[nodiscard]] static inline BitRun LargestRun_Blocks(const uint64_t* p, uint64_t numBits, uint64_t flip)
+{
+	BitRun best = { ~0ULL, 0ULL };
+	uint64_t end = 0;
+	for (uint64_t start = NextRun_Blocks(p, numBits, 0, flip, end); start < numBits; start = NextRun_Blocks(p, numBits, end, flip, end))
+	{
+		if (end - start > best.length)
+			best = { start, end - start };
+	}
+	return best;
+}
+
+// Return the index of the first bit aligned to alignment, a power of 2, that starts n bits within the shortest run of
+// set bits in the numBits bits of the blocks at p that holds such n bits, with each block XORed with flip first (~0ULL
+// for runs of clear bits instead). Ties go to the lowest index. Return ~0ULL if no run holds them. Excess bits of the
+// last block are ignored. One pass, a run at a time, stopping early at a run of exactly n bits.
+[[nodiscard]] static inline uint64_t BestFitRun_Blocks(const uint64_t* p, uint64_t numBits, uint64_t n, uint64_t alignment, uint64_t flip)
+{
+	uint64_t best = ~0ULL;
+	uint64_t bestLength = ~0ULL;
+	uint64_t end = 0;
+	for (uint64_t start = NextRun_Blocks(p, numBits, 0, flip, end); start < numBits; start = NextRun_Blocks(p, numBits, end, flip, end))
+	{
+		const uint64_t length = end - start;
+		const uint64_t aligned = (start + alignment - 1ULL) & ~(alignment - 1ULL);
+		if (length < bestLength && aligned <= end && n <= end - aligned)
+		{
+			best = aligned;
+			bestLength = length;
+			if (length == n)
+				break;
+		}
+	}
+	return best;
+}
+
+// Write each run of set bits in the numBits bits of the blocks at p, with each block XORed with flip first (~0ULL for
+// runs of clear bits instead), to out, in increasing order. Excess bits of the last block are ignored. out must have
+// room for one entry per run, at most (numBits + 1) / 2; nothing past that is written. Return the number of entries written.
+// One pass: the set bits of x ^ (x << 1), carrying in the previous block's top bit, are exactly the edges of the runs,
+// which alternate between starts and ends.
+static inline uint64_t EncodeRuns_Blocks(BitRun* __restrict out, const uint64_t* __restrict p, uint64_t numBits, uint64_t flip)
+{
+	BitRun* const first = out;
+	const uint64_t numBlocks = (numBits + 63ULL) >> 6ULL;
+	uint64_t carry = 0;
+	bool inRun = false;
+	for (uint64_t i = 0; i < numBlocks; ++i)
+	{
+		uint64_t x = p[i] ^ flip;
+		if (i == numBlocks - 1 && (numBits & 63ULL))
+			x &= ~(~0ULL << (numBits & 63ULL));
+
+		for (uint64_t edges = x ^ ((x << 1ULL) | carry); edges; edges = ClearFirstSetBit_U64(edges))
+		{
+			const uint64_t iBit = (i << 6ULL) + FirstSetBitIndex_U64(edges);
+			if (inRun)
+			{
+				out->length = iBit - out->start;
+				++out;
+			}
+			else
+			{
+				out->start = iBit;
+			}
+			inRun = !inRun;
+		}
+		carry = x >> 63ULL;
+	}
+
+	if (inRun)
+	{
+		out->length = numBits - out->start;
+		++out;
+	}
+	return uint64_t(out - first);
+}
+
+// Return the CRC32C (Castagnoli) of the n bytes at p, continuing from crc, the CRC32C of the bytes before them
+// (0 for none). Equivalent to the CRC of the concatenation.
+[[nodiscard]] BITOPS_TARGET("sse4.2") static inline uint32_t Crc32c_Buffer(const uint8_t* p, uint64_t n, uint32_t crc = 0)
+{
+	uint64_t c = ~crc;
+	for (; n >= 8; n -= 8, p += 8)
+	{
+		uint64_t x;
+		memcpy(&x, p, 8);
+		c = _mm_crc32_u64(c, x);
+	}
+	uint32_t c32 = uint32_t(c);
+	for (; n; --n, ++p)
+		c32 = _mm_crc32_u8(c32, *p);
+	return ~c32;
+}
+
+// Shift the numBits bits of the blocks at src toward higher indices by s into the blocks at dst, which may be src:
+// bit i moves to bit i + s. Shifting by numBits or more clears all bits. One pass, from the top down.
+// Excess bits of dst's last block are unspecified.
+static inline void ShiftLeft_Blocks(uint64_t* dst, const uint64_t* src, uint64_t numBits, uint64_t s)
+{
+	const uint64_t numBlocks = (numBits + 63ULL) >> 6ULL;
+	if (s >= numBits)
+	{
+		for (uint64_t i = 0; i < numBlocks; ++i)
+			dst[i] = 0ULL;
+		return;
+	}
+
+	const uint64_t q = s >> 6ULL;
+	const uint64_t r = s & 63ULL;
+
+	if (r == 0)
+	{
+		for (uint64_t i = numBlocks; i-- > q;)
+			dst[i] = src[i - q];
+	}
+	else
+	{
+		for (uint64_t i = numBlocks - 1; i > q; --i)
+			dst[i] = (src[i - q] << r) | (src[i - q - 1] >> (64ULL - r));
+		dst[q] = src[0] << r;
+	}
+
+	for (uint64_t i = 0; i < q; ++i)
+		dst[i] = 0ULL;
+}
+
+// Shift the numBits bits of the blocks at src toward lower indices by s into the blocks at dst, which may be src:
+// bit i moves to bit i - s. Shifting by numBits or more clears all bits. One pass, from the bottom up.
+// Excess bits of src's last block are ignored.
+static inline void ShiftRight_Blocks(uint64_t* dst, const uint64_t* src, uint64_t numBits, uint64_t s)
+{
+	const uint64_t numBlocks = (numBits + 63ULL) >> 6ULL;
+	if (s >= numBits)
+	{
+		for (uint64_t i = 0; i < numBlocks; ++i)
+			dst[i] = 0ULL;
+		return;
+	}
+
+	const uint64_t q = s >> 6ULL;
+	const uint64_t r = s & 63ULL;
+	const uint64_t last = numBlocks - 1 - q;
+	const uint64_t top = src[numBlocks - 1] & (~0ULL >> ((0ULL - numBits) & 63ULL));
+
+	if (r == 0)
+	{
+		for (uint64_t i = 0; i < last; ++i)
+			dst[i] = src[i + q];
+	}
+	else if (last)
+	{
+		for (uint64_t i = 0; i < last - 1; ++i)
+			dst[i] = (src[i + q] >> r) | (src[i + q + 1] << (64ULL - r));
+		dst[last - 1] = (src[numBlocks - 2] >> r) | (top << (64ULL - r));
+	}
+	dst[last] = top >> r;
+
+	for (uint64_t i = last + 1; i < numBlocks; ++i)
+		dst[i] = 0ULL;
+}
+
+// Return the 64 bits starting at bit i < numBits of the numBits >= 64 bits of the blocks at p, continuing from bit 0
+// past the end.
+[[nodiscard]] static inline uint64_t WrappedBlockAt_Blocks(const uint64_t* p, uint64_t numBits, uint64_t i)
+{
+	const uint64_t numBlocks = (numBits + 63ULL) >> 6ULL;
+	const uint64_t iBlock = i >> 6ULL;
+	const uint64_t sh = i & 63ULL;
+	const uint64_t hi = iBlock + 1 < numBlocks ? p[iBlock + 1] : 0ULL;
+	const uint64_t block = sh ? (p[iBlock] >> sh) | (hi << (64ULL - sh)) : p[iBlock];
+
+	const uint64_t remaining = numBits - i;
+	if (remaining >= 64ULL)
+		return block;
+
+	return (block & ((1ULL << remaining) - 1ULL)) | (p[0] << remaining);
+}
+
+// Rotate the numBits > 0 bits of the blocks at src toward higher indices by s < numBits into the blocks at dst, which
+// must not be src: bit i moves to bit (i + s) % numBits. One pass, gathering each output block from the input.
+// Excess bits of src's last block are ignored, and those of dst's are unspecified.
+static inline void RotateLeft_Blocks(uint64_t* __restrict dst, const uint64_t* __restrict src, uint64_t numBits, uint64_t s)
+{
+	if (numBits < 64)
+	{
+		const uint64_t block = src[0] & ((1ULL << numBits) - 1ULL);
+		dst[0] = s ? (block << s) | (block >> (numBits - s)) : block;
+		return;
+	}
+
+	// Output block i starts with input bit (64 * i - s) % numBits.
+	const uint64_t numBlocks = (numBits + 63ULL) >> 6ULL;
+	uint64_t iSrc = s ? numBits - s : 0ULL;
+	for (uint64_t i = 0; i < numBlocks; ++i)
+	{
+		dst[i] = WrappedBlockAt_Blocks(src, numBits, iSrc);
+		iSrc += 64ULL;
+		iSrc = iSrc >= numBits ? iSrc - numBits : iSrc;
+	}
+}
+
+// Reverse the order of bits a through b - 1 of the blocks at p in place, leaving the rest: bit a + j swaps with
+// bit b - 1 - j. Reverses the whole blocks holding the range with ReverseBits_Buffer(), shifts the range back into
+// place, and restores the bits around it in its first and last blocks.
+static inline void ReverseBitRange_Blocks(uint64_t* p, uint64_t a, uint64_t b)
+{
+	if (b - a < 2ULL)
+		return;
+
+	const uint64_t first = a >> 6ULL;
+	const uint64_t numBlocks = ((b + 63ULL) >> 6ULL) - first;
+	const uint64_t numBits = numBlocks << 6ULL;
+	const uint64_t head = p[first];
+	const uint64_t tail = p[first + numBlocks - 1];
+
+	// Bit x of the blocks moves to bit numBits - 1 - x, so the range now starts at bit numBits - (b - 64 * first).
+	uint64_t* q = p + first;
+	ReverseBits_Buffer(reinterpret_cast<uint8_t*>(q), reinterpret_cast<const uint8_t*>(q), numBlocks << 3ULL);
+	const uint64_t from = numBits - (b - (first << 6ULL));
+	const uint64_t to = a & 63ULL;
+	if (from > to)
+		ShiftRight_Blocks(q, q, numBits, from - to);
+	else
+		ShiftLeft_Blocks(q, q, numBits, to - from);
+
+	const uint64_t headMask = (1ULL << (a & 63ULL)) - 1ULL;
+	const uint64_t tailMask = (b & 63ULL) ? ~0ULL << (b & 63ULL) : 0ULL;
+	q[0] = (q[0] & ~headMask) | (head & headMask);
+	q[numBlocks - 1] = (q[numBlocks - 1] & ~tailMask) | (tail & tailMask);
+}
+
+// Blocks up to which RotateLeftInPlace_Blocks() rotates from a copy on the stack rather than by reversals.
+static constexpr uint64_t kRotateInPlaceCopyBlocks = 8;
+
+// Rotate the numBits > 0 bits of the blocks at p toward higher indices by s < numBits, in place: bit i moves to
+// bit (i + s) % numBits. Past kRotateInPlaceCopyBlocks blocks, reverses all the bits, then bits 0 through s - 1 and
+// bits s through numBits - 1, so needs no temporary. Each reversal is a vector pass and a shift pass over its blocks.
+// Excess bits of the last block are left as they were.
+static inline void RotateLeftInPlace_Blocks(uint64_t* p, uint64_t numBits, uint64_t s)
+{
+	if (s == 0)
+		return;
+
+	if (numBits <= 64)
+	{
+		const uint64_t mask = ~0ULL >> (64ULL - numBits);
+		const uint64_t block = p[0] & mask;
+		p[0] = (p[0] & ~mask) | (((block << s) | (block >> (numBits - s))) & mask);
+		return;
+	}
+
+	// Up to a cache line, a copy costs less than the reversals.
+	const uint64_t numBlocks = (numBits + 63ULL) >> 6ULL;
+	if (numBlocks <= kRotateInPlaceCopyBlocks)
+	{
+		uint64_t src[kRotateInPlaceCopyBlocks];
+		memcpy(src, p, numBlocks << 3ULL);
+		RotateLeft_Blocks(p, src, numBits, s);
+		const uint64_t mask = ~0ULL >> ((0ULL - numBits) & 63ULL);
+		p[numBlocks - 1] = (p[numBlocks - 1] & mask) | (src[numBlocks - 1] & ~mask);
+		return;
+	}
+
+	ReverseBitRange_Blocks(p, 0, numBits);
+	ReverseBitRange_Blocks(p, 0, s);
+	ReverseBitRange_Blocks(p, s, numBits);
+}
+
 #if defined(_MSC_VER) && !defined(__clang__) && !defined(__GNUC__)
 #pragma warning (pop)
 #endif
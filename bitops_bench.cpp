@@ -0,0 +1,169 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#include <vector>
+
+#include "bench.h"
+#include "bitops.h"
+
+// Inputs per primitive benchmark, cycled through, so that a whole table stays in L1.
+static constexpr uint64_t kNumInputs = 4096;
+
+template <class T>
+struct PrimitiveInputs
+{
+    T x[kNumInputs];
+
+    // Index or count argument, in [1, bits of T).
+    uint32_t n[kNumInputs];
+};
+
+// Throughput of f(x, n) over the inputs: each iteration is independent but for an XOR into an accumulator, so
+// the time per op is reciprocal throughput, not latency.
+template <class T, class F>
+static void BenchPrimitive(const char* name, uint32_t density, const PrimitiveInputs<T>& in, F&& f)
+{
+    char fullName[96];
+    snprintf(fullName, sizeof(fullName), "%s/%u%%", name, density);
+    if (!BenchSelected("bitops", fullName))
+        return;
+
+    const BenchResult r = BenchMeasure([&](uint64_t numIterations)
+        {
+            uint64_t acc = 0;
+            for (uint64_t k = 0; k < numIterations; ++k)
+            {
+                const uint64_t i = k & (kNumInputs - 1);
+                acc ^= uint64_t(f(in.x[i], in.n[i]));
+            }
+            DoNotOptimize(acc);
+        });
+    PrintBenchResult("bitops", fullName, r, sizeof(T));
+}
+
+#define BENCH_PRIMITIVE(name, S, ...) BenchPrimitive(#name "_" #S, density, in, [](T x, uint32_t n) { (void)x; (void)n; return name##_##S(__VA_ARGS__); })
+
+// Every _U8/_U16/_U32/_U64 primitive of one width S, on inputs of the given density.
+#define BENCH_PRIMITIVES(S)                                                         \
+    BENCH_PRIMITIVE(AssignBit, S, x, n, n & 1U);                                    \
+    BENCH_PRIMITIVE(AssignMask, S, x, T(~x), n & 1U);                               \
+    BENCH_PRIMITIVE(SetBitRange, S, n >> 1U, n);                                    \
+    BENCH_PRIMITIVE(CountSetBits, S, x);                                            \
+    BENCH_PRIMITIVE(CountLeadingZeros, S, x);                                       \
+    BENCH_PRIMITIVE(CountTrailingZeros, S, x);                                      \
+    BENCH_PRIMITIVE(FirstSetBitMask, S, x);                                         \
+    BENCH_PRIMITIVE(FirstSetBitIndex, S, x);                                        \
+    BENCH_PRIMITIVE(FirstClearBitMask, S, x);                                       \
+    BENCH_PRIMITIVE(FirstClearBitIndex, S, x);                                      \
+    BENCH_PRIMITIVE(LastSetBitMask, S, x);                                          \
+    BENCH_PRIMITIVE(LastSetBitIndex, S, x);                                         \
+    BENCH_PRIMITIVE(LastClearBitMask, S, x);                                        \
+    BENCH_PRIMITIVE(LastClearBitIndex, S, x);                                       \
+    BENCH_PRIMITIVE(ClearFirstSetBit, S, x);                                        \
+    BENCH_PRIMITIVE(ReverseBytes, S, x);                                            \
+    BENCH_PRIMITIVE(ReverseBits, S, x);                                             \
+    BENCH_PRIMITIVE(IsPowerOf2AndNotZero, S, x);                                    \
+    BENCH_PRIMITIVE(IsPowerOf2OrZero, S, x);                                        \
+    BENCH_PRIMITIVE(RoundUpToPowerOf2, S, x);                                       \
+    BENCH_PRIMITIVE(RoundDownToPowerOf2, S, x);                                     \
+    BENCH_PRIMITIVE(LogBase2, S, x);                                                \
+    BENCH_PRIMITIVE(NthSetBitIndex, S, x, n);                                       \
+    BENCH_PRIMITIVE(FirstNSetBitsIndex, S, x, n);                                   \
+    BENCH_PRIMITIVE(LastNSetBitsIndex, S, x, n);                                    \
+    BENCH_PRIMITIVE(FirstNClearBitsIndex, S, x, n);                                 \
+    BENCH_PRIMITIVE(LastNClearBitsIndex, S, x, n);                                  \
+    BenchPrimitive("FirstNSetBitsIndex_" #S "/validBits", density, in, [](T x, uint32_t n) { return FirstNSetBitsIndex_##S(x, n, T(0x5555555555555555ULL)); });      \
+    BenchPrimitive("LastNSetBitsIndex_" #S "/validBits", density, in, [](T x, uint32_t n) { return LastNSetBitsIndex_##S(x, n, T(0x5555555555555555ULL)); });        \
+    BenchPrimitive("FirstNClearBitsIndex_" #S "/validBits", density, in, [](T x, uint32_t n) { return FirstNClearBitsIndex_##S(x, n, T(0x5555555555555555ULL)); });  \
+    BenchPrimitive("LastNClearBitsIndex_" #S "/validBits", density, in, [](T x, uint32_t n) { return LastNClearBitsIndex_##S(x, n, T(0x5555555555555555ULL)); })
+
+template <class T>
+static void MakePrimitiveInputs(PrimitiveInputs<T>& in, uint32_t density, uint64_t& state)
+{
+    uint64_t blocks[kNumInputs];
+    FillBenchBlocks(blocks, kNumInputs, density, state);
+    for (uint64_t i = 0; i < kNumInputs; ++i)
+    {
+        in.x[i] = T(blocks[i]);
+        in.n[i] = uint32_t(1 + BenchSplitMix64(state) % (sizeof(T) * 8 - 1));
+    }
+}
+
+static void BenchPrimitivesU8(uint32_t density, uint64_t& state)
+{
+    using T = uint8_t;
+    PrimitiveInputs<T> in;
+    MakePrimitiveInputs(in, density, state);
+    BENCH_PRIMITIVES(U8);
+}
+
+static void BenchPrimitivesU16(uint32_t density, uint64_t& state)
+{
+    using T = uint16_t;
+    PrimitiveInputs<T> in;
+    MakePrimitiveInputs(in, density, state);
+    BENCH_PRIMITIVES(U16);
+}
+
+static void BenchPrimitivesU32(uint32_t density, uint64_t& state)
+{
+    using T = uint32_t;
+    PrimitiveInputs<T> in;
+    MakePrimitiveInputs(in, density, state);
+    BENCH_PRIMITIVES(U32);
+}
+
+static void BenchPrimitivesU64(uint32_t density, uint64_t& state)
+{
+    using T = uint64_t;
+    PrimitiveInputs<T> in;
+    MakePrimitiveInputs(in, density, state);
+    BENCH_PRIMITIVES(U64);
+}
+
+// Whole-buffer operations, whose time depends only on size.
+static void BenchBuffers(uint64_t& state)
+{
+    for (const uint64_t numBits : { 1ULL << 16ULL, 1ULL << 20ULL, 1ULL << 24ULL })
+    {
+        const uint64_t numBlocks = numBits >> 6ULL;
+        const uint64_t nBytes = numBits >> 3ULL;
+        std::vector<uint64_t> src(numBlocks);
+        std::vector<uint64_t> dst(numBlocks);
+        FillBenchBlocks(src.data(), numBlocks, 50, state);
+        const uint8_t* s = reinterpret_cast<const uint8_t*>(src.data());
+        uint8_t* d = reinterpret_cast<uint8_t*>(dst.data());
+        char name[96];
+
+        snprintf(name, sizeof(name), "ReverseBitsInBytes_Buffer/%llu", static_cast<unsigned long long>(numBits));
+        if (BenchSelected("bitops", name))
+            PrintBenchResult("bitops", name, BenchMeasure([&](uint64_t numIterations) { for (uint64_t k = 0; k < numIterations; ++k) { ReverseBitsInBytes_Buffer(d, s, nBytes); ClobberMemory(); } }), nBytes);
+
+        snprintf(name, sizeof(name), "ReverseBits_Buffer/%llu", static_cast<unsigned long long>(numBits));
+        if (BenchSelected("bitops", name))
+            PrintBenchResult("bitops", name, BenchMeasure([&](uint64_t numIterations) { for (uint64_t k = 0; k < numIterations; ++k) { ReverseBits_Buffer(d, s, nBytes); ClobberMemory(); } }), nBytes);
+
+        snprintf(name, sizeof(name), "Crc32c_Buffer/%llu", static_cast<unsigned long long>(numBits));
+        if (BenchSelected("bitops", name))
+            PrintBenchResult("bitops", name, BenchMeasure([&](uint64_t numIterations) { for (uint64_t k = 0; k < numIterations; ++k) { DoNotOptimize(Crc32c_Buffer(s, nBytes)); } }), nBytes);
+    }
+}
+
+void BenchBitOps()
+{
+    uint64_t state = 0xB170B5ULL;
+    for (const uint32_t density : kBenchDensities)
+    {
+        BenchPrimitivesU8(density, state);
+        BenchPrimitivesU16(density, state);
+        BenchPrimitivesU32(density, state);
+        BenchPrimitivesU64(density, state);
+    }
+    BenchBuffers(state);
+}
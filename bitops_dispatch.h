@@ -0,0 +1,251 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#pragma once
+
+// Runtime selection of the bulk kernels in bitops.h.
+//
+// The scalar primitives in bitops.h compile straight to single instructions (popcnt, lzcnt, tzcnt, pshufb)
+// and are chosen by the translation unit's target, since a call through a pointer would cost more than the
+// operation itself. The bulk kernels over spans are different: each has SSE4.2, AVX2, and AVX-512 variants
+// compiled side by side, and this header probes CPUID once and binds the best one the host supports. A
+// binary built for a baseline target can then call GetBitOpsDispatch().countSetBits(...) and friends and
+// use AVX2 or AVX-512 wherever they exist.
+//
+// The lowest tier still requires SSE4.2, POPCNT, and SSSE3.
+//
+// Set the environment variable BITOPS_MAX_ISA to sse42 or avx2 to cap the selected tier.
+
+#include <cstdlib>
+#include <cstring>
+
+#include "bitops.h"
+
+#if defined(_MSC_VER) && !defined(__clang__) && !defined(__GNUC__)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+enum class BitOpsIsa : uint32_t
+{
+	SSE42,
+	AVX2,
+	AVX512,
+};
+
+[[nodiscard]] static inline const char* BitOpsIsaName(BitOpsIsa isa)
+{
+	switch (isa)
+	{
+	case BitOpsIsa::SSE42:
+		return "SSE4.2";
+	case BitOpsIsa::AVX2:
+		return "AVX2";
+	case BitOpsIsa::AVX512:
+		return "AVX-512";
+	}
+	return "unknown";
+}
+
+struct BitOpsCpuFeatures
+{
+	bool sse42;
+	bool ssse3;
+	bool popcnt;
+	bool avx2;
+	bool avx512f;
+	bool avx512bw;
+	bool avx512vpopcntdq;
+	bool gfni;
+};
+
+// Query CPUID, and XCR0 for OS support of the wide register state.
+[[nodiscard]] static inline BitOpsCpuFeatures ProbeBitOpsCpuFeatures()
+{
+	uint32_t r1[4] = {};
+	uint32_t r7[4] = {};
+	uint64_t xcr0 = 0;
+
+#if defined(_MSC_VER) && !defined(__clang__) && !defined(__GNUC__)
+	int regs[4];
+	__cpuid(regs, 0);
+	const uint32_t maxLeaf = uint32_t(regs[0]);
+	__cpuidex(regs, 1, 0);
+	memcpy(r1, regs, sizeof(r1));
+	if (maxLeaf >= 7)
+	{
+		__cpuidex(regs, 7, 0);
+		memcpy(r7, regs, sizeof(r7));
+	}
+	const bool osxsave = (r1[2] >> 27) & 1U;
+	if (osxsave)
+		xcr0 = _xgetbv(0);
+#else
+	const uint32_t maxLeaf = __get_cpuid_max(0, nullptr);
+	__cpuid_count(1, 0, r1[0], r1[1], r1[2], r1[3]);
+	if (maxLeaf >= 7)
+		__cpuid_count(7, 0, r7[0], r7[1], r7[2], r7[3]);
+	const bool osxsave = (r1[2] >> 27) & 1U;
+	if (osxsave)
+	{
+		uint32_t lo, hi;
+		__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+		xcr0 = (uint64_t(hi) << 32ULL) | lo;
+	}
+#endif
+
+	// XMM and YMM state; then opmask and both halves of the ZMM state.
+	const bool osAvx = (xcr0 & 0x6ULL) == 0x6ULL;
+	const bool osAvx512 = osAvx && (xcr0 & 0xE0ULL) == 0xE0ULL;
+
+	BitOpsCpuFeatures f;
+	f.ssse3 = (r1[2] >> 9) & 1U;
+	f.sse42 = (r1[2] >> 20) & 1U;
+	f.popcnt = (r1[2] >> 23) & 1U;
+	f.avx2 = osAvx && ((r7[1] >> 5) & 1U);
+	f.avx512f = osAvx512 && ((r7[1] >> 16) & 1U);
+	f.avx512bw = osAvx512 && ((r7[1] >> 30) & 1U);
+	f.avx512vpopcntdq = osAvx512 && ((r7[2] >> 14) & 1U);
+	f.gfni = (r7[2] >> 8) & 1U;
+	return f;
+}
+
+// Return the widest tier the host fully supports. SSE4.2, POPCNT, and SSSE3 are a hard minimum rather than a
+// tier: they are not checked here, and on a host without them the SSE4.2 kernels fault on an illegal instruction.
+[[nodiscard]] static inline BitOpsIsa BestBitOpsIsa(const BitOpsCpuFeatures& f)
+{
+	if (f.avx2 && f.avx512f && f.avx512bw)
+		return BitOpsIsa::AVX512;
+	if (f.avx2)
+		return BitOpsIsa::AVX2;
+	return BitOpsIsa::SSE42;
+}
+
+struct BitOpsDispatch
+{
+	// Tier used for the kernels below. countSetBits can sit one tier lower, since
+	// its AVX-512 variant additionally needs VPOPCNTDQ.
+	BitOpsIsa isa;
+	BitOpsIsa countSetBitsIsa;
+
+	uint64_t (*countSetBits)(const uint64_t* p, uint64_t n);
+	void (*reverseBitsInBytes)(uint8_t* dst, const uint8_t* src, uint64_t nBytes);
+	void (*reverseBits)(uint8_t* dst, const uint8_t* src, uint64_t nBytes);
+	void (*andBlocks)(uint64_t* dst, const uint64_t* a, const uint64_t* b, uint64_t n);
+	void (*orBlocks)(uint64_t* dst, const uint64_t* a, const uint64_t* b, uint64_t n);
+	void (*xorBlocks)(uint64_t* dst, const uint64_t* a, const uint64_t* b, uint64_t n);
+	void (*andNotBlocks)(uint64_t* dst, const uint64_t* a, const uint64_t* b, uint64_t n);
+	void (*blendBlocks)(uint64_t* dst, const uint64_t* a, const uint64_t* b, const uint64_t* mask, uint64_t n);
+	uint64_t (*decodeSetBits)(uint32_t* out, const uint64_t* p, uint64_t n, uint32_t base);
+	uint64_t (*firstBlockNotEqualTo)(const uint64_t* p, uint64_t n, uint64_t x);
+	uint64_t (*firstUnequalBlock)(const uint64_t* p, const uint64_t* q, uint64_t n);
+	uint64_t (*lastBlockNotEqualTo)(const uint64_t* p, uint64_t n, uint64_t x);
+	void (*testBits)(uint8_t* out, const uint64_t* p, const uint64_t* idx, uint64_t n);
+};
+
+// Bind the best kernels for the given features, using no tier above maxIsa.
+[[nodiscard]] static inline BitOpsDispatch MakeBitOpsDispatch(const BitOpsCpuFeatures& f, BitOpsIsa maxIsa)
+{
+	const BitOpsIsa best = BestBitOpsIsa(f);
+	const BitOpsIsa isa = best < maxIsa ? best : maxIsa;
+
+	BitOpsDispatch d;
+	d.isa = isa;
+	if (isa == BitOpsIsa::AVX512)
+	{
+		d.reverseBitsInBytes = f.gfni ? ReverseBitsInBytes_Buffer_AVX512_GFNI : ReverseBitsInBytes_Buffer_AVX512;
+		d.reverseBits = f.gfni ? ReverseBits_Buffer_AVX512_GFNI : ReverseBits_Buffer_AVX512;
+		d.andBlocks = BinaryOp_Blocks_AVX512<BitOpAnd>;
+		d.orBlocks = BinaryOp_Blocks_AVX512<BitOpOr>;
+		d.xorBlocks = BinaryOp_Blocks_AVX512<BitOpXor>;
+		d.andNotBlocks = BinaryOp_Blocks_AVX512<BitOpAndNot>;
+		d.blendBlocks = TernaryOp_Blocks_AVX512<BitOpBlend>;
+		d.decodeSetBits = DecodeSetBits_Blocks_AVX512;
+		d.firstBlockNotEqualTo = FirstBlockNotEqualTo_Blocks_AVX512;
+		d.firstUnequalBlock = FirstUnequalBlock_Blocks_AVX512;
+		d.lastBlockNotEqualTo = LastBlockNotEqualTo_Blocks_AVX512;
+		d.testBits = TestBits_Blocks_AVX512;
+	}
+	else if (isa == BitOpsIsa::AVX2)
+	{
+		d.reverseBitsInBytes = f.gfni ? ReverseBitsInBytes_Buffer_AVX2_GFNI : ReverseBitsInBytes_Buffer_AVX2;
+		d.reverseBits = f.gfni ? ReverseBits_Buffer_AVX2_GFNI : ReverseBits_Buffer_AVX2;
+		d.andBlocks = BinaryOp_Blocks_AVX2<BitOpAnd>;
+		d.orBlocks = BinaryOp_Blocks_AVX2<BitOpOr>;
+		d.xorBlocks = BinaryOp_Blocks_AVX2<BitOpXor>;
+		d.andNotBlocks = BinaryOp_Blocks_AVX2<BitOpAndNot>;
+		d.blendBlocks = TernaryOp_Blocks_AVX2<BitOpBlend>;
+		d.decodeSetBits = DecodeSetBits_Blocks_AVX2;
+		d.firstBlockNotEqualTo = FirstBlockNotEqualTo_Blocks_AVX2;
+		d.firstUnequalBlock = FirstUnequalBlock_Blocks_AVX2;
+		d.lastBlockNotEqualTo = LastBlockNotEqualTo_Blocks_AVX2;
+		d.testBits = TestBits_Blocks_AVX2;
+	}
+	else
+	{
+		// The hard minimum; see BestBitOpsIsa().
+		d.reverseBitsInBytes = ReverseBitsInBytes_Buffer_SSSE3;
+		d.reverseBits = ReverseBits_Buffer_SSSE3;
+		d.andBlocks = BinaryOp_Blocks_SSE42<BitOpAnd>;
+		d.orBlocks = BinaryOp_Blocks_SSE42<BitOpOr>;
+		d.xorBlocks = BinaryOp_Blocks_SSE42<BitOpXor>;
+		d.andNotBlocks = BinaryOp_Blocks_SSE42<BitOpAndNot>;
+		d.blendBlocks = TernaryOp_Blocks_SSE42<BitOpBlend>;
+		d.decodeSetBits = DecodeSetBits_Blocks_SSE42;
+		d.firstBlockNotEqualTo = FirstBlockNotEqualTo_Blocks_SSE42;
+		d.firstUnequalBlock = FirstUnequalBlock_Blocks_SSE42;
+		d.lastBlockNotEqualTo = LastBlockNotEqualTo_Blocks_SSE42;
+		d.testBits = TestBits_Blocks_SSE42;
+	}
+
+	if (isa == BitOpsIsa::AVX512 && f.avx512vpopcntdq)
+	{
+		d.countSetBitsIsa = BitOpsIsa::AVX512;
+		d.countSetBits = CountSetBits_Blocks_AVX512;
+	}
+	else if (isa >= BitOpsIsa::AVX2)
+	{
+		d.countSetBitsIsa = BitOpsIsa::AVX2;
+		d.countSetBits = CountSetBits_Blocks_AVX2;
+	}
+	else
+	{
+		d.countSetBitsIsa = BitOpsIsa::SSE42;
+		d.countSetBits = CountSetBits_Blocks_SSE42;
+	}
+
+	return d;
+}
+
+// Return the tier cap from BITOPS_MAX_ISA, or AVX-512 if unset or unrecognized.
+[[nodiscard]] static inline BitOpsIsa BitOpsMaxIsaFromEnvironment()
+{
+#if defined(_MSC_VER) && !defined(__clang__) && !defined(__GNUC__)
+#pragma warning (push)
+#pragma warning (disable:4996)
+#endif
+	const char* s = getenv("BITOPS_MAX_ISA");
+#if defined(_MSC_VER) && !defined(__clang__) && !defined(__GNUC__)
+#pragma warning (pop)
+#endif
+	if (s && !strcmp(s, "sse42"))
+		return BitOpsIsa::SSE42;
+	if (s && !strcmp(s, "avx2"))
+		return BitOpsIsa::AVX2;
+	return BitOpsIsa::AVX512;
+}
+
+// Return the process-wide kernel table. The host is probed once, on first use.
+// Deliberately not static: one table per program, not one per translation unit.
+[[nodiscard]] inline const BitOpsDispatch& GetBitOpsDispatch()
+{
+	static const BitOpsDispatch d = MakeBitOpsDispatch(ProbeBitOpsCpuFeatures(), BitOpsMaxIsaFromEnvironment());
+	return d;
+}
@@ -0,0 +1,239 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#include <iostream>
+
+#include "bitops_dispatch.h"
+#include "testutil.h"
+
+#define ASSERT_TRUE(a) do { if (!(a)) { std::cerr << "FAIL: expected true for " << #a << ", got false\n"; __debugbreak(); } } while (0)
+#define ASSERT_FALSE(a) do { if ((a)) { std::cerr << "FAIL: expected false for " << #a << ", got true\n"; __debugbreak(); } } while (0)
+
+template <class T>
+static void TestPrintHelper(T x)
+{
+    std::cout << x;
+}
+
+#define ASSERT_BIN_OP(a, b, op) do {                                                            \
+    const auto& va = (a);                                                                       \
+    const auto& vb = (b);                                                                       \
+    if (!(va op vb))                                                                            \
+    {                                                                                           \
+        std::cerr << "FAIL: expected " << #a << " " << #op << " " << #b << " (evaluates to ";   \
+        TestPrintHelper(va);                                                                    \
+        std::cerr << " " << #op << " ";                                                         \
+        TestPrintHelper(vb);                                                                    \
+        std::cerr << ")\n";                                                                     \
+        __debugbreak();                                                                         \
+    }                                                                                           \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_BIN_OP(a, b, ==)
+#define ASSERT_NE(a, b) ASSERT_BIN_OP(a, b, !=)
+
+// This file builds for a baseline x86-64 target, so it must not use popcnt directly.
+static uint64_t RefCountSetBits(uint64_t x)
+{
+    uint64_t count = 0;
+    for (; x; x &= x - 1)
+        ++count;
+    return count;
+}
+
+static void TestDispatchTable(const BitOpsDispatch& d)
+{
+    constexpr uint64_t kMaxBlocks = 200;
+    uint64_t a[kMaxBlocks + 1];
+    uint64_t b[kMaxBlocks + 1];
+    uint64_t r[kMaxBlocks + 2];
+    uint64_t state = uint64_t(d.isa);
+    for (uint64_t i = 0; i <= kMaxBlocks; ++i)
+    {
+        a[i] = SplitMix64(state);
+        b[i] = SplitMix64(state);
+    }
+
+    for (uint64_t offset = 0; offset < 2; ++offset)
+    {
+        uint64_t ref = 0;
+        for (uint64_t n = 0; n <= kMaxBlocks - offset; ++n)
+        {
+            if (n)
+                ref += RefCountSetBits(a[offset + n - 1]);
+            ASSERT_EQ(d.countSetBits(a + offset, n), ref);
+        }
+    }
+
+    for (uint64_t n = 0; n <= kMaxBlocks; n += (n < 20 ? 1 : 7))
+    {
+        const uint64_t kGuard = 0x0123456789ABCDEFULL;
+
+        r[n] = kGuard;
+        d.andBlocks(r, a, b, n);
+        for (uint64_t i = 0; i < n; ++i)
+            ASSERT_EQ(r[i], a[i] & b[i]);
+        ASSERT_EQ(r[n], kGuard);
+
+        d.orBlocks(r, a, b, n);
+        for (uint64_t i = 0; i < n; ++i)
+            ASSERT_EQ(r[i], a[i] | b[i]);
+        ASSERT_EQ(r[n], kGuard);
+
+        d.xorBlocks(r, a, b, n);
+        for (uint64_t i = 0; i < n; ++i)
+            ASSERT_EQ(r[i], a[i] ^ b[i]);
+        ASSERT_EQ(r[n], kGuard);
+
+        d.andNotBlocks(r, a, b, n);
+        for (uint64_t i = 0; i < n; ++i)
+            ASSERT_EQ(r[i], a[i] & ~b[i]);
+        ASSERT_EQ(r[n], kGuard);
+
+        d.blendBlocks(r, a, b, a + 1, n);
+        for (uint64_t i = 0; i < n; ++i)
+            ASSERT_EQ(r[i], (a[i] & ~a[i + 1]) | (b[i] & a[i + 1]));
+        ASSERT_EQ(r[n], kGuard);
+
+        // in place
+        for (uint64_t i = 0; i < n; ++i)
+            r[i] = a[i];
+        d.xorBlocks(r, r, b, n);
+        for (uint64_t i = 0; i < n; ++i)
+            ASSERT_EQ(r[i], a[i] ^ b[i]);
+    }
+
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(a);
+    uint8_t* dst = reinterpret_cast<uint8_t*>(r);
+    for (uint64_t nBytes = 0; nBytes <= 300; ++nBytes)
+    {
+        dst[nBytes] = 0x5A;
+        d.reverseBitsInBytes(dst, src + 1, nBytes);
+        for (uint64_t i = 0; i < nBytes; ++i)
+            ASSERT_EQ(int(dst[i]), int(ReverseBits_U8(src[i + 1])));
+        ASSERT_EQ(int(dst[nBytes]), 0x5A);
+        d.reverseBitsInBytes(dst, dst, nBytes);
+        for (uint64_t i = 0; i < nBytes; ++i)
+            ASSERT_EQ(int(dst[i]), int(src[i + 1]));
+    }
+
+    for (uint64_t nBytes = 0; nBytes <= 300; ++nBytes)
+    {
+        dst[nBytes] = 0x5A;
+        d.reverseBits(dst, src + 1, nBytes);
+        for (uint64_t i = 0; i < nBytes; ++i)
+            ASSERT_EQ(int(dst[i]), int(ReverseBits_U8(src[nBytes - i])));
+        ASSERT_EQ(int(dst[nBytes]), 0x5A);
+        d.reverseBits(dst, dst, nBytes);
+        for (uint64_t i = 0; i < nBytes; ++i)
+            ASSERT_EQ(int(dst[i]), int(src[i + 1]));
+    }
+
+    static uint32_t indices[kMaxBlocks * 64 + 1];
+    for (const bool sparse : { false, true })
+    {
+        uint64_t p[kMaxBlocks];
+        for (uint64_t i = 0; i < kMaxBlocks; ++i)
+            p[i] = sparse ? a[i] & b[i] & SplitMix64(state) : a[i];
+
+        for (uint64_t n = 0; n <= kMaxBlocks; n += (n < 20 ? 1 : 7))
+        {
+            const uint32_t kGuard = 0xDEADBEEFU;
+            uint64_t total = 0;
+            for (uint64_t i = 0; i < n; ++i)
+                total += RefCountSetBits(p[i]);
+
+            indices[total] = kGuard;
+            ASSERT_EQ(d.decodeSetBits(indices, p, n, 100U), total);
+            uint64_t k = 0;
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                for (uint64_t j = 0; j < 64; ++j)
+                {
+                    if ((p[i] >> j) & 1ULL)
+                        ASSERT_EQ(indices[k++], uint32_t(100 + 64 * i + j));
+                }
+            }
+            ASSERT_EQ(indices[total], kGuard);
+        }
+    }
+
+    for (uint64_t i = 0; i < kMaxBlocks; ++i)
+        r[i] = a[i];
+    for (uint64_t n = 0; n <= kMaxBlocks; n += (n < 40 ? 1 : 7))
+    {
+        ASSERT_EQ(d.firstUnequalBlock(a, r, n), n);
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            r[i] ^= 1ULL << (i & 63ULL);
+            ASSERT_EQ(d.firstUnequalBlock(a, r, n), i);
+            r[i] = a[i];
+        }
+    }
+
+    for (uint64_t i = 0; i < kMaxBlocks; ++i)
+        r[i] = ~0ULL;
+    for (uint64_t n = 0; n <= kMaxBlocks; n += (n < 40 ? 1 : 7))
+    {
+        ASSERT_EQ(d.firstBlockNotEqualTo(r, n, ~0ULL), n);
+        ASSERT_EQ(d.firstBlockNotEqualTo(r, n, 0), n ? 0 : n);
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            r[i] = ~(1ULL << (i & 63ULL));
+            ASSERT_EQ(d.firstBlockNotEqualTo(r, n, ~0ULL), i);
+            ASSERT_EQ(d.lastBlockNotEqualTo(r, n, ~0ULL), i);
+            r[i] = ~0ULL;
+        }
+        ASSERT_EQ(d.lastBlockNotEqualTo(r, n, ~0ULL), ~0ULL);
+        ASSERT_EQ(d.lastBlockNotEqualTo(r, n, 0), n - 1);
+    }
+
+    uint64_t idx[kMaxBlocks];
+    uint8_t out[kMaxBlocks];
+    for (uint64_t i = 0; i < kMaxBlocks; ++i)
+        idx[i] = (SplitMix64(state) % kMaxBlocks) * 64 + (i & 63ULL);
+    for (uint64_t n = 0; n <= kMaxBlocks; n += (n < 40 ? 1 : 7))
+    {
+        d.testBits(out, a, idx, n);
+        for (uint64_t i = 0; i < n; ++i)
+            ASSERT_EQ(out[i], uint8_t((a[idx[i] >> 6ULL] >> (idx[i] & 63ULL)) & 1ULL));
+    }
+}
+
+void TestBitOpsDispatch()
+{
+    const BitOpsCpuFeatures f = ProbeBitOpsCpuFeatures();
+    ASSERT_TRUE(f.sse42 && f.ssse3 && f.popcnt);
+    ASSERT_TRUE(!f.avx512f || f.avx2);
+
+    // every tier the host can run
+    for (const BitOpsIsa maxIsa : { BitOpsIsa::SSE42, BitOpsIsa::AVX2, BitOpsIsa::AVX512 })
+    {
+        const BitOpsDispatch d = MakeBitOpsDispatch(f, maxIsa);
+        ASSERT_TRUE(d.isa <= maxIsa);
+        ASSERT_TRUE(d.isa <= BestBitOpsIsa(f));
+        ASSERT_TRUE(d.countSetBitsIsa <= d.isa);
+        ASSERT_NE(BitOpsIsaName(d.isa)[0], 'u');
+        TestDispatchTable(d);
+
+        // and the same tier without GFNI
+        if (f.gfni)
+        {
+            BitOpsCpuFeatures g = f;
+            g.gfni = false;
+            TestDispatchTable(MakeBitOpsDispatch(g, maxIsa));
+        }
+    }
+
+    // the process-wide table is probed once
+    const BitOpsDispatch& d = GetBitOpsDispatch();
+    ASSERT_TRUE(&d == &GetBitOpsDispatch());
+    ASSERT_TRUE(d.isa <= BestBitOpsIsa(f));
+    TestDispatchTable(d);
+}
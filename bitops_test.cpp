@@ -8,8 +8,10 @@
 *******************************************************************/
 
 #include <iostream>
+#include <vector>
 
 #include "bitops.h"
+#include "testutil.h"
 
 #define ASSERT_TRUE(a) do { if (!(a)) { std::cerr << "FAIL: expected true for " << #a << ", got false\n"; __debugbreak(); } } while (0)
 #define ASSERT_FALSE(a) do { if ((a)) { std::cerr << "FAIL: expected false for " << #a << ", got true\n"; __debugbreak(); } } while (0)
@@ -427,6 +429,26 @@ static auto Overload_LastNClearBitsIndex(uint64_t x, uint32_t n, uint64_t validB
     return LastNClearBitsIndex_U64(x, n, validBits);
 }
 
+static auto Overload_NthSetBitIndex(uint8_t x, uint32_t n)
+{
+    return NthSetBitIndex_U8(x, n);
+}
+
+static auto Overload_NthSetBitIndex(uint16_t x, uint32_t n)
+{
+    return NthSetBitIndex_U16(x, n);
+}
+
+static auto Overload_NthSetBitIndex(uint32_t x, uint32_t n)
+{
+    return NthSetBitIndex_U32(x, n);
+}
+
+static auto Overload_NthSetBitIndex(uint64_t x, uint32_t n)
+{
+    return NthSetBitIndex_U64(x, n);
+}
+
 template <class T>
 static T Overload_SetBitRange(uint32_t a, uint32_t b);
 
@@ -454,6 +476,21 @@ uint64_t Overload_SetBitRange(uint32_t a, uint32_t b)
     return SetBitRange_U64(a, b);
 }
 
+template <class T>
+static uint32_t RefNthSetBitIndex(T x, uint32_t n)
+{
+    for (uint32_t i = 0; i < sizeof(T) * 8; ++i)
+    {
+        if ((x >> i) & 1U)
+        {
+            if (n == 0)
+                return i;
+            --n;
+        }
+    }
+    return uint32_t(sizeof(T) * 8);
+}
+
 template <class T>
 static T RefReverseBits(T x)
 {
@@ -600,6 +637,80 @@ static void NBitsTestHelper()
     }
 }
 
+constexpr uint64_t kMaxOpBlocks = 70;
+
+// Every variant of BinaryOp_Blocks<Op> the target supports, out of place and in place, against Op::U64, at
+// each alignment of dst; nothing outside dst[0, n) is written.
+template <class Op>
+static void TestBinaryOpBlocks(const uint64_t* a, const uint64_t* b)
+{
+    using Kernel = void (*)(uint64_t*, const uint64_t*, const uint64_t*, uint64_t);
+    const Kernel kernels[] = {
+        BinaryOp_Blocks_SSE42<Op>, BinaryOp_Blocks_SSE42<Op, true>,
+#if defined(__AVX2__)
+        BinaryOp_Blocks_AVX2<Op>, BinaryOp_Blocks_AVX2<Op, true>,
+#endif
+#if defined(__AVX512F__)
+        BinaryOp_Blocks_AVX512<Op>, BinaryOp_Blocks_AVX512<Op, true>,
+#endif
+        BinaryOp_Blocks<Op>,
+    };
+
+    constexpr uint64_t kGuard = 0x0123456789ABCDEFULL;
+    alignas(64) uint64_t r[kMaxOpBlocks + 16];
+    for (const Kernel kernel : kernels)
+    {
+        for (uint64_t offset = 0; offset < 8; ++offset)
+        {
+            for (uint64_t n = 0; n <= kMaxOpBlocks; ++n)
+            {
+                for (const bool inPlace : { false, true })
+                {
+                    for (uint64_t i = 0; i < kMaxOpBlocks + 16; ++i)
+                        r[i] = inPlace && i >= offset && i < offset + n ? a[i - offset] : kGuard;
+                    kernel(r + offset, inPlace ? r + offset : a, b, n);
+                    for (uint64_t i = 0; i < kMaxOpBlocks + 16; ++i)
+                        ASSERT_EQ(r[i], i >= offset && i < offset + n ? Op::U64(a[i - offset], b[i - offset]) : kGuard);
+                }
+            }
+        }
+    }
+}
+
+// As above, for TernaryOp_Blocks<Op>.
+template <class Op>
+static void TestTernaryOpBlocks(const uint64_t* a, const uint64_t* b, const uint64_t* c)
+{
+    using Kernel = void (*)(uint64_t*, const uint64_t*, const uint64_t*, const uint64_t*, uint64_t);
+    const Kernel kernels[] = {
+        TernaryOp_Blocks_SSE42<Op>, TernaryOp_Blocks_SSE42<Op, true>,
+#if defined(__AVX2__)
+        TernaryOp_Blocks_AVX2<Op>, TernaryOp_Blocks_AVX2<Op, true>,
+#endif
+#if defined(__AVX512F__)
+        TernaryOp_Blocks_AVX512<Op>, TernaryOp_Blocks_AVX512<Op, true>,
+#endif
+        TernaryOp_Blocks<Op>,
+    };
+
+    constexpr uint64_t kGuard = 0x0123456789ABCDEFULL;
+    alignas(64) uint64_t r[kMaxOpBlocks + 16];
+    for (const Kernel kernel : kernels)
+    {
+        for (uint64_t offset = 0; offset < 8; ++offset)
+        {
+            for (uint64_t n = 0; n <= kMaxOpBlocks; ++n)
+            {
+                for (uint64_t i = 0; i < kMaxOpBlocks + 16; ++i)
+                    r[i] = kGuard;
+                kernel(r + offset, a, b, c, n);
+                for (uint64_t i = 0; i < kMaxOpBlocks + 16; ++i)
+                    ASSERT_EQ(r[i], i >= offset && i < offset + n ? Op::U64(a[i - offset], b[i - offset], c[i - offset]) : kGuard);
+            }
+        }
+    }
+}
+
 void TestBitOps()
 {
     // assign bit
@@ -853,6 +964,461 @@ void TestBitOps()
         ASSERT_EQ(f(T(0b1111111111111111111111111111111111111111111111111111111111101111)), 63U);
     }
 
+    // count set bits in blocks
+    {
+        constexpr uint64_t kMaxBlocks = 300;
+        uint64_t p[kMaxBlocks + 3];
+        uint64_t state = 0;
+        for (const uint64_t fill : { 0ULL, 1ULL, 2ULL, ~0ULL })
+        {
+            for (uint64_t i = 0; i < kMaxBlocks + 3; ++i)
+            {
+                const uint64_t r = SplitMix64(state);
+                p[i] = fill == 1 ? r : fill == 2 ? r & SplitMix64(state) & SplitMix64(state) : fill;
+            }
+
+            for (uint64_t offset = 0; offset < 3; ++offset)
+            {
+                uint64_t ref = 0;
+                ASSERT_EQ(CountSetBits_Blocks(p + offset, 0), 0U);
+                for (uint64_t n = 1; n <= kMaxBlocks; ++n)
+                {
+                    ref += CountSetBits_U64(p[offset + n - 1]);
+                    ASSERT_EQ(CountSetBits_Blocks(p + offset, n), ref);
+                }
+            }
+        }
+    }
+
+    // decode set bits in blocks
+    {
+        constexpr uint64_t kMaxBlocks = 100;
+        static uint32_t out[kMaxBlocks * 64 + 1];
+        uint64_t p[kMaxBlocks];
+        uint64_t state = 1;
+        for (const uint64_t fill : { 0ULL, 1ULL, 2ULL, ~0ULL })
+        {
+            for (uint64_t i = 0; i < kMaxBlocks; ++i)
+            {
+                const uint64_t r = SplitMix64(state);
+                p[i] = fill == 1 ? r : fill == 2 ? r & SplitMix64(state) & SplitMix64(state) : fill;
+            }
+
+            for (uint64_t n = 0; n <= kMaxBlocks; ++n)
+            {
+                const uint64_t total = CountSetBits_Blocks(p, n);
+                for (const auto decode : { DecodeSetBits_Blocks_SSE42, DecodeSetBits_Blocks })
+                {
+                    out[total] = 0xDEADBEEFU;
+                    ASSERT_EQ(decode(out, p, n, 7U), total);
+                    uint64_t k = 0;
+                    for (uint64_t i = 0; i < n * 64; ++i)
+                    {
+                        if ((p[i >> 6] >> (i & 63)) & 1ULL)
+                            ASSERT_EQ(out[k++], uint32_t(i + 7));
+                    }
+                    ASSERT_EQ(out[total], 0xDEADBEEFU);
+                }
+            }
+        }
+    }
+
+    // first and last mismatching block
+    {
+        constexpr uint64_t kMaxBlocks = 100;
+        using NotEqualTo = uint64_t (*)(const uint64_t*, uint64_t, uint64_t);
+        using Unequal = uint64_t (*)(const uint64_t*, const uint64_t*, uint64_t);
+        const NotEqualTo notEqualTos[] = {
+            FirstBlockNotEqualTo_Blocks_SSE42,
+#if defined(__AVX2__)
+            FirstBlockNotEqualTo_Blocks_AVX2,
+#endif
+#if defined(__AVX512F__)
+            FirstBlockNotEqualTo_Blocks_AVX512,
+#endif
+            FirstBlockNotEqualTo_Blocks,
+        };
+        const Unequal unequals[] = {
+            FirstUnequalBlock_Blocks_SSE42,
+#if defined(__AVX2__)
+            FirstUnequalBlock_Blocks_AVX2,
+#endif
+#if defined(__AVX512F__)
+            FirstUnequalBlock_Blocks_AVX512,
+#endif
+            FirstUnequalBlock_Blocks,
+        };
+        const NotEqualTo lastNotEqualTos[] = {
+            LastBlockNotEqualTo_Blocks_SSE42,
+#if defined(__AVX2__)
+            LastBlockNotEqualTo_Blocks_AVX2,
+#endif
+#if defined(__AVX512F__)
+            LastBlockNotEqualTo_Blocks_AVX512,
+#endif
+            LastBlockNotEqualTo_Blocks,
+        };
+
+        uint64_t p[kMaxBlocks + 3];
+        uint64_t q[kMaxBlocks + 3];
+        uint64_t state = 3;
+        for (const uint64_t x : { 0ULL, ~0ULL, 0x0123456789ABCDEFULL })
+        {
+            for (uint64_t offset = 0; offset < 3; ++offset)
+            {
+                for (uint64_t n = 0; n <= kMaxBlocks; ++n)
+                {
+                    // no mismatch, then one at each position, in a single bit or in the whole block, with
+                    // later ones that must not be found first
+                    for (uint64_t i = 0; i <= n; ++i)
+                    {
+                        for (const bool oneBit : { false, true })
+                        {
+                            for (uint64_t k = 0; k < kMaxBlocks + 3; ++k)
+                            {
+                                const bool match = k >= offset && k - offset < i;
+                                p[k] = match ? x : SplitMix64(state);
+                                q[k] = match ? x : SplitMix64(state);
+                            }
+                            if (i < n)
+                            {
+                                const uint64_t diff = oneBit ? 1ULL << (SplitMix64(state) & 63ULL) : ~0ULL;
+                                p[offset + i] = x ^ diff;
+                                q[offset + i] = x;
+                            }
+
+                            for (const NotEqualTo f : notEqualTos)
+                                ASSERT_EQ(f(p + offset, n, x), i);
+                            for (const Unequal f : unequals)
+                                ASSERT_EQ(f(p + offset, q + offset, n), i);
+                        }
+                    }
+
+                    // and from the end: none, then one at each position, with earlier ones
+                    for (uint64_t i = 0; i <= n; ++i)
+                    {
+                        for (uint64_t k = 0; k < kMaxBlocks + 3; ++k)
+                            p[k] = k >= offset + n - i && k < offset + n ? x : SplitMix64(state);
+                        if (i < n)
+                            p[offset + n - i - 1] = x ^ (1ULL << (SplitMix64(state) & 63ULL));
+
+                        for (const NotEqualTo f : lastNotEqualTos)
+                            ASSERT_EQ(f(p + offset, n, x), i < n ? n - i - 1 : ~0ULL);
+                    }
+                }
+            }
+        }
+    }
+
+    // batched bit tests, sets, and clears
+    {
+        constexpr uint64_t kNumBlocks = 37;
+        constexpr uint64_t kMaxIndices = 100;
+        using Test = void (*)(uint8_t*, const uint64_t*, const uint64_t*, uint64_t);
+        const Test tests[] = {
+            TestBits_Blocks_SSE42,
+#if defined(__AVX2__)
+            TestBits_Blocks_AVX2,
+#endif
+#if defined(__AVX512F__)
+            TestBits_Blocks_AVX512,
+#endif
+            TestBits_Blocks,
+        };
+
+        uint64_t p[kNumBlocks];
+        uint64_t idx[kMaxIndices];
+        uint8_t out[kMaxIndices + 1];
+        uint64_t state = 4;
+        for (uint64_t n = 0; n <= kMaxIndices; ++n)
+        {
+            for (uint64_t k = 0; k < kNumBlocks; ++k)
+                p[k] = SplitMix64(state);
+
+            // repeats, and the first and last bits, included
+            for (uint64_t i = 0; i < n; ++i)
+                idx[i] = i % 5 == 4 ? idx[i - 2] : SplitMix64(state) % (kNumBlocks * 64);
+            if (n)
+            {
+                idx[0] = 0;
+                idx[n - 1] = kNumBlocks * 64 - 1;
+            }
+
+            for (const Test f : tests)
+            {
+                // and nothing past the end written
+                out[n] = 0xAA;
+                f(out, p, idx, n);
+                for (uint64_t i = 0; i < n; ++i)
+                    ASSERT_EQ(out[i], uint8_t((p[idx[i] >> 6ULL] >> (idx[i] & 63ULL)) & 1ULL));
+                ASSERT_EQ(out[n], uint8_t(0xAA));
+            }
+
+            uint64_t r[kNumBlocks];
+            memcpy(r, p, sizeof(p));
+            SetBits_Blocks(p, idx, n);
+            for (uint64_t i = 0; i < n; ++i)
+                r[idx[i] >> 6ULL] |= 1ULL << (idx[i] & 63ULL);
+            for (uint64_t k = 0; k < kNumBlocks; ++k)
+                ASSERT_EQ(p[k], r[k]);
+
+            ClearBits_Blocks(p, idx, n);
+            for (uint64_t i = 0; i < n; ++i)
+                r[idx[i] >> 6ULL] &= ~(1ULL << (idx[i] & 63ULL));
+            for (uint64_t k = 0; k < kNumBlocks; ++k)
+                ASSERT_EQ(p[k], r[k]);
+        }
+    }
+
+    // Bloom filter bucket bits
+    {
+        using Set = void (*)(uint64_t*, uint32_t);
+        using Test = bool (*)(const uint64_t*, uint32_t);
+        const Set sets[] = {
+            SetBloomBucketBits_SSE42,
+#if defined(__AVX2__)
+            SetBloomBucketBits_AVX2,
+#endif
+#if defined(__AVX512F__)
+            SetBloomBucketBits_AVX512,
+#endif
+            SetBloomBucketBits,
+        };
+        const Test tests[] = {
+            AreBloomBucketBitsSet_SSE42,
+#if defined(__AVX2__)
+            AreBloomBucketBitsSet_AVX2,
+#endif
+#if defined(__AVX512F__)
+            AreBloomBucketBitsSet_AVX512,
+#endif
+            AreBloomBucketBitsSet,
+        };
+
+        uint64_t state = 5;
+        for (uint64_t k = 0; k < 10000; ++k)
+        {
+            const uint32_t h = k < 2 ? uint32_t(0U - k) : uint32_t(SplitMix64(state));
+            uint64_t r[8];
+            for (uint64_t i = 0; i < 8; ++i)
+                r[i] = 1ULL << ((h * kBloomBucketSalts[i]) >> 26U);
+
+            for (const Set f : sets)
+            {
+                // over a random bucket, whose other bits are kept
+                uint64_t p[8];
+                uint64_t q[8];
+                for (uint64_t i = 0; i < 8; ++i)
+                    p[i] = q[i] = SplitMix64(state) & SplitMix64(state);
+                f(p, h);
+                for (uint64_t i = 0; i < 8; ++i)
+                    ASSERT_EQ(p[i], q[i] | r[i]);
+            }
+
+            for (const Test f : tests)
+            {
+                ASSERT_TRUE(f(r, h));
+                for (uint64_t i = 0; i < 8; ++i)
+                {
+                    uint64_t q[8];
+                    for (uint64_t j = 0; j < 8; ++j)
+                        q[j] = ~0ULL;
+                    q[i] = ~r[i];
+                    ASSERT_FALSE(f(q, h));
+                }
+            }
+        }
+    }
+
+    // binary and ternary ops in blocks
+    {
+        uint64_t p[3][kMaxOpBlocks];
+        uint64_t state = 2;
+        for (uint64_t i = 0; i < kMaxOpBlocks; ++i)
+        {
+            p[0][i] = SplitMix64(state);
+            p[1][i] = SplitMix64(state);
+            p[2][i] = SplitMix64(state);
+        }
+
+        TestBinaryOpBlocks<BitOpAnd>(p[0], p[1]);
+        TestBinaryOpBlocks<BitOpOr>(p[0], p[1]);
+        TestBinaryOpBlocks<BitOpXor>(p[0], p[1]);
+        TestBinaryOpBlocks<BitOpAndNot>(p[0], p[1]);
+        TestBinaryOpBlocks<BitOpNotAnd>(p[0], p[1]);
+        TestBinaryOpBlocks<BitOpNotAndNot>(p[0], p[1]);
+        TestBinaryOpBlocks<BitOpOrNot>(p[0], p[1]);
+        TestBinaryOpBlocks<BitOpNotOr>(p[0], p[1]);
+        TestBinaryOpBlocks<BitOpNotOrNot>(p[0], p[1]);
+        TestBinaryOpBlocks<BitOpXorNot>(p[0], p[1]);
+        TestBinaryOpBlocks<BitOpNot>(p[0], p[1]);
+        TestTernaryOpBlocks<BitOpBlend>(p[0], p[1], p[2]);
+
+        ASSERT_EQ(BitOpNotAnd::U64(0b1100, 0b1010), 0b0010ULL);
+        ASSERT_EQ(BitOpOrNot::U64(0b1100, 0b1010) & 0xF, 0b1101ULL);
+        ASSERT_EQ(BitOpNotOr::U64(0b1100, 0b1010) & 0xF, 0b1011ULL);
+        ASSERT_EQ(BitOpXorNot::U64(0b1100, 0b1010) & 0xF, 0b1001ULL);
+        ASSERT_EQ(BitOpBlend::U64(0b1100, 0b1010, 0b0110), 0b1010ULL);
+    }
+
+    // reverse bits of buffer, every variant the target supports, out of place and in place
+    {
+        constexpr uint64_t kMaxBytes = 400;
+        uint8_t p[kMaxBytes];
+        uint8_t r[kMaxBytes + 1];
+        uint64_t state = 3;
+        for (uint64_t i = 0; i < kMaxBytes; ++i)
+            p[i] = uint8_t(SplitMix64(state));
+
+        using Kernel = void (*)(uint8_t*, const uint8_t*, uint64_t);
+        const Kernel kernels[] = {
+            ReverseBits_Buffer_SSSE3,
+#if defined(__AVX2__)
+            ReverseBits_Buffer_AVX2,
+#if defined(__GFNI__)
+            ReverseBits_Buffer_AVX2_GFNI,
+#endif
+#endif
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+            ReverseBits_Buffer_AVX512,
+#if defined(__GFNI__)
+            ReverseBits_Buffer_AVX512_GFNI,
+#endif
+#endif
+            ReverseBits_Buffer,
+        };
+
+        for (const Kernel kernel : kernels)
+        {
+            for (uint64_t n = 0; n <= kMaxBytes; n += (n < 260 ? 1 : 13))
+            {
+                r[n] = 0x5A;
+                kernel(r, p, n);
+                for (uint64_t i = 0; i < n; ++i)
+                    ASSERT_EQ(r[i], RefReverseBits(p[n - 1 - i]));
+                ASSERT_EQ(r[n], 0x5A);
+                kernel(r, r, n);
+                for (uint64_t i = 0; i < n; ++i)
+                    ASSERT_EQ(r[i], p[i]);
+                ASSERT_EQ(r[n], 0x5A);
+            }
+        }
+    }
+
+    // runs in blocks, with garbage excess bits, against a bit-by-bit walk
+    {
+        constexpr uint64_t kMaxBlocks = 12;
+        uint64_t p[kMaxBlocks];
+        static BitRun runs[kMaxBlocks * 32 + 1];
+        uint64_t state = 4;
+        for (uint64_t trial = 0; trial < 400; ++trial)
+        {
+            for (uint64_t i = 0; i < kMaxBlocks; ++i)
+            {
+                const uint64_t r = SplitMix64(state);
+                const uint64_t kind = (trial + i) % 5;
+                p[i] = kind == 0 ? r : kind == 1 ? 0ULL : kind == 2 ? ~0ULL : kind == 3 ? r & SplitMix64(state) & SplitMix64(state) : r | SplitMix64(state);
+            }
+
+            const uint64_t numBits = SplitMix64(state) % (kMaxBlocks * 64 + 1);
+            for (const uint64_t flip : { 0ULL, ~0ULL })
+            {
+                std::vector<BitRun> ref;
+                for (uint64_t i = 0; i < numBits; ++i)
+                {
+                    if (!(((p[i >> 6] ^ flip) >> (i & 63)) & 1ULL))
+                        continue;
+                    if (!ref.empty() && ref.back().start + ref.back().length == i)
+                        ++ref.back().length;
+                    else
+                        ref.push_back({ i, 1 });
+                }
+
+                runs[ref.size()] = { 0xDEADULL, 0xBEEFULL };
+                ASSERT_EQ(EncodeRuns_Blocks(runs, p, numBits, flip), uint64_t(ref.size()));
+                for (uint64_t k = 0; k < ref.size(); ++k)
+                {
+                    ASSERT_EQ(runs[k].start, ref[k].start);
+                    ASSERT_EQ(runs[k].length, ref[k].length);
+                }
+                ASSERT_EQ(runs[ref.size()].start, 0xDEADULL);
+
+                BitRun largest = { ~0ULL, 0 };
+                for (const BitRun& r : ref)
+                    largest = r.length > largest.length ? r : largest;
+                const BitRun l = LargestRun_Blocks(p, numBits, flip);
+                ASSERT_EQ(l.start, largest.start);
+                ASSERT_EQ(l.length, largest.length);
+
+                for (uint64_t alignment = 1; alignment <= 256; alignment <<= 2)
+                {
+                    // including sizes so large that aligned + n would wrap around
+                    for (const uint64_t n : { 1ULL, 2ULL, 3ULL, 7ULL, 40ULL, 64ULL, 65ULL, 200ULL, ~0ULL - 100ULL, ~0ULL })
+                    {
+                        uint64_t best = ~0ULL;
+                        uint64_t bestLength = ~0ULL;
+                        for (const BitRun& r : ref)
+                        {
+                            const uint64_t aligned = (r.start + alignment - 1) / alignment * alignment;
+                            if (r.length < bestLength && aligned <= r.start + r.length && n <= r.start + r.length - aligned)
+                            {
+                                best = aligned;
+                                bestLength = r.length;
+                            }
+                        }
+                        ASSERT_EQ(BestFitRun_Blocks(p, numBits, n, alignment, flip), best);
+                    }
+                }
+
+                uint64_t end = 0;
+                uint64_t k = 0;
+                for (uint64_t i = NextRun_Blocks(p, numBits, 0, flip, end); i < numBits; i = NextRun_Blocks(p, numBits, end, flip, end), ++k)
+                {
+                    ASSERT_TRUE(k < ref.size());
+                    ASSERT_EQ(i, ref[k].start);
+                    ASSERT_EQ(end - i, ref[k].length);
+                }
+                ASSERT_EQ(k, uint64_t(ref.size()));
+
+                // from the middle of a run, or between runs
+                if (numBits)
+                {
+                    const uint64_t i = SplitMix64(state) % numBits;
+                    uint64_t j = i;
+                    while (j < numBits && !(((p[j >> 6] ^ flip) >> (j & 63)) & 1ULL))
+                        ++j;
+                    end = ~0ULL;
+                    ASSERT_EQ(NextRun_Blocks(p, numBits, i, flip, end), j);
+                    if (j < numBits)
+                    {
+                        uint64_t e = j;
+                        while (e < numBits && (((p[e >> 6] ^ flip) >> (e & 63)) & 1ULL))
+                            ++e;
+                        ASSERT_EQ(end, e);
+                    }
+                    else
+                    {
+                        ASSERT_EQ(end, ~0ULL);
+                    }
+                }
+            }
+        }
+    }
+
+    // crc32c
+    {
+        const uint8_t digits[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+        ASSERT_EQ(Crc32c_Buffer(digits, 9), 0xE3069283U);
+        ASSERT_EQ(Crc32c_Buffer(digits, 0), 0U);
+
+        // Any split continues to the same CRC.
+        for (uint64_t i = 0; i <= 9; ++i)
+            ASSERT_EQ(Crc32c_Buffer(digits + i, 9 - i, Crc32c_Buffer(digits, i)), 0xE3069283U);
+
+        uint8_t zeros[32] = {};
+        ASSERT_EQ(Crc32c_Buffer(zeros, 32), 0x8A9136AAU);
+    }
+
     // count leading zeros
     {
         auto n = 8U;
@@ -1427,6 +1993,104 @@ void TestBitOps()
             ASSERT_EQ(f(T(-1) >> i), T(1ULL << (n - i)));
     }
 
+    // nth set bit index
+    {
+        for (uint32_t x = 0; x < 256; ++x)
+        {
+            for (uint32_t n = 0; n < 8; ++n)
+            {
+                ASSERT_EQ(Overload_NthSetBitIndex(uint8_t(x), n), RefNthSetBitIndex(uint8_t(x), n));
+                ASSERT_EQ(Overload_NthSetBitIndex(uint16_t(x << 8), n + 8), RefNthSetBitIndex(uint16_t(x << 8), n + 8));
+            }
+        }
+
+        uint64_t state = 0x2545F4914F6CDD1DULL;
+        for (uint32_t i = 0; i < 20000; ++i)
+        {
+            const uint64_t r = SplitMix64(state);
+            // Vary the density, so that every byte position and count is hit.
+            const uint64_t x = i % 3 == 0 ? r : i % 3 == 1 ? r & SplitMix64(state) & SplitMix64(state) : r | SplitMix64(state);
+            for (uint32_t n = 0; n < 64; ++n)
+            {
+                const uint64_t expected = RefNthSetBitIndex(x, n);
+                ASSERT_EQ(Overload_NthSetBitIndex(x, n), expected);
+                ASSERT_EQ(NthSetBitIndex_U64_Broadword(x, n), expected);
+#if defined(__BMI2__)
+                ASSERT_EQ(NthSetBitIndex_U64_PDEP(x, n), expected);
+#endif
+                if (n < 32)
+                    ASSERT_EQ(Overload_NthSetBitIndex(uint32_t(x), n), RefNthSetBitIndex(uint32_t(x), n));
+                if (n < 16)
+                    ASSERT_EQ(Overload_NthSetBitIndex(uint16_t(x), n), RefNthSetBitIndex(uint16_t(x), n));
+            }
+        }
+
+        ASSERT_EQ(Overload_NthSetBitIndex(uint64_t(0), 0), 64ULL);
+        ASSERT_EQ(Overload_NthSetBitIndex(~uint64_t(0), 63), 63ULL);
+        ASSERT_EQ(Overload_NthSetBitIndex(uint64_t(1) << 63, 0), 63ULL);
+        ASSERT_EQ(Overload_NthSetBitIndex(uint64_t(1) << 63, 1), 64ULL);
+        ASSERT_EQ(Overload_NthSetBitIndex(uint32_t(0), 31), 32U);
+    }
+
+    // shifts and rotates in blocks
+    {
+        constexpr uint64_t kMaxBits = 700;
+        constexpr uint64_t kMaxBlocks = (kMaxBits + 63) / 64;
+        uint64_t src[kMaxBlocks];
+        uint64_t dst[kMaxBlocks];
+        uint64_t state = 6;
+        const auto bit = [](const uint64_t* p, uint64_t i) { return (p[i >> 6ULL] >> (i & 63ULL)) & 1ULL; };
+        for (uint64_t numBits = 1; numBits <= kMaxBits; ++numBits)
+        {
+            for (uint64_t k = 0; k < 6; ++k)
+            {
+                // every small shift, then random ones, up to past the size
+                const uint64_t s = k < 3 ? k : SplitMix64(state) % (numBits + 70);
+                for (uint64_t i = 0; i < kMaxBlocks; ++i)
+                    src[i] = SplitMix64(state);
+
+                ShiftLeft_Blocks(dst, src, numBits, s);
+                for (uint64_t i = 0; i < numBits; ++i)
+                    ASSERT_EQ(bit(dst, i), i >= s ? bit(src, i - s) : 0ULL);
+
+                ShiftRight_Blocks(dst, src, numBits, s);
+                for (uint64_t i = 0; i < numBits; ++i)
+                    ASSERT_EQ(bit(dst, i), i + s < numBits ? bit(src, i + s) : 0ULL);
+
+                RotateLeft_Blocks(dst, src, numBits, s % numBits);
+                for (uint64_t i = 0; i < numBits; ++i)
+                    ASSERT_EQ(bit(dst, (i + s) % numBits), bit(src, i));
+
+                // and in place
+                memcpy(dst, src, sizeof(src));
+                ShiftLeft_Blocks(dst, dst, numBits, s);
+                for (uint64_t i = 0; i < numBits; ++i)
+                    ASSERT_EQ(bit(dst, i), i >= s ? bit(src, i - s) : 0ULL);
+
+                memcpy(dst, src, sizeof(src));
+                ShiftRight_Blocks(dst, dst, numBits, s);
+                for (uint64_t i = 0; i < numBits; ++i)
+                    ASSERT_EQ(bit(dst, i), i + s < numBits ? bit(src, i + s) : 0ULL);
+
+                // rotating in place leaves the bits past the end alone
+                memcpy(dst, src, sizeof(src));
+                RotateLeftInPlace_Blocks(dst, numBits, s % numBits);
+                for (uint64_t i = 0; i < numBits; ++i)
+                    ASSERT_EQ(bit(dst, (i + s) % numBits), bit(src, i));
+                for (uint64_t i = numBits; i < 64 * kMaxBlocks; ++i)
+                    ASSERT_EQ(bit(dst, i), bit(src, i));
+
+                // reversing a range leaves the bits outside it alone
+                const uint64_t a = SplitMix64(state) % (numBits + 1);
+                const uint64_t b = a + SplitMix64(state) % (numBits - a + 1);
+                memcpy(dst, src, sizeof(src));
+                ReverseBitRange_Blocks(dst, a, b);
+                for (uint64_t i = 0; i < 64 * kMaxBlocks; ++i)
+                    ASSERT_EQ(bit(dst, i), i >= a && i < b ? bit(src, a + b - 1 - i) : bit(src, i));
+            }
+        }
+    }
+
     // simultaneously test [First|Last]N[Set|Clear]Bits
     NBitsTestHelper<uint8_t>();
     NBitsTestHelper<uint16_t>();
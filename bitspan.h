@@ -0,0 +1,521 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#pragma once
+
+#include <type_traits>
+
+#include "bitarray.h"
+
+// Non-owning view of a bit array in memory it doesn't own: a memory-mapped file, a network buffer, shared
+// memory, or the storage of a BitArray or DynamicBitArray. Bit i is bit (i & 63) of the little-endian
+// uint64_t at index i >> 6, the same layout BitArray uses, so a bitmap written as blocks can be queried in
+// place without a copy; pages are faulted in as the queries reach them.
+//
+// BitArrayView (over const uint64_t) has the whole query API of DynamicBitArray: Count*, First*, Last*,
+// Next*, Prev*, Nth*, FirstBlockOf*, AreAll*, iteration, and decoding. The queries are BitArray's own, from
+// BitArrayQueries (bitarray.h). BitSpan (over uint64_t) adds the single-bit, range, and in-place binary, shift,
+// and rotate operations. Spans are cheap to copy and pass by value; a BitSpan converts to a BitArrayView.
+// Constness is deep, as for a container: a const BitSpan can't modify its bits.
+//
+// Same semantics as DynamicBitArray: bits past NumBits() in the last block are ignored by queries, but
+// writes may change them, so the view owns its whole last block. Queries that scan require a nonzero size,
+// and binary operations require both operands to have the same size. The blocks must be 8-byte aligned.
+template <class Block>
+class BasicBitSpan : public BitArrayQueries<BasicBitSpan<Block>>
+{
+    static_assert(std::is_same_v<std::remove_const_t<Block>, uint64_t>, "BasicBitSpan is a span of uint64_t or const uint64_t.");
+
+    template <class>
+    friend class BasicBitSpan;
+
+public:
+    // Empty.
+    BasicBitSpan() : m_block(nullptr), m_numBits(0), m_numBlocks(0)
+    {
+    }
+
+    // The first numBits bits of blocks.
+    BasicBitSpan(Block* blocks, uint64_t numBits) : m_block(blocks), m_numBits(numBits), m_numBlocks(NumBlocksFor(numBits))
+    {
+    }
+
+    template <uint64_t kNBits>
+    BasicBitSpan(BitArray<kNBits>& v) : BasicBitSpan(v.Blocks(), kNBits)
+    {
+    }
+
+    // Read-only views only.
+    template <uint64_t kNBits, class B = Block, class = std::enable_if_t<std::is_const_v<B>>>
+    BasicBitSpan(const BitArray<kNBits>& v) : BasicBitSpan(v.Blocks(), kNBits)
+    {
+    }
+
+    // A BitSpan converts to a BitArrayView. Only a BitSpan itself: a DynamicBitArray, which holds its span as a
+    // private base, converts through its own operator instead.
+    template <class Other, class = std::enable_if_t<std::is_same_v<Other, BasicBitSpan<uint64_t>> && std::is_const_v<Block>>>
+    BasicBitSpan(const Other& other) : BasicBitSpan(other.m_block, other.m_numBits)
+    {
+    }
+
+    // Return the number of bits.
+    uint64_t NumBits() const
+    {
+        return m_numBits;
+    }
+
+    // Return the number of 64-bit blocks in use.
+    uint64_t NumBlocks() const
+    {
+        return m_numBlocks;
+    }
+
+    // Return the underlying blocks. Bits past NumBits() in the last block are unspecified.
+    const uint64_t* Blocks() const
+    {
+        return m_block;
+    }
+
+    Block* Blocks()
+    {
+        return m_block;
+    }
+
+    // Repeat value into every block.
+    void Rep(uint64_t value)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        for (uint64_t i = 0; i < m_numBlocks; ++i)
+            m_block[i] = value;
+    }
+
+    // Assign value to all bits.
+    void AssignAll(bool value)
+    {
+        Rep(value ? uint64_t(-1) : uint64_t(0));
+    }
+
+    // Set all bits.
+    void SetAll()
+    {
+        AssignAll(true);
+    }
+
+    // Clear all bits.
+    void ClearAll()
+    {
+        AssignAll(false);
+    }
+
+    // Set a bit.
+    void SetBit(uint64_t index)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(index < m_numBits);
+        m_block[index >> 6ULL] |= 1ULL << (index & 63ULL);
+    }
+
+    // Clear a bit.
+    void ClearBit(uint64_t index)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(index < m_numBits);
+        m_block[index >> 6ULL] &= ~(1ULL << (index & 63ULL));
+    }
+
+    // Invert a bit.
+    void XorBit(uint64_t index)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(index < m_numBits);
+        m_block[index >> 6ULL] ^= 1ULL << (index & 63ULL);
+    }
+
+    // Assign a value to a single bit.
+    void AssignBit(uint64_t index, bool value)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(index < m_numBits);
+        m_block[index >> 6ULL] = AssignBit_U64(m_block[index >> 6ULL], index & 63ULL, value);
+    }
+
+    // Set bit idx[i] for each of the n indices at idx, with prefetching like TestBits().
+    void SetBits(const uint64_t* idx, uint64_t n)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        for (uint64_t i = 0; i < n; ++i)
+            ASSERT(idx[i] < m_numBits);
+        SetBits_Blocks(m_block, idx, n);
+    }
+
+    // Clear bit idx[i] for each of the n indices at idx, with prefetching like TestBits().
+    void ClearBits(const uint64_t* idx, uint64_t n)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        for (uint64_t i = 0; i < n; ++i)
+            ASSERT(idx[i] < m_numBits);
+        ClearBits_Blocks(m_block, idx, n);
+    }
+
+    // Set all bits between indices [a, b], inclusive.
+    void SetBitsInRange(uint64_t a, uint64_t b)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(a <= b);
+        ASSERT(b < m_numBits);
+
+        const uint64_t iBlockA = a >> 6ULL;
+        const uint64_t iBlockB = b >> 6ULL;
+
+        if (iBlockA == iBlockB)
+        {
+            m_block[iBlockA] |= SetBitRange_U64(a, b);
+        }
+        else
+        {
+            m_block[iBlockA] |= SetBitRange_U64(a, 63ULL);
+
+            for (uint64_t iBlock = iBlockA + 1; iBlock < iBlockB; ++iBlock)
+                m_block[iBlock] = ~0ULL;
+
+            m_block[iBlockB] |= SetBitRange_U64(0, b);
+        }
+    }
+
+    // Clear all bits between indices [a, b], inclusive.
+    void ClearBitsInRange(uint64_t a, uint64_t b)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(a <= b);
+        ASSERT(b < m_numBits);
+
+        const uint64_t iBlockA = a >> 6ULL;
+        const uint64_t iBlockB = b >> 6ULL;
+
+        if (iBlockA == iBlockB)
+        {
+            m_block[iBlockA] &= ~SetBitRange_U64(a, b);
+        }
+        else
+        {
+            m_block[iBlockA] &= ~SetBitRange_U64(a, 63ULL);
+
+            for (uint64_t iBlock = iBlockA + 1; iBlock < iBlockB; ++iBlock)
+                m_block[iBlock] = 0ULL;
+
+            m_block[iBlockB] &= ~SetBitRange_U64(0, b);
+        }
+    }
+
+    void operator|=(BasicBitSpan<const uint64_t> other)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(m_numBits == other.m_numBits);
+        BinaryOp_Blocks<BitOpOr>(m_block, m_block, other.m_block, m_numBlocks);
+    }
+
+    void operator&=(BasicBitSpan<const uint64_t> other)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(m_numBits == other.m_numBits);
+        BinaryOp_Blocks<BitOpAnd>(m_block, m_block, other.m_block, m_numBlocks);
+    }
+
+    void operator^=(BasicBitSpan<const uint64_t> other)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(m_numBits == other.m_numBits);
+        BinaryOp_Blocks<BitOpXor>(m_block, m_block, other.m_block, m_numBlocks);
+    }
+
+    void AndNot(BasicBitSpan<const uint64_t> other)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(m_numBits == other.m_numBits);
+        BinaryOp_Blocks<BitOpAndNot>(m_block, m_block, other.m_block, m_numBlocks);
+    }
+
+    void OrNot(BasicBitSpan<const uint64_t> other)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(m_numBits == other.m_numBits);
+        BinaryOp_Blocks<BitOpOrNot>(m_block, m_block, other.m_block, m_numBlocks);
+    }
+
+    void NotOr(BasicBitSpan<const uint64_t> other)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(m_numBits == other.m_numBits);
+        BinaryOp_Blocks<BitOpNotOr>(m_block, m_block, other.m_block, m_numBlocks);
+    }
+
+    void NotOrNot(BasicBitSpan<const uint64_t> other)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(m_numBits == other.m_numBits);
+        BinaryOp_Blocks<BitOpNotOrNot>(m_block, m_block, other.m_block, m_numBlocks);
+    }
+
+    void XorNot(BasicBitSpan<const uint64_t> other)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(m_numBits == other.m_numBits);
+        BinaryOp_Blocks<BitOpXorNot>(m_block, m_block, other.m_block, m_numBlocks);
+    }
+
+    void NotXor(BasicBitSpan<const uint64_t> other)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(m_numBits == other.m_numBits);
+        BinaryOp_Blocks<BitOpXorNot>(m_block, m_block, other.m_block, m_numBlocks);
+    }
+
+    void NotXorNot(BasicBitSpan<const uint64_t> other)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(m_numBits == other.m_numBits);
+        BinaryOp_Blocks<BitOpXor>(m_block, m_block, other.m_block, m_numBlocks);
+    }
+
+    void NotAnd(BasicBitSpan<const uint64_t> other)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(m_numBits == other.m_numBits);
+        BinaryOp_Blocks<BitOpNotAnd>(m_block, m_block, other.m_block, m_numBlocks);
+    }
+
+    void NotAndNot(BasicBitSpan<const uint64_t> other)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(m_numBits == other.m_numBits);
+        BinaryOp_Blocks<BitOpNotAndNot>(m_block, m_block, other.m_block, m_numBlocks);
+    }
+
+    void AssignNot(BasicBitSpan<const uint64_t> other)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(m_numBits == other.m_numBits);
+        BinaryOp_Blocks<BitOpNot>(m_block, other.m_block, other.m_block, m_numBlocks);
+    }
+
+    void Blend(BasicBitSpan<const uint64_t> other, BasicBitSpan<const uint64_t> mask)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ASSERT(m_numBits == other.m_numBits);
+        ASSERT(m_numBits == mask.m_numBits);
+        TernaryOp_Blocks<BitOpBlend>(m_block, m_block, other.m_block, mask.m_block, m_numBlocks);
+    }
+
+    void Invert()
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        BinaryOp_Blocks<BitOpNot>(m_block, m_block, m_block, m_numBlocks);
+    }
+
+    // Reverse the order of the bits: bit i moves to bit NumBits() - 1 - i.
+    void ReverseBits()
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ReverseBits_Buffer(reinterpret_cast<uint8_t*>(m_block), reinterpret_cast<const uint8_t*>(m_block), m_numBlocks << 3ULL);
+
+        // The garbage excess bits are now at the bottom.
+        const uint64_t excess = (m_numBlocks << 6ULL) - m_numBits;
+        if (excess)
+        {
+            for (uint64_t i = 0; i < m_numBlocks - 1; ++i)
+                m_block[i] = (m_block[i] >> excess) | (m_block[i + 1] << (64ULL - excess));
+            m_block[m_numBlocks - 1] >>= excess;
+        }
+    }
+
+    // Left shift. Shifting by NumBits() or more clears all bits.
+    void operator<<=(uint64_t s)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ShiftLeft_Blocks(m_block, m_block, m_numBits, s);
+    }
+
+    // Right shift. Shifting by NumBits() or more clears all bits.
+    void operator>>=(uint64_t s)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        ShiftRight_Blocks(m_block, m_block, m_numBits, s);
+    }
+
+    // Rotate toward higher indices: bit i moves to bit (i + s) % NumBits(). In place, with no temporary copy.
+    void RotateLeft(uint64_t s)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        if (m_numBits == 0)
+            return;
+        RotateLeftInPlace_Blocks(m_block, m_numBits, s % m_numBits);
+    }
+
+    // Rotate toward lower indices: bit i moves to bit (i - s) % NumBits(). In place, with no temporary copy.
+    void RotateRight(uint64_t s)
+    {
+        static_assert(kWritable, "BitArrayView is read-only.");
+        if (m_numBits == 0)
+            return;
+        RotateLeftInPlace_Blocks(m_block, m_numBits, (m_numBits - s % m_numBits) % m_numBits);
+    }
+
+    bool operator==(BasicBitSpan<const uint64_t> other) const
+    {
+        if (m_numBits != other.m_numBits)
+            return false;
+
+        return m_numBlocks == 0 || AreBlocksEqual(other.m_block);
+    }
+
+    bool operator!=(BasicBitSpan<const uint64_t> other) const
+    {
+        return !(*this == other);
+    }
+
+    class EndIterator
+    {
+    };
+
+    class Iterator
+    {
+    public:
+        ALWAYS_INLINE Iterator(const uint64_t* __restrict v, uint64_t numBlocks, uint64_t lastBlockMask) : m_v(v), m_numBlocks(numBlocks), m_lastBlockMask(lastBlockMask)
+        {
+            for (m_iBlock = 0; m_iBlock + 1 < m_numBlocks; ++m_iBlock)
+            {
+                m_block = m_v[m_iBlock];
+                if (m_block)
+                {
+                    m_iBit = (m_iBlock << 6ULL) + FirstSetBitIndex_U64(m_block);
+                    return;
+                }
+            }
+
+            if (m_iBlock < m_numBlocks)
+            {
+                m_block = m_v[m_numBlocks - 1] & m_lastBlockMask;
+                if (m_block)
+                {
+                    m_iBit = (m_iBlock << 6ULL) + FirstSetBitIndex_U64(m_block);
+                    return;
+                }
+
+                ++m_iBlock;
+            }
+        }
+
+        ALWAYS_INLINE uint64_t operator*() const
+        {
+            return m_iBit;
+        }
+
+        ALWAYS_INLINE Iterator& operator++()
+        {
+            m_block = ClearFirstSetBit_U64(m_block);
+
+            for (;;)
+            {
+                if (m_block)
+                {
+                    m_iBit = (m_iBlock << 6ULL) + FirstSetBitIndex_U64(m_block);
+                    return *this;
+                }
+
+                if (++m_iBlock >= m_numBlocks)
+                    return *this;
+
+                m_block = m_v[m_iBlock];
+                m_block = m_iBlock == m_numBlocks - 1 ? m_block & m_lastBlockMask : m_block;
+            };
+        }
+
+        ALWAYS_INLINE bool operator==(const Iterator& other) const
+        {
+            return m_iBit == other.m_iBit;
+        }
+
+        ALWAYS_INLINE bool operator!=(const Iterator& other) const
+        {
+            return !(*this == other);
+        }
+
+        ALWAYS_INLINE bool operator==(const EndIterator&) const
+        {
+            return m_iBlock >= m_numBlocks;
+        }
+
+        ALWAYS_INLINE bool operator!=(const EndIterator&) const
+        {
+            return m_iBlock < m_numBlocks;
+        }
+
+    private:
+        const uint64_t* __restrict m_v;
+        uint64_t m_numBlocks;
+        uint64_t m_lastBlockMask;
+        uint64_t m_block;
+        uint64_t m_iBlock;
+        uint64_t m_iBit;
+    };
+
+    ALWAYS_INLINE Iterator begin() const
+    {
+        return Iterator(m_block, m_numBlocks, this->LastBlockMask());
+    }
+
+    ALWAYS_INLINE EndIterator end() const
+    {
+        return {};
+    }
+
+    // Write the indices of all set bits to out, in increasing order: the same indices as iterating, but decoded
+    // 8 or 16 at a time by a vectorized kernel. out must have room for CountSetBits() entries.
+    // Return the number of entries written. NumBits() must not exceed 2^32.
+    uint64_t DecodeSetBits(uint32_t* __restrict out) const
+    {
+        ASSERT(m_numBits <= (1ULL << 32ULL));
+        return m_numBlocks ? DecodeSetBitsHelper(out, 0, m_numBlocks) : 0ULL;
+    }
+
+    // Call f(const uint32_t* indices, uint64_t count) for successive batches of the indices of the set bits,
+    // in increasing order. Each batch is decoded as by DecodeSetBits() into a buffer on the stack, so no
+    // caller buffer is needed; the indices are valid only during the call. NumBits() must not exceed 2^32.
+    template <class F>
+    void ForEachSetBitBatch(F&& f) const
+    {
+        ASSERT(m_numBits <= (1ULL << 32ULL));
+        uint32_t indices[kDecodeBatchBlocks << 6ULL];
+        for (uint64_t iBlock = 0; iBlock < m_numBlocks; iBlock += kDecodeBatchBlocks)
+        {
+            const uint64_t n = m_numBlocks - iBlock < kDecodeBatchBlocks ? m_numBlocks - iBlock : kDecodeBatchBlocks;
+            const uint64_t count = DecodeSetBitsHelper(indices, iBlock, n);
+            if (count)
+                f(static_cast<const uint32_t*>(indices), count);
+        }
+    }
+
+protected:
+    static constexpr bool kWritable = !std::is_const_v<Block>;
+
+    static uint64_t NumBlocksFor(uint64_t numBits)
+    {
+        return (numBits + 63ULL) >> 6ULL;
+    }
+
+    using Queries = BitArrayQueries<BasicBitSpan<Block>>;
+    using Queries::kDecodeBatchBlocks, Queries::DecodeSetBitsHelper, Queries::AreBlocksEqual;
+
+    Block* m_block;
+    uint64_t m_numBits;
+    uint64_t m_numBlocks;
+};
+
+using BitArrayView = BasicBitSpan<const uint64_t>;
+using BitSpan = BasicBitSpan<uint64_t>;
@@ -0,0 +1,320 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#include <algorithm>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bitexpr.h"
+#include "bitspan.h"
+#include "rankselect.h"
+#include "testutil.h"
+
+#define ASSERT_TRUE(a) do { if (!(a)) { std::cerr << "FAIL: expected true for " << #a << ", got false\n"; __debugbreak(); } } while (0)
+
+#define ASSERT_BIN_OP(a, b, op) do {                                                            \
+    const auto& va = (a);                                                                       \
+    const auto& vb = (b);                                                                       \
+    if (!(va op vb))                                                                            \
+    {                                                                                           \
+        std::cerr << "FAIL: expected " << #a << " " << #op << " " << #b << " (evaluates to ";   \
+        std::cerr << va << " " << #op << " " << vb << ")\n";                                    \
+        __debugbreak();                                                                         \
+    }                                                                                           \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_BIN_OP(a, b, ==)
+
+static_assert(std::is_convertible_v<BitSpan, BitArrayView>);
+static_assert(!std::is_convertible_v<BitArrayView, BitSpan>);
+static_assert(std::is_convertible_v<const BitArray<100>&, BitArrayView>);
+static_assert(!std::is_convertible_v<const BitArray<100>&, BitSpan>);
+static_assert(std::is_convertible_v<const DynamicBitArray&, BitArrayView>);
+static_assert(!std::is_convertible_v<DynamicBitArray&, BitSpan&>);
+static_assert(!std::is_convertible_v<DynamicBitArray&, BitSpan>);
+
+// Every query of a view over a foreign buffer, against BitArray<n> holding the same bits.
+template <size_t n>
+static void TestQueries(uint64_t& state)
+{
+    BitArray<n> v;
+    std::vector<uint64_t> buffer(BitArray<n>::kNumBlocks);
+
+    for (uint32_t density = 0; density <= 4; ++density)
+    {
+        // Excess bits of the last block are garbage in both.
+        for (uint64_t i = 0; i < BitArray<n>::kNumBlocks; ++i)
+        {
+            const uint64_t r = SplitMix64(state);
+            const uint64_t sparse = r & SplitMix64(state) & SplitMix64(state) & SplitMix64(state);
+            buffer[i] = density == 0 ? 0ULL : density == 1 ? sparse : density == 2 ? r : density == 3 ? ~sparse : ~0ULL;
+            v.Blocks()[i] = buffer[i];
+        }
+        buffer.back() ^= ~BitArray<n>::LastBlockMask();
+
+        const BitArrayView d(buffer.data(), n);
+        ASSERT_EQ(d.NumBits(), n);
+        ASSERT_EQ(d.NumBlocks(), BitArray<n>::kNumBlocks);
+        ASSERT_TRUE(d == BitArrayView(v));
+
+        ASSERT_EQ(d.CountSetBits(), v.CountSetBits());
+        ASSERT_EQ(d.AreAllBitsSet(), v.AreAllBitsSet());
+        ASSERT_EQ(d.AreAllBitsClear(), v.AreAllBitsClear());
+        ASSERT_EQ(d.CountLeadingZeros(), v.CountLeadingZeros());
+        ASSERT_EQ(d.CountTrailingZeros(), v.CountTrailingZeros());
+        ASSERT_EQ(d.FirstSetBitIndex(), v.FirstSetBitIndex());
+        ASSERT_EQ(d.FirstClearBitIndex(), v.FirstClearBitIndex());
+        ASSERT_EQ(d.LastSetBitIndex(), v.LastSetBitIndex());
+        ASSERT_EQ(d.LastClearBitIndex(), v.LastClearBitIndex());
+
+        for (uint64_t i = 0; i < n; i += 1 + (i >> 4))
+        {
+            ASSERT_EQ(d.IsBitSet(i), v.IsBitSet(i));
+            ASSERT_EQ(d.PrevSetBitIndex(i), v.PrevSetBitIndex(i));
+            ASSERT_EQ(d.PrevClearBitIndex(i), v.PrevClearBitIndex(i));
+            ASSERT_EQ(d.NextSetBitIndex(i), v.NextSetBitIndex(i));
+            ASSERT_EQ(d.NextClearBitIndex(i), v.NextClearBitIndex(i));
+            ASSERT_EQ(d.NthSetBitIndex(i), v.NthSetBitIndex(i));
+            ASSERT_EQ(d.NthClearBitIndex(i), v.NthClearBitIndex(i));
+
+            const uint64_t j = i + (SplitMix64(state) % (n - i));
+            ASSERT_EQ(d.CountSetBitsInRange(i, j), v.CountSetBitsInRange(i, j));
+            ASSERT_EQ(d.AreAllBitsInRangeSet(i, j), v.AreAllBitsInRangeSet(i, j));
+            ASSERT_EQ(d.AreAllBitsInRangeClear(i, j), v.AreAllBitsInRangeClear(i, j));
+        }
+
+        for (uint64_t len = 1; len <= n; len += 1 + (len >> 2))
+        {
+            ASSERT_EQ(d.FirstBlockOfNSetBits(len), v.FirstBlockOfNSetBits(len));
+            ASSERT_EQ(d.FirstBlockOfNClearBits(len), v.FirstBlockOfNClearBits(len));
+            ASSERT_EQ(d.FirstAlignedBlockOfNSetBits(len, 8), v.FirstAlignedBlockOfNSetBits(len, 8));
+            ASSERT_EQ(d.FirstAlignedBlockOfNClearBits(len, 128), v.FirstAlignedBlockOfNClearBits(len, 128));
+        }
+
+        std::vector<uint64_t> expected;
+        for (uint64_t i : v)
+            expected.push_back(i);
+        std::vector<uint64_t> actual;
+        for (uint64_t i : d)
+            actual.push_back(i);
+        ASSERT_TRUE(actual == expected);
+
+        std::vector<uint32_t> decoded(d.CountSetBits());
+        ASSERT_EQ(d.DecodeSetBits(decoded.data()), decoded.size());
+        ASSERT_TRUE(std::equal(decoded.begin(), decoded.end(), expected.begin(), expected.end()));
+
+        std::vector<BitRun> runs((n + 1) / 2);
+        std::vector<BitRun> ref((n + 1) / 2);
+        const uint64_t numClearRuns = d.EncodeClearRuns(runs.data());
+        ASSERT_EQ(numClearRuns, v.EncodeClearRuns(ref.data()));
+        for (uint64_t k = 0; k < numClearRuns; ++k)
+            ASSERT_TRUE(runs[k].start == ref[k].start && runs[k].length == ref[k].length);
+        uint64_t k = 0;
+        for (const BitRun r : d.SetRuns())
+            k += r.length;
+        ASSERT_EQ(k, v.CountSetBits());
+
+        const RankSelectIndex index(d);
+        ASSERT_EQ(index.CountSetBits(), v.CountSetBits());
+    }
+}
+
+// Writes through a span land in the buffer, matching BitArray<n> doing the same.
+template <size_t n>
+static void TestWrites(uint64_t& state)
+{
+    BitArray<n> v;
+    v.ClearAll();
+    std::vector<uint64_t> buffer(BitArray<n>::kNumBlocks, 0ULL);
+    BitSpan s(buffer.data(), n);
+
+    for (uint64_t k = 0; k < 4 * n; ++k)
+    {
+        const uint64_t i = SplitMix64(state) % n;
+        switch (SplitMix64(state) % 5)
+        {
+        case 0: s.SetBit(i); v.SetBit(i); break;
+        case 1: s.ClearBit(i); v.ClearBit(i); break;
+        case 2: s.XorBit(i); v.XorBit(i); break;
+        case 3: { const bool value = SplitMix64(state) & 1; s.AssignBit(i, value); v.AssignBit(i, value); break; }
+        case 4:
+        {
+            const uint64_t j = i + SplitMix64(state) % (n - i);
+            if (k & 1)
+            {
+                s.SetBitsInRange(i, j);
+                v.SetBitsInRange(i, j);
+            }
+            else
+            {
+                s.ClearBitsInRange(i, j);
+                v.ClearBitsInRange(i, j);
+            }
+            break;
+        }
+        }
+    }
+    ASSERT_TRUE(BitArrayView(buffer.data(), n) == BitArrayView(v));
+
+    // Batches of bits, repeats included.
+    uint64_t idx[64];
+    uint8_t out[64];
+    for (uint64_t& i : idx)
+        i = SplitMix64(state) % n;
+    s.SetBits(idx, 64);
+    s.ClearBits(idx, 32);
+    for (uint64_t i = 0; i < 64; ++i)
+        v.SetBit(idx[i]);
+    for (uint64_t i = 0; i < 32; ++i)
+        v.ClearBit(idx[i]);
+    ASSERT_TRUE(BitArrayView(buffer.data(), n) == BitArrayView(v));
+    s.TestBits(idx, 64, out);
+    for (uint64_t i = 0; i < 64; ++i)
+        ASSERT_EQ(bool(out[i]), v.IsBitSet(idx[i]));
+
+    // In-place binary operations, with a BitArray as the other operand.
+    BitArray<n> w;
+    for (uint64_t i = 0; i < BitArray<n>::kNumBlocks; ++i)
+        w.Blocks()[i] = SplitMix64(state);
+
+    s |= w;
+    v |= w;
+    ASSERT_TRUE(s == BitArrayView(v));
+    s ^= w;
+    v ^= w;
+    ASSERT_TRUE(s == BitArrayView(v));
+    s.Invert();
+    v.Invert();
+    ASSERT_TRUE(s == BitArrayView(v));
+    s &= w;
+    v &= w;
+    ASSERT_TRUE(s == BitArrayView(v));
+    s.AndNot(w);
+    v.AndNot(w);
+    ASSERT_TRUE(s == BitArrayView(v));
+
+    BitArray<n> mask;
+    for (uint64_t i = 0; i < BitArray<n>::kNumBlocks; ++i)
+        mask.Blocks()[i] = SplitMix64(state);
+    s.OrNot(w);
+    v.OrNot(w);
+    ASSERT_TRUE(s == BitArrayView(v));
+    s.NotOr(mask);
+    v.NotOr(mask);
+    ASSERT_TRUE(s == BitArrayView(v));
+    s.NotOrNot(w);
+    v.NotOrNot(w);
+    ASSERT_TRUE(s == BitArrayView(v));
+    s.XorNot(mask);
+    v.XorNot(mask);
+    ASSERT_TRUE(s == BitArrayView(v));
+    s.NotXor(w);
+    v.NotXor(w);
+    ASSERT_TRUE(s == BitArrayView(v));
+    s.NotXorNot(mask);
+    v.NotXorNot(mask);
+    ASSERT_TRUE(s == BitArrayView(v));
+    s.NotAnd(w);
+    v.NotAnd(w);
+    ASSERT_TRUE(s == BitArrayView(v));
+    s.NotAndNot(mask);
+    v.NotAndNot(mask);
+    ASSERT_TRUE(s == BitArrayView(v));
+    s.Blend(w, mask);
+    v.Blend(w, mask);
+    ASSERT_TRUE(s == BitArrayView(v));
+    s.AssignNot(mask);
+    v.AssignNot(mask);
+    ASSERT_TRUE(s == BitArrayView(v));
+
+    // Shifts and rotates, by up to and past the size.
+    for (uint64_t k = 0; k < 8; ++k)
+    {
+        const uint64_t shift = SplitMix64(state) % (2 * n + 1);
+        s.RotateLeft(shift);
+        v.RotateLeft(shift);
+        ASSERT_TRUE(s == BitArrayView(v));
+        s.RotateRight(shift / 3);
+        v.RotateRight(shift / 3);
+        ASSERT_TRUE(s == BitArrayView(v));
+        if (k & 1)
+        {
+            s <<= shift;
+            v <<= shift;
+        }
+        else
+        {
+            s >>= shift;
+            v >>= shift;
+        }
+        ASSERT_TRUE(s == BitArrayView(v));
+        s.XorNot(w);
+        v.XorNot(w);
+    }
+
+    s.SetAll();
+    ASSERT_TRUE(s.AreAllBitsSet());
+    s.ClearAll();
+    ASSERT_TRUE(s.AreAllBitsClear());
+
+    // A span over a BitArray writes into it.
+    BitSpan(v).SetBit(n - 1);
+    ASSERT_TRUE(v.IsBitSet(n - 1));
+}
+
+template <class F>
+static void SweepSizes(F func)
+{
+    func(std::integral_constant<size_t, 1>{});
+    func(std::integral_constant<size_t, 63>{});
+    func(std::integral_constant<size_t, 64>{});
+    func(std::integral_constant<size_t, 65>{});
+    func(std::integral_constant<size_t, 200>{});
+    func(std::integral_constant<size_t, 4161>{});
+}
+
+void TestBitSpan()
+{
+    uint64_t state = 0x5EA4ULL;
+
+    // empty
+    {
+        const BitArrayView d;
+        ASSERT_EQ(d.NumBits(), 0ULL);
+        ASSERT_EQ(d.NumBlocks(), 0ULL);
+        ASSERT_TRUE(d.begin() == d.end());
+        ASSERT_TRUE(d == BitArrayView());
+    }
+
+    SweepSizes([&](auto n) { TestQueries<decltype(n)::value>(state); });
+    SweepSizes([&](auto n) { TestWrites<decltype(n)::value>(state); });
+
+    // Views of a DynamicBitArray see its writes, and it combines with views.
+    {
+        DynamicBitArray a(300);
+        const BitArrayView view = a;
+        a.SetBit(7);
+        ASSERT_TRUE(view.IsBitSet(7));
+        ASSERT_EQ(view.Blocks(), a.Blocks());
+
+        std::vector<uint64_t> buffer(5, 0ULL);
+        BitSpan b(buffer.data(), 300);
+        b.SetBitsInRange(100, 199);
+        a |= b;
+        ASSERT_EQ(a.CountSetBits(), 101ULL);
+        ASSERT_TRUE(view == a);
+
+        // Lazy expressions read views and write spans.
+        Assign(b, Lazy(view) & ~Lazy(b));
+        ASSERT_EQ(b.CountSetBits(), 1ULL);
+        ASSERT_EQ(CountSetBits(Lazy(a) ^ b), 100ULL);
+    }
+}
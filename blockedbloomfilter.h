@@ -0,0 +1,127 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "bitarray.h"
+
+// Bloom filter whose keys each set their bits within one cache line, a 512-bit bucket, so that a lookup costs one
+// cache miss rather than one per bit.
+//
+// A key is given as a well-mixed 64-bit hash of it. The high 32 bits choose the bucket; the low 32 bits, times 8 odd
+// salts, choose one bit in each of the bucket's 8 words (see SetBloomBucketBits()), all 8 at once with SIMD.
+// InsertBatch() and ContainsBatch() prefetch the buckets of later hashes, so a batch's misses overlap too.
+//
+// Confining a key to one bucket costs some accuracy, as buckets fill unevenly. False positive rates, by bits per key
+// (see NumBucketsFor()), against an unblocked filter with the best number of bits per key:
+//
+//     bits/key   blocked   unblocked
+//        8       2.9%      2.2% (6 bits)
+//       10       1.0%      0.82% (7 bits)
+//       12       0.42%     0.31% (8 bits)
+//       16       0.091%    0.046% (11 bits)
+//       20       0.026%    0.0067% (14 bits)
+//
+// Not thread-safe for concurrent inserts. Lookups may run concurrently with each other.
+class BlockedBloomFilter
+{
+public:
+    static constexpr uint64_t kBucketBits = 512;
+
+    // A bucket, aligned to a cache line.
+    struct alignas(64) Bucket
+    {
+        BitArray<kBucketBits> bits;
+    };
+
+    // Return the number of buckets for numKeys keys at bitsPerKey bits each, at least 1.
+    static uint64_t NumBucketsFor(uint64_t numKeys, uint64_t bitsPerKey)
+    {
+        const uint64_t n = (numKeys * bitsPerKey + kBucketBits - 1) / kBucketBits;
+        return n ? n : 1;
+    }
+
+    // An empty filter of numBuckets buckets, at most 2^32.
+    explicit BlockedBloomFilter(uint64_t numBuckets) : m_bucket(numBuckets)
+    {
+        ASSERT(numBuckets != 0);
+        ASSERT(numBuckets <= (1ULL << 32ULL));
+        Clear();
+    }
+
+    // Add a key.
+    void Insert(uint64_t hash)
+    {
+        SetBloomBucketBits(m_bucket[BucketIndex(hash)].bits.Blocks(), uint32_t(hash));
+    }
+
+    // Check if a key may have been added. False only if it never was.
+    bool Contains(uint64_t hash) const
+    {
+        return AreBloomBucketBitsSet(m_bucket[BucketIndex(hash)].bits.Blocks(), uint32_t(hash));
+    }
+
+    // Add the n keys at hashes, prefetching the buckets of later ones.
+    void InsertBatch(const uint64_t* hashes, uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            Prefetch(hashes, i + kBitBatchPrefetchDistance, n);
+            Insert(hashes[i]);
+        }
+    }
+
+    // out[i] = Contains(hashes[i]) for the n keys at hashes, prefetching the buckets of later ones.
+    void ContainsBatch(const uint64_t* __restrict hashes, uint64_t n, uint8_t* __restrict out) const
+    {
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            Prefetch(hashes, i + kBitBatchPrefetchDistance, n);
+            out[i] = uint8_t(Contains(hashes[i]));
+        }
+    }
+
+    // Remove every key.
+    void Clear()
+    {
+        for (Bucket& b : m_bucket)
+            b.bits.ClearAll();
+    }
+
+    // Return the number of buckets.
+    uint64_t NumBuckets() const
+    {
+        return m_bucket.size();
+    }
+
+    // Return the bits of a bucket.
+    const BitArray<kBucketBits>& BucketBits(uint64_t i) const
+    {
+        ASSERT(i < m_bucket.size());
+        return m_bucket[i].bits;
+    }
+
+private:
+    // Return the bucket of a key: the high 32 bits of its hash, scaled to the number of buckets.
+    uint64_t BucketIndex(uint64_t hash) const
+    {
+        return ((hash >> 32ULL) * m_bucket.size()) >> 32ULL;
+    }
+
+    // Prefetch the bucket of hashes[i], if i < n.
+    void Prefetch(const uint64_t* hashes, uint64_t i, uint64_t n) const
+    {
+        if (i < n)
+            _mm_prefetch(reinterpret_cast<const char*>(&m_bucket[BucketIndex(hashes[i])]), _MM_HINT_T0);
+    }
+
+    std::vector<Bucket> m_bucket;
+};
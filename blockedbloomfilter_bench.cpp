@@ -0,0 +1,118 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#include <memory>
+#include <vector>
+
+#include "bench.h"
+#include "blockedbloomfilter.h"
+
+// Bits in each benchmarked filter, 16 MiB: more than a core's caches.
+static constexpr uint64_t kBenchFilterBits = 1ULL << 27ULL;
+
+// Bits per key, and the number of bits each key sets in the unblocked filter: the best number for that many.
+static constexpr uint64_t kBenchBitsPerKey = 10;
+static constexpr uint64_t kBenchNaiveHashes = 7;
+
+// Keys cycled through by each lookup or insert benchmark, far more than there are cache lines in L2.
+static constexpr uint64_t kBenchKeys = 1ULL << 20ULL;
+
+// Keys per batch.
+static constexpr uint64_t kBenchBatch = 256;
+
+// What BlockedBloomFilter replaces: a BitArray with kBenchNaiveHashes bits per key anywhere in it, from double
+// hashing of the two halves of the key's hash, each bit its own cache miss.
+class NaiveBloomFilter
+{
+public:
+    NaiveBloomFilter()
+    {
+        m_bits.ClearAll();
+    }
+
+    void Insert(uint64_t hash)
+    {
+        const uint64_t h2 = hash >> 32ULL;
+        for (uint64_t i = 0; i < kBenchNaiveHashes; ++i)
+            m_bits.SetBit(Index(hash, h2, i));
+    }
+
+    bool Contains(uint64_t hash) const
+    {
+        const uint64_t h2 = hash >> 32ULL;
+        for (uint64_t i = 0; i < kBenchNaiveHashes; ++i)
+        {
+            if (!m_bits.IsBitSet(Index(hash, h2, i)))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    static uint64_t Index(uint64_t hash, uint64_t h2, uint64_t i)
+    {
+        return (uint32_t(hash) + i * h2) & (kBenchFilterBits - 1);
+    }
+
+    BitArray<kBenchFilterBits> m_bits;
+};
+
+// Time per key of f(keys, i), which handles keys[i], or kBenchBatch keys from keys[i] if batched.
+template <class F>
+static void BenchKeys(const char* name, const std::vector<uint64_t>& keys, bool batched, F&& f)
+{
+    if (!BenchSelected("BlockedBloomFilter", name))
+        return;
+
+    const uint64_t step = batched ? kBenchBatch : 1;
+    uint64_t i = 0;
+    BenchResult r = BenchMeasure([&](uint64_t numIterations)
+        {
+            for (uint64_t k = 0; k < numIterations; ++k)
+            {
+                f(keys.data(), i);
+                i = (i + step) & (kBenchKeys - 1);
+            }
+            ClobberMemory();
+        });
+    r.ns /= double(step);
+    r.cycles /= double(step);
+    PrintBenchResult("BlockedBloomFilter", name, r);
+}
+
+void BenchBlockedBloomFilter()
+{
+    uint64_t state = 0xB100ULL;
+    const uint64_t numKeys = kBenchFilterBits / kBenchBitsPerKey;
+
+    // Filters at their design load, and keys to look up of which about half were inserted.
+    const std::unique_ptr<NaiveBloomFilter> naive = std::make_unique<NaiveBloomFilter>();
+    BlockedBloomFilter blocked(kBenchFilterBits / BlockedBloomFilter::kBucketBits);
+    for (uint64_t k = 0; k < numKeys; ++k)
+    {
+        const uint64_t hash = BenchSplitMix64(state);
+        naive->Insert(hash);
+        blocked.Insert(hash);
+    }
+
+    std::vector<uint64_t> keys(kBenchKeys);
+    uint64_t insertState = 0xB100ULL;
+    for (uint64_t& key : keys)
+        key = (BenchSplitMix64(state) & 1) ? BenchSplitMix64(insertState) : BenchSplitMix64(state);
+    std::vector<uint8_t> out(kBenchBatch);
+
+    BenchKeys("naive BitArray/Contains", keys, false, [&](const uint64_t* p, uint64_t i) { DoNotOptimize(naive->Contains(p[i])); });
+    BenchKeys("Contains", keys, false, [&](const uint64_t* p, uint64_t i) { DoNotOptimize(blocked.Contains(p[i])); });
+    BenchKeys("ContainsBatch", keys, true, [&](const uint64_t* p, uint64_t i) { blocked.ContainsBatch(p + i, kBenchBatch, out.data()); ClobberMemory(); });
+
+    // Half the keys are new, but few enough that inserting them barely raises the load.
+    BenchKeys("naive BitArray/Insert", keys, false, [&](const uint64_t* p, uint64_t i) { naive->Insert(p[i]); });
+    BenchKeys("Insert", keys, false, [&](const uint64_t* p, uint64_t i) { blocked.Insert(p[i]); });
+    BenchKeys("InsertBatch", keys, true, [&](const uint64_t* p, uint64_t i) { blocked.InsertBatch(p + i, kBenchBatch); });
+}
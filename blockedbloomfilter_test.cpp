@@ -0,0 +1,129 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#include <iostream>
+#include <vector>
+
+#include "blockedbloomfilter.h"
+#include "testutil.h"
+
+#define ASSERT_TRUE(a) do { if (!(a)) { std::cerr << "FAIL: expected true for " << #a << ", got false\n"; __debugbreak(); } } while (0)
+#define ASSERT_FALSE(a) do { if ((a)) { std::cerr << "FAIL: expected false for " << #a << ", got true\n"; __debugbreak(); } } while (0)
+
+#define ASSERT_BIN_OP(a, b, op) do {                                                            \
+    const auto& va = (a);                                                                       \
+    const auto& vb = (b);                                                                       \
+    if (!(va op vb))                                                                            \
+    {                                                                                           \
+        std::cerr << "FAIL: expected " << #a << " " << #op << " " << #b << " (evaluates to ";   \
+        std::cerr << va << " " << #op << " " << vb << ")\n";                                    \
+        __debugbreak();                                                                         \
+    }                                                                                           \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_BIN_OP(a, b, ==)
+#define ASSERT_LT(a, b) ASSERT_BIN_OP(a, b, <)
+
+// Insert numKeys random keys at bitsPerKey, singly or batched, and check that every one is found, both ways, and
+// that the rate of false positives over as many other keys is below maxRate.
+static void TestFalsePositives(uint64_t numKeys, uint64_t bitsPerKey, double maxRate, bool batched, uint64_t& state)
+{
+    BlockedBloomFilter f(BlockedBloomFilter::NumBucketsFor(numKeys, bitsPerKey));
+    ASSERT_EQ(f.NumBuckets(), numKeys ? (numKeys * bitsPerKey + 511) / 512 : 1);
+
+    std::vector<uint64_t> keys(numKeys);
+    for (uint64_t& k : keys)
+        k = SplitMix64(state);
+    if (batched)
+    {
+        f.InsertBatch(keys.data(), numKeys);
+    }
+    else
+    {
+        for (const uint64_t k : keys)
+            f.Insert(k);
+    }
+
+    std::vector<uint8_t> out(numKeys + 1);
+    out[numKeys] = 0xAA;
+    f.ContainsBatch(keys.data(), numKeys, out.data());
+    for (uint64_t i = 0; i < numKeys; ++i)
+    {
+        ASSERT_TRUE(f.Contains(keys[i]));
+        ASSERT_EQ(out[i], uint8_t(1));
+    }
+    ASSERT_EQ(out[numKeys], uint8_t(0xAA));
+
+    for (uint64_t& k : keys)
+        k = SplitMix64(state);
+    f.ContainsBatch(keys.data(), numKeys, out.data());
+    uint64_t falsePositives = 0;
+    for (uint64_t i = 0; i < numKeys; ++i)
+    {
+        ASSERT_EQ(bool(out[i]), f.Contains(keys[i]));
+        falsePositives += out[i];
+    }
+    if (numKeys)
+        ASSERT_LT(double(falsePositives) / double(numKeys), maxRate);
+}
+
+void TestBlockedBloomFilter()
+{
+    uint64_t state = 5;
+
+    // Each key sets one bit in each word of one bucket, and nothing else.
+    {
+        BlockedBloomFilter f(7);
+        ASSERT_EQ(f.NumBuckets(), 7ULL);
+        for (uint64_t i = 0; i < 7; ++i)
+            ASSERT_TRUE(f.BucketBits(i).AreAllBitsClear());
+
+        const uint64_t key = SplitMix64(state);
+        ASSERT_FALSE(f.Contains(key));
+        f.Insert(key);
+        ASSERT_TRUE(f.Contains(key));
+
+        uint64_t numSetBuckets = 0;
+        for (uint64_t i = 0; i < 7; ++i)
+        {
+            const BitArray<512>& b = f.BucketBits(i);
+            if (b.AreAllBitsClear())
+                continue;
+            ++numSetBuckets;
+            for (uint64_t w = 0; w < 8; ++w)
+                ASSERT_EQ(b.CountSetBitsInRange(64 * w, 64 * w + 63), 1ULL);
+        }
+        ASSERT_EQ(numSetBuckets, 1ULL);
+
+        f.Clear();
+        ASSERT_FALSE(f.Contains(key));
+        for (uint64_t i = 0; i < 7; ++i)
+            ASSERT_TRUE(f.BucketBits(i).AreAllBitsClear());
+    }
+
+    // Every bucket is reachable, including from the extremes of the hash.
+    {
+        BlockedBloomFilter f(1ULL << 10ULL);
+        for (uint64_t i = 0; i < (1ULL << 10ULL); ++i)
+            f.Insert((i << 54ULL) | (SplitMix64(state) & 0xFFFFFFFFULL));
+        f.Insert(~0ULL);
+        f.Insert(0);
+        for (uint64_t i = 0; i < (1ULL << 10ULL); ++i)
+            ASSERT_FALSE(f.BucketBits(i).AreAllBitsClear());
+        ASSERT_TRUE(f.Contains(~0ULL));
+        ASSERT_TRUE(f.Contains(0));
+    }
+
+    // Small filters, then the documented rates, with some slack.
+    for (uint64_t n = 0; n < 100; ++n)
+        TestFalsePositives(n, 10, 1.0, n & 1, state);
+    TestFalsePositives(200000, 10, 0.0125, false, state);
+    TestFalsePositives(200000, 10, 0.0125, true, state);
+    TestFalsePositives(200000, 16, 0.0013, true, state);
+}
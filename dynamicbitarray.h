@@ -0,0 +1,303 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#pragma once
+
+#include <cstring>
+#include <new>
+
+#include "bitspan.h"
+
+// A BitArray whose size is chosen at runtime. Storage is on the heap, 64-byte aligned, and padded
+// to a whole number of cache lines. The size is fixed at construction or by Resize().
+//
+// Same API and semantics as BitArray. Queries that scan (Count*, First*, Last*, Next*, Prev*, Nth*,
+// FirstBlockOf*) require a nonzero size.
+// Binary operations require both operands to have the same size.
+//
+// The queries and the single-bit, range, and in-place operations are those of BitSpan, over the array's own
+// storage. The span is a private base, so that it can't be pointed at other memory through a BitSpan&: View()
+// and Span() return spans of the array, and it converts to a BitArrayView implicitly.
+class DynamicBitArray : private BitSpan
+{
+public:
+    using BitSpan::NumBits, BitSpan::NumBlocks, BitSpan::Blocks, BitSpan::LastBlockMask;
+
+    using BitSpan::Rep, BitSpan::AssignAll, BitSpan::SetAll, BitSpan::ClearAll;
+    using BitSpan::SetBit, BitSpan::ClearBit, BitSpan::XorBit, BitSpan::AssignBit, BitSpan::IsBitSet;
+    using BitSpan::TestBits, BitSpan::SetBits, BitSpan::ClearBits;
+    using BitSpan::SetBitsInRange, BitSpan::ClearBitsInRange;
+
+    using BitSpan::CountSetBits, BitSpan::CountSetBitsInRange, BitSpan::CountLeadingZeros, BitSpan::CountTrailingZeros;
+    using BitSpan::AreAllBitsSet, BitSpan::AreAllBitsClear, BitSpan::AreAllBitsInRangeSet, BitSpan::AreAllBitsInRangeClear;
+    using BitSpan::FirstSetBitIndex, BitSpan::FirstClearBitIndex, BitSpan::LastSetBitIndex, BitSpan::LastClearBitIndex;
+    using BitSpan::NextSetBitIndex, BitSpan::NextClearBitIndex, BitSpan::PrevSetBitIndex, BitSpan::PrevClearBitIndex;
+    using BitSpan::NthSetBitIndex, BitSpan::NthClearBitIndex;
+    using BitSpan::FirstBlockOfNSetBits, BitSpan::FirstBlockOfNClearBits;
+    using BitSpan::FirstAlignedBlockOfNSetBits, BitSpan::FirstAlignedBlockOfNClearBits;
+    using BitSpan::BestFitBlockOfNClearBits, BitSpan::BestFitAlignedBlockOfNClearBits, BitSpan::LargestClearRun;
+
+    using BitSpan::operator|=, BitSpan::operator&=, BitSpan::operator^=, BitSpan::AndNot;
+    using BitSpan::OrNot, BitSpan::NotOr, BitSpan::NotOrNot, BitSpan::XorNot, BitSpan::NotXor, BitSpan::NotXorNot;
+    using BitSpan::NotAnd, BitSpan::NotAndNot, BitSpan::AssignNot, BitSpan::Blend, BitSpan::Invert;
+    using BitSpan::operator<<=, BitSpan::operator>>=, BitSpan::RotateLeft, BitSpan::RotateRight, BitSpan::ReverseBits;
+    using BitSpan::operator==, BitSpan::operator!=;
+
+    using BitSpan::begin, BitSpan::end, BitSpan::DecodeSetBits, BitSpan::ForEachSetBitBatch;
+    using BitSpan::SetRuns, BitSpan::ClearRuns, BitSpan::EncodeRuns, BitSpan::EncodeClearRuns;
+
+    DynamicBitArray() : m_capacity(0)
+    {
+    }
+
+    // All bits clear.
+    explicit DynamicBitArray(uint64_t numBits) : DynamicBitArray(numBits, kUninitialized)
+    {
+        ClearAll();
+    }
+
+    DynamicBitArray(uint64_t numBits, bool value) : DynamicBitArray(numBits, kUninitialized)
+    {
+        AssignAll(value);
+    }
+
+    DynamicBitArray(const DynamicBitArray& other) : DynamicBitArray(other.m_numBits, kUninitialized)
+    {
+        if (m_numBlocks)
+            memcpy(m_block, other.m_block, m_numBlocks << 3ULL);
+    }
+
+    DynamicBitArray(DynamicBitArray&& other) noexcept : BitSpan(other.m_block, other.m_numBits), m_capacity(other.m_capacity)
+    {
+        other.m_block = nullptr;
+        other.m_numBits = other.m_numBlocks = other.m_capacity = 0;
+    }
+
+    DynamicBitArray& operator=(const DynamicBitArray& other)
+    {
+        if (this != &other)
+        {
+            Reserve(other.m_numBlocks);
+            m_numBits = other.m_numBits;
+            m_numBlocks = other.m_numBlocks;
+            if (m_numBlocks)
+                memcpy(m_block, other.m_block, m_numBlocks << 3ULL);
+        }
+        return *this;
+    }
+
+    DynamicBitArray& operator=(DynamicBitArray&& other) noexcept
+    {
+        if (this != &other)
+        {
+            _mm_free(m_block);
+            m_block = other.m_block;
+            m_numBits = other.m_numBits;
+            m_numBlocks = other.m_numBlocks;
+            m_capacity = other.m_capacity;
+            other.m_block = nullptr;
+            other.m_numBits = other.m_numBlocks = other.m_capacity = 0;
+        }
+        return *this;
+    }
+
+    ~DynamicBitArray()
+    {
+        _mm_free(m_block);
+    }
+
+    // Change the size. Existing bits are kept; new bits are clear.
+    // Shrinking keeps the allocation.
+    void Resize(uint64_t numBits)
+    {
+        const uint64_t numBlocks = NumBlocksFor(numBits);
+        Reserve(numBlocks);
+
+        if (numBits > m_numBits)
+        {
+            if (m_numBlocks)
+                m_block[m_numBlocks - 1] &= LastBlockMask();
+            for (uint64_t i = m_numBlocks; i < numBlocks; ++i)
+                m_block[i] = 0ULL;
+        }
+
+        m_numBits = numBits;
+        m_numBlocks = numBlocks;
+    }
+
+    // Return a read-only span of the bits. The array also converts to one implicitly.
+    BitArrayView View() const
+    {
+        return BitArrayView(m_block, m_numBits);
+    }
+
+    // Return a span of the bits, to pass where a BitSpan is taken. Resize() and assignment invalidate it.
+    BitSpan Span()
+    {
+        return BitSpan(m_block, m_numBits);
+    }
+
+    operator BitArrayView() const
+    {
+        return View();
+    }
+
+    friend DynamicBitArray operator|(const DynamicBitArray& __restrict a, const DynamicBitArray& __restrict b)
+    {
+        ASSERT(a.m_numBits == b.m_numBits);
+        DynamicBitArray ret(a.m_numBits, kUninitialized);
+        BinaryOp_Blocks<BitOpOr>(ret.m_block, a.m_block, b.m_block, ret.m_numBlocks);
+        return ret;
+    }
+
+    friend DynamicBitArray OrNot(const DynamicBitArray& __restrict a, const DynamicBitArray& __restrict b)
+    {
+        ASSERT(a.m_numBits == b.m_numBits);
+        DynamicBitArray ret(a.m_numBits, kUninitialized);
+        BinaryOp_Blocks<BitOpOrNot>(ret.m_block, a.m_block, b.m_block, ret.m_numBlocks);
+        return ret;
+    }
+
+    friend DynamicBitArray NotOrNot(const DynamicBitArray& __restrict a, const DynamicBitArray& __restrict b)
+    {
+        ASSERT(a.m_numBits == b.m_numBits);
+        DynamicBitArray ret(a.m_numBits, kUninitialized);
+        BinaryOp_Blocks<BitOpNotOrNot>(ret.m_block, a.m_block, b.m_block, ret.m_numBlocks);
+        return ret;
+    }
+
+    friend DynamicBitArray operator^(const DynamicBitArray& __restrict a, const DynamicBitArray& __restrict b)
+    {
+        ASSERT(a.m_numBits == b.m_numBits);
+        DynamicBitArray ret(a.m_numBits, kUninitialized);
+        BinaryOp_Blocks<BitOpXor>(ret.m_block, a.m_block, b.m_block, ret.m_numBlocks);
+        return ret;
+    }
+
+    friend DynamicBitArray XorNot(const DynamicBitArray& __restrict a, const DynamicBitArray& __restrict b)
+    {
+        ASSERT(a.m_numBits == b.m_numBits);
+        DynamicBitArray ret(a.m_numBits, kUninitialized);
+        BinaryOp_Blocks<BitOpXorNot>(ret.m_block, a.m_block, b.m_block, ret.m_numBlocks);
+        return ret;
+    }
+
+    friend DynamicBitArray NotXorNot(const DynamicBitArray& __restrict a, const DynamicBitArray& __restrict b)
+    {
+        ASSERT(a.m_numBits == b.m_numBits);
+        DynamicBitArray ret(a.m_numBits, kUninitialized);
+        BinaryOp_Blocks<BitOpXor>(ret.m_block, a.m_block, b.m_block, ret.m_numBlocks);
+        return ret;
+    }
+
+    friend DynamicBitArray operator&(const DynamicBitArray& __restrict a, const DynamicBitArray& __restrict b)
+    {
+        ASSERT(a.m_numBits == b.m_numBits);
+        DynamicBitArray ret(a.m_numBits, kUninitialized);
+        BinaryOp_Blocks<BitOpAnd>(ret.m_block, a.m_block, b.m_block, ret.m_numBlocks);
+        return ret;
+    }
+
+    friend DynamicBitArray AndNot(const DynamicBitArray& __restrict a, const DynamicBitArray& __restrict b)
+    {
+        ASSERT(a.m_numBits == b.m_numBits);
+        DynamicBitArray ret(a.m_numBits, kUninitialized);
+        BinaryOp_Blocks<BitOpAndNot>(ret.m_block, a.m_block, b.m_block, ret.m_numBlocks);
+        return ret;
+    }
+
+    friend DynamicBitArray NotAndNot(const DynamicBitArray& __restrict a, const DynamicBitArray& __restrict b)
+    {
+        ASSERT(a.m_numBits == b.m_numBits);
+        DynamicBitArray ret(a.m_numBits, kUninitialized);
+        BinaryOp_Blocks<BitOpNotAndNot>(ret.m_block, a.m_block, b.m_block, ret.m_numBlocks);
+        return ret;
+    }
+
+    friend DynamicBitArray operator~(const DynamicBitArray& __restrict other)
+    {
+        DynamicBitArray ret(other.m_numBits, kUninitialized);
+        BinaryOp_Blocks<BitOpNot>(ret.m_block, other.m_block, other.m_block, ret.m_numBlocks);
+        return ret;
+    }
+
+    friend DynamicBitArray Blend(const DynamicBitArray& __restrict a, const DynamicBitArray& __restrict b, const DynamicBitArray& __restrict mask)
+    {
+        ASSERT(a.m_numBits == b.m_numBits);
+        ASSERT(a.m_numBits == mask.m_numBits);
+        DynamicBitArray ret(a.m_numBits, kUninitialized);
+        TernaryOp_Blocks<BitOpBlend>(ret.m_block, a.m_block, b.m_block, mask.m_block, ret.m_numBlocks);
+        return ret;
+    }
+
+    // Left shift. Shifting by NumBits() or more clears all bits.
+    friend DynamicBitArray operator<<(const DynamicBitArray& __restrict other, uint64_t s)
+    {
+        DynamicBitArray ret(other.m_numBits, kUninitialized);
+        ShiftLeft_Blocks(ret.m_block, other.m_block, other.m_numBits, s);
+        return ret;
+    }
+
+    // Right shift. Shifting by NumBits() or more clears all bits.
+    friend DynamicBitArray operator>>(const DynamicBitArray& __restrict other, uint64_t s)
+    {
+        DynamicBitArray ret(other.m_numBits, kUninitialized);
+        ShiftRight_Blocks(ret.m_block, other.m_block, other.m_numBits, s);
+        return ret;
+    }
+
+    // Rotate toward higher indices: bit i moves to bit (i + s) % NumBits().
+    friend DynamicBitArray RotateLeft(const DynamicBitArray& __restrict other, uint64_t s)
+    {
+        DynamicBitArray ret(other.m_numBits, kUninitialized);
+        if (other.m_numBits)
+            RotateLeft_Blocks(ret.m_block, other.m_block, other.m_numBits, s % other.m_numBits);
+        return ret;
+    }
+
+    // Rotate toward lower indices: bit i moves to bit (i - s) % NumBits().
+    friend DynamicBitArray RotateRight(const DynamicBitArray& __restrict other, uint64_t s)
+    {
+        DynamicBitArray ret(other.m_numBits, kUninitialized);
+        if (other.m_numBits)
+            RotateLeft_Blocks(ret.m_block, other.m_block, other.m_numBits, (other.m_numBits - s % other.m_numBits) % other.m_numBits);
+        return ret;
+    }
+
+private:
+    enum UninitializedTag { kUninitialized };
+
+    DynamicBitArray(uint64_t numBits, UninitializedTag) : m_capacity(0)
+    {
+        Reserve(NumBlocksFor(numBits));
+        m_numBits = numBits;
+        m_numBlocks = NumBlocksFor(numBits);
+    }
+
+    // Grow the allocation to hold at least numBlocks, keeping the blocks in use.
+    // Capacity is a whole number of 64-byte cache lines.
+    void Reserve(uint64_t numBlocks)
+    {
+        if (numBlocks <= m_capacity)
+            return;
+
+        const uint64_t capacity = (numBlocks + 7ULL) & ~7ULL;
+        uint64_t* block = static_cast<uint64_t*>(_mm_malloc(capacity << 3ULL, 64));
+        if (!block)
+            throw std::bad_alloc();
+        if (m_numBlocks)
+            memcpy(block, m_block, m_numBlocks << 3ULL);
+        _mm_free(m_block);
+        m_block = block;
+        m_capacity = capacity;
+    }
+
+    uint64_t m_capacity;
+};
+
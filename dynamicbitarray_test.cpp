@@ -0,0 +1,317 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#include <algorithm>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "dynamicbitarray.h"
+#include "testutil.h"
+
+#define ASSERT_TRUE(a) do { if (!(a)) { std::cerr << "FAIL: expected true for " << #a << ", got false\n"; __debugbreak(); } } while (0)
+#define ASSERT_FALSE(a) do { if ((a)) { std::cerr << "FAIL: expected false for " << #a << ", got true\n"; __debugbreak(); } } while (0)
+
+#define ASSERT_BIN_OP(a, b, op) do {                                                            \
+    const auto& va = (a);                                                                       \
+    const auto& vb = (b);                                                                       \
+    if (!(va op vb))                                                                            \
+    {                                                                                           \
+        std::cerr << "FAIL: expected " << #a << " " << #op << " " << #b << " (evaluates to ";   \
+        std::cerr << va << " " << #op << " " << vb << ")\n";                                    \
+        __debugbreak();                                                                         \
+    }                                                                                           \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_BIN_OP(a, b, ==)
+
+// Fill both arrays with the same pseudorandom blocks, including the excess bits of the last block.
+// Density 0 and 4 are all clear and all set; 1, 2, 3 are sparse, half, and dense.
+template <size_t n>
+static void FillRandom(BitArray<n>& v, DynamicBitArray& d, uint64_t& state, uint32_t density)
+{
+    uint64_t* p = reinterpret_cast<uint64_t*>(&v);
+    for (uint64_t i = 0; i < BitArray<n>::kNumBlocks; ++i)
+    {
+        const uint64_t r = SplitMix64(state);
+        const uint64_t sparse = r & SplitMix64(state) & SplitMix64(state) & SplitMix64(state);
+        p[i] = density == 0 ? 0ULL : density == 1 ? sparse : density == 2 ? r : density == 3 ? ~sparse : ~0ULL;
+        d.Blocks()[i] = p[i];
+    }
+}
+
+template <size_t n>
+static void CheckSame(const BitArray<n>& v, const DynamicBitArray& d)
+{
+    ASSERT_EQ(d.NumBits(), n);
+    for (uint64_t i = 0; i < n; ++i)
+        ASSERT_EQ(d.IsBitSet(i), v.IsBitSet(i));
+}
+
+// Every query against BitArray<n> holding the same bits.
+template <size_t n>
+static void TestQueries(uint64_t& state)
+{
+    BitArray<n> v;
+    DynamicBitArray d(n);
+    ASSERT_EQ(d.NumBlocks(), BitArray<n>::kNumBlocks);
+    ASSERT_EQ(uint64_t(reinterpret_cast<uintptr_t>(d.Blocks()) & 63ULL), 0ULL);
+
+    for (uint32_t density = 0; density <= 4; ++density)
+    {
+        FillRandom(v, d, state, density);
+
+        ASSERT_EQ(d.CountSetBits(), v.CountSetBits());
+        ASSERT_EQ(d.AreAllBitsSet(), v.AreAllBitsSet());
+        ASSERT_EQ(d.AreAllBitsClear(), v.AreAllBitsClear());
+        ASSERT_EQ(d.CountLeadingZeros(), v.CountLeadingZeros());
+        ASSERT_EQ(d.CountTrailingZeros(), v.CountTrailingZeros());
+        ASSERT_EQ(d.FirstSetBitIndex(), v.FirstSetBitIndex());
+        ASSERT_EQ(d.FirstClearBitIndex(), v.FirstClearBitIndex());
+        ASSERT_EQ(d.LastSetBitIndex(), v.LastSetBitIndex());
+        ASSERT_EQ(d.LastClearBitIndex(), v.LastClearBitIndex());
+
+        for (uint64_t i = 0; i < n; i += 1 + (i >> 4))
+        {
+            ASSERT_EQ(d.IsBitSet(i), v.IsBitSet(i));
+            ASSERT_EQ(d.PrevSetBitIndex(i), v.PrevSetBitIndex(i));
+            ASSERT_EQ(d.PrevClearBitIndex(i), v.PrevClearBitIndex(i));
+            ASSERT_EQ(d.NextSetBitIndex(i), v.NextSetBitIndex(i));
+            ASSERT_EQ(d.NextClearBitIndex(i), v.NextClearBitIndex(i));
+            ASSERT_EQ(d.NthSetBitIndex(i), v.NthSetBitIndex(i));
+            ASSERT_EQ(d.NthClearBitIndex(i), v.NthClearBitIndex(i));
+
+            const uint64_t j = i + (SplitMix64(state) % (n - i));
+            ASSERT_EQ(d.CountSetBitsInRange(i, j), v.CountSetBitsInRange(i, j));
+            ASSERT_EQ(d.AreAllBitsInRangeSet(i, j), v.AreAllBitsInRangeSet(i, j));
+            ASSERT_EQ(d.AreAllBitsInRangeClear(i, j), v.AreAllBitsInRangeClear(i, j));
+        }
+
+        for (uint64_t len = 1; len <= n; len += 1 + (len >> 2))
+        {
+            ASSERT_EQ(d.FirstBlockOfNSetBits(len), v.FirstBlockOfNSetBits(len));
+            ASSERT_EQ(d.FirstBlockOfNClearBits(len), v.FirstBlockOfNClearBits(len));
+            ASSERT_EQ(d.BestFitBlockOfNClearBits(len), v.BestFitBlockOfNClearBits(len));
+            for (uint64_t alignment = 1; alignment <= 128; alignment <<= 1)
+            {
+                ASSERT_EQ(d.FirstAlignedBlockOfNSetBits(len, alignment), v.FirstAlignedBlockOfNSetBits(len, alignment));
+                ASSERT_EQ(d.FirstAlignedBlockOfNClearBits(len, alignment), v.FirstAlignedBlockOfNClearBits(len, alignment));
+                ASSERT_EQ(d.BestFitAlignedBlockOfNClearBits(len, alignment), v.BestFitAlignedBlockOfNClearBits(len, alignment));
+            }
+        }
+        ASSERT_EQ(d.LargestClearRun().start, v.LargestClearRun().start);
+        ASSERT_EQ(d.LargestClearRun().length, v.LargestClearRun().length);
+
+        std::vector<uint64_t> expected;
+        for (uint64_t i : v)
+            expected.push_back(i);
+        std::vector<uint64_t> actual;
+        for (uint64_t i : d)
+            actual.push_back(i);
+        ASSERT_TRUE(actual == expected);
+
+        std::vector<uint32_t> decoded(d.CountSetBits());
+        ASSERT_EQ(d.DecodeSetBits(decoded.data()), decoded.size());
+        ASSERT_TRUE(std::equal(decoded.begin(), decoded.end(), expected.begin(), expected.end()));
+
+        std::vector<uint32_t> batched;
+        d.ForEachSetBitBatch([&](const uint32_t* indices, uint64_t count) { batched.insert(batched.end(), indices, indices + count); });
+        ASSERT_TRUE(batched == decoded);
+
+        std::vector<BitRun> runs((n + 1) / 2);
+        const uint64_t numRuns = d.EncodeRuns(runs.data());
+        ASSERT_EQ(numRuns, v.EncodeRuns(runs.data()));
+        uint64_t k = 0;
+        for (const BitRun r : d.SetRuns())
+        {
+            ASSERT_EQ(r.start, runs[k].start);
+            ASSERT_EQ(r.length, runs[k].length);
+            ++k;
+        }
+        ASSERT_EQ(k, numRuns);
+        const uint64_t numClearRuns = d.EncodeClearRuns(runs.data());
+        ASSERT_EQ(numClearRuns, v.EncodeClearRuns(runs.data()));
+        k = 0;
+        for (const BitRun r : d.ClearRuns())
+        {
+            ASSERT_EQ(r.start, runs[k].start);
+            ASSERT_EQ(r.length, runs[k].length);
+            ++k;
+        }
+        ASSERT_EQ(k, numClearRuns);
+    }
+}
+
+// Every mutating operation against BitArray<n> holding the same bits.
+template <size_t n>
+static void TestOps(uint64_t& state)
+{
+    BitArray<n> va, vb, vm;
+    DynamicBitArray a(n), b(n), m(n);
+    FillRandom(va, a, state, 2);
+    FillRandom(vb, b, state, 2);
+    FillRandom(vm, m, state, 2);
+
+    CheckSame(va | vb, a | b);
+    CheckSame(va ^ vb, a ^ b);
+    CheckSame(va & vb, a & b);
+    CheckSame(OrNot(va, vb), OrNot(a, b));
+    CheckSame(NotOrNot(va, vb), NotOrNot(a, b));
+    CheckSame(XorNot(va, vb), XorNot(a, b));
+    CheckSame(NotXorNot(va, vb), NotXorNot(a, b));
+    CheckSame(AndNot(va, vb), AndNot(a, b));
+    CheckSame(NotAndNot(va, vb), NotAndNot(a, b));
+    CheckSame(~va, ~a);
+    CheckSame(Blend(va, vb, vm), Blend(a, b, m));
+
+    va |= vb; a |= b; CheckSame(va, a);
+    va.NotOr(vm); a.NotOr(m); CheckSame(va, a);
+    va ^= vb; a ^= b; CheckSame(va, a);
+    va.NotXor(vm); a.NotXor(m); CheckSame(va, a);
+    va &= vm; a &= m; CheckSame(va, a);
+    va.NotAnd(vb); a.NotAnd(b); CheckSame(va, a);
+    va.Invert(); a.Invert(); CheckSame(va, a);
+    va.Blend(vb, vm); a.Blend(b, m); CheckSame(va, a);
+    va.ReverseBits(); a.ReverseBits(); CheckSame(va, a);
+
+    for (uint64_t s = 0; s < n + 70; s += 1 + (s >> 3))
+    {
+        CheckSame(va << s, a << s);
+        CheckSame(va >> s, a >> s);
+        CheckSame(RotateLeft(va, s), RotateLeft(a, s));
+        CheckSame(RotateRight(va, s), RotateRight(a, s));
+        va.RotateLeft(s); a.RotateLeft(s); CheckSame(va, a);
+        va.RotateRight(s + 3); a.RotateRight(s + 3); CheckSame(va, a);
+        va <<= s; a <<= s; CheckSame(va, a);
+        va >>= s; a >>= s; CheckSame(va, a);
+        FillRandom(va, a, state, 2);
+    }
+
+    const uint64_t i = SplitMix64(state) % n;
+    const uint64_t j = i + (SplitMix64(state) % (n - i));
+    va.SetBitsInRange(i, j); a.SetBitsInRange(i, j); CheckSame(va, a);
+    va.ClearBitsInRange(j / 2, j); a.ClearBitsInRange(j / 2, j); CheckSame(va, a);
+    va.XorBit(i); a.XorBit(i); CheckSame(va, a);
+
+    ASSERT_TRUE(a == a);
+    ASSERT_FALSE(a != a);
+    DynamicBitArray c = a;
+    c.XorBit(n - 1);
+    ASSERT_TRUE(a != c);
+}
+
+template <class F>
+static void SweepSizes(F func)
+{
+    func(std::integral_constant<size_t, 1>{});
+    func(std::integral_constant<size_t, 63>{});
+    func(std::integral_constant<size_t, 64>{});
+    func(std::integral_constant<size_t, 65>{});
+    func(std::integral_constant<size_t, 128>{});
+    func(std::integral_constant<size_t, 200>{});
+    func(std::integral_constant<size_t, 511>{});
+    func(std::integral_constant<size_t, 4161>{});
+}
+
+void TestDynamicBitArray()
+{
+    uint64_t state = 0x123456789ULL;
+
+    // construction
+    {
+        DynamicBitArray d;
+        ASSERT_EQ(d.NumBits(), 0ULL);
+        ASSERT_EQ(d.NumBlocks(), 0ULL);
+        ASSERT_TRUE(d.begin() == d.end());
+        ASSERT_TRUE(d == DynamicBitArray(0));
+        ASSERT_EQ(d.DecodeSetBits(nullptr), 0ULL);
+        ASSERT_EQ(d.EncodeRuns(nullptr), 0ULL);
+        ASSERT_TRUE(d.SetRuns().begin() == d.SetRuns().end());
+        d.ForEachSetBitBatch([](const uint32_t*, uint64_t) { ASSERT_TRUE(false); });
+
+        DynamicBitArray z(100);
+        ASSERT_TRUE(z.AreAllBitsClear());
+        DynamicBitArray o(100, true);
+        ASSERT_TRUE(o.AreAllBitsSet());
+        ASSERT_EQ(o.CountSetBits(), 100ULL);
+        ASSERT_TRUE(z != o);
+        ASSERT_TRUE(z != DynamicBitArray(101));
+    }
+
+    // copy, move
+    {
+        DynamicBitArray a(300);
+        a.SetBit(5);
+        a.SetBit(299);
+
+        DynamicBitArray b(a);
+        ASSERT_TRUE(a == b);
+        b.ClearBit(5);
+        ASSERT_TRUE(a.IsBitSet(5));
+
+        DynamicBitArray c(10);
+        c = a;
+        ASSERT_TRUE(c == a);
+
+        DynamicBitArray d(std::move(c));
+        ASSERT_TRUE(d == a);
+        ASSERT_EQ(c.NumBits(), 0ULL);
+
+        c = std::move(d);
+        ASSERT_TRUE(c == a);
+        ASSERT_EQ(d.NumBits(), 0ULL);
+    }
+
+    // View() and Span() see the array's storage, and assigning to a span repoints only the span.
+    {
+        DynamicBitArray a(300);
+        uint64_t other[5] = {};
+        BitSpan s = a.Span();
+        s.SetBit(9);
+        ASSERT_TRUE(a.IsBitSet(9));
+        ASSERT_EQ(a.View().Blocks(), a.Blocks());
+
+        s = BitSpan(other, 300);
+        s.SetBit(10);
+        ASSERT_FALSE(a.IsBitSet(10));
+        ASSERT_EQ(a.Span().Blocks(), a.Blocks());
+    }
+
+    // Resize
+    {
+        DynamicBitArray d(70, true);
+        d.Resize(10);
+        ASSERT_EQ(d.NumBits(), 10ULL);
+        ASSERT_EQ(d.NumBlocks(), 1ULL);
+        ASSERT_EQ(d.CountSetBits(), 10ULL);
+
+        // Bits beyond the old size come back clear, including the excess of the old last block.
+        d.Resize(5000);
+        ASSERT_EQ(d.CountSetBits(), 10ULL);
+        ASSERT_EQ(d.LastSetBitIndex(), 9ULL);
+        ASSERT_EQ(d.NextClearBitIndex(9), 10ULL);
+
+        d.SetBit(4999);
+        d.Resize(4999);
+        d.Resize(5000);
+        ASSERT_FALSE(d.IsBitSet(4999));
+        ASSERT_EQ(d.CountSetBits(), 10ULL);
+
+        DynamicBitArray e;
+        e.Resize(64);
+        ASSERT_TRUE(e.AreAllBitsClear());
+    }
+
+    // queries
+    SweepSizes([&](auto n) { TestQueries<decltype(n)::value>(state); });
+
+    // bitwise ops, shifts
+    SweepSizes([&](auto n) { TestOps<decltype(n)::value>(state); });
+}
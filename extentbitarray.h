@@ -0,0 +1,290 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#pragma once
+
+#include "bitarray.h"
+
+// Clear-run summary of a span of bits: the lengths of the run of clear bits at its start, the run at its end, and
+// the longest run anywhere in it.
+struct ExtentSummary
+{
+    uint32_t prefix;
+    uint32_t suffix;
+    uint32_t longest;
+    uint32_t length;
+};
+
+// Return the summary of span a followed by span b.
+[[nodiscard]] static constexpr ExtentSummary CombineExtentSummaries(const ExtentSummary& a, const ExtentSummary& b)
+{
+    const uint32_t across = a.suffix + b.prefix;
+    const uint32_t longest = a.longest > b.longest ? a.longest : b.longest;
+    return {
+        a.prefix == a.length ? a.length + b.prefix : a.prefix,
+        b.suffix == b.length ? b.length + a.suffix : b.suffix,
+        across > longest ? across : longest,
+        a.length + b.length,
+    };
+}
+
+// BitArray with a cached summary of its runs of clear bits, so that LargestClearRunLength() is O(1), and
+// LargestClearRun() and FirstBlockOfNClearBits() take O(log n) instead of walking every block. Meant for
+// allocator free maps queried for their largest extent after every change.
+//
+// The summary is a complete binary tree over the array, one leaf per 512-bit line, each node holding the
+// ExtentSummary of the bits below it. A search descends from the root toward the leftmost node whose summary
+// admits the run, and then walks the bits of a single line. The tree costs about half the size of the array.
+//
+// Updates recompute the summary of each line they touch, then the nodes above it: O(log n) per line.
+template <uint64_t kNBits>
+class ExtentBitArray
+{
+    static_assert(kNBits < (1ULL << 32ULL), "Run lengths must fit in 32 bits");
+
+public:
+    static constexpr uint64_t kNumBits = kNBits;
+    static constexpr uint64_t kNumBlocks = BitArray<kNBits>::kNumBlocks;
+
+    // All bits start clear.
+    ExtentBitArray()
+    {
+        ClearAll();
+    }
+
+    // Start with the bits of v.
+    explicit ExtentBitArray(const BitArray<kNumBits>& v)
+    {
+        Assign(v);
+    }
+
+    // Replace the bits with those of v, rebuilding the summary.
+    void Assign(const BitArray<kNumBits>& v)
+    {
+        m_bits = v;
+        Rebuild();
+    }
+
+    // Return the array itself, for the rest of the BitArray queries.
+    const BitArray<kNumBits>& Bits() const
+    {
+        return m_bits;
+    }
+
+    // Clear all bits.
+    void ClearAll()
+    {
+        m_bits.ClearAll();
+        Rebuild();
+    }
+
+    // Set all bits.
+    void SetAll()
+    {
+        m_bits.SetAll();
+        Rebuild();
+    }
+
+    // Check if a bit is set.
+    bool IsBitSet(uint64_t index) const
+    {
+        return m_bits.IsBitSet(index);
+    }
+
+    // Set a bit.
+    void SetBit(uint64_t index)
+    {
+        m_bits.SetBit(index);
+        UpdateLine(index >> kLineShift);
+    }
+
+    // Clear a bit.
+    void ClearBit(uint64_t index)
+    {
+        m_bits.ClearBit(index);
+        UpdateLine(index >> kLineShift);
+    }
+
+    // Assign a value to a single bit.
+    void AssignBit(uint64_t index, bool value)
+    {
+        m_bits.AssignBit(index, value);
+        UpdateLine(index >> kLineShift);
+    }
+
+    // Set all bits between indices [a, b], inclusive.
+    void SetBitsInRange(uint64_t a, uint64_t b)
+    {
+        m_bits.SetBitsInRange(a, b);
+        UpdateLines(a >> kLineShift, b >> kLineShift);
+    }
+
+    // Clear all bits between indices [a, b], inclusive.
+    void ClearBitsInRange(uint64_t a, uint64_t b)
+    {
+        m_bits.ClearBitsInRange(a, b);
+        UpdateLines(a >> kLineShift, b >> kLineShift);
+    }
+
+    // Return the length of the longest run of clear bits, or 0 if all bits are set. O(1).
+    uint64_t LargestClearRunLength() const
+    {
+        return m_tree[1].longest;
+    }
+
+    // Return the longest run of clear bits, the lowest-index one if there is a tie, or { ~0ULL, 0 } if all bits
+    // are set.
+    BitRun LargestClearRun() const
+    {
+        const uint64_t n = m_tree[1].longest;
+        if (n == 0)
+            return { ~0ULL, 0ULL };
+
+        uint64_t iNode = 1;
+        uint64_t iBit = 0;
+        while (iNode < kNumLeaves)
+        {
+            const ExtentSummary& left = m_tree[2 * iNode];
+            const ExtentSummary& right = m_tree[2 * iNode + 1];
+            if (left.longest == n)
+            {
+                iNode = 2 * iNode;
+            }
+            else if (left.suffix + right.prefix == n)
+            {
+                return { iBit + left.length - left.suffix, n };
+            }
+            else
+            {
+                iBit += left.length;
+                iNode = 2 * iNode + 1;
+            }
+        }
+
+        const BitRun run = LargestRun_Blocks(m_bits.Blocks() + (iBit >> 6ULL), m_tree[iNode].length, ~0ULL);
+        return { iBit + run.start, run.length };
+    }
+
+    // Return the index of the start of the first block of n consecutive clear bits, or ~0ULL if there is no such
+    // block. The same result as Bits().FirstBlockOfNClearBits(n).
+    uint64_t FirstBlockOfNClearBits(uint64_t n) const
+    {
+        ASSERT(n != 0);
+
+        if (m_tree[1].longest < n)
+            return ~0ULL;
+
+        uint64_t iNode = 1;
+        uint64_t iBit = 0;
+        while (iNode < kNumLeaves)
+        {
+            const ExtentSummary& left = m_tree[2 * iNode];
+            const ExtentSummary& right = m_tree[2 * iNode + 1];
+            if (m_tree[iNode].prefix >= n)
+                return iBit;
+
+            if (left.longest >= n)
+            {
+                iNode = 2 * iNode;
+            }
+            else if (left.suffix + right.prefix >= n)
+            {
+                return iBit + left.length - left.suffix;
+            }
+            else
+            {
+                iBit += left.length;
+                iNode = 2 * iNode + 1;
+            }
+        }
+
+        // The run lies within this line.
+        const uint64_t* p = m_bits.Blocks() + (iBit >> 6ULL);
+        const uint64_t numBits = m_tree[iNode].length;
+        uint64_t end = 0;
+        for (uint64_t i = NextRun_Blocks(p, numBits, 0, ~0ULL, end); i < numBits; i = NextRun_Blocks(p, numBits, end, ~0ULL, end))
+        {
+            if (end - i >= n)
+                return iBit + i;
+        }
+
+        ASSERT(false);
+        return ~0ULL;
+    }
+
+private:
+    static constexpr uint64_t kLineShift = 9;
+    static constexpr uint64_t kLineBits = 1ULL << kLineShift;
+    static constexpr uint64_t kNumLines = (kNumBits + kLineBits - 1ULL) >> kLineShift;
+
+    [[nodiscard]] static constexpr uint64_t NumLeavesFor(uint64_t numLines)
+    {
+        uint64_t n = 1;
+        while (n < numLines)
+            n <<= 1ULL;
+        return n;
+    }
+
+    // Leaves past kNumLines are empty spans, which combine as nothing.
+    static constexpr uint64_t kNumLeaves = NumLeavesFor(kNumLines);
+
+    // Return the summary of line iLine, from its bits. One pass over its runs of clear bits.
+    ExtentSummary LineSummary(uint64_t iLine) const
+    {
+        const uint64_t iBit = iLine << kLineShift;
+        const uint64_t numBits = kNumBits - iBit < kLineBits ? kNumBits - iBit : kLineBits;
+        const uint64_t* p = m_bits.Blocks() + (iBit >> 6ULL);
+
+        ExtentSummary s = { 0U, 0U, 0U, uint32_t(numBits) };
+        uint64_t end = 0;
+        for (uint64_t i = NextRun_Blocks(p, numBits, 0, ~0ULL, end); i < numBits; i = NextRun_Blocks(p, numBits, end, ~0ULL, end))
+        {
+            const uint32_t length = uint32_t(end - i);
+            s.prefix = i == 0 ? length : s.prefix;
+            s.suffix = end == numBits ? length : s.suffix;
+            s.longest = length > s.longest ? length : s.longest;
+        }
+        return s;
+    }
+
+    void UpdateLine(uint64_t iLine)
+    {
+        uint64_t iNode = kNumLeaves + iLine;
+        m_tree[iNode] = LineSummary(iLine);
+        for (iNode >>= 1ULL; iNode; iNode >>= 1ULL)
+            m_tree[iNode] = CombineExtentSummaries(m_tree[2 * iNode], m_tree[2 * iNode + 1]);
+    }
+
+    // Update lines [iFirst, iLast], then each node above them once, level by level.
+    void UpdateLines(uint64_t iFirst, uint64_t iLast)
+    {
+        for (uint64_t iLine = iFirst; iLine <= iLast; ++iLine)
+            m_tree[kNumLeaves + iLine] = LineSummary(iLine);
+
+        for (uint64_t lo = (kNumLeaves + iFirst) >> 1ULL, hi = (kNumLeaves + iLast) >> 1ULL; lo; lo >>= 1ULL, hi >>= 1ULL)
+        {
+            for (uint64_t iNode = lo; iNode <= hi; ++iNode)
+                m_tree[iNode] = CombineExtentSummaries(m_tree[2 * iNode], m_tree[2 * iNode + 1]);
+        }
+    }
+
+    void Rebuild()
+    {
+        for (uint64_t iLine = 0; iLine < kNumLeaves; ++iLine)
+            m_tree[kNumLeaves + iLine] = iLine < kNumLines ? LineSummary(iLine) : ExtentSummary{};
+
+        for (uint64_t iNode = kNumLeaves - 1; iNode; --iNode)
+            m_tree[iNode] = CombineExtentSummaries(m_tree[2 * iNode], m_tree[2 * iNode + 1]);
+    }
+
+    BitArray<kNumBits> m_bits;
+
+    // Node 1 is the root, the children of node i are 2i and 2i + 1, and the leaves start at kNumLeaves.
+    ExtentSummary m_tree[2 * kNumLeaves];
+};
@@ -0,0 +1,195 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "extentbitarray.h"
+#include "testutil.h"
+
+#define ASSERT_TRUE(a) do { if (!(a)) { std::cerr << "FAIL: expected true for " << #a << ", got false\n"; __debugbreak(); } } while (0)
+
+#define ASSERT_BIN_OP(a, b, op) do {                                                            \
+    const auto& va = (a);                                                                       \
+    const auto& vb = (b);                                                                       \
+    if (!(va op vb))                                                                            \
+    {                                                                                           \
+        std::cerr << "FAIL: expected " << #a << " " << #op << " " << #b << " (evaluates to ";   \
+        std::cerr << va << " " << #op << " " << vb << ")\n";                                    \
+        __debugbreak();                                                                         \
+    }                                                                                           \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_BIN_OP(a, b, ==)
+
+// Check the summary-driven queries against a scan of the bits one at a time. FirstBlockOfNClearBits(len) only
+// changes where len passes the length of the longest run so far, so checking it on both sides of each such
+// length covers every answer it can give.
+template <uint64_t n>
+static void CheckQueries(const ExtentBitArray<n>& e)
+{
+    BitRun largest = { ~0ULL, 0ULL };
+    std::vector<BitRun> records;
+    uint64_t start = 0;
+    for (uint64_t i = 0; i <= n; ++i)
+    {
+        if (i < n && !e.IsBitSet(i))
+            continue;
+
+        if (i - start > largest.length)
+        {
+            largest = { start, i - start };
+            records.push_back(largest);
+        }
+        start = i + 1;
+    }
+
+    ASSERT_EQ(e.LargestClearRunLength(), largest.length);
+    ASSERT_EQ(e.LargestClearRun().start, largest.start);
+    ASSERT_EQ(e.LargestClearRun().length, largest.length);
+
+    uint64_t shorter = 0;
+    for (const BitRun& r : records)
+    {
+        ASSERT_EQ(e.FirstBlockOfNClearBits(shorter + 1), r.start);
+        ASSERT_EQ(e.FirstBlockOfNClearBits(r.length), r.start);
+        shorter = r.length;
+    }
+    ASSERT_EQ(e.FirstBlockOfNClearBits(largest.length + 1), ~0ULL);
+}
+
+// Every run with both ends at or next to a line boundary or an end of the array, cleared in a full array or set in
+// an empty one, and every pair of such clear runs, over three lines, the last one partial.
+static void TestRunsAtLineBoundaries()
+{
+    constexpr uint64_t n = 1300;
+    const uint64_t ends[] = { 0, 1, 63, 64, 510, 511, 512, 513, 1022, 1023, 1024, 1025, 1298, 1299 };
+    const std::unique_ptr<ExtentBitArray<n>> e = std::make_unique<ExtentBitArray<n>>();
+    for (const uint64_t a : ends)
+    {
+        for (const uint64_t b : ends)
+        {
+            if (b < a)
+                continue;
+
+            e->ClearAll();
+            e->SetBitsInRange(a, b);
+            CheckQueries(*e);
+
+            e->SetAll();
+            e->ClearBitsInRange(a, b);
+            CheckQueries(*e);
+
+            for (const uint64_t c : ends)
+            {
+                for (const uint64_t d : ends)
+                {
+                    if (c <= b + 1 || d < c)
+                        continue;
+
+                    e->SetAll();
+                    e->ClearBitsInRange(a, b);
+                    e->ClearBitsInRange(c, d);
+                    CheckQueries(*e);
+                }
+            }
+        }
+    }
+}
+
+// Return a random index within 3 of a line boundary, or of the end of the array.
+template <uint64_t n>
+static uint64_t NearLineBoundary(uint64_t& state)
+{
+    const uint64_t i = (SplitMix64(state) % (n / 512 + 1)) * 512 + SplitMix64(state) % 7 - 3;
+    return i < n ? i : n - 1 - SplitMix64(state) % (n < 4 ? n : 4);
+}
+
+// Random runs set and cleared between indices near line boundaries, so that they cross lines and split or join
+// runs that do, checked after every update.
+template <uint64_t n>
+static void TestRandomRuns(uint64_t numUpdates, uint64_t& state)
+{
+    const std::unique_ptr<ExtentBitArray<n>> e = std::make_unique<ExtentBitArray<n>>();
+    const std::unique_ptr<BitArray<n>> v = std::make_unique<BitArray<n>>();
+    v->ClearAll();
+    CheckQueries(*e);
+
+    for (uint64_t k = 0; k < numUpdates; ++k)
+    {
+        uint64_t a = NearLineBoundary<n>(state);
+        uint64_t b = NearLineBoundary<n>(state);
+        if (a > b)
+            std::swap(a, b);
+
+        switch (SplitMix64(state) % 4)
+        {
+        case 0: e->SetBitsInRange(a, b); v->SetBitsInRange(a, b); break;
+        case 1: e->ClearBitsInRange(a, b); v->ClearBitsInRange(a, b); break;
+        case 2: e->SetBit(a); v->SetBit(a); break;
+        default: e->AssignBit(b, false); v->AssignBit(b, false); break;
+        }
+
+        ASSERT_TRUE(e->Bits() == *v);
+        CheckQueries(*e);
+    }
+
+    // From an existing array, with garbage excess bits.
+    for (uint64_t i = 0; i < BitArray<n>::kNumBlocks; ++i)
+        v->Blocks()[i] = SplitMix64(state) | SplitMix64(state);
+    e->Assign(*v);
+    ASSERT_TRUE(e->Bits() == *v);
+    CheckQueries(*e);
+}
+
+void TestExtentBitArray()
+{
+    uint64_t state = 0xE87E17ULL;
+
+    TestRunsAtLineBoundaries();
+
+    // one line
+    TestRandomRuns<1>(100, state);
+    TestRandomRuns<63>(500, state);
+    TestRandomRuns<64>(500, state);
+    TestRandomRuns<512>(500, state);
+
+    // several, with a partial last line and empty leaves
+    TestRandomRuns<513>(1000, state);
+    TestRandomRuns<2500>(2000, state);
+    TestRandomRuns<100000>(200, state);
+    TestRandomRuns<(1ULL << 20) + 7>(20, state);
+
+    // A run crossing many lines, found without walking them, and the largest run moving as it is split.
+    {
+        constexpr uint64_t n = 1ULL << 20;
+        const std::unique_ptr<ExtentBitArray<n>> e = std::make_unique<ExtentBitArray<n>>();
+        ASSERT_EQ(e->LargestClearRunLength(), n);
+        e->SetAll();
+        ASSERT_EQ(e->LargestClearRunLength(), 0ULL);
+        ASSERT_EQ(e->LargestClearRun().start, ~0ULL);
+        ASSERT_EQ(e->FirstBlockOfNClearBits(1), ~0ULL);
+
+        e->ClearBitsInRange(1000, 500000);
+        e->ClearBitsInRange(600000, 600099);
+        ASSERT_EQ(e->LargestClearRun().start, 1000ULL);
+        ASSERT_EQ(e->LargestClearRunLength(), 499001ULL);
+        ASSERT_EQ(e->FirstBlockOfNClearBits(499001), 1000ULL);
+        ASSERT_EQ(e->FirstBlockOfNClearBits(499002), ~0ULL);
+
+        e->SetBit(250000);
+        ASSERT_EQ(e->LargestClearRun().start, 250001ULL);
+        ASSERT_EQ(e->LargestClearRunLength(), 250000ULL);
+        ASSERT_EQ(e->FirstBlockOfNClearBits(249000), 1000ULL);
+        ASSERT_EQ(e->FirstBlockOfNClearBits(249001), 250001ULL);
+        ASSERT_EQ(e->FirstBlockOfNClearBits(250001), ~0ULL);
+    }
+}
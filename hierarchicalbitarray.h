@@ -0,0 +1,304 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#pragma once
+
+#include "bitarray.h"
+
+// Shape of the summaries: the number of bits in each level, and where each level's words start.
+struct HierarchicalBitArrayLevels
+{
+    // 64^11 blocks is past any addressable array.
+    static constexpr uint64_t kMaxLevels = 11;
+
+    uint64_t numLevels;
+    uint64_t numBits[kMaxLevels];
+    uint64_t offset[kMaxLevels];
+    uint64_t numWords;
+};
+
+[[nodiscard]] static constexpr HierarchicalBitArrayLevels MakeHierarchicalBitArrayLevels(uint64_t numBlocks)
+{
+    HierarchicalBitArrayLevels levels = {};
+    uint64_t numBits = numBlocks;
+    for (;;)
+    {
+        const uint64_t numWords = (numBits + 63ULL) >> 6ULL;
+        levels.numBits[levels.numLevels] = numBits;
+        levels.offset[levels.numLevels] = levels.numWords;
+        levels.numWords += numWords;
+        ++levels.numLevels;
+        if (numWords == 1)
+            return levels;
+        numBits = numWords;
+    }
+}
+
+// BitArray with summary levels above it, so that first/next set and clear bit searches take O(log64 n)
+// instead of walking every block. Meant for large, sparse (or nearly full) maps searched often: timer
+// wheels, ID allocators.
+//
+// Level 0 of each summary has one bit per block of the array, level 1 one bit per word of level 0, and so
+// on up to a single word. The non-empty summary marks blocks with any bit set, the non-full summary blocks
+// with any bit clear. A search climbs until a word has a candidate past the start, then descends, touching
+// at most one word per level each way. A 16M-bit array has three levels; together the summaries cost about 3%
+// on top of the array.
+//
+// Updates keep the summaries current, and stop climbing at the first level whose word doesn't change
+// between zero and nonzero, so a single-bit update is O(1) in the common case.
+template <uint64_t kNBits>
+class HierarchicalBitArray
+{
+public:
+    static constexpr uint64_t kNumBits = kNBits;
+    static constexpr uint64_t kNumBlocks = BitArray<kNBits>::kNumBlocks;
+
+    // All bits start clear.
+    HierarchicalBitArray()
+    {
+        ClearAll();
+    }
+
+    // Start with the bits of v.
+    explicit HierarchicalBitArray(const BitArray<kNumBits>& v)
+    {
+        Assign(v);
+    }
+
+    // Replace the bits with those of v, rebuilding the summaries.
+    void Assign(const BitArray<kNumBits>& v)
+    {
+        m_bits = v;
+        m_bits.Blocks()[kNumBlocks - 1] &= LastBlockMask();
+        Rebuild();
+    }
+
+    // Return the array itself, for the rest of the BitArray queries.
+    const BitArray<kNumBits>& Bits() const
+    {
+        return m_bits;
+    }
+
+    // Clear all bits.
+    void ClearAll()
+    {
+        m_bits.ClearAll();
+        Rebuild();
+    }
+
+    // Set all bits.
+    void SetAll()
+    {
+        m_bits.SetAll();
+        m_bits.Blocks()[kNumBlocks - 1] &= LastBlockMask();
+        Rebuild();
+    }
+
+    // Check if a bit is set.
+    bool IsBitSet(uint64_t index) const
+    {
+        return m_bits.IsBitSet(index);
+    }
+
+    // Set a bit.
+    void SetBit(uint64_t index)
+    {
+        m_bits.SetBit(index);
+        UpdateSummaries(index >> 6ULL);
+    }
+
+    // Clear a bit.
+    void ClearBit(uint64_t index)
+    {
+        m_bits.ClearBit(index);
+        UpdateSummaries(index >> 6ULL);
+    }
+
+    // Invert a bit.
+    void XorBit(uint64_t index)
+    {
+        m_bits.XorBit(index);
+        UpdateSummaries(index >> 6ULL);
+    }
+
+    // Assign a value to a single bit.
+    void AssignBit(uint64_t index, bool value)
+    {
+        m_bits.AssignBit(index, value);
+        UpdateSummaries(index >> 6ULL);
+    }
+
+    // Set all bits between indices [a, b], inclusive.
+    void SetBitsInRange(uint64_t a, uint64_t b)
+    {
+        m_bits.SetBitsInRange(a, b);
+        for (uint64_t iBlock = a >> 6ULL; iBlock <= b >> 6ULL; ++iBlock)
+            UpdateSummaries(iBlock);
+    }
+
+    // Clear all bits between indices [a, b], inclusive.
+    void ClearBitsInRange(uint64_t a, uint64_t b)
+    {
+        m_bits.ClearBitsInRange(a, b);
+        for (uint64_t iBlock = a >> 6ULL; iBlock <= b >> 6ULL; ++iBlock)
+            UpdateSummaries(iBlock);
+    }
+
+    // Return true if all bits are clear. O(1).
+    bool AreAllBitsClear() const
+    {
+        return !m_nonEmpty[kLevels.offset[kLevels.numLevels - 1]];
+    }
+
+    // Return true if all bits are set. O(1).
+    bool AreAllBitsSet() const
+    {
+        return !m_nonFull[kLevels.offset[kLevels.numLevels - 1]];
+    }
+
+    // Return the index of the first (trailing; lowest index) set bit, or ~0ULL if all bits are clear.
+    uint64_t FirstSetBitIndex() const
+    {
+        const uint64_t iBlock = NextSummaryBit(m_nonEmpty, 0);
+        return iBlock == ~0ULL ? ~0ULL : (iBlock << 6ULL) + FirstSetBitIndex_U64(m_bits.Blocks()[iBlock]);
+    }
+
+    // Return the index of the first (trailing; lowest index) clear bit, or ~0ULL if all bits are set.
+    uint64_t FirstClearBitIndex() const
+    {
+        const uint64_t iBlock = NextSummaryBit(m_nonFull, 0);
+        return iBlock == ~0ULL ? ~0ULL : (iBlock << 6ULL) + FirstClearBitIndex_U64(m_bits.Blocks()[iBlock]);
+    }
+
+    // Return the index of the next-highest-index set bit after and not including i, or ~0ULL if there are no set
+    // bits after the ith bit.
+    uint64_t NextSetBitIndex(uint64_t i) const
+    {
+        ASSERT(i < kNumBits);
+
+        const uint64_t iBlock = i >> 6ULL;
+        if (const uint64_t block = m_bits.Blocks()[iBlock] & ((~1ULL) << (i & 63ULL)))
+            return (iBlock << 6ULL) + FirstSetBitIndex_U64(block);
+
+        const uint64_t iNext = NextSummaryBit(m_nonEmpty, iBlock + 1);
+        return iNext == ~0ULL ? ~0ULL : (iNext << 6ULL) + FirstSetBitIndex_U64(m_bits.Blocks()[iNext]);
+    }
+
+    // Return the index of the next-highest-index clear bit after and not including i, or ~0ULL if there are no clear
+    // bits after the ith bit.
+    uint64_t NextClearBitIndex(uint64_t i) const
+    {
+        ASSERT(i < kNumBits);
+
+        const uint64_t iBlock = i >> 6ULL;
+        const uint64_t valid = iBlock == kNumBlocks - 1 ? LastBlockMask() : ~0ULL;
+        if (const uint64_t block = ~m_bits.Blocks()[iBlock] & ((~1ULL) << (i & 63ULL)) & valid)
+            return (iBlock << 6ULL) + FirstSetBitIndex_U64(block);
+
+        const uint64_t iNext = NextSummaryBit(m_nonFull, iBlock + 1);
+        return iNext == ~0ULL ? ~0ULL : (iNext << 6ULL) + FirstClearBitIndex_U64(m_bits.Blocks()[iNext]);
+    }
+
+    // Mask of the valid (in-use) bits of the last block.
+    static constexpr uint64_t LastBlockMask()
+    {
+        return BitArray<kNumBits>::LastBlockMask();
+    }
+
+private:
+    static constexpr HierarchicalBitArrayLevels kLevels = MakeHierarchicalBitArrayLevels(kNumBlocks);
+
+    // Set or clear the summary bit of block iBlock at level 0, then carry the change up as far as a
+    // word changes between zero and nonzero.
+    static void UpdateSummary(uint64_t* summary, uint64_t iBlock, bool value)
+    {
+        uint64_t i = iBlock;
+        for (uint64_t level = 0; level < kLevels.numLevels; ++level)
+        {
+            uint64_t& word = summary[kLevels.offset[level] + (i >> 6ULL)];
+            const uint64_t old = word;
+            word = AssignBit_U64(old, i & 63ULL, value);
+            if (!old == !word)
+                return;
+            value = word != 0ULL;
+            i >>= 6ULL;
+        }
+    }
+
+    void UpdateSummaries(uint64_t iBlock)
+    {
+        const uint64_t block = m_bits.Blocks()[iBlock];
+        const uint64_t invalid = iBlock == kNumBlocks - 1 ? ~LastBlockMask() : 0ULL;
+        UpdateSummary(m_nonEmpty, iBlock, block != 0ULL);
+        UpdateSummary(m_nonFull, iBlock, ~(block | invalid) != 0ULL);
+    }
+
+    void Rebuild()
+    {
+        for (uint64_t i = 0; i < kLevels.numWords; ++i)
+        {
+            m_nonEmpty[i] = 0ULL;
+            m_nonFull[i] = 0ULL;
+        }
+
+        // Fill level 0 directly, then each level from the one below.
+        for (uint64_t iBlock = 0; iBlock < kNumBlocks; ++iBlock)
+        {
+            const uint64_t block = m_bits.Blocks()[iBlock];
+            const uint64_t invalid = iBlock == kNumBlocks - 1 ? ~LastBlockMask() : 0ULL;
+            m_nonEmpty[iBlock >> 6ULL] |= uint64_t(block != 0ULL) << (iBlock & 63ULL);
+            m_nonFull[iBlock >> 6ULL] |= uint64_t(~(block | invalid) != 0ULL) << (iBlock & 63ULL);
+        }
+
+        for (uint64_t level = 1; level < kLevels.numLevels; ++level)
+        {
+            for (uint64_t i = 0; i < kLevels.numBits[level]; ++i)
+            {
+                const uint64_t below = kLevels.offset[level - 1] + i;
+                uint64_t* const p = m_nonEmpty + kLevels.offset[level] + (i >> 6ULL);
+                uint64_t* const q = m_nonFull + kLevels.offset[level] + (i >> 6ULL);
+                *p |= uint64_t(m_nonEmpty[below] != 0ULL) << (i & 63ULL);
+                *q |= uint64_t(m_nonFull[below] != 0ULL) << (i & 63ULL);
+            }
+        }
+    }
+
+    // Return the index of the first level-0 summary bit set at or after i, or ~0ULL if there is none.
+    static uint64_t NextSummaryBit(const uint64_t* summary, uint64_t i)
+    {
+        // Climb while the rest of the current word is empty.
+        uint64_t level = 0;
+        uint64_t word;
+        for (;;)
+        {
+            if (i >= kLevels.numBits[level])
+                return ~0ULL;
+
+            word = summary[kLevels.offset[level] + (i >> 6ULL)] & (~0ULL << (i & 63ULL));
+            if (word)
+                break;
+
+            if (++level == kLevels.numLevels)
+                return ~0ULL;
+            i = (i >> 6ULL) + 1;
+        }
+
+        // Descend, taking the first set bit at each level.
+        i = (i & ~63ULL) + FirstSetBitIndex_U64(word);
+        while (level-- > 0)
+            i = (i << 6ULL) + FirstSetBitIndex_U64(summary[kLevels.offset[level] + i]);
+
+        return i;
+    }
+
+    // Excess bits of the last block are kept clear.
+    BitArray<kNumBits> m_bits;
+    uint64_t m_nonEmpty[kLevels.numWords];
+    uint64_t m_nonFull[kLevels.numWords];
+};
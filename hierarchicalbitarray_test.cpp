@@ -0,0 +1,175 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#include <iostream>
+#include <memory>
+
+#include "hierarchicalbitarray.h"
+#include "testutil.h"
+
+#define ASSERT_TRUE(a) do { if (!(a)) { std::cerr << "FAIL: expected true for " << #a << ", got false\n"; __debugbreak(); } } while (0)
+
+#define ASSERT_BIN_OP(a, b, op) do {                                                            \
+    const auto& va = (a);                                                                       \
+    const auto& vb = (b);                                                                       \
+    if (!(va op vb))                                                                            \
+    {                                                                                           \
+        std::cerr << "FAIL: expected " << #a << " " << #op << " " << #b << " (evaluates to ";   \
+        std::cerr << va << " " << #op << " " << vb << ")\n";                                    \
+        __debugbreak();                                                                         \
+    }                                                                                           \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_BIN_OP(a, b, ==)
+
+// Every search agrees with the plain BitArray, from the start and from random points.
+template <uint64_t n>
+static void CheckSearches(const HierarchicalBitArray<n>& h, const BitArray<n>& v, uint64_t& state)
+{
+    ASSERT_TRUE(h.Bits() == v);
+    ASSERT_EQ(h.AreAllBitsClear(), v.AreAllBitsClear());
+    ASSERT_EQ(h.AreAllBitsSet(), v.AreAllBitsSet());
+    ASSERT_EQ(h.FirstSetBitIndex(), v.FirstSetBitIndex());
+    ASSERT_EQ(h.FirstClearBitIndex(), v.FirstClearBitIndex());
+
+    for (uint64_t k = 0; k < 16; ++k)
+    {
+        const uint64_t i = k == 0 ? n - 1 : SplitMix64(state) % n;
+        ASSERT_EQ(h.NextSetBitIndex(i), v.NextSetBitIndex(i));
+        ASSERT_EQ(h.NextClearBitIndex(i), v.NextClearBitIndex(i));
+    }
+}
+
+// Random updates at several densities of set bits (out of 64), checked against BitArray<n> doing the same.
+template <uint64_t n>
+static void TestRandomUpdates(uint64_t& state)
+{
+    const std::unique_ptr<HierarchicalBitArray<n>> h = std::make_unique<HierarchicalBitArray<n>>();
+    const std::unique_ptr<BitArray<n>> v = std::make_unique<BitArray<n>>();
+    v->ClearAll();
+    CheckSearches(*h, *v, state);
+
+    for (const uint64_t density : { 1ULL, 32ULL, 63ULL })
+    {
+        // Start from all clear for sparse, all set for dense.
+        if (density < 32)
+        {
+            h->ClearAll();
+            v->ClearAll();
+        }
+        else if (density > 32)
+        {
+            h->SetAll();
+            v->SetAll();
+        }
+        CheckSearches(*h, *v, state);
+
+        for (uint64_t k = 0; k < 2000; ++k)
+        {
+            const uint64_t i = SplitMix64(state) % n;
+            const bool value = SplitMix64(state) % 64 < density;
+            switch (SplitMix64(state) % 8)
+            {
+            case 0: h->SetBit(i); v->SetBit(i); break;
+            case 1: h->ClearBit(i); v->ClearBit(i); break;
+            case 2: h->XorBit(i); v->XorBit(i); break;
+            case 7:
+            {
+                const uint64_t j = i + SplitMix64(state) % (n - i < 300 ? n - i : 300);
+                if (value)
+                {
+                    h->SetBitsInRange(i, j);
+                    v->SetBitsInRange(i, j);
+                }
+                else
+                {
+                    h->ClearBitsInRange(i, j);
+                    v->ClearBitsInRange(i, j);
+                }
+                break;
+            }
+            default: h->AssignBit(i, value); v->AssignBit(i, value); break;
+            }
+
+            if (k % 97 == 0)
+                CheckSearches(*h, *v, state);
+        }
+        CheckSearches(*h, *v, state);
+    }
+
+    // Walk all set bits, then all clear bits, of a sparse map.
+    {
+        BitArray<n>& r = *v;
+        for (uint64_t i = 0; i < BitArray<n>::kNumBlocks; ++i)
+            r.Blocks()[i] = SplitMix64(state) & SplitMix64(state) & SplitMix64(state) & SplitMix64(state) & SplitMix64(state);
+        h->Assign(r);
+        CheckSearches(*h, r, state);
+
+        uint64_t count = 0;
+        for (uint64_t i = h->FirstSetBitIndex(); i != ~0ULL; i = h->NextSetBitIndex(i))
+        {
+            ASSERT_TRUE(r.IsBitSet(i));
+            ++count;
+        }
+        ASSERT_EQ(count, r.CountSetBits());
+
+        r = ~r;
+        h->Assign(r);
+        count = 0;
+        for (uint64_t i = h->FirstClearBitIndex(); i != ~0ULL; i = h->NextClearBitIndex(i))
+        {
+            ASSERT_TRUE(!r.IsBitSet(i));
+            ++count;
+        }
+        ASSERT_EQ(count, n - r.CountSetBits());
+    }
+}
+
+void TestHierarchicalBitArray()
+{
+    uint64_t state = 0x41E7A7C1ULL;
+
+    // one level
+    TestRandomUpdates<1>(state);
+    TestRandomUpdates<63>(state);
+    TestRandomUpdates<64>(state);
+    TestRandomUpdates<65>(state);
+    TestRandomUpdates<4096>(state);
+
+    // two levels
+    TestRandomUpdates<4097>(state);
+    TestRandomUpdates<100000>(state);
+    TestRandomUpdates<262144>(state);
+
+    // three levels
+    TestRandomUpdates<262145>(state);
+    TestRandomUpdates<(1ULL << 22) + 3>(state);
+
+    // A lone bit at either end of a large map, and a lone clear bit in a full one.
+    {
+        constexpr uint64_t n = 1ULL << 22;
+        const std::unique_ptr<HierarchicalBitArray<n>> h = std::make_unique<HierarchicalBitArray<n>>();
+        h->SetBit(n - 1);
+        ASSERT_EQ(h->FirstSetBitIndex(), n - 1);
+        ASSERT_EQ(h->NextSetBitIndex(0), n - 1);
+        h->ClearBit(n - 1);
+        ASSERT_TRUE(h->AreAllBitsClear());
+        ASSERT_EQ(h->FirstSetBitIndex(), ~0ULL);
+        h->SetBit(0);
+        ASSERT_EQ(h->NextSetBitIndex(0), ~0ULL);
+
+        h->SetAll();
+        ASSERT_TRUE(h->AreAllBitsSet());
+        ASSERT_EQ(h->FirstClearBitIndex(), ~0ULL);
+        h->ClearBit(3000000);
+        ASSERT_EQ(h->FirstClearBitIndex(), 3000000ULL);
+        ASSERT_EQ(h->NextClearBitIndex(5), 3000000ULL);
+        ASSERT_EQ(h->NextClearBitIndex(3000000), ~0ULL);
+    }
+}
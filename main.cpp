@@ -8,10 +8,36 @@
 *******************************************************************/
 
 extern void TestBitOps();
+extern void TestBitOpsDispatch();
 extern void TestBitArray();
+extern void TestDynamicBitArray();
+extern void TestBitSpan();
+extern void TestRankSelect();
+extern void TestBitExpr();
+extern void TestAtomicBitArray();
+extern void TestHierarchicalBitArray();
+extern void TestRoaringBitmap();
+extern void TestBitArrayIO();
+extern void TestParallelBitArray();
+extern void TestExtentBitArray();
+extern void TestBitmapAllocator();
+extern void TestBlockedBloomFilter();
 
 int main()
 {
     TestBitOps();
+    TestBitOpsDispatch();
     TestBitArray();
+    TestDynamicBitArray();
+    TestBitSpan();
+    TestRankSelect();
+    TestBitExpr();
+    TestAtomicBitArray();
+    TestHierarchicalBitArray();
+    TestRoaringBitmap();
+    TestBitArrayIO();
+    TestParallelBitArray();
+    TestExtentBitArray();
+    TestBitmapAllocator();
+    TestBlockedBloomFilter();
 }
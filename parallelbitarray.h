@@ -0,0 +1,352 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "dynamicbitarray.h"
+
+// Multi-threaded bulk operations for very large bit arrays: counts, AreAll*, First*, in-place binary
+// operations, inversion, and range set/clear, over any BitArray, DynamicBitArray, or span. The operations
+// that write a DynamicBitArray take its Span().
+//
+// Each operation splits the blocks into tasks, runs the usual single-threaded kernel on each, and combines
+// the results. Every task boundary except the ends falls on a 64-byte line of the array being written, so
+// no two threads ever write the same cache line. Arrays too small to be worth it run on the calling thread.
+//
+// The work runs on an executor: any object with
+//
+//     uint32_t NumThreads() const;
+//     template <class F> void ParallelFor(uint64_t numTasks, F&& f);
+//
+// where ParallelFor calls f(i) once for each i in [0, numTasks), possibly concurrently, and returns once all
+// calls have. BitThreadPool below is one; an adapter to an existing pool is a few lines. Tasks don't throw.
+//
+//     BitThreadPool pool;
+//     ParallelAnd(pool, a, b);
+//     const uint64_t n = ParallelCountSetBits(pool, a);
+
+// Fixed set of worker threads for the Parallel* operations. The calling thread takes part in the work.
+// ParallelFor calls from several threads at once are run one after another.
+class BitThreadPool
+{
+public:
+    // numThreads in total, counting the caller; 0 for one per hardware thread.
+    explicit BitThreadPool(uint32_t numThreads = 0)
+    {
+        if (!numThreads)
+            numThreads = std::max(1U, std::thread::hardware_concurrency());
+
+        m_numThreads = numThreads;
+        m_workers.reserve(numThreads - 1);
+        for (uint32_t i = 1; i < numThreads; ++i)
+            m_workers.emplace_back([this] { WorkerLoop(); });
+    }
+
+    BitThreadPool(const BitThreadPool&) = delete;
+    BitThreadPool& operator=(const BitThreadPool&) = delete;
+
+    ~BitThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+
+        for (std::thread& t : m_workers)
+            t.join();
+    }
+
+    uint32_t NumThreads() const
+    {
+        return m_numThreads;
+    }
+
+    // Call f(i) for each i in [0, numTasks) across the pool, returning once all calls have.
+    template <class F>
+    void ParallelFor(uint64_t numTasks, F&& f)
+    {
+        if (numTasks <= 1 || m_workers.empty())
+        {
+            for (uint64_t i = 0; i < numTasks; ++i)
+                f(i);
+            return;
+        }
+
+        std::lock_guard<std::mutex> serialize(m_runMutex);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_task = [](void* ctx, uint64_t i) { (*static_cast<std::remove_reference_t<F>*>(ctx))(i); };
+            m_ctx = const_cast<void*>(static_cast<const void*>(&f));
+            m_numTasks = numTasks;
+            m_next.store(0, std::memory_order_relaxed);
+            m_numFinished = 0;
+            ++m_generation;
+        }
+        m_wake.notify_all();
+
+        RunTasks();
+
+        // Every worker checks in, so none is left reading this call's state when the next one starts.
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_finished.wait(lock, [this] { return m_numFinished == m_workers.size(); });
+    }
+
+private:
+    void WorkerLoop()
+    {
+        uint64_t generation = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this, generation] { return m_stop || m_generation != generation; });
+                if (m_stop)
+                    return;
+                generation = m_generation;
+            }
+
+            RunTasks();
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_numFinished;
+            }
+            m_finished.notify_one();
+        }
+    }
+
+    void RunTasks()
+    {
+        for (uint64_t i; (i = m_next.fetch_add(1, std::memory_order_relaxed)) < m_numTasks;)
+            m_task(m_ctx, i);
+    }
+
+    std::vector<std::thread> m_workers;
+    uint32_t m_numThreads;
+
+    std::mutex m_runMutex;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_finished;
+    uint64_t m_generation = 0;
+    uint64_t m_numFinished = 0;
+    bool m_stop = false;
+
+    void (*m_task)(void*, uint64_t) = nullptr;
+    void* m_ctx = nullptr;
+    uint64_t m_numTasks = 0;
+    std::atomic<uint64_t> m_next{ 0 };
+};
+
+// Fewest blocks worth handing to a thread: 256 KiB.
+static constexpr uint64_t kParallelMinBlocksPerTask = 1ULL << 15ULL;
+
+// Tasks per thread, so that early-exiting queries can skip work and uneven threads even out.
+static constexpr uint64_t kParallelTasksPerThread = 4;
+
+// Call f(iBegin, iEnd) on disjoint block ranges covering [0, numBlocks) of p, across exec. Every boundary
+// but 0 and numBlocks is at a 64-byte-aligned block.
+template <class Executor, class F>
+static inline void ParallelForBlocks(Executor& exec, const uint64_t* p, uint64_t numBlocks, F f)
+{
+    const uint64_t maxTasks = uint64_t(exec.NumThreads()) * kParallelTasksPerThread;
+    uint64_t blocksPerTask = std::max<uint64_t>(kParallelMinBlocksPerTask, (numBlocks + maxTasks - 1) / maxTasks);
+    blocksPerTask = (blocksPerTask + 7ULL) & ~7ULL;
+
+    const uint64_t lead = std::min<uint64_t>(numBlocks, ((0ULL - uint64_t(reinterpret_cast<uintptr_t>(p))) & 63ULL) >> 3ULL);
+    const uint64_t numTasks = numBlocks > lead ? (numBlocks - lead + blocksPerTask - 1) / blocksPerTask : 1;
+
+    if (numTasks == 1)
+    {
+        f(0ULL, numBlocks);
+        return;
+    }
+
+    exec.ParallelFor(numTasks, [&](uint64_t i)
+    {
+        const uint64_t iBegin = i ? lead + i * blocksPerTask : 0ULL;
+        const uint64_t iEnd = std::min<uint64_t>(numBlocks, lead + (i + 1) * blocksPerTask);
+        f(iBegin, iEnd);
+    });
+}
+
+// The blocks [iBegin, iEnd) of v as a span of their own.
+template <class Block>
+static inline BasicBitSpan<Block> SubSpan(BasicBitSpan<Block> v, uint64_t iBegin, uint64_t iEnd)
+{
+    return BasicBitSpan<Block>(v.Blocks() + iBegin, std::min<uint64_t>(v.NumBits(), iEnd << 6ULL) - (iBegin << 6ULL));
+}
+
+// Return the total number of set bits.
+template <class Executor>
+[[nodiscard]] static inline uint64_t ParallelCountSetBits(Executor& exec, BitArrayView v)
+{
+    std::atomic<uint64_t> count{ 0 };
+    ParallelForBlocks(exec, v.Blocks(), v.NumBlocks(), [&](uint64_t iBegin, uint64_t iEnd)
+    {
+        count.fetch_add(SubSpan(v, iBegin, iEnd).CountSetBits(), std::memory_order_relaxed);
+    });
+    return count.load(std::memory_order_relaxed);
+}
+
+// Return true if all bits are set.
+template <class Executor>
+[[nodiscard]] static inline bool ParallelAreAllBitsSet(Executor& exec, BitArrayView v)
+{
+    std::atomic<bool> all{ true };
+    ParallelForBlocks(exec, v.Blocks(), v.NumBlocks(), [&](uint64_t iBegin, uint64_t iEnd)
+    {
+        if (all.load(std::memory_order_relaxed) && !SubSpan(v, iBegin, iEnd).AreAllBitsSet())
+            all.store(false, std::memory_order_relaxed);
+    });
+    return all.load(std::memory_order_relaxed);
+}
+
+// Return true if all bits are clear.
+template <class Executor>
+[[nodiscard]] static inline bool ParallelAreAllBitsClear(Executor& exec, BitArrayView v)
+{
+    std::atomic<bool> all{ true };
+    ParallelForBlocks(exec, v.Blocks(), v.NumBlocks(), [&](uint64_t iBegin, uint64_t iEnd)
+    {
+        if (all.load(std::memory_order_relaxed) && !SubSpan(v, iBegin, iEnd).AreAllBitsClear())
+            all.store(false, std::memory_order_relaxed);
+    });
+    return all.load(std::memory_order_relaxed);
+}
+
+// Lower first to index if it is below it. Tasks starting past first can skip their search.
+static inline void ParallelMinIndex(std::atomic<uint64_t>& first, uint64_t index)
+{
+    uint64_t current = first.load(std::memory_order_relaxed);
+    while (index < current && !first.compare_exchange_weak(current, index, std::memory_order_relaxed))
+    {
+    }
+}
+
+// Return the index of the first (trailing; lowest index) set bit, or ~0ULL if all bits are clear.
+template <class Executor>
+[[nodiscard]] static inline uint64_t ParallelFirstSetBitIndex(Executor& exec, BitArrayView v)
+{
+    std::atomic<uint64_t> first{ ~0ULL };
+    ParallelForBlocks(exec, v.Blocks(), v.NumBlocks(), [&](uint64_t iBegin, uint64_t iEnd)
+    {
+        if ((iBegin << 6ULL) < first.load(std::memory_order_relaxed))
+        {
+            const uint64_t i = SubSpan(v, iBegin, iEnd).FirstSetBitIndex();
+            if (i != ~0ULL)
+                ParallelMinIndex(first, (iBegin << 6ULL) + i);
+        }
+    });
+    return first.load(std::memory_order_relaxed);
+}
+
+// Return the index of the first (trailing; lowest index) clear bit, or ~0ULL if all bits are set.
+template <class Executor>
+[[nodiscard]] static inline uint64_t ParallelFirstClearBitIndex(Executor& exec, BitArrayView v)
+{
+    std::atomic<uint64_t> first{ ~0ULL };
+    ParallelForBlocks(exec, v.Blocks(), v.NumBlocks(), [&](uint64_t iBegin, uint64_t iEnd)
+    {
+        if ((iBegin << 6ULL) < first.load(std::memory_order_relaxed))
+        {
+            const uint64_t i = SubSpan(v, iBegin, iEnd).FirstClearBitIndex();
+            if (i != ~0ULL)
+                ParallelMinIndex(first, (iBegin << 6ULL) + i);
+        }
+    });
+    return first.load(std::memory_order_relaxed);
+}
+
+// dst = Op(dst, src), blockwise. Both must have the same size.
+template <class Op, class Executor>
+static inline void ParallelBinaryOp(Executor& exec, BitSpan dst, BitArrayView src)
+{
+    ASSERT(dst.NumBits() == src.NumBits());
+    ParallelForBlocks(exec, dst.Blocks(), dst.NumBlocks(), [&](uint64_t iBegin, uint64_t iEnd)
+    {
+        BinaryOp_Blocks<Op>(dst.Blocks() + iBegin, dst.Blocks() + iBegin, src.Blocks() + iBegin, iEnd - iBegin);
+    });
+}
+
+// dst |= src
+template <class Executor>
+static inline void ParallelOr(Executor& exec, BitSpan dst, BitArrayView src)
+{
+    ParallelBinaryOp<BitOpOr>(exec, dst, src);
+}
+
+// dst &= src
+template <class Executor>
+static inline void ParallelAnd(Executor& exec, BitSpan dst, BitArrayView src)
+{
+    ParallelBinaryOp<BitOpAnd>(exec, dst, src);
+}
+
+// dst ^= src
+template <class Executor>
+static inline void ParallelXor(Executor& exec, BitSpan dst, BitArrayView src)
+{
+    ParallelBinaryOp<BitOpXor>(exec, dst, src);
+}
+
+// dst &= ~src
+template <class Executor>
+static inline void ParallelAndNot(Executor& exec, BitSpan dst, BitArrayView src)
+{
+    ParallelBinaryOp<BitOpAndNot>(exec, dst, src);
+}
+
+// Invert all bits.
+template <class Executor>
+static inline void ParallelInvert(Executor& exec, BitSpan v)
+{
+    ParallelForBlocks(exec, v.Blocks(), v.NumBlocks(), [&](uint64_t iBegin, uint64_t iEnd)
+    {
+        SubSpan(v, iBegin, iEnd).Invert();
+    });
+}
+
+// Set all bits between indices [a, b], inclusive.
+template <class Executor>
+static inline void ParallelSetBitsInRange(Executor& exec, BitSpan v, uint64_t a, uint64_t b)
+{
+    ASSERT(a <= b);
+    ASSERT(b < v.NumBits());
+
+    const uint64_t iBlockA = a >> 6ULL;
+    ParallelForBlocks(exec, v.Blocks() + iBlockA, (b >> 6ULL) - iBlockA + 1, [&](uint64_t iBegin, uint64_t iEnd)
+    {
+        const uint64_t base = (iBlockA + iBegin) << 6ULL;
+        SubSpan(v, iBlockA + iBegin, iBlockA + iEnd).SetBitsInRange(std::max<uint64_t>(a, base) - base, std::min<uint64_t>(b, ((iBlockA + iEnd) << 6ULL) - 1) - base);
+    });
+}
+
+// Clear all bits between indices [a, b], inclusive.
+template <class Executor>
+static inline void ParallelClearBitsInRange(Executor& exec, BitSpan v, uint64_t a, uint64_t b)
+{
+    ASSERT(a <= b);
+    ASSERT(b < v.NumBits());
+
+    const uint64_t iBlockA = a >> 6ULL;
+    ParallelForBlocks(exec, v.Blocks() + iBlockA, (b >> 6ULL) - iBlockA + 1, [&](uint64_t iBegin, uint64_t iEnd)
+    {
+        const uint64_t base = (iBlockA + iBegin) << 6ULL;
+        SubSpan(v, iBlockA + iBegin, iBlockA + iEnd).ClearBitsInRange(std::max<uint64_t>(a, base) - base, std::min<uint64_t>(b, ((iBlockA + iEnd) << 6ULL) - 1) - base);
+    });
+}
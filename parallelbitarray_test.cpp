@@ -0,0 +1,211 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#include <iostream>
+#include <vector>
+
+#include "parallelbitarray.h"
+#include "testutil.h"
+
+#define ASSERT_TRUE(a) do { if (!(a)) { std::cerr << "FAIL: expected true for " << #a << ", got false\n"; __debugbreak(); } } while (0)
+#define ASSERT_FALSE(a) do { if ((a)) { std::cerr << "FAIL: expected false for " << #a << ", got true\n"; __debugbreak(); } } while (0)
+
+#define ASSERT_BIN_OP(a, b, op) do {                                                            \
+    const auto& va = (a);                                                                       \
+    const auto& vb = (b);                                                                       \
+    if (!(va op vb))                                                                            \
+    {                                                                                           \
+        std::cerr << "FAIL: expected " << #a << " " << #op << " " << #b << " (evaluates to ";   \
+        std::cerr << va << " " << #op << " " << vb << ")\n";                                    \
+        __debugbreak();                                                                         \
+    }                                                                                           \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_BIN_OP(a, b, ==)
+
+// Runs tasks in order on the calling thread, recording how many it was given.
+struct SerialExecutor
+{
+    uint64_t numTasks = 0;
+
+    uint32_t NumThreads() const
+    {
+        return 16;
+    }
+
+    template <class F>
+    void ParallelFor(uint64_t n, F&& f)
+    {
+        numTasks += n;
+        for (uint64_t i = 0; i < n; ++i)
+            f(i);
+    }
+};
+
+// Every Parallel* operation on a span at offset blocks into a buffer, against the serial operation on a copy.
+template <class Executor>
+static void TestOps(Executor& exec, uint64_t numBits, uint64_t offset, uint64_t& state)
+{
+    const uint64_t numBlocks = (numBits + 63ULL) >> 6ULL;
+    std::vector<uint64_t> bufferA(numBlocks + 8);
+    std::vector<uint64_t> bufferB(numBlocks + 8);
+    std::vector<uint64_t> bufferRef(numBlocks);
+    BitSpan a(bufferA.data() + offset, numBits);
+    BitSpan b(bufferB.data() + offset + 1, numBits);
+    BitSpan ref(bufferRef.data(), numBits);
+
+    for (uint64_t i = 0; i < numBlocks; ++i)
+    {
+        a.Blocks()[i] = SplitMix64(state);
+        b.Blocks()[i] = SplitMix64(state);
+        ref.Blocks()[i] = a.Blocks()[i];
+    }
+
+    ASSERT_EQ(ParallelCountSetBits(exec, a), ref.CountSetBits());
+
+    ParallelOr(exec, a, b);
+    ref |= b;
+    ASSERT_TRUE(a == ref);
+    ParallelAnd(exec, a, b);
+    ref &= b;
+    ASSERT_TRUE(a == ref);
+    ParallelXor(exec, a, b);
+    ref ^= b;
+    ASSERT_TRUE(a == ref);
+    ParallelInvert(exec, a);
+    ref.Invert();
+    ASSERT_TRUE(a == ref);
+    ParallelAndNot(exec, a, b);
+    ref.AndNot(b);
+    ASSERT_TRUE(a == ref);
+    ASSERT_EQ(ParallelCountSetBits(exec, a), ref.CountSetBits());
+
+    for (uint64_t k = 0; k < 6; ++k)
+    {
+        uint64_t lo = SplitMix64(state) % numBits;
+        uint64_t hi = SplitMix64(state) % numBits;
+        if (lo > hi)
+            std::swap(lo, hi);
+        if (k & 1)
+        {
+            ParallelSetBitsInRange(exec, a, lo, hi);
+            ref.SetBitsInRange(lo, hi);
+        }
+        else
+        {
+            ParallelClearBitsInRange(exec, a, lo, hi);
+            ref.ClearBitsInRange(lo, hi);
+        }
+        ASSERT_TRUE(a == ref);
+        ASSERT_EQ(ParallelCountSetBits(exec, a), ref.CountSetBits());
+    }
+
+    // First*, AreAll*, with the first hit in a random place, or none at all.
+    for (uint64_t k = 0; k < 4; ++k)
+    {
+        a.ClearAll();
+        ASSERT_TRUE(ParallelAreAllBitsClear(exec, a));
+        ASSERT_FALSE(ParallelAreAllBitsSet(exec, a));
+        ASSERT_EQ(ParallelFirstSetBitIndex(exec, a), ~0ULL);
+        ASSERT_EQ(ParallelFirstClearBitIndex(exec, a), 0ULL);
+
+        const uint64_t i = SplitMix64(state) % numBits;
+        const uint64_t j = i + SplitMix64(state) % (numBits - i);
+        a.SetBit(j);
+        a.SetBit(i);
+        ASSERT_FALSE(ParallelAreAllBitsClear(exec, a));
+        ASSERT_EQ(ParallelFirstSetBitIndex(exec, a), i);
+
+        a.Invert();
+        ASSERT_EQ(ParallelFirstClearBitIndex(exec, a), i);
+        ASSERT_FALSE(ParallelAreAllBitsSet(exec, a));
+        a.SetBit(i);
+        a.SetBit(j);
+        ASSERT_TRUE(ParallelAreAllBitsSet(exec, a));
+        ASSERT_EQ(ParallelFirstClearBitIndex(exec, a), ~0ULL);
+
+        // Excess bits of the last block are ignored.
+        a.Blocks()[numBlocks - 1] &= a.LastBlockMask();
+        ASSERT_TRUE(ParallelAreAllBitsSet(exec, a));
+    }
+}
+
+void TestParallelBitArray()
+{
+    uint64_t state = 0x9A4A11E1ULL;
+
+    // Tasks cover the blocks exactly, and split on cache lines of the array.
+    {
+        std::vector<uint64_t> buffer(2000000 + 8);
+        for (uint64_t offset = 0; offset < 8; ++offset)
+        {
+            for (const uint64_t numBlocks : { uint64_t(1), uint64_t(1000), kParallelMinBlocksPerTask * 3 + 5, uint64_t(2000000) })
+            {
+                const uint64_t* p = buffer.data() + offset;
+                SerialExecutor exec;
+                uint64_t covered = 0;
+                ParallelForBlocks(exec, p, numBlocks, [&](uint64_t iBegin, uint64_t iEnd)
+                {
+                    ASSERT_EQ(iBegin, covered);
+                    ASSERT_TRUE(iBegin < iEnd);
+                    ASSERT_TRUE(iEnd - iBegin <= kParallelMinBlocksPerTask + 7 || exec.numTasks == 0);
+                    if (iEnd != numBlocks)
+                        ASSERT_EQ(reinterpret_cast<uintptr_t>(p + iEnd) & 63U, 0U);
+                    covered = iEnd;
+                });
+                ASSERT_EQ(covered, numBlocks);
+                ASSERT_EQ(exec.numTasks != 0, numBlocks > kParallelMinBlocksPerTask);
+            }
+        }
+    }
+
+    // Small arrays, run inline.
+    {
+        SerialExecutor exec;
+        for (const uint64_t numBits : { 1ULL, 63ULL, 64ULL, 65ULL, 100000ULL })
+            TestOps(exec, numBits, SplitMix64(state) & 7ULL, state);
+        ASSERT_EQ(exec.numTasks, 0ULL);
+    }
+
+    for (const uint32_t numThreads : { 1U, 4U, 0U })
+    {
+        BitThreadPool pool(numThreads);
+        for (const uint64_t numBits : { (1ULL << 22ULL) + 13ULL, (1ULL << 24ULL) + 64ULL, (1ULL << 24ULL) + 77ULL })
+            TestOps(pool, numBits, SplitMix64(state) & 7ULL, state);
+
+        // Many small jobs back to back, each seeing all of its tasks run.
+        std::vector<std::atomic<uint64_t>> hits(64);
+        std::vector<uint64_t> expected(64, 0ULL);
+        for (uint64_t k = 0; k < 2000; ++k)
+        {
+            const uint64_t n = 1 + k % 64;
+            pool.ParallelFor(n, [&](uint64_t i) { hits[i].fetch_add(1, std::memory_order_relaxed); });
+            for (uint64_t i = 0; i < n; ++i)
+                ++expected[i];
+        }
+        for (uint64_t i = 0; i < 64; ++i)
+            ASSERT_EQ(hits[i].load(), expected[i]);
+    }
+
+    // Works on BitArray and DynamicBitArray directly, and writes a DynamicBitArray through its Span().
+    {
+        BitThreadPool pool(3);
+        DynamicBitArray d(1ULL << 23ULL);
+        d.ClearAll();
+        ParallelSetBitsInRange(pool, d.Span(), 5, d.NumBits() - 6);
+        ASSERT_EQ(ParallelCountSetBits(pool, d), d.NumBits() - 10);
+        ASSERT_EQ(ParallelFirstClearBitIndex(pool, d), 0ULL);
+        ASSERT_EQ(ParallelFirstSetBitIndex(pool, d), 5ULL);
+
+        static BitArray<(1ULL << 23ULL)> v;
+        v.SetAll();
+        ParallelAndNot(pool, v, d);
+        ASSERT_EQ(ParallelCountSetBits(pool, v), 10ULL);
+    }
+}
@@ -0,0 +1,230 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "dynamicbitarray.h"
+
+// Rank/select directory over a BitArray, DynamicBitArray, or BitArrayView, in the style of poppy
+// (Zhou, Andersen, Kaminsky: "Space-Efficient, High-Performance Rank & Select Structures on Uncompressed Bit Sequences").
+//
+// Bits are grouped into 512-bit basic blocks and 2048-bit superblocks. Each superblock has one 64-bit entry: the
+// number of set bits before it (relative to its 2^32-bit upper block) in the low 32 bits, then the popcounts of its
+// first three basic blocks in 10 bits each. Every 8192nd set bit, and every 8192nd clear bit, records the superblock
+// it falls in. The superblock entries cost 3.125% of the bitmap and the 64-bit samples about 0.78% more, set and
+// clear together, for about 3.9% in all.
+//
+// Rank(i) is one directory load plus at most 8 popcnts. Select(n) binary searches the superblocks between two
+// neighboring samples, then walks basic blocks and words.
+//
+// The index reads the bitmap's blocks in place: the bitmap must outlive the index and must not be modified
+// after the index is built. Rebuild the index after any change.
+class RankSelectIndex
+{
+public:
+    template <uint64_t kNBits>
+    explicit RankSelectIndex(const BitArray<kNBits>& v) : RankSelectIndex(v.Blocks(), kNBits)
+    {
+    }
+
+    explicit RankSelectIndex(BitArrayView v) : RankSelectIndex(v.Blocks(), v.NumBits())
+    {
+    }
+
+    // Index numBits bits starting at blocks. Bits past numBits in the last block are ignored.
+    RankSelectIndex(const uint64_t* blocks, uint64_t numBits) : m_block(blocks), m_numBits(numBits), m_numBlocks((numBits + 63ULL) >> 6ULL)
+    {
+        Build();
+    }
+
+    // Return the number of indexed bits.
+    uint64_t NumBits() const
+    {
+        return m_numBits;
+    }
+
+    // Return the total number of set bits.
+    uint64_t CountSetBits() const
+    {
+        return m_numSet;
+    }
+
+    // Return the number of set bits in [0, i). i may equal NumBits().
+    uint64_t Rank(uint64_t i) const
+    {
+        ASSERT(i <= m_numBits);
+
+        const uint64_t entry = m_super[i >> kSuperShift];
+        uint64_t count = m_upper[i >> kUpperShift] + (entry & 0xFFFFFFFFULL);
+
+        const uint64_t iBasic = (i >> kBasicShift) & 3ULL;
+        count += iBasic > 0 ? (entry >> 32ULL) & 0x3FFULL : 0ULL;
+        count += iBasic > 1 ? (entry >> 42ULL) & 0x3FFULL : 0ULL;
+        count += iBasic > 2 ? (entry >> 52ULL) & 0x3FFULL : 0ULL;
+
+        const uint64_t iBlock = i >> 6ULL;
+        for (uint64_t iWord = iBlock & ~7ULL; iWord < iBlock; ++iWord)
+            count += CountSetBits_U64(m_block[iWord]);
+
+        if (i & 63ULL)
+            count += CountSetBits_U64(m_block[iBlock] & ((1ULL << (i & 63ULL)) - 1ULL));
+
+        return count;
+    }
+
+    // Return the number of clear bits in [0, i). i may equal NumBits().
+    uint64_t RankClear(uint64_t i) const
+    {
+        return i - Rank(i);
+    }
+
+    // Return the index of the nth (0-based) set bit, or ~0ULL if there are n or fewer set bits.
+    // Same result as NthSetBitIndex() on the indexed bitmap.
+    uint64_t Select(uint64_t n) const
+    {
+        if (n >= m_numSet)
+            return ~0ULL;
+
+        return SelectHelper<false>(n, m_selectSamples);
+    }
+
+    // Return the index of the nth (0-based) clear bit, or ~0ULL if there are n or fewer clear bits.
+    // Same result as NthClearBitIndex() on the indexed bitmap.
+    uint64_t SelectClear(uint64_t n) const
+    {
+        if (n >= m_numBits - m_numSet)
+            return ~0ULL;
+
+        return SelectHelper<true>(n, m_selectClearSamples);
+    }
+
+    // Return the size of the directory in bytes, not counting the bitmap itself.
+    uint64_t MemoryOverheadBytes() const
+    {
+        return (m_upper.capacity() + m_super.capacity() + m_selectSamples.capacity() + m_selectClearSamples.capacity()) * sizeof(uint64_t);
+    }
+
+private:
+    static constexpr uint64_t kBasicShift = 9;
+    static constexpr uint64_t kSuperShift = 11;
+    static constexpr uint64_t kUpperShift = 32;
+    static constexpr uint64_t kSuperPerUpperShift = kUpperShift - kSuperShift;
+    static constexpr uint64_t kSampleShift = 13;
+
+    // Return block i, with bits past m_numBits cleared.
+    uint64_t Block(uint64_t i) const
+    {
+        const uint64_t block = m_block[i];
+        return i == m_numBlocks - 1 ? block & (~0ULL >> ((0ULL - m_numBits) & 63ULL)) : block;
+    }
+
+    void Build()
+    {
+        const uint64_t numSuper = (m_numBits >> kSuperShift) + 1;
+        m_super.resize(numSuper);
+        m_upper.resize((m_numBits >> kUpperShift) + 1);
+
+        uint64_t total = 0;
+        uint64_t totalClear = 0;
+        for (uint64_t iSuper = 0; iSuper < numSuper; ++iSuper)
+        {
+            if ((iSuper & ((1ULL << kSuperPerUpperShift) - 1ULL)) == 0)
+                m_upper[iSuper >> kSuperPerUpperShift] = total;
+
+            uint64_t entry = total - m_upper[iSuper >> kSuperPerUpperShift];
+            for (uint64_t iBasic = 0; iBasic < 4; ++iBasic)
+            {
+                uint64_t basicCount = 0;
+                const uint64_t iFirst = (iSuper << 5ULL) + (iBasic << 3ULL);
+                for (uint64_t iBlock = iFirst; iBlock < iFirst + 8 && iBlock < m_numBlocks; ++iBlock)
+                    basicCount += CountSetBits_U64(Block(iBlock));
+
+                if (iBasic < 3)
+                    entry |= basicCount << (32ULL + 10ULL * iBasic);
+
+                // Basic blocks, and so superblocks, past the end count as all clear; they come after every real bit.
+                const uint64_t basicClear = 512ULL - basicCount;
+                const uint64_t nextTotal = total + basicCount;
+                const uint64_t nextTotalClear = totalClear + basicClear;
+                for (uint64_t s = (total + (1ULL << kSampleShift) - 1ULL) >> kSampleShift; (s << kSampleShift) < nextTotal; ++s)
+                    m_selectSamples.push_back(iSuper);
+                for (uint64_t s = (totalClear + (1ULL << kSampleShift) - 1ULL) >> kSampleShift; (s << kSampleShift) < nextTotalClear; ++s)
+                    m_selectClearSamples.push_back(iSuper);
+                total = nextTotal;
+                totalClear = nextTotalClear;
+            }
+            m_super[iSuper] = entry;
+        }
+
+        m_numSet = total;
+        m_selectSamples.push_back(numSuper - 1);
+        m_selectClearSamples.push_back(numSuper - 1);
+        m_selectSamples.shrink_to_fit();
+        m_selectClearSamples.shrink_to_fit();
+    }
+
+    // Return the number of set (or clear) bits before superblock iSuper.
+    template <bool kClear>
+    uint64_t SuperRank(uint64_t iSuper) const
+    {
+        const uint64_t count = m_upper[iSuper >> kSuperPerUpperShift] + (m_super[iSuper] & 0xFFFFFFFFULL);
+        return kClear ? (iSuper << kSuperShift) - count : count;
+    }
+
+    template <bool kClear>
+    uint64_t SelectHelper(uint64_t n, const std::vector<uint64_t>& samples) const
+    {
+        // The nth bit lies in the last superblock whose rank is <= n, which is between these two samples.
+        uint64_t lo = samples[n >> kSampleShift];
+        uint64_t hi = samples[(n >> kSampleShift) + 1];
+        while (lo < hi)
+        {
+            const uint64_t mid = (lo + hi + 1) >> 1ULL;
+            if (SuperRank<kClear>(mid) <= n)
+                lo = mid;
+            else
+                hi = mid - 1;
+        }
+
+        const uint64_t entry = m_super[lo];
+        n -= SuperRank<kClear>(lo);
+
+        uint64_t iBlock = lo << 5ULL;
+        for (uint64_t iBasic = 0; iBasic < 3; ++iBasic)
+        {
+            const uint64_t basicCount = (entry >> (32ULL + 10ULL * iBasic)) & 0x3FFULL;
+            const uint64_t count = kClear ? 512ULL - basicCount : basicCount;
+            if (n < count)
+                break;
+            n -= count;
+            iBlock += 8;
+        }
+
+        for (;; ++iBlock)
+        {
+            const uint64_t block = kClear ? ~Block(iBlock) : Block(iBlock);
+            const uint64_t count = CountSetBits_U64(block);
+            if (n < count)
+                return (iBlock << 6ULL) + NthSetBitIndex_U64(block, uint32_t(n));
+            n -= count;
+        }
+    }
+
+    const uint64_t* m_block;
+    uint64_t m_numBits;
+    uint64_t m_numBlocks;
+    uint64_t m_numSet;
+
+    std::vector<uint64_t> m_upper;
+    std::vector<uint64_t> m_super;
+    std::vector<uint64_t> m_selectSamples;
+    std::vector<uint64_t> m_selectClearSamples;
+};
@@ -0,0 +1,124 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#include <iostream>
+
+#include "rankselect.h"
+#include "testutil.h"
+
+#define ASSERT_TRUE(a) do { if (!(a)) { std::cerr << "FAIL: expected true for " << #a << ", got false\n"; __debugbreak(); } } while (0)
+
+#define ASSERT_BIN_OP(a, b, op) do {                                                            \
+    const auto& va = (a);                                                                       \
+    const auto& vb = (b);                                                                       \
+    if (!(va op vb))                                                                            \
+    {                                                                                           \
+        std::cerr << "FAIL: expected " << #a << " " << #op << " " << #b << " (evaluates to ";   \
+        std::cerr << va << " " << #op << " " << vb << ")\n";                                    \
+        __debugbreak();                                                                         \
+    }                                                                                           \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_BIN_OP(a, b, ==)
+#define ASSERT_LE(a, b) ASSERT_BIN_OP(a, b, <=)
+
+// Fill with pseudorandom blocks, including the excess bits of the last block.
+// Density 0 and 4 are all clear and all set; 1, 2, 3 are sparse, half, and dense; 5 is a handful of bits.
+static void FillRandom(DynamicBitArray& v, uint64_t& state, uint32_t density)
+{
+    for (uint64_t i = 0; i < v.NumBlocks(); ++i)
+    {
+        const uint64_t r = SplitMix64(state);
+        const uint64_t sparse = r & SplitMix64(state) & SplitMix64(state) & SplitMix64(state);
+        v.Blocks()[i] = density == 0 ? 0ULL : density == 1 ? sparse : density == 2 ? r : density == 3 ? ~sparse : density == 4 ? ~0ULL : 0ULL;
+    }
+
+    if (density == 5)
+    {
+        for (uint64_t i = 0; i < 40; ++i)
+            v.SetBit(SplitMix64(state) % v.NumBits());
+    }
+}
+
+static void CheckAgainstBitArray(const DynamicBitArray& v)
+{
+    const RankSelectIndex index(v);
+    ASSERT_EQ(index.NumBits(), v.NumBits());
+    ASSERT_EQ(index.CountSetBits(), v.CountSetBits());
+
+    uint64_t rank = 0;
+    for (uint64_t i = 0; i < v.NumBits(); ++i)
+    {
+        ASSERT_EQ(index.Rank(i), rank);
+        ASSERT_EQ(index.RankClear(i), i - rank);
+        if (v.IsBitSet(i))
+        {
+            ASSERT_EQ(index.Select(rank), i);
+            ++rank;
+        }
+        else
+        {
+            ASSERT_EQ(index.SelectClear(i - rank), i);
+        }
+    }
+
+    ASSERT_EQ(index.Rank(v.NumBits()), rank);
+    ASSERT_EQ(index.Select(rank), ~0ULL);
+    ASSERT_EQ(index.SelectClear(v.NumBits() - rank), ~0ULL);
+    ASSERT_EQ(index.Select(~0ULL), ~0ULL);
+    ASSERT_EQ(index.SelectClear(~0ULL), ~0ULL);
+}
+
+void TestRankSelect()
+{
+    uint64_t state = 0x5EED5EEDULL;
+
+    // empty
+    {
+        const DynamicBitArray v;
+        const RankSelectIndex index(v);
+        ASSERT_EQ(index.Rank(0), 0ULL);
+        ASSERT_EQ(index.Select(0), ~0ULL);
+        ASSERT_EQ(index.SelectClear(0), ~0ULL);
+    }
+
+    // Rank, RankClear, Select, SelectClear
+    for (uint64_t numBits : { 1ULL, 63ULL, 64ULL, 511ULL, 512ULL, 2047ULL, 2048ULL, 2049ULL, 10000ULL, 65536ULL, 100003ULL })
+    {
+        for (uint32_t density = 0; density <= 5; ++density)
+        {
+            DynamicBitArray v(numBits);
+            FillRandom(v, state, density);
+            CheckAgainstBitArray(v);
+        }
+    }
+
+    // Select agrees with NthSetBitIndex, NthClearBitIndex on a fixed-size array
+    {
+        BitArray<70000> v;
+        uint64_t* p = const_cast<uint64_t*>(v.Blocks());
+        for (uint64_t i = 0; i < BitArray<70000>::kNumBlocks; ++i)
+            p[i] = SplitMix64(state) & SplitMix64(state);
+
+        const RankSelectIndex index(v);
+        for (uint64_t n = 0; n < 70000; n += 97)
+        {
+            ASSERT_EQ(index.Select(n), v.NthSetBitIndex(n));
+            ASSERT_EQ(index.SelectClear(n), v.NthClearBitIndex(n));
+        }
+    }
+
+    // memory overhead
+    {
+        const DynamicBitArray v(1ULL << 24, true);
+        const RankSelectIndex index(v);
+        ASSERT_TRUE(index.MemoryOverheadBytes() > 0);
+        ASSERT_LE(index.MemoryOverheadBytes() * 8 * 100, v.NumBits() * 4);
+    }
+}
@@ -0,0 +1,722 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "bitarray.h"
+
+// Compressed set of 32-bit values, in the style of Roaring
+// (Chambi, Lemire, Kaser, Godin: "Better bitmap performance with Roaring bitmaps").
+//
+// Values are split by their upper 16 bits into chunks of 65536, and only nonempty chunks are stored, each in
+// the container that suits its contents:
+//   - array:  up to 4096 values, as a sorted list of their lower 16 bits, 2 bytes per value
+//   - bitmap: more than 4096 values, as a BitArray<65536>, 8 KB
+//   - run:    a sorted list of (start, length - 1) pairs, 4 bytes per run of consecutive values. AddRange()
+//             produces runs, and RunOptimize() switches each container to whichever form is smallest.
+// A set of 0.01% density over all 2^32 values then costs about 2 bytes per value instead of 512 MB.
+//
+// &, |, ^ and AndNot work chunk by chunk and pick an algorithm for each pair of container types: a merge of
+// two sorted arrays, a sweep over two run lists, a filter of an array against the other container, or the
+// BitArray block loops between bitmaps. Array results past 4096 values become bitmaps, and bitmap results of
+// 4096 values or fewer become arrays.
+enum class RoaringContainer : uint8_t
+{
+    Array,
+    Run,
+    Bitmap,
+};
+
+class RoaringBitmap
+{
+public:
+    using Chunk = BitArray<65536>;
+
+    // Array containers hold at most this many values.
+    static constexpr uint32_t kMaxArraySize = 4096;
+
+    // Return true if x is in the set.
+    bool Contains(uint32_t x) const
+    {
+        const uint64_t i = FindKey(uint16_t(x >> 16U));
+        return i != ~0ULL && ContainerContains(m_containers[i], uint16_t(x));
+    }
+
+    // Add x to the set.
+    void Add(uint32_t x)
+    {
+        ContainerAdd(FindOrInsertKey(uint16_t(x >> 16U)), uint16_t(x));
+    }
+
+    // Remove x from the set.
+    void Remove(uint32_t x)
+    {
+        const uint64_t i = FindKey(uint16_t(x >> 16U));
+        if (i == ~0ULL)
+            return;
+
+        ContainerRemove(m_containers[i], uint16_t(x));
+        if (!m_containers[i].cardinality)
+        {
+            m_keys.erase(m_keys.begin() + int64_t(i));
+            m_containers.erase(m_containers.begin() + int64_t(i));
+        }
+    }
+
+    // Add all values between a and b, inclusive, as runs.
+    void AddRange(uint32_t a, uint32_t b)
+    {
+        ASSERT(a <= b);
+
+        for (uint32_t key = a >> 16U;; ++key)
+        {
+            const uint16_t lo = key == a >> 16U ? uint16_t(a) : uint16_t(0);
+            const uint16_t hi = key == b >> 16U ? uint16_t(b) : uint16_t(0xFFFF);
+
+            Container run;
+            run.type = RoaringContainer::Run;
+            run.cardinality = uint32_t(hi - lo) + 1U;
+            run.values = { lo, uint16_t(hi - lo) };
+
+            Container& c = FindOrInsertKey(uint16_t(key));
+            c = c.cardinality ? Combine<BitOpOr>(c, run) : std::move(run);
+
+            if (key == b >> 16U)
+                break;
+        }
+    }
+
+    // Remove all values.
+    void Clear()
+    {
+        m_keys.clear();
+        m_containers.clear();
+    }
+
+    // Return the number of values in the set.
+    uint64_t Cardinality() const
+    {
+        uint64_t count = 0;
+        for (const Container& c : m_containers)
+            count += c.cardinality;
+        return count;
+    }
+
+    // Return true if the set is empty.
+    bool IsEmpty() const
+    {
+        return m_containers.empty();
+    }
+
+    // Call f(x) for every value x in the set, in increasing order.
+    template <class F>
+    void ForEach(F&& f) const
+    {
+        for (uint64_t i = 0; i < m_containers.size(); ++i)
+        {
+            const Container& c = m_containers[i];
+            const uint32_t high = uint32_t(m_keys[i]) << 16U;
+            if (c.type == RoaringContainer::Array)
+            {
+                for (const uint16_t v : c.values)
+                    f(high | v);
+            }
+            else if (c.type == RoaringContainer::Run)
+            {
+                for (uint64_t r = 0; r < c.values.size(); r += 2)
+                {
+                    for (uint32_t v = c.values[r]; v <= uint32_t(c.values[r]) + c.values[r + 1]; ++v)
+                        f(high | v);
+                }
+            }
+            else
+            {
+                c.bits->ForEachSetBitBatch([&](const uint32_t* indices, uint64_t count)
+                    {
+                        for (uint64_t k = 0; k < count; ++k)
+                            f(high | indices[k]);
+                    });
+            }
+        }
+    }
+
+    // Store each container in whichever of the three forms is smallest.
+    void RunOptimize()
+    {
+        for (Container& c : m_containers)
+        {
+            const uint64_t runBytes = CountRuns(c) * 4;
+            const uint64_t plainBytes = c.cardinality <= kMaxArraySize ? c.cardinality * 2ULL : sizeof(Chunk);
+            if (runBytes < plainBytes)
+                ToRun(c);
+            else if (c.type == RoaringContainer::Run)
+                ToPlain(c);
+        }
+    }
+
+    // Return the number of containers of the given type.
+    uint64_t CountContainers(RoaringContainer type) const
+    {
+        uint64_t count = 0;
+        for (const Container& c : m_containers)
+            count += c.type == type;
+        return count;
+    }
+
+    // Return the approximate heap footprint in bytes.
+    uint64_t MemoryBytes() const
+    {
+        uint64_t bytes = m_keys.capacity() * sizeof(uint16_t) + m_containers.capacity() * sizeof(Container);
+        for (const Container& c : m_containers)
+            bytes += c.values.capacity() * sizeof(uint16_t) + (c.bits ? sizeof(Chunk) : 0);
+        return bytes;
+    }
+
+    friend bool operator==(const RoaringBitmap& a, const RoaringBitmap& b)
+    {
+        if (a.m_keys != b.m_keys)
+            return false;
+
+        for (uint64_t i = 0; i < a.m_containers.size(); ++i)
+        {
+            const Container& x = a.m_containers[i];
+            const Container& y = b.m_containers[i];
+            if (x.cardinality != y.cardinality)
+                return false;
+
+            // The same values may be held in different forms.
+            if (x.type == y.type && x.type != RoaringContainer::Bitmap)
+            {
+                if (x.values != y.values)
+                    return false;
+            }
+            else if (Combine<BitOpXor>(x, y).cardinality)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    friend bool operator!=(const RoaringBitmap& a, const RoaringBitmap& b)
+    {
+        return !(a == b);
+    }
+
+    friend RoaringBitmap operator&(const RoaringBitmap& a, const RoaringBitmap& b)
+    {
+        return CombineSets<BitOpAnd>(a, b);
+    }
+
+    friend RoaringBitmap operator|(const RoaringBitmap& a, const RoaringBitmap& b)
+    {
+        return CombineSets<BitOpOr>(a, b);
+    }
+
+    friend RoaringBitmap operator^(const RoaringBitmap& a, const RoaringBitmap& b)
+    {
+        return CombineSets<BitOpXor>(a, b);
+    }
+
+    // a & ~b
+    friend RoaringBitmap AndNot(const RoaringBitmap& a, const RoaringBitmap& b)
+    {
+        return CombineSets<BitOpAndNot>(a, b);
+    }
+
+    void operator&=(const RoaringBitmap& other)
+    {
+        *this = *this & other;
+    }
+
+    void operator|=(const RoaringBitmap& other)
+    {
+        *this = *this | other;
+    }
+
+    void operator^=(const RoaringBitmap& other)
+    {
+        *this = *this ^ other;
+    }
+
+    void AndNot(const RoaringBitmap& other)
+    {
+        *this = CombineSets<BitOpAndNot>(*this, other);
+    }
+
+private:
+    struct Container
+    {
+        Container() = default;
+        Container(Container&&) = default;
+        Container& operator=(Container&&) = default;
+
+        Container(const Container& other) :
+            type(other.type), cardinality(other.cardinality), values(other.values), bits(other.bits ? std::make_unique<Chunk>(*other.bits) : nullptr)
+        {
+        }
+
+        Container& operator=(const Container& other)
+        {
+            if (this != &other)
+                *this = Container(other);
+            return *this;
+        }
+
+        RoaringContainer type = RoaringContainer::Array;
+        uint32_t cardinality = 0;
+
+        // Array: the values, sorted. Run: (start, length - 1) pairs, sorted, disjoint and not adjacent.
+        std::vector<uint16_t> values;
+
+        // Bitmap only.
+        std::unique_ptr<Chunk> bits;
+    };
+
+    // Return the index of key, or ~0ULL if it has no container.
+    uint64_t FindKey(uint16_t key) const
+    {
+        const auto it = std::lower_bound(m_keys.begin(), m_keys.end(), key);
+        return it != m_keys.end() && *it == key ? uint64_t(it - m_keys.begin()) : ~0ULL;
+    }
+
+    // Return the container of key, adding an empty one if there is none.
+    Container& FindOrInsertKey(uint16_t key)
+    {
+        const auto it = std::lower_bound(m_keys.begin(), m_keys.end(), key);
+        const int64_t i = it - m_keys.begin();
+        if (it == m_keys.end() || *it != key)
+        {
+            m_keys.insert(it, key);
+            m_containers.insert(m_containers.begin() + i, Container());
+        }
+        return m_containers[uint64_t(i)];
+    }
+
+    static bool ContainerContains(const Container& c, uint16_t v)
+    {
+        if (c.type == RoaringContainer::Array)
+            return std::binary_search(c.values.begin(), c.values.end(), v);
+
+        if (c.type == RoaringContainer::Bitmap)
+            return c.bits->IsBitSet(v);
+
+        // Last run starting at or before v.
+        uint64_t lo = 0;
+        uint64_t hi = c.values.size() >> 1ULL;
+        while (lo < hi)
+        {
+            const uint64_t mid = (lo + hi) >> 1ULL;
+            if (c.values[mid << 1ULL] <= v)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo && uint32_t(v - c.values[(lo - 1) << 1ULL]) <= c.values[((lo - 1) << 1ULL) + 1];
+    }
+
+    static void ContainerAdd(Container& c, uint16_t v)
+    {
+        if (c.type == RoaringContainer::Run)
+        {
+            if (ContainerContains(c, v))
+                return;
+            ToPlain(c);
+        }
+
+        if (c.type == RoaringContainer::Array)
+        {
+            const auto it = std::lower_bound(c.values.begin(), c.values.end(), v);
+            if (it != c.values.end() && *it == v)
+                return;
+            if (c.cardinality < kMaxArraySize)
+            {
+                c.values.insert(it, v);
+                ++c.cardinality;
+                return;
+            }
+            ToBitmap(c);
+        }
+
+        if (!c.bits->IsBitSet(v))
+        {
+            c.bits->SetBit(v);
+            ++c.cardinality;
+        }
+    }
+
+    static void ContainerRemove(Container& c, uint16_t v)
+    {
+        if (c.type == RoaringContainer::Run)
+        {
+            if (!ContainerContains(c, v))
+                return;
+            ToPlain(c);
+        }
+
+        if (c.type == RoaringContainer::Array)
+        {
+            const auto it = std::lower_bound(c.values.begin(), c.values.end(), v);
+            if (it != c.values.end() && *it == v)
+            {
+                c.values.erase(it);
+                --c.cardinality;
+            }
+            return;
+        }
+
+        if (c.bits->IsBitSet(v))
+        {
+            c.bits->ClearBit(v);
+            if (--c.cardinality <= kMaxArraySize)
+                ToArray(c);
+        }
+    }
+
+    // Return the container's values as a bitmap.
+    static std::unique_ptr<Chunk> MakeChunk(const Container& c)
+    {
+        if (c.type == RoaringContainer::Bitmap)
+            return std::make_unique<Chunk>(*c.bits);
+
+        std::unique_ptr<Chunk> bits = std::make_unique<Chunk>();
+        bits->ClearAll();
+        if (c.type == RoaringContainer::Array)
+        {
+            for (const uint16_t v : c.values)
+                bits->SetBit(v);
+        }
+        else
+        {
+            for (uint64_t r = 0; r < c.values.size(); r += 2)
+                bits->SetBitsInRange(c.values[r], uint64_t(c.values[r]) + c.values[r + 1]);
+        }
+        return bits;
+    }
+
+    static void ToBitmap(Container& c)
+    {
+        c.bits = MakeChunk(c);
+        c.values = std::vector<uint16_t>();
+        c.type = RoaringContainer::Bitmap;
+    }
+
+    static void ToArray(Container& c)
+    {
+        std::vector<uint16_t> values;
+        values.reserve(c.cardinality);
+        if (c.type == RoaringContainer::Bitmap)
+        {
+            c.bits->ForEachSetBitBatch([&](const uint32_t* indices, uint64_t count)
+                {
+                    for (uint64_t k = 0; k < count; ++k)
+                        values.push_back(uint16_t(indices[k]));
+                });
+        }
+        else if (c.type == RoaringContainer::Run)
+        {
+            for (uint64_t r = 0; r < c.values.size(); r += 2)
+            {
+                for (uint32_t v = c.values[r]; v <= uint32_t(c.values[r]) + c.values[r + 1]; ++v)
+                    values.push_back(uint16_t(v));
+            }
+        }
+        else
+        {
+            return;
+        }
+
+        c.values = std::move(values);
+        c.bits.reset();
+        c.type = RoaringContainer::Array;
+    }
+
+    // Convert to an array or a bitmap, whichever the cardinality calls for.
+    static void ToPlain(Container& c)
+    {
+        if (c.cardinality <= kMaxArraySize)
+            ToArray(c);
+        else
+            ToBitmap(c);
+    }
+
+    // Return the number of runs of consecutive values.
+    static uint64_t CountRuns(const Container& c)
+    {
+        if (c.type == RoaringContainer::Run)
+            return c.values.size() >> 1ULL;
+
+        if (c.type == RoaringContainer::Array)
+        {
+            uint64_t runs = c.values.empty() ? 0 : 1;
+            for (uint64_t i = 1; i < c.values.size(); ++i)
+                runs += c.values[i] != c.values[i - 1] + 1;
+            return runs;
+        }
+
+        // A run starts at each set bit whose lower neighbor is clear.
+        uint64_t runs = 0;
+        uint64_t carry = 0;
+        for (uint64_t i = 0; i < Chunk::kNumBlocks; ++i)
+        {
+            const uint64_t block = c.bits->Blocks()[i];
+            runs += CountSetBits_U64(block & ~((block << 1ULL) | carry));
+            carry = block >> 63ULL;
+        }
+        return runs;
+    }
+
+    static void ToRun(Container& c)
+    {
+        if (c.type == RoaringContainer::Run)
+            return;
+
+        std::vector<uint16_t> runs;
+        runs.reserve(CountRuns(c) * 2);
+        const auto append = [&runs](uint16_t v)
+            {
+                if (!runs.empty() && uint32_t(runs[runs.size() - 2]) + runs.back() + 1U == v)
+                {
+                    ++runs.back();
+                }
+                else
+                {
+                    runs.push_back(v);
+                    runs.push_back(0);
+                }
+            };
+
+        if (c.type == RoaringContainer::Array)
+        {
+            for (const uint16_t v : c.values)
+                append(v);
+        }
+        else
+        {
+            c.bits->ForEachSetBitBatch([&](const uint32_t* indices, uint64_t count)
+                {
+                    for (uint64_t k = 0; k < count; ++k)
+                        append(uint16_t(indices[k]));
+                });
+        }
+
+        c.values = std::move(runs);
+        c.bits.reset();
+        c.type = RoaringContainer::Run;
+    }
+
+    // dst = Op(dst, src), with the BitArray block loops.
+    template <class Op>
+    static void CombineChunks(Chunk& dst, const Chunk& src)
+    {
+        if constexpr (std::is_same_v<Op, BitOpAnd>)
+            dst &= src;
+        else if constexpr (std::is_same_v<Op, BitOpOr>)
+            dst |= src;
+        else if constexpr (std::is_same_v<Op, BitOpXor>)
+            dst ^= src;
+        else
+            dst.AndNot(src);
+    }
+
+    // Settle an array or bitmap result into the right form for its cardinality.
+    static void Settle(Container& c)
+    {
+        if (c.type == RoaringContainer::Array && c.cardinality > kMaxArraySize)
+        {
+            ToBitmap(c);
+        }
+        else if (c.type == RoaringContainer::Bitmap && c.cardinality <= kMaxArraySize)
+        {
+            ToArray(c);
+        }
+        else if (c.type == RoaringContainer::Bitmap && c.cardinality == Chunk::kNumBits)
+        {
+            c.values = { 0, 0xFFFF };
+            c.bits.reset();
+            c.type = RoaringContainer::Run;
+        }
+    }
+
+    // Return Op(a, b) for two containers of the same chunk.
+    template <class Op>
+    static Container Combine(const Container& a, const Container& b)
+    {
+        // And and AndNot keep only values of a; And keeps only values of b.
+        const bool subsetOfA = !(Op::U64(0ULL, 1ULL) & 1ULL);
+        const bool subsetOfB = !(Op::U64(1ULL, 0ULL) & 1ULL);
+
+        if (a.type == RoaringContainer::Run && b.type == RoaringContainer::Run)
+            return CombineRuns<Op>(a, b);
+
+        Container r;
+        if (a.type == RoaringContainer::Array && b.type == RoaringContainer::Array)
+        {
+            // Merge, applying Op to membership of each value in either.
+            r.values.reserve(subsetOfA ? a.values.size() : a.values.size() + b.values.size());
+            uint64_t i = 0;
+            uint64_t j = 0;
+            while (i < a.values.size() || j < b.values.size())
+            {
+                const bool takeA = j == b.values.size() || (i < a.values.size() && a.values[i] <= b.values[j]);
+                const bool takeB = i == a.values.size() || (j < b.values.size() && b.values[j] <= a.values[i]);
+                const uint16_t v = takeA ? a.values[i] : b.values[j];
+                if (Op::U64(takeA, takeB) & 1ULL)
+                    r.values.push_back(v);
+                i += takeA;
+                j += takeB;
+            }
+        }
+        else if (a.type == RoaringContainer::Array && subsetOfA)
+        {
+            for (const uint16_t v : a.values)
+            {
+                if (Op::U64(1ULL, ContainerContains(b, v)) & 1ULL)
+                    r.values.push_back(v);
+            }
+        }
+        else if (b.type == RoaringContainer::Array && subsetOfB)
+        {
+            for (const uint16_t v : b.values)
+            {
+                if (Op::U64(ContainerContains(a, v), 1ULL) & 1ULL)
+                    r.values.push_back(v);
+            }
+        }
+        else
+        {
+            // Here, an array operand of | or ^ can go on either side, and Op(x, 0) == x. Start from the other
+            // operand as a bitmap and apply the array's values, or combine with the other bitmap.
+            const bool swap = a.type == RoaringContainer::Array;
+            const Container& dense = swap ? b : a;
+            const Container& other = swap ? a : b;
+
+            r.type = RoaringContainer::Bitmap;
+            r.bits = MakeChunk(dense);
+            if (other.type == RoaringContainer::Array)
+            {
+                for (const uint16_t v : other.values)
+                    r.bits->AssignBit(v, Op::U64(r.bits->IsBitSet(v), 1ULL) & 1ULL);
+            }
+            else if (other.type == RoaringContainer::Bitmap)
+            {
+                CombineChunks<Op>(*r.bits, *other.bits);
+            }
+            else
+            {
+                CombineChunks<Op>(*r.bits, *MakeChunk(other));
+            }
+            r.cardinality = uint32_t(r.bits->CountSetBits());
+            Settle(r);
+            return r;
+        }
+
+        r.cardinality = uint32_t(r.values.size());
+        Settle(r);
+        return r;
+    }
+
+    // Return Op(a, b) for two run containers, as runs: one sweep over the boundaries of both.
+    template <class Op>
+    static Container CombineRuns(const Container& a, const Container& b)
+    {
+        Container r;
+        r.type = RoaringContainer::Run;
+
+        const uint64_t numA = a.values.size() >> 1ULL;
+        const uint64_t numB = b.values.size() >> 1ULL;
+        uint64_t iA = 0;
+        uint64_t iB = 0;
+        uint32_t pos = 0;
+        while (pos < Chunk::kNumBits)
+        {
+            // Runs as [start, end), skipping those already behind pos.
+            while (iA < numA && uint32_t(a.values[iA << 1ULL]) + a.values[(iA << 1ULL) + 1] + 1U <= pos)
+                ++iA;
+            while (iB < numB && uint32_t(b.values[iB << 1ULL]) + b.values[(iB << 1ULL) + 1] + 1U <= pos)
+                ++iB;
+
+            const bool inA = iA < numA && a.values[iA << 1ULL] <= pos;
+            const bool inB = iB < numB && b.values[iB << 1ULL] <= pos;
+            const uint32_t nextA = iA == numA ? uint32_t(Chunk::kNumBits) : inA ? uint32_t(a.values[iA << 1ULL]) + a.values[(iA << 1ULL) + 1] + 1U : a.values[iA << 1ULL];
+            const uint32_t nextB = iB == numB ? uint32_t(Chunk::kNumBits) : inB ? uint32_t(b.values[iB << 1ULL]) + b.values[(iB << 1ULL) + 1] + 1U : b.values[iB << 1ULL];
+            const uint32_t next = nextA < nextB ? nextA : nextB;
+
+            if (Op::U64(inA, inB) & 1ULL)
+            {
+                if (!r.values.empty() && uint32_t(r.values[r.values.size() - 2]) + r.values.back() + 1U == pos)
+                {
+                    r.values.back() = uint16_t(r.values.back() + (next - pos));
+                }
+                else
+                {
+                    r.values.push_back(uint16_t(pos));
+                    r.values.push_back(uint16_t(next - pos - 1U));
+                }
+                r.cardinality += next - pos;
+            }
+
+            pos = next;
+        }
+
+        return r;
+    }
+
+    template <class Op>
+    static RoaringBitmap CombineSets(const RoaringBitmap& a, const RoaringBitmap& b)
+    {
+        // Which chunks present in only one operand survive.
+        const bool keepA = Op::U64(1ULL, 0ULL) & 1ULL;
+        const bool keepB = Op::U64(0ULL, 1ULL) & 1ULL;
+
+        RoaringBitmap r;
+        uint64_t i = 0;
+        uint64_t j = 0;
+        while (i < a.m_keys.size() || j < b.m_keys.size())
+        {
+            if (j == b.m_keys.size() || (i < a.m_keys.size() && a.m_keys[i] < b.m_keys[j]))
+            {
+                if (keepA)
+                    r.Append(a.m_keys[i], Container(a.m_containers[i]));
+                ++i;
+            }
+            else if (i == a.m_keys.size() || b.m_keys[j] < a.m_keys[i])
+            {
+                if (keepB)
+                    r.Append(b.m_keys[j], Container(b.m_containers[j]));
+                ++j;
+            }
+            else
+            {
+                r.Append(a.m_keys[i], Combine<Op>(a.m_containers[i], b.m_containers[j]));
+                ++i;
+                ++j;
+            }
+        }
+        return r;
+    }
+
+    // Append a container past all current keys, dropping it if empty.
+    void Append(uint16_t key, Container&& c)
+    {
+        if (!c.cardinality)
+            return;
+        m_keys.push_back(key);
+        m_containers.push_back(std::move(c));
+    }
+
+    std::vector<uint16_t> m_keys;
+    std::vector<Container> m_containers;
+};
@@ -0,0 +1,257 @@
+/*******************************************************************
+*
+*    Author: Kareem Omar
+*    kareem.h.omar@gmail.com
+*    https://github.com/komrad36
+*
+*    Last updated Dec 11, 2025
+*******************************************************************/
+
+#include <iostream>
+#include <set>
+#include <vector>
+
+#include "roaringbitmap.h"
+#include "testutil.h"
+
+#define ASSERT_TRUE(a) do { if (!(a)) { std::cerr << "FAIL: expected true for " << #a << ", got false\n"; __debugbreak(); } } while (0)
+#define ASSERT_FALSE(a) do { if ((a)) { std::cerr << "FAIL: expected false for " << #a << ", got true\n"; __debugbreak(); } } while (0)
+
+#define ASSERT_BIN_OP(a, b, op) do {                                                            \
+    const auto& va = (a);                                                                       \
+    const auto& vb = (b);                                                                       \
+    if (!(va op vb))                                                                            \
+    {                                                                                           \
+        std::cerr << "FAIL: expected " << #a << " " << #op << " " << #b << " (evaluates to ";   \
+        std::cerr << va << " " << #op << " " << vb << ")\n";                                    \
+        __debugbreak();                                                                         \
+    }                                                                                           \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_BIN_OP(a, b, ==)
+
+// The bitmap holds exactly the values of the reference set, in order.
+static void CheckSame(const RoaringBitmap& r, const std::set<uint32_t>& s)
+{
+    ASSERT_EQ(r.Cardinality(), uint64_t(s.size()));
+    ASSERT_EQ(r.IsEmpty(), s.empty());
+
+    std::vector<uint32_t> values;
+    r.ForEach([&values](uint32_t x) { values.push_back(x); });
+    ASSERT_TRUE(values == std::vector<uint32_t>(s.begin(), s.end()));
+
+    for (const uint32_t x : s)
+        ASSERT_TRUE(r.Contains(x));
+}
+
+enum class Shape
+{
+    Sparse,
+    Dense,
+    Runs,
+};
+
+// Values in a few chunks around key 5, shaped so that each chunk lands in a particular container type.
+static void Fill(RoaringBitmap& r, std::set<uint32_t>& s, Shape shape, uint64_t& state)
+{
+    for (uint32_t key = 4; key < 8; ++key)
+    {
+        const uint32_t high = key << 16U;
+        if (shape == Shape::Sparse)
+        {
+            for (uint64_t k = 0; k < 1500; ++k)
+            {
+                const uint32_t x = high | uint32_t(SplitMix64(state) & 0xFFFF);
+                r.Add(x);
+                s.insert(x);
+            }
+        }
+        else if (shape == Shape::Dense)
+        {
+            for (uint64_t k = 0; k < 30000; ++k)
+            {
+                const uint32_t x = high | uint32_t(SplitMix64(state) & 0xFFFF);
+                r.Add(x);
+                s.insert(x);
+            }
+        }
+        else
+        {
+            for (uint64_t k = 0; k < 40; ++k)
+            {
+                const uint32_t a = high | uint32_t(SplitMix64(state) & 0xFFFF);
+                const uint32_t b = a + uint32_t(SplitMix64(state) % 3000);
+                r.AddRange(a, b);
+                for (uint32_t x = a; x <= b; ++x)
+                    s.insert(x);
+            }
+        }
+    }
+}
+
+template <class Op>
+static std::set<uint32_t> Reference(const std::set<uint32_t>& a, const std::set<uint32_t>& b)
+{
+    std::set<uint32_t> all(a);
+    all.insert(b.begin(), b.end());
+
+    std::set<uint32_t> ret;
+    for (const uint32_t x : all)
+    {
+        if (Op::U64(a.count(x), b.count(x)) & 1ULL)
+            ret.insert(x);
+    }
+    return ret;
+}
+
+// Every set operation between every pair of container types, against std::set.
+static void TestSetOps(uint64_t& state)
+{
+    for (const Shape shapeA : { Shape::Sparse, Shape::Dense, Shape::Runs })
+    {
+        for (const Shape shapeB : { Shape::Sparse, Shape::Dense, Shape::Runs })
+        {
+            RoaringBitmap a;
+            RoaringBitmap b;
+            std::set<uint32_t> sa;
+            std::set<uint32_t> sb;
+            Fill(a, sa, shapeA, state);
+            Fill(b, sb, shapeB, state);
+
+            // A chunk only in each.
+            a.Add(0x10000000U);
+            sa.insert(0x10000000U);
+            b.Add(0xFFFFFFFFU);
+            sb.insert(0xFFFFFFFFU);
+
+            CheckSame(a, sa);
+            CheckSame(b, sb);
+
+            CheckSame(a & b, Reference<BitOpAnd>(sa, sb));
+            CheckSame(a | b, Reference<BitOpOr>(sa, sb));
+            CheckSame(a ^ b, Reference<BitOpXor>(sa, sb));
+            CheckSame(AndNot(a, b), Reference<BitOpAndNot>(sa, sb));
+
+            ASSERT_TRUE((a ^ a).IsEmpty());
+            ASSERT_TRUE((a & a) == a);
+            ASSERT_TRUE((a | b) == (b | a));
+
+            RoaringBitmap c = a;
+            c |= b;
+            ASSERT_TRUE(c == (a | b));
+            c &= b;
+            ASSERT_TRUE(c == b);
+            c ^= a;
+            ASSERT_TRUE(c == (a ^ b));
+            c.AndNot(b);
+            ASSERT_TRUE(c == AndNot(a, b));
+        }
+    }
+}
+
+void TestRoaringBitmap()
+{
+    uint64_t state = 0x70A21ULL;
+
+    // empty
+    {
+        RoaringBitmap r;
+        CheckSame(r, {});
+        ASSERT_FALSE(r.Contains(0));
+        r.Remove(5);
+        ASSERT_TRUE(r.IsEmpty());
+        ASSERT_TRUE(r == RoaringBitmap());
+    }
+
+    // Random adds and removes, crossing the array/bitmap threshold both ways.
+    {
+        RoaringBitmap r;
+        std::set<uint32_t> s;
+        for (uint64_t k = 0; k < 60000; ++k)
+        {
+            const uint64_t rnd = SplitMix64(state);
+            const uint32_t x = uint32_t(rnd & 0x1FFF) | (uint32_t((rnd >> 32) % 3) << 16U);
+            // Mostly adds, then mostly removes.
+            if ((rnd >> 40) % 8 < (k < 30000 ? 6ULL : 1ULL))
+            {
+                r.Add(x);
+                s.insert(x);
+            }
+            else
+            {
+                r.Remove(x);
+                s.erase(x);
+            }
+            ASSERT_EQ(r.Contains(x), s.count(x) != 0);
+            if (k % 5000 == 0)
+                CheckSame(r, s);
+        }
+        CheckSame(r, s);
+    }
+
+    // Container types follow cardinality.
+    {
+        RoaringBitmap r;
+        for (uint32_t x = 0; x < RoaringBitmap::kMaxArraySize; ++x)
+            r.Add(x * 2);
+        ASSERT_EQ(r.CountContainers(RoaringContainer::Array), 1ULL);
+        r.Add(1);
+        ASSERT_EQ(r.CountContainers(RoaringContainer::Bitmap), 1ULL);
+        r.Remove(1);
+        ASSERT_EQ(r.CountContainers(RoaringContainer::Array), 1ULL);
+    }
+
+    // Ranges are stored as runs, across chunks and up to the last value.
+    {
+        RoaringBitmap r;
+        r.AddRange(0xFFF0, 0x3000F);
+        ASSERT_EQ(r.Cardinality(), 0x30010ULL - 0xFFF0ULL);
+        ASSERT_EQ(r.CountContainers(RoaringContainer::Run), 4ULL);
+        ASSERT_TRUE(r.MemoryBytes() < 1024);
+        ASSERT_FALSE(r.Contains(0xFFEF));
+        ASSERT_TRUE(r.Contains(0xFFF0));
+        ASSERT_TRUE(r.Contains(0x3000F));
+        ASSERT_FALSE(r.Contains(0x30010));
+
+        r.AddRange(0xFFFFFFF0U, 0xFFFFFFFFU);
+        ASSERT_TRUE(r.Contains(0xFFFFFFFFU));
+        ASSERT_EQ(r.Cardinality(), 0x30010ULL - 0xFFF0ULL + 16ULL);
+
+        // Removing from a run falls back to a plain container.
+        r.Remove(0x20000);
+        ASSERT_FALSE(r.Contains(0x20000));
+        ASSERT_TRUE(r.Contains(0x20001));
+        ASSERT_EQ(r.CountContainers(RoaringContainer::Bitmap), 1ULL);
+
+        // A range filling a whole chunk is one run, whatever was there before.
+        r.AddRange(0x20000, 0x2FFFF);
+        ASSERT_EQ(r.CountContainers(RoaringContainer::Run), 5ULL);
+    }
+
+    // RunOptimize picks the smallest form, and leaves the values alone.
+    {
+        RoaringBitmap r;
+        std::set<uint32_t> s;
+        for (uint32_t x = 100; x < 20000; ++x)
+        {
+            r.Add(x);
+            s.insert(x);
+        }
+        for (uint32_t x = 0x10000; x < 0x10000 + 3000; x += 3)
+        {
+            r.Add(x);
+            s.insert(x);
+        }
+        ASSERT_EQ(r.CountContainers(RoaringContainer::Bitmap), 1ULL);
+        const RoaringBitmap before = r;
+
+        r.RunOptimize();
+        ASSERT_EQ(r.CountContainers(RoaringContainer::Run), 1ULL);
+        ASSERT_EQ(r.CountContainers(RoaringContainer::Array), 1ULL);
+        ASSERT_TRUE(r.MemoryBytes() < before.MemoryBytes());
+        ASSERT_TRUE(r == before);
+        CheckSame(r, s);
+    }
+
+    TestSetOps(state);
+}